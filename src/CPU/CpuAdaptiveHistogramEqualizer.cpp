@@ -0,0 +1,182 @@
+#include "CpuAdaptiveHistogramEqualizer.h"
+
+#include "CpuComputeHistogram.h"
+#include "CpuHistogram.h"
+#include "CpuParallel.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace CS570;
+
+void CpuAdaptiveHistogramEqualizer::TileAxis::Build(uint32_t pixels, uint32_t tileCount)
+{
+    tileBegin.resize(tileCount + 1);
+    for (uint32_t tile = 0; tile <= tileCount; ++tile)
+        tileBegin[tile] = static_cast<uint32_t>(uint64_t(tile) * pixels / tileCount);
+
+    std::vector<float> centers(tileCount);
+    for (uint32_t tile = 0; tile < tileCount; ++tile)
+        centers[tile] = 0.5f * static_cast<float>(tileBegin[tile] + tileBegin[tile + 1]);
+
+    tile0.resize(pixels);
+    tile1.resize(pixels);
+    weight1.resize(pixels);
+    uint32_t tile = 0;
+    for (uint32_t pixel = 0; pixel < pixels; ++pixel)
+    {
+        float position = static_cast<float>(pixel) + 0.5f;
+        while (tile + 1 < tileCount && centers[tile + 1] <= position)
+            ++tile;
+
+        // Before the first center and past the last one a pixel only sees its own tile.
+        if (position < centers[tile] || tile + 1 == tileCount)
+        {
+            tile0[pixel] = tile;
+            tile1[pixel] = tile;
+            weight1[pixel] = 0.0f;
+        }
+        else
+        {
+            tile0[pixel] = tile;
+            tile1[pixel] = tile + 1;
+            weight1[pixel] = (position - centers[tile]) / (centers[tile + 1] - centers[tile]);
+        }
+    }
+}
+
+void CpuAdaptiveHistogramEqualizer::OnCreate(const CpuImage& input, uint32_t tileCount, float clipLimit, uint32_t binCount)
+{
+    m_pInput = &input;
+    m_clipLimit = clipLimit;
+
+    SetBinCount(binCount);
+    SetTileCount(tileCount);
+
+    // Only red is equalized, so the output is a single grey plane.
+    m_equalizedOutput.Resize(input.GetWidth(), input.GetHeight(), CpuPixelFormat::R32F);
+}
+
+void CpuAdaptiveHistogramEqualizer::OnDestroy()
+{
+    m_columns = TileAxis();
+    m_rows = TileAxis();
+    std::vector<float>().swap(m_tileValues);
+    m_equalizedOutput.Release();
+    m_pInput = nullptr;
+}
+
+void CpuAdaptiveHistogramEqualizer::SetTileCount(uint32_t tileCount)
+{
+    assert(m_pInput != nullptr);
+
+    m_tileCount = std::max(tileCount, 1u);
+    m_columns.Build(m_pInput->GetWidth(), std::max(std::min(m_tileCount, m_pInput->GetWidth()), 1u));
+    m_rows.Build(m_pInput->GetHeight(), std::max(std::min(m_tileCount, m_pInput->GetHeight()), 1u));
+}
+
+void CpuAdaptiveHistogramEqualizer::SetBinCount(uint32_t binCount)
+{
+    if (!IsSupportedHistogramBinCount(binCount))
+        throw "Histogram bin count must be a power of two from 8 to 65536.";
+
+    m_binCount = binCount;
+}
+
+void CpuAdaptiveHistogramEqualizer::BuildTileTable(
+    uint32_t tileX,
+    uint32_t tileY,
+    std::vector<uint32_t>* pCounts,
+    std::vector<uint32_t>* pLUT,
+    std::vector<uint32_t>* pInverseLUT)
+{
+    const uint32_t columnBegin = m_columns.tileBegin[tileX];
+    const uint32_t columnEnd = m_columns.tileBegin[tileX + 1];
+    const uint32_t rowBegin = m_rows.tileBegin[tileY];
+    const uint32_t rowEnd = m_rows.tileBegin[tileY + 1];
+
+    std::vector<uint32_t>& counts = *pCounts;
+    std::fill(counts.begin(), counts.end(), 0u);
+    AccumulateHistogram(*m_pInput, HistogramMode::Red, m_binCount, columnBegin, columnEnd, rowBegin, rowEnd, counts.data());
+
+    if (m_clipLimit > 0.0f)
+    {
+        const uint64_t pixelCount = uint64_t(columnEnd - columnBegin) * (rowEnd - rowBegin);
+        const uint32_t limit = std::max(
+            static_cast<uint32_t>(m_clipLimit * static_cast<float>(pixelCount) / static_cast<float>(m_binCount)), 1u);
+
+        uint64_t excess = 0;
+        for (uint32_t& count : counts)
+        {
+            if (count > limit)
+            {
+                excess += count - limit;
+                count = limit;
+            }
+        }
+
+        // Spread the clipped counts evenly, the remainder over bins spaced evenly across the range.
+        const uint32_t spread = static_cast<uint32_t>(excess / m_binCount);
+        const uint32_t remainder = static_cast<uint32_t>(excess % m_binCount);
+        for (uint32_t& count : counts)
+            count += spread;
+        if (remainder > 0)
+        {
+            const uint32_t step = m_binCount / remainder;
+            for (uint32_t bin = 0, added = 0; added < remainder; bin += step, ++added)
+                ++counts[bin];
+        }
+    }
+
+    BuildHistogramLUTs(counts.data(), m_binCount, m_binCount, pLUT, pInverseLUT);
+
+    float* pValues = m_tileValues.data() + (size_t(tileY) * m_columns.GetTileCount() + tileX) * m_binCount;
+    for (uint32_t bin = 0; bin < m_binCount; ++bin)
+        pValues[bin] = GetRemappedBinValue((*pLUT)[bin], m_binCount);
+}
+
+void CpuAdaptiveHistogramEqualizer::Execute()
+{
+    assert(m_pInput != nullptr);
+
+    const uint32_t tileCountX = m_columns.GetTileCount();
+    const uint32_t tileCountY = m_rows.GetTileCount();
+    m_tileValues.resize(size_t(tileCountX) * tileCountY * m_binCount);
+
+    ParallelFor(0, size_t(tileCountX) * tileCountY, 1, [&](size_t tileBegin, size_t tileEnd) {
+        std::vector<uint32_t> counts(m_binCount);
+        std::vector<uint32_t> lut;
+        std::vector<uint32_t> inverseLUT;
+        for (size_t tile = tileBegin; tile < tileEnd; ++tile)
+        {
+            BuildTileTable(
+                static_cast<uint32_t>(tile % tileCountX), static_cast<uint32_t>(tile / tileCountX), &counts, &lut, &inverseLUT);
+        }
+    });
+
+    const uint32_t width = m_pInput->GetWidth();
+    const size_t tileRowSize = size_t(tileCountX) * m_binCount;
+    ParallelFor(0, m_pInput->GetHeight(), 32, [&](size_t rowBegin, size_t rowEnd) {
+        std::vector<float> reds(width);
+        for (size_t y = rowBegin; y < rowEnd; ++y)
+        {
+            const float* pTop = m_tileValues.data() + m_rows.tile0[y] * tileRowSize;
+            const float* pBottom = m_tileValues.data() + m_rows.tile1[y] * tileRowSize;
+            const float weightY = m_rows.weight1[y];
+
+            LoadRedRow(*m_pInput, static_cast<uint32_t>(y), reds.data());
+            float* pDst = m_equalizedOutput.GetRowSamples<float>(static_cast<uint32_t>(y));
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                const uint32_t bin = ComputeBinNumber(reds[x], m_binCount);
+                const size_t left = size_t(m_columns.tile0[x]) * m_binCount + bin;
+                const size_t right = size_t(m_columns.tile1[x]) * m_binCount + bin;
+                const float weightX = m_columns.weight1[x];
+
+                float top = pTop[left] + weightX * (pTop[right] - pTop[left]);
+                float bottom = pBottom[left] + weightX * (pBottom[right] - pBottom[left]);
+                pDst[x] = top + weightY * (bottom - top);
+            }
+        }
+    });
+}
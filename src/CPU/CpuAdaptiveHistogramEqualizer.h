@@ -0,0 +1,71 @@
+#pragma once
+
+#include "CpuImageProcessor.h"
+
+#include <vector>
+
+namespace CS570
+{
+    // Contrast limited adaptive histogram equalization (CLAHE) of the red channel.
+    //
+    // The image is split into a tileCount x tileCount grid. Every tile counts its histogram with
+    // AccumulateHistogram, clips the bins at clipLimit times the mean bin count, spreads the clipped
+    // counts over all bins and turns the result into an equalization table with BuildHistogramLUTs.
+    // The tiles are independent and run in parallel. A single pass then writes every pixel as the
+    // bilinear interpolation of the tables of the four nearest tile centers, so the cost is one
+    // histogram and one lookup pass, as for the global equalizer.
+    class CpuAdaptiveHistogramEqualizer : public BaseCpuImageProcessor
+    {
+    public:
+        static const uint32_t k_defaultTileCount = 8;
+        static const uint32_t k_defaultBinCount = 256;
+
+        // binCount is a power of two from 8 to 65536. A clipLimit of 0 disables clipping.
+        void OnCreate(
+            const CpuImage& input,
+            uint32_t tileCount = k_defaultTileCount,
+            float clipLimit = 2.0f,
+            uint32_t binCount = k_defaultBinCount);
+        void OnDestroy();
+
+        // Tiles per row and column, clamped to the image size.
+        void SetTileCount(uint32_t tileCount);
+        void SetClipLimit(float clipLimit) { m_clipLimit = clipLimit; }
+        void SetBinCount(uint32_t binCount);
+
+        void Execute() override;
+
+        CpuImage& GetOutputImage() override { return m_equalizedOutput; }
+
+    private:
+        // Pixel range of tile i of tileCount along an axis of size pixels, and the interpolation
+        // terms of every pixel along it: the two nearest tile centers and the weight of the second.
+        struct TileAxis
+        {
+            std::vector<uint32_t> tileBegin;
+            std::vector<uint32_t> tile0;
+            std::vector<uint32_t> tile1;
+            std::vector<float> weight1;
+
+            void Build(uint32_t pixels, uint32_t tileCount);
+            uint32_t GetTileCount() const { return static_cast<uint32_t>(tileBegin.size() - 1); }
+        };
+
+        void BuildTileTable(uint32_t tileX, uint32_t tileY, std::vector<uint32_t>* pCounts, std::vector<uint32_t>* pLUT,
+            std::vector<uint32_t>* pInverseLUT);
+
+        const CpuImage* m_pInput = nullptr;
+
+        uint32_t m_tileCount = k_defaultTileCount;
+        float m_clipLimit = 2.0f;
+        uint32_t m_binCount = k_defaultBinCount;
+
+        TileAxis m_columns;
+        TileAxis m_rows;
+
+        // The output value of every bin of every tile, tiles in row major order.
+        std::vector<float> m_tileValues;
+
+        CpuImage m_equalizedOutput;
+    };
+}
@@ -0,0 +1,163 @@
+#include "CpuComputeHistogram.h"
+
+#include "CpuParallel.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace CS570;
+
+float CS570::GetRemappedBinValue(uint32_t level, uint32_t levelCount)
+{
+    if (levelCount != 8)
+        return static_cast<float>(std::min(level, levelCount - 1)) / static_cast<float>(levelCount - 1);
+
+    const float binSize = 255.0f / 8.0f;
+    const float remapped[8] = { 0, binSize * 1.25f, 2.5f * binSize, 3.5f * binSize, 4.5f * binSize, 5.5f * binSize, 6.75f * binSize, 8.0f * binSize };
+    return remapped[std::min(level, 7u)] / 255.0f;
+}
+
+template <typename T, uint32_t ChannelCount>
+static void RemapBinRows(
+    const CpuImage& input, PixelChannels<ChannelCount>, uint32_t binCount, const float* pBinValues, CpuImage* pOutput)
+{
+    const uint32_t width = input.GetWidth();
+    ParallelFor(0, input.GetHeight(), 32, [&](size_t rowBegin, size_t rowEnd) {
+        for (size_t y = rowBegin; y < rowEnd; ++y)
+        {
+            const T* pInput = input.GetRowSamples<T>(static_cast<uint32_t>(y));
+            float* pDst = pOutput->GetRowSamples<float>(static_cast<uint32_t>(y));
+            for (uint32_t x = 0; x < width; ++x)
+                pDst[x] = pBinValues[ComputeBinNumber(LoadSample(pInput[size_t(x) * ChannelCount]), binCount)];
+        }
+    });
+}
+
+void CS570::RemapBins(const CpuImage& input, uint32_t binCount, const float* pBinValues, CpuImage* pOutput)
+{
+    assert(pOutput->GetFormat() == CpuPixelFormat::R32F);
+    DispatchPixelFormat(input.GetFormat(), [&](auto sample, auto channels) {
+        RemapBinRows<decltype(sample)>(input, channels, binCount, pBinValues, pOutput);
+    });
+}
+
+void CS570::BuildHistogramLUTs(
+    const uint32_t* pCounts,
+    uint32_t binCount,
+    uint32_t levelCount,
+    std::vector<uint32_t>* pLUT,
+    std::vector<uint32_t>* pInverseLUT)
+{
+    assert(binCount > 0 && levelCount > 0);
+
+    const size_t blockSize = 4096;
+    const size_t blockCount = (binCount + blockSize - 1) / blockSize;
+
+    std::vector<uint64_t> blockOffsets(blockCount, 0);
+    ParallelFor(0, blockCount, 1, [&](size_t blockBegin, size_t blockEnd) {
+        for (size_t block = blockBegin; block < blockEnd; ++block)
+        {
+            const size_t end = std::min(size_t(binCount), (block + 1) * blockSize);
+            uint64_t sum = 0;
+            for (size_t bin = block * blockSize; bin < end; ++bin)
+                sum += pCounts[bin];
+            blockOffsets[block] = sum;
+        }
+    });
+
+    uint64_t total = 0;
+    for (uint64_t& offset : blockOffsets)
+    {
+        uint64_t sum = offset;
+        offset = total;
+        total += sum;
+    }
+
+    // Integer math, so the forward and inverse LUT agree exactly whatever the bin count.
+    auto computeLevel = [total, levelCount](uint64_t cumulativeCount) {
+        return total > 0 ? static_cast<uint32_t>(cumulativeCount * (levelCount - 1) / total) : 0u;
+    };
+
+    pLUT->resize(binCount);
+    pInverseLUT->resize(levelCount);
+    uint32_t* pLevels = pLUT->data();
+    uint32_t* pBins = pInverseLUT->data();
+    ParallelFor(0, blockCount, 1, [&](size_t blockBegin, size_t blockEnd) {
+        for (size_t block = blockBegin; block < blockEnd; ++block)
+        {
+            const size_t end = std::min(size_t(binCount), (block + 1) * blockSize);
+            uint64_t cumulativeCount = blockOffsets[block];
+            uint32_t previousLevel = computeLevel(cumulativeCount);
+            for (size_t bin = block * blockSize; bin < end; ++bin)
+            {
+                cumulativeCount += pCounts[bin];
+                uint32_t level = computeLevel(cumulativeCount);
+                pLevels[bin] = level;
+
+                // Levels (previousLevel, level] first reach this bin; the first bin also owns level 0.
+                // The ranges of the bins are disjoint, so blocks never write the same entry.
+                for (uint32_t inverseLevel = bin == 0 ? 0u : previousLevel + 1; inverseLevel <= level; ++inverseLevel)
+                    pBins[inverseLevel] = static_cast<uint32_t>(bin);
+                previousLevel = level;
+            }
+        }
+    });
+
+    // Empty histograms only reach level 0.
+    if (total == 0)
+        std::fill(pInverseLUT->begin(), pInverseLUT->end(), 0u);
+}
+
+HistogramMatchReferencePtr CS570::BuildHistogramMatchReference(const CpuImage& match, uint32_t binCount)
+{
+    CpuComputeHistogram computeHistogram;
+    computeHistogram.OnCreate(match, binCount);
+    computeHistogram.Execute();
+
+    std::shared_ptr<HistogramMatchReference> pReference = std::make_shared<HistogramMatchReference>();
+    pReference->binCount = binCount;
+    pReference->inverseLUT = computeHistogram.GetInverseLUT();
+    return pReference;
+}
+
+void CS570::BuildHistogramMatchLUT(
+    const std::vector<uint32_t>& lut,
+    const HistogramMatchReference& reference,
+    std::vector<float>* pMatchLUT)
+{
+    assert(lut.size() == reference.binCount);
+
+    // The inverse LUT is fully filled, so every level of the input has a bin.
+    const uint32_t binCount = reference.binCount;
+    pMatchLUT->resize(binCount);
+    for (uint32_t bin = 0; bin < binCount; ++bin)
+        (*pMatchLUT)[bin] = GetRemappedBinValue(reference.inverseLUT[lut[bin]], binCount);
+}
+
+void CpuComputeHistogram::OnCreate(const CpuImage& input, uint32_t binCount)
+{
+    if (!IsSupportedHistogramBinCount(binCount))
+        throw "Histogram bin count must be a power of two from 8 to 65536.";
+
+    m_pInput = &input;
+    m_binCount = binCount;
+    m_binCounts.assign(binCount, 0u);
+    m_lut.assign(binCount, 0u);
+    m_inverseLUT.assign(binCount, 0u);
+}
+
+void CpuComputeHistogram::OnDestroy()
+{
+    m_pInput = nullptr;
+    std::vector<uint32_t>().swap(m_binCounts);
+    std::vector<uint32_t>().swap(m_lut);
+    std::vector<uint32_t>().swap(m_inverseLUT);
+}
+
+void CpuComputeHistogram::Execute()
+{
+    assert(m_pInput != nullptr);
+
+    CountHistogram(*m_pInput, HistogramMode::Red, m_binCount, &m_binCounts);
+    BuildHistogramLUTs(m_binCounts.data(), m_binCount, m_binCount, &m_lut, &m_inverseLUT);
+}
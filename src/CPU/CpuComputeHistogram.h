@@ -0,0 +1,75 @@
+#pragma once
+
+#include "CpuHistogram.h"
+#include "CpuImage.h"
+
+#include <memory>
+#include <vector>
+
+namespace CS570
+{
+    // Output value of remapped level `level` of levelCount. 8 levels keep the table of the
+    // histogram shaders; more levels are spread evenly over [0, 1].
+    float GetRemappedBinValue(uint32_t level, uint32_t levelCount);
+
+    // Writes v = pBinValues[bin of the input red channel in binCount bins] to a R32F output. Every
+    // pixel of a bin maps to the same output, so the per-pixel work of Equalize and Match is one
+    // table lookup.
+    void RemapBins(const CpuImage& input, uint32_t binCount, const float* pBinValues, CpuImage* pOutput);
+
+    // Builds the forward LUT (bin to level, floor((levelCount - 1) * cdf / total)) and the exact
+    // inverse LUT (level to the first bin whose forward level reaches it) of a histogram in one
+    // blocked parallel prefix sum: block totals, a scan of the totals, then every block scans its
+    // bins from its offset and writes both LUTs. The inverse is fully filled, every level has a bin.
+    void BuildHistogramLUTs(
+        const uint32_t* pCounts,
+        uint32_t binCount,
+        uint32_t levelCount,
+        std::vector<uint32_t>* pLUT,
+        std::vector<uint32_t>* pInverseLUT);
+
+    // Inverse LUT of the image a histogram match maps to. It only depends on the reference image,
+    // so a batch of images matched to one reference can share it.
+    struct HistogramMatchReference
+    {
+        uint32_t binCount = 0u;
+        std::vector<uint32_t> inverseLUT;
+    };
+    typedef std::shared_ptr<const HistogramMatchReference> HistogramMatchReferencePtr;
+
+    HistogramMatchReferencePtr BuildHistogramMatchReference(const CpuImage& match, uint32_t binCount);
+
+    // Composes the forward LUT of the input with the inverse LUT of the reference into the output
+    // value of every input bin, so matching a pixel is a single lookup.
+    void BuildHistogramMatchLUT(
+        const std::vector<uint32_t>& lut,
+        const HistogramMatchReference& reference,
+        std::vector<float>* pMatchLUT);
+
+    // Implements HistogramCount (bin counting) and CreateLUT over the red channel.
+    class CpuComputeHistogram
+    {
+    public:
+        static const uint32_t k_defaultBinCount = 8;
+
+        // binCount is a power of two from 8 to 65536; the LUTs have as many levels as bins.
+        void OnCreate(const CpuImage& input, uint32_t binCount = k_defaultBinCount);
+        void OnDestroy();
+
+        void Execute();
+
+        uint32_t GetBinCount() const { return m_binCount; }
+
+        const std::vector<uint32_t>& GetBinCounts() const { return m_binCounts; }
+        const std::vector<uint32_t>& GetLUT() const { return m_lut; }
+        const std::vector<uint32_t>& GetInverseLUT() const { return m_inverseLUT; }
+
+    private:
+        const CpuImage* m_pInput = nullptr;
+        uint32_t m_binCount = k_defaultBinCount;
+
+        std::vector<uint32_t> m_binCounts;
+        std::vector<uint32_t> m_lut;
+        std::vector<uint32_t> m_inverseLUT;
+    };
+}
@@ -0,0 +1,571 @@
+#include "CpuConnectedComponents.h"
+
+#include "CpuParallel.h"
+#include "CpuPPM.h"
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <sstream>
+
+using namespace CS570;
+
+namespace
+{
+    struct ClassKeyTable
+    {
+        uint8_t keys[256];
+
+        ClassKeyTable()
+        {
+            for (uint32_t red = 0; red < 256; ++red)
+            {
+                uint8_t bitCount = 0;
+                for (uint32_t value = red; value != 0; value >>= 1)
+                    ++bitCount;
+                keys[red] = bitCount;
+            }
+        }
+    };
+
+    const ClassKeyTable s_classKeys;
+
+    struct PixelColor
+    {
+        uint8_t rgb[3];
+    };
+
+    const uint32_t k_numObjectColors = 10;
+    const PixelColor k_objectColors[k_numObjectColors] = {
+        {0, 0, 0},
+        {255, 0, 0},
+        {0, 255, 0},
+        {0, 0, 255},
+        {255, 0, 255},
+        {255, 255, 0},
+        {0, 255, 255},
+        {255, 128, 128},
+        {128, 255, 128},
+        {128, 128, 255}
+    };
+
+    // Union-find over provisional labels whose parents are always smaller than their children.
+    uint32_t FindRoot(uint32_t* pParents, uint32_t label)
+    {
+        uint32_t root = label;
+        while (pParents[root] != root)
+            root = pParents[root];
+
+        while (pParents[label] != root)
+        {
+            uint32_t parent = pParents[label];
+            pParents[label] = root;
+            label = parent;
+        }
+
+        return root;
+    }
+
+    uint32_t Merge(uint32_t* pParents, uint32_t label0, uint32_t label1)
+    {
+        uint32_t root0 = FindRoot(pParents, label0);
+        uint32_t root1 = FindRoot(pParents, label1);
+        if (root0 == root1)
+            return root0;
+
+        // The smaller label stays the root, so parents always come earlier in raster order.
+        if (root0 < root1)
+        {
+            pParents[root1] = root0;
+            return root0;
+        }
+
+        pParents[root0] = root1;
+        return root1;
+    }
+
+    // Statistics of one provisional or final label, summed rather than averaged until the end.
+    struct ComponentAccumulator
+    {
+        uint64_t area = 0;
+        uint64_t sumX = 0;
+        uint64_t sumY = 0;
+        uint64_t sumIntensity = 0;
+        uint32_t minX = 0xFFFFFFFFu;
+        uint32_t minY = 0xFFFFFFFFu;
+        uint32_t maxX = 0u;
+        uint32_t maxY = 0u;
+        uint8_t classKey = 0;
+
+        void Add(uint32_t x, uint32_t y, uint8_t key, uint8_t intensity)
+        {
+            ++area;
+            sumX += x;
+            sumY += y;
+            sumIntensity += intensity;
+            minX = std::min(minX, x);
+            minY = std::min(minY, y);
+            maxX = std::max(maxX, x);
+            maxY = std::max(maxY, y);
+            classKey = key;
+        }
+
+        void Add(const ComponentAccumulator& other)
+        {
+            area += other.area;
+            sumX += other.sumX;
+            sumY += other.sumY;
+            sumIntensity += other.sumIntensity;
+            minX = std::min(minX, other.minX);
+            minY = std::min(minY, other.minY);
+            maxX = std::max(maxX, other.maxX);
+            maxY = std::max(maxY, other.maxY);
+            classKey = std::max(classKey, other.classKey);
+        }
+    };
+
+    // Provisional labels of one strip, from 1, and with statistics on, what every one of them
+    // covers. Label 0 is the background.
+    class StripLabels
+    {
+    public:
+        StripLabels() : m_parents(1, 0u), m_stats(1) {}
+
+        template <bool Stats>
+        uint32_t New()
+        {
+            uint32_t label = static_cast<uint32_t>(m_parents.size());
+            m_parents.push_back(label);
+            if (Stats)
+                m_stats.emplace_back();
+            return label;
+        }
+
+        uint32_t Merge(uint32_t label0, uint32_t label1) { return ::Merge(m_parents.data(), label0, label1); }
+
+        uint32_t GetCount() const { return static_cast<uint32_t>(m_parents.size() - 1); }
+        const std::vector<uint32_t>& GetParents() const { return m_parents; }
+
+        ComponentAccumulator& GetStats(uint32_t label) { return m_stats[label]; }
+        const std::vector<ComponentAccumulator>& GetStats() const { return m_stats; }
+
+    private:
+        std::vector<uint32_t> m_parents;
+        std::vector<ComponentAccumulator> m_stats;
+    };
+
+    // Provisional label of the non-background pixel at x of a strip row.
+    template <Connectivity Neighbors, bool Stats>
+    inline uint32_t ChooseLabel(
+        const uint8_t* pKeys,
+        const uint8_t* pKeysAbove,
+        const uint32_t* pLabels,
+        const uint32_t* pLabelsAbove,
+        bool hasAbove,
+        uint32_t x,
+        uint32_t width,
+        StripLabels* pStripLabels)
+    {
+        // a b c
+        // d e      e is the current pixel, a to d are visited.
+        const uint8_t key = pKeys[x];
+        const bool hasLeft = x > 0;
+        const bool hasRight = x + 1 < width;
+        const bool d = hasLeft && pKeys[x - 1] == key;
+        if (!hasAbove)
+            return d ? pLabels[x - 1] : pStripLabels->New<Stats>();
+
+        const bool b = pKeysAbove[x] == key;
+        if (Neighbors == Connectivity::Four)
+        {
+            if (b && d)
+                return pLabelsAbove[x] == pLabels[x - 1] ? pLabels[x - 1] : pStripLabels->Merge(pLabelsAbove[x], pLabels[x - 1]);
+            if (b)
+                return pLabelsAbove[x];
+            if (d)
+                return pLabels[x - 1];
+            return pStripLabels->New<Stats>();
+        }
+
+        // SAUF: b touches every other neighbor, so when it matches nothing else needs a look,
+        // and only c can join two components a and d don't already share.
+        if (b)
+            return pLabelsAbove[x];
+        if (hasRight && pKeysAbove[x + 1] == key)
+        {
+            if (hasLeft && pKeysAbove[x - 1] == key)
+                return pStripLabels->Merge(pLabelsAbove[x + 1], pLabelsAbove[x - 1]);
+            if (d)
+                return pStripLabels->Merge(pLabelsAbove[x + 1], pLabels[x - 1]);
+            return pLabelsAbove[x + 1];
+        }
+        if (hasLeft && pKeysAbove[x - 1] == key)
+            return pLabelsAbove[x - 1];
+        if (d)
+            return pLabels[x - 1];
+        return pStripLabels->New<Stats>();
+    }
+
+    // Labels rows [rowBegin, rowEnd) as if they were the whole image. With Stats every pixel is also
+    // added to the statistics of its provisional label.
+    template <Connectivity Neighbors, bool Stats>
+    void LabelStrip(
+        const uint8_t* pClassKeys,
+        const uint8_t* pIntensities,
+        uint32_t intensityStride,
+        uint32_t width,
+        uint32_t rowBegin,
+        uint32_t rowEnd,
+        uint32_t* pLabelImage,
+        StripLabels* pStripLabels)
+    {
+        for (uint32_t y = rowBegin; y < rowEnd; ++y)
+        {
+            const bool hasAbove = y > rowBegin;
+            const uint8_t* pKeys = pClassKeys + size_t(y) * width;
+            const uint8_t* pKeysAbove = hasAbove ? pKeys - width : pKeys;
+            const uint8_t* pRowIntensities = Stats && pIntensities != nullptr ? pIntensities + size_t(y) * width * intensityStride : nullptr;
+            uint32_t* pLabels = pLabelImage + size_t(y) * width;
+            const uint32_t* pLabelsAbove = hasAbove ? pLabels - width : pLabels;
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                if (pKeys[x] == 0)
+                {
+                    pLabels[x] = 0;
+                    continue;
+                }
+
+                const uint32_t label = ChooseLabel<Neighbors, Stats>(
+                    pKeys, pKeysAbove, pLabels, pLabelsAbove, hasAbove, x, width, pStripLabels);
+                pLabels[x] = label;
+
+                if (Stats)
+                {
+                    pStripLabels->GetStats(label).Add(
+                        x, y, pKeys[x], pRowIntensities != nullptr ? pRowIntensities[size_t(x) * intensityStride] : 0);
+                }
+            }
+        }
+    }
+
+    template <bool Stats>
+    void LabelStrip(
+        Connectivity connectivity,
+        const uint8_t* pClassKeys,
+        const uint8_t* pIntensities,
+        uint32_t intensityStride,
+        uint32_t width,
+        uint32_t rowBegin,
+        uint32_t rowEnd,
+        uint32_t* pLabelImage,
+        StripLabels* pStripLabels)
+    {
+        if (connectivity == Connectivity::Four)
+        {
+            LabelStrip<Connectivity::Four, Stats>(
+                pClassKeys, pIntensities, intensityStride, width, rowBegin, rowEnd, pLabelImage, pStripLabels);
+        }
+        else
+        {
+            LabelStrip<Connectivity::Eight, Stats>(
+                pClassKeys, pIntensities, intensityStride, width, rowBegin, rowEnd, pLabelImage, pStripLabels);
+        }
+    }
+}
+
+uint8_t CS570::GetComponentClassKey(uint8_t red)
+{
+    return s_classKeys.keys[red];
+}
+
+void CS570::ComputeComponentClassKeys(const uint8_t* pPixels, size_t pixelCount, uint32_t pixelStride, uint8_t* pKeys)
+{
+    ParallelFor(0, pixelCount, 1 << 16, [&](size_t begin, size_t end) {
+        for (size_t pixel = begin; pixel < end; ++pixel)
+            pKeys[pixel] = s_classKeys.keys[pPixels[pixel * pixelStride]];
+    });
+}
+
+void CS570::ComputeComponentClassKeys(const CpuImage& image, std::vector<uint8_t>* pKeys, std::vector<uint8_t>* pReds)
+{
+    const uint32_t width = image.GetWidth();
+    pKeys->resize(size_t(width) * image.GetHeight());
+    uint8_t* pKeyData = pKeys->data();
+    uint8_t* pRedData = nullptr;
+    if (pReds != nullptr)
+    {
+        pReds->resize(pKeys->size());
+        pRedData = pReds->data();
+    }
+    ParallelFor(0, image.GetHeight(), 32, [&](size_t rowBegin, size_t rowEnd) {
+        std::vector<float> reds(width);
+        for (size_t row = rowBegin; row < rowEnd; ++row)
+        {
+            LoadRedRow(image, static_cast<uint32_t>(row), reds.data());
+            uint8_t* pKey = pKeyData + row * width;
+            for (uint32_t col = 0; col < width; ++col)
+            {
+                // Written so that NaN, which fails every comparison, lands on 0 like negative values.
+                float red = reds[col];
+                red = red > 0.0f ? std::min(red, 1.0f) : 0.0f;
+                uint8_t red8 = static_cast<uint8_t>(red * 255.0f + 0.5f);
+                pKey[col] = s_classKeys.keys[red8];
+                if (pRedData != nullptr)
+                    pRedData[row * width + col] = red8;
+            }
+        }
+    });
+}
+
+void CpuConnectedComponents::OnCreate(const uint8_t* pClassKeys, uint32_t width, uint32_t height, Connectivity connectivity)
+{
+    m_pClassKeys = pClassKeys;
+    m_width = width;
+    m_height = height;
+    m_connectivity = connectivity;
+    m_componentCount = 0u;
+    m_labels.resize(size_t(width) * height);
+}
+
+void CpuConnectedComponents::OnDestroy()
+{
+    m_pClassKeys = nullptr;
+    std::vector<uint32_t>().swap(m_labels);
+    std::vector<uint32_t>().swap(m_parents);
+    std::vector<uint32_t>().swap(m_stripRows);
+    std::vector<uint32_t>().swap(m_stripLabels);
+    std::vector<ComponentStats>().swap(m_componentStats);
+    m_componentCount = 0u;
+}
+
+void CpuConnectedComponents::SetComponentStats(bool enabled, const uint8_t* pIntensities, uint32_t intensityStride)
+{
+    m_computeStats = enabled;
+    m_pIntensities = pIntensities;
+    m_intensityStride = intensityStride;
+}
+
+void CpuConnectedComponents::MergeSeam(uint32_t strip)
+{
+    const uint32_t width = m_width;
+    const uint32_t row = m_stripRows[strip];
+    const uint8_t* pKeys = m_pClassKeys + size_t(row) * width;
+    const uint8_t* pKeysAbove = pKeys - width;
+    const uint32_t* pLabels = m_labels.data() + size_t(row) * width;
+    const uint32_t* pLabelsAbove = pLabels - width;
+    const uint32_t offset = m_stripLabels[strip];
+    const uint32_t offsetAbove = m_stripLabels[strip - 1];
+    uint32_t* pParents = m_parents.data();
+
+    for (uint32_t x = 0; x < width; ++x)
+    {
+        const uint8_t key = pKeys[x];
+        if (key == 0)
+            continue;
+
+        const uint32_t label = pLabels[x] + offset;
+        if (pKeysAbove[x] == key)
+        {
+            Merge(pParents, label, pLabelsAbove[x] + offsetAbove);
+            // The diagonal neighbors touch the one above, so they are already joined.
+            continue;
+        }
+
+        if (m_connectivity == Connectivity::Eight)
+        {
+            if (x > 0 && pKeysAbove[x - 1] == key)
+                Merge(pParents, label, pLabelsAbove[x - 1] + offsetAbove);
+            if (x + 1 < width && pKeysAbove[x + 1] == key)
+                Merge(pParents, label, pLabelsAbove[x + 1] + offsetAbove);
+        }
+    }
+}
+
+void CpuConnectedComponents::Execute()
+{
+    assert(m_pClassKeys != nullptr || m_labels.empty());
+
+    const uint32_t stripCount = std::max(
+        std::min(m_height / m_minStripHeight, GetCpuWorkerCount() * 4), 1u);
+    m_stripRows.resize(stripCount + 1);
+    for (uint32_t strip = 0; strip <= stripCount; ++strip)
+        m_stripRows[strip] = static_cast<uint32_t>(uint64_t(strip) * m_height / stripCount);
+
+    std::vector<StripLabels> stripLabels(stripCount);
+    ParallelFor(0, stripCount, 1, [&](size_t stripBegin, size_t stripEnd) {
+        for (size_t strip = stripBegin; strip < stripEnd; ++strip)
+        {
+            if (m_computeStats)
+            {
+                LabelStrip<true>(m_connectivity, m_pClassKeys, m_pIntensities, m_intensityStride, m_width,
+                    m_stripRows[strip], m_stripRows[strip + 1], m_labels.data(), &stripLabels[strip]);
+            }
+            else
+            {
+                LabelStrip<false>(m_connectivity, m_pClassKeys, m_pIntensities, m_intensityStride, m_width,
+                    m_stripRows[strip], m_stripRows[strip + 1], m_labels.data(), &stripLabels[strip]);
+            }
+        }
+    });
+
+    // Strip s's label l is global label l + m_stripLabels[s], which keeps every parent smaller
+    // than its children.
+    m_stripLabels.resize(stripCount + 1);
+    m_stripLabels[0] = 0;
+    for (uint32_t strip = 0; strip < stripCount; ++strip)
+        m_stripLabels[strip + 1] = m_stripLabels[strip] + stripLabels[strip].GetCount();
+
+    m_parents.resize(size_t(m_stripLabels[stripCount]) + 1);
+    m_parents[0] = 0;
+    ParallelFor(0, stripCount, 1, [&](size_t stripBegin, size_t stripEnd) {
+        for (size_t strip = stripBegin; strip < stripEnd; ++strip)
+        {
+            const uint32_t offset = m_stripLabels[strip];
+            const std::vector<uint32_t>& parents = stripLabels[strip].GetParents();
+            for (size_t label = 1; label < parents.size(); ++label)
+                m_parents[label + offset] = parents[label] + offset;
+        }
+    });
+
+    // Round by round, merge the seam in the middle of every pair of neighboring groups of span
+    // strips. The union-find trees of a group only hold labels of its own strips, so the merges of
+    // one round never touch the same labels.
+    for (uint32_t span = 1; span < stripCount; span *= 2)
+    {
+        const uint32_t seamCount = (stripCount - span + 2 * span - 1) / (2 * span);
+        ParallelFor(0, seamCount, 1, [&](size_t seamBegin, size_t seamEnd) {
+            for (size_t seam = seamBegin; seam < seamEnd; ++seam)
+                MergeSeam(static_cast<uint32_t>(seam * 2 * span + span));
+        });
+    }
+
+    // Parents are smaller than their children, so one ascending pass leaves every provisional label
+    // mapped to the final label of its root.
+    uint32_t componentCount = 0;
+    for (size_t label = 1; label < m_parents.size(); ++label)
+    {
+        if (m_parents[label] == label)
+            m_parents[label] = ++componentCount;
+        else
+            m_parents[label] = m_parents[m_parents[label]];
+    }
+    m_componentCount = componentCount;
+
+    if (m_computeStats)
+    {
+        // Every strip accumulated its provisional labels; add them up under their final labels.
+        std::vector<ComponentAccumulator> accumulators(size_t(componentCount) + 1);
+        for (uint32_t strip = 0; strip < stripCount; ++strip)
+        {
+            const uint32_t* pFinalLabels = m_parents.data() + m_stripLabels[strip];
+            const std::vector<ComponentAccumulator>& stats = stripLabels[strip].GetStats();
+            for (size_t label = 1; label < stats.size(); ++label)
+                accumulators[pFinalLabels[label]].Add(stats[label]);
+        }
+
+        m_componentStats.resize(componentCount);
+        ParallelFor(0, componentCount, 4096, [&](size_t begin, size_t end) {
+            for (size_t component = begin; component < end; ++component)
+            {
+                const ComponentAccumulator& accumulator = accumulators[component + 1];
+                const double area = static_cast<double>(accumulator.area);
+                ComponentStats& stats = m_componentStats[component];
+                stats.label = static_cast<uint32_t>(component + 1);
+                stats.classKey = accumulator.classKey;
+                stats.area = accumulator.area;
+                stats.minX = accumulator.minX;
+                stats.minY = accumulator.minY;
+                stats.maxX = accumulator.maxX;
+                stats.maxY = accumulator.maxY;
+                stats.centroidX = static_cast<float>(accumulator.sumX / area);
+                stats.centroidY = static_cast<float>(accumulator.sumY / area);
+                stats.meanIntensity = static_cast<float>(accumulator.sumIntensity / area);
+            }
+        });
+    }
+    else
+    {
+        m_componentStats.clear();
+    }
+    std::vector<StripLabels>().swap(stripLabels);
+
+    ParallelFor(0, m_height, 32, [&](size_t rowBegin, size_t rowEnd) {
+        uint32_t strip = static_cast<uint32_t>(
+            std::upper_bound(m_stripRows.begin(), m_stripRows.end(), static_cast<uint32_t>(rowBegin)) - m_stripRows.begin() - 1);
+        for (size_t row = rowBegin; row < rowEnd; ++row)
+        {
+            while (row >= m_stripRows[strip + 1])
+                ++strip;
+
+            const uint32_t* pFinalLabels = m_parents.data() + m_stripLabels[strip];
+            uint32_t* pLabels = m_labels.data() + row * m_width;
+            // Branch free: label 0 reads the entry of the strip's first label, masked to 0.
+            for (uint32_t x = 0; x < m_width; ++x)
+            {
+                const uint32_t label = pLabels[x];
+                pLabels[x] = pFinalLabels[label] & (0u - static_cast<uint32_t>(label != 0));
+            }
+        }
+    });
+}
+
+void CS570::WriteLabelPPM(const std::string& imageFile, const uint32_t* pLabels, uint32_t width, uint32_t height)
+{
+    WritePPM(imageFile, width, height, [pLabels, width](uint32_t row, uint8_t* pRowBytes) {
+        const uint32_t* pRowLabels = pLabels + size_t(row) * width;
+        for (uint32_t col = 0; col < width; ++col)
+        {
+            const PixelColor& pixelColor = k_objectColors[pRowLabels[col] % k_numObjectColors];
+            pRowBytes[col * 3 + 0] = pixelColor.rgb[0];
+            pRowBytes[col * 3 + 1] = pixelColor.rgb[1];
+            pRowBytes[col * 3 + 2] = pixelColor.rgb[2];
+        }
+    });
+}
+
+void CS570::WriteComponentStats(const std::string& file, const std::vector<ComponentStats>& stats)
+{
+    const bool csv = file.size() >= 4 && file.compare(file.size() - 4, 4, ".csv") == 0;
+    std::ofstream fstream(file, csv ? std::ios::out : std::ios::binary);
+    if (!fstream.is_open())
+        throw "Failed to open component statistics file for writing.";
+
+    if (csv)
+    {
+        std::stringstream table;
+        table << "label,class,area,min_x,min_y,max_x,max_y,centroid_x,centroid_y,mean_intensity\n";
+        for (const ComponentStats& component : stats)
+        {
+            table << component.label << ',' << component.classKey << ',' << component.area << ','
+                  << component.minX << ',' << component.minY << ',' << component.maxX << ',' << component.maxY << ','
+                  << component.centroidX << ',' << component.centroidY << ',' << component.meanIntensity << '\n';
+        }
+        fstream << table.str();
+        return;
+    }
+
+    std::vector<uint8_t> bytes;
+    auto append = [&bytes](const void* pValue, size_t size) {
+        const uint8_t* pBytes = static_cast<const uint8_t*>(pValue);
+        bytes.insert(bytes.end(), pBytes, pBytes + size);
+    };
+
+    const uint32_t count = static_cast<uint32_t>(stats.size());
+    bytes.reserve(8 + stats.size() * 44);
+    append("CCS1", 4);
+    append(&count, sizeof(count));
+    for (const ComponentStats& component : stats)
+    {
+        append(&component.label, sizeof(component.label));
+        append(&component.classKey, sizeof(component.classKey));
+        append(&component.area, sizeof(component.area));
+        append(&component.minX, sizeof(component.minX));
+        append(&component.minY, sizeof(component.minY));
+        append(&component.maxX, sizeof(component.maxX));
+        append(&component.maxY, sizeof(component.maxY));
+        append(&component.centroidX, sizeof(component.centroidX));
+        append(&component.centroidY, sizeof(component.centroidY));
+        append(&component.meanIntensity, sizeof(component.meanIntensity));
+    }
+    fstream.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "CpuImage.h"
+
+#include <string>
+#include <vector>
+
+namespace CS570
+{
+    enum class Connectivity
+    {
+        // Left, right, up and down neighbors.
+        Four,
+        // The diagonal neighbors as well.
+        Eight,
+    };
+
+    // The object class of an 8 bit red value, the position of its highest set bit: pixels whose red
+    // values have the same highest set bit belong to the same object and 0 is the background.
+    uint8_t GetComponentClassKey(uint8_t red);
+
+    // Class key of every pixel of an 8 bit image whose pixels are pixelStride bytes apart, red first.
+    void ComputeComponentClassKeys(const uint8_t* pPixels, size_t pixelCount, uint32_t pixelStride, uint8_t* pKeys);
+    // Class key of every pixel of the red channel, quantized as WritePPM does, and if pReds is not
+    // null the quantized red values themselves, to serve as intensities.
+    void ComputeComponentClassKeys(const CpuImage& image, std::vector<uint8_t>* pKeys, std::vector<uint8_t>* pReds = nullptr);
+
+    // Per component statistics of a labeling, label being the component's label.
+    struct ComponentStats
+    {
+        uint32_t label;
+        uint32_t classKey;
+        uint64_t area;
+        uint32_t minX;
+        uint32_t minY;
+        uint32_t maxX;
+        uint32_t maxY;
+        float centroidX;
+        float centroidY;
+        float meanIntensity;
+    };
+
+    // Connected component labeling of a class key image: neighboring pixels with the same non-zero
+    // key get the same label. Labels count from 1 in raster order of the first pixel of every
+    // component, the order the BFS labeler of WriteConnectedComponentImage used, and 0 is the
+    // background.
+    //
+    // Two scans over a flat label buffer. The first gives every pixel a provisional label from its
+    // already visited neighbors, using the SAUF decision tree so most pixels test a single neighbor,
+    // and records equivalences in a union-find array whose parents always have smaller labels. The
+    // second resolves every provisional label to its root and numbers the roots consecutively.
+    //
+    // The first scan runs on horizontal strips in parallel, each strip with its own provisional
+    // labels. The strips' union-find arrays are then concatenated in strip order and the labels
+    // across every seam merged, in log2(strips) rounds whose merges touch disjoint groups of strips
+    // so they run in parallel too. Provisional labels stay in raster order, so the result is the
+    // same as a single strip's.
+    //
+    // With statistics on, the first scan also adds every pixel to the area, bounding box, coordinate
+    // sums and intensity sum of its provisional label. Every strip keeps these per label of its own,
+    // so the workers share nothing, and after the labels are resolved the strips' sums are added up
+    // under the final labels.
+    class CpuConnectedComponents
+    {
+    public:
+        // pClassKeys holds width x height keys and must stay alive until Execute returns.
+        void OnCreate(const uint8_t* pClassKeys, uint32_t width, uint32_t height, Connectivity connectivity = Connectivity::Four);
+        void OnDestroy();
+
+        void Execute();
+
+        uint32_t GetWidth() const { return m_width; }
+        uint32_t GetHeight() const { return m_height; }
+        uint32_t GetComponentCount() const { return m_componentCount; }
+
+        // Row major, width x height labels.
+        const std::vector<uint32_t>& GetLabels() const { return m_labels; }
+
+        // Strips of the first scan are never shorter than this, so small images stay in one strip.
+        void SetMinStripHeight(uint32_t rows) { m_minStripHeight = rows > 0 ? rows : 1u; }
+
+        static const uint32_t k_defaultMinStripHeight = 64;
+
+        // Makes Execute gather ComponentStats. pIntensities, if not null, holds an 8 bit intensity for
+        // every pixel, intensityStride bytes apart, and must stay alive until Execute returns.
+        void SetComponentStats(bool enabled, const uint8_t* pIntensities = nullptr, uint32_t intensityStride = 1);
+        // One entry per component, in label order. Empty unless statistics are on.
+        const std::vector<ComponentStats>& GetComponentStats() const { return m_componentStats; }
+
+    private:
+        void MergeSeam(uint32_t strip);
+
+        const uint8_t* m_pClassKeys = nullptr;
+        uint32_t m_width = 0u;
+        uint32_t m_height = 0u;
+        Connectivity m_connectivity = Connectivity::Four;
+        uint32_t m_minStripHeight = k_defaultMinStripHeight;
+        bool m_computeStats = false;
+        const uint8_t* m_pIntensities = nullptr;
+        uint32_t m_intensityStride = 1u;
+
+        std::vector<uint32_t> m_labels;
+        std::vector<uint32_t> m_parents;
+        // First row and first global provisional label of every strip, plus an end entry.
+        std::vector<uint32_t> m_stripRows;
+        std::vector<uint32_t> m_stripLabels;
+        uint32_t m_componentCount = 0u;
+        std::vector<ComponentStats> m_componentStats;
+    };
+
+    // Writes a label image as a P6 ppm, every label colored from a small fixed palette with the
+    // background black.
+    void WriteLabelPPM(const std::string& imageFile, const uint32_t* pLabels, uint32_t width, uint32_t height);
+
+    // Writes component statistics as a table, a CSV file with a header row if the file name ends in
+    // .csv, otherwise binary: the bytes "CCS1", a uint32_t count and the ComponentStats records packed
+    // field by field in the machine's byte order, 44 bytes each.
+    void WriteComponentStats(const std::string& file, const std::vector<ComponentStats>& stats);
+}
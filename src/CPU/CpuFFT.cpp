@@ -0,0 +1,300 @@
+#include "CpuFFT.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+using namespace CS570;
+
+static const double k_pi = 3.14159265358979323846;
+
+// Stockham stages exist for these radices. Sizes with any other prime factor use Bluestein.
+static const uint32_t k_oddRadices[] = { 3, 5, 7 };
+
+static bool HasOnlyStageFactors(uint32_t value)
+{
+    while (value % 2 == 0)
+        value /= 2;
+    for (uint32_t radix : k_oddRadices)
+    {
+        while (value % radix == 0)
+            value /= radix;
+    }
+    return value == 1;
+}
+
+static Complex UnitRoot(double angle)
+{
+    return Complex(static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)));
+}
+
+void CpuFFT::OnCreate(uint32_t size)
+{
+    assert(size > 0);
+    m_size = size;
+
+    if (HasOnlyStageFactors(size))
+    {
+        CreateStages();
+        return;
+    }
+
+    uint32_t paddedSize = 1;
+    while (paddedSize < 2 * size - 1)
+        paddedSize <<= 1;
+
+    m_pPaddedFFT.reset(new CpuFFT());
+    m_pPaddedFFT->OnCreate(paddedSize);
+
+    // n^2 is taken modulo 2N so the angle stays small enough for exact float twiddles.
+    m_chirp.resize(size);
+    for (uint32_t n = 0; n < size; ++n)
+    {
+        uint64_t nSquared = (uint64_t(n) * n) % (2 * uint64_t(size));
+        m_chirp[n] = UnitRoot(-k_pi * static_cast<double>(nSquared) / size);
+    }
+
+    m_chirpFilter.assign(paddedSize, Complex(0.0f, 0.0f));
+    m_chirpFilter[0] = Conjugate(m_chirp[0]);
+    for (uint32_t n = 1; n < size; ++n)
+    {
+        m_chirpFilter[n] = Conjugate(m_chirp[n]);
+        m_chirpFilter[paddedSize - n] = Conjugate(m_chirp[n]);
+    }
+
+    std::vector<Complex> scratch(m_pPaddedFFT->GetScratchSize());
+    m_pPaddedFFT->Transform(m_chirpFilter.data(), scratch.data());
+
+    // Fold the 1 / M of the inverse transform into the filter.
+    const float inversePaddedSize = 1.0f / static_cast<float>(paddedSize);
+    for (auto& value : m_chirpFilter)
+        value = value * inversePaddedSize;
+}
+
+void CpuFFT::OnDestroy()
+{
+    m_size = 0u;
+    m_stages.clear();
+    m_twiddles.clear();
+    m_pPaddedFFT.reset();
+    m_chirp.clear();
+    m_chirpFilter.clear();
+}
+
+void CpuFFT::CreateStages()
+{
+    uint32_t length = m_size;
+    uint32_t stride = 1;
+    while (length > 1)
+    {
+        uint32_t radix = (length % 8 == 0) ? 8 : (length % 4 == 0) ? 4 : (length % 2 == 0) ? 2 : 0;
+        for (uint32_t oddRadix : k_oddRadices)
+        {
+            if (radix == 0 && length % oddRadix == 0)
+                radix = oddRadix;
+        }
+
+        Stage stage;
+        stage.radix = radix;
+        stage.length = length;
+        stage.stride = stride;
+        stage.twiddleOffset = m_twiddles.size();
+        m_stages.push_back(stage);
+
+        const uint32_t subLength = length / radix;
+        for (uint32_t p = 0; p < subLength; ++p)
+        {
+            for (uint32_t k = 1; k < radix; ++k)
+                m_twiddles.push_back(UnitRoot(-2.0 * k_pi * static_cast<double>(uint64_t(p) * k) / length));
+        }
+
+        length = subLength;
+        stride *= radix;
+    }
+}
+
+size_t CpuFFT::GetScratchSize() const
+{
+    if (m_pPaddedFFT)
+        return size_t(m_pPaddedFFT->GetSize()) + m_pPaddedFFT->GetScratchSize();
+    return m_size;
+}
+
+void CpuFFT::Transform(Complex* pData, Complex* pScratch) const
+{
+    if (m_pPaddedFFT)
+        TransformBluestein(pData, pScratch);
+    else
+        TransformStockham(pData, pScratch);
+}
+
+// Multiplies by -i.
+static Complex MulMinusI(Complex a)
+{
+    return Complex(a.im, -a.re);
+}
+
+static void Radix2Stage(uint32_t subLength, uint32_t stride, const Complex* pTwiddles, const Complex* x, Complex* y)
+{
+    const size_t m = subLength;
+    const size_t s = stride;
+    for (size_t p = 0; p < m; ++p)
+    {
+        const Complex w1 = pTwiddles[p];
+        for (size_t q = 0; q < s; ++q)
+        {
+            const Complex a = x[q + s * p];
+            const Complex b = x[q + s * (p + m)];
+            y[q + s * (2 * p + 0)] = a + b;
+            y[q + s * (2 * p + 1)] = (a - b) * w1;
+        }
+    }
+}
+
+static void Radix4Stage(uint32_t subLength, uint32_t stride, const Complex* pTwiddles, const Complex* x, Complex* y)
+{
+    const size_t m = subLength;
+    const size_t s = stride;
+    for (size_t p = 0; p < m; ++p)
+    {
+        const Complex w1 = pTwiddles[3 * p + 0];
+        const Complex w2 = pTwiddles[3 * p + 1];
+        const Complex w3 = pTwiddles[3 * p + 2];
+        for (size_t q = 0; q < s; ++q)
+        {
+            const Complex a = x[q + s * (p + 0 * m)];
+            const Complex b = x[q + s * (p + 1 * m)];
+            const Complex c = x[q + s * (p + 2 * m)];
+            const Complex d = x[q + s * (p + 3 * m)];
+            const Complex apc = a + c;
+            const Complex amc = a - c;
+            const Complex bpd = b + d;
+            const Complex mjbmd = MulMinusI(b - d);
+            y[q + s * (4 * p + 0)] = apc + bpd;
+            y[q + s * (4 * p + 1)] = (amc + mjbmd) * w1;
+            y[q + s * (4 * p + 2)] = (apc - bpd) * w2;
+            y[q + s * (4 * p + 3)] = (amc - mjbmd) * w3;
+        }
+    }
+}
+
+static void Radix8Stage(uint32_t subLength, uint32_t stride, const Complex* pTwiddles, const Complex* x, Complex* y)
+{
+    const float invSqrt2 = 0.70710678118654752f;
+    const size_t m = subLength;
+    const size_t s = stride;
+    for (size_t p = 0; p < m; ++p)
+    {
+        const Complex* pW = pTwiddles + 7 * p;
+        for (size_t q = 0; q < s; ++q)
+        {
+            Complex v[8];
+            for (size_t j = 0; j < 8; ++j)
+                v[j] = x[q + s * (p + j * m)];
+
+            // 4 point DFTs of the even and odd inputs.
+            const Complex e02p = v[0] + v[4], e02m = v[0] - v[4];
+            const Complex e13p = v[2] + v[6], e13m = MulMinusI(v[2] - v[6]);
+            const Complex e0 = e02p + e13p, e1 = e02m + e13m, e2 = e02p - e13p, e3 = e02m - e13m;
+
+            const Complex o02p = v[1] + v[5], o02m = v[1] - v[5];
+            const Complex o13p = v[3] + v[7], o13m = MulMinusI(v[3] - v[7]);
+            const Complex o0 = o02p + o13p, o1 = o02m + o13m, o2 = o02p - o13p, o3 = o02m - o13m;
+
+            // W8^k * O[k]
+            const Complex t1 = Complex((o1.re + o1.im) * invSqrt2, (o1.im - o1.re) * invSqrt2);
+            const Complex t2 = MulMinusI(o2);
+            const Complex t3 = Complex((o3.im - o3.re) * invSqrt2, -(o3.re + o3.im) * invSqrt2);
+
+            Complex* pOut = y + q + s * 8 * p;
+            pOut[0] = e0 + o0;
+            pOut[s * 1] = (e1 + t1) * pW[0];
+            pOut[s * 2] = (e2 + t2) * pW[1];
+            pOut[s * 3] = (e3 + t3) * pW[2];
+            pOut[s * 4] = (e0 - o0) * pW[3];
+            pOut[s * 5] = (e1 - t1) * pW[4];
+            pOut[s * 6] = (e2 - t2) * pW[5];
+            pOut[s * 7] = (e3 - t3) * pW[6];
+        }
+    }
+}
+
+// Direct radix-point DFT for the odd radices, which are rare enough not to need hand written butterflies.
+static void OddRadixStage(uint32_t radix, uint32_t subLength, uint32_t stride, const Complex* pTwiddles, const Complex* x, Complex* y)
+{
+    Complex roots[8];
+    for (uint32_t k = 0; k < radix; ++k)
+        roots[k] = UnitRoot(-2.0 * k_pi * k / radix);
+
+    const size_t m = subLength;
+    const size_t s = stride;
+    for (size_t p = 0; p < m; ++p)
+    {
+        const Complex* pW = pTwiddles + (radix - 1) * p;
+        for (size_t q = 0; q < s; ++q)
+        {
+            Complex v[8];
+            for (size_t j = 0; j < radix; ++j)
+                v[j] = x[q + s * (p + j * m)];
+
+            Complex* pOut = y + q + s * radix * p;
+            for (uint32_t k = 0; k < radix; ++k)
+            {
+                Complex sum = v[0];
+                for (uint32_t j = 1; j < radix; ++j)
+                    sum = sum + v[j] * roots[(j * k) % radix];
+                pOut[s * k] = k == 0 ? sum : sum * pW[k - 1];
+            }
+        }
+    }
+}
+
+void CpuFFT::TransformStockham(Complex* pData, Complex* pScratch) const
+{
+    const Complex* pInput = pData;
+    Complex* pOutput = pScratch;
+    for (const auto& stage : m_stages)
+    {
+        const uint32_t subLength = stage.length / stage.radix;
+        const Complex* pTwiddles = m_twiddles.data() + stage.twiddleOffset;
+        if (stage.radix == 8)
+            Radix8Stage(subLength, stage.stride, pTwiddles, pInput, pOutput);
+        else if (stage.radix == 4)
+            Radix4Stage(subLength, stage.stride, pTwiddles, pInput, pOutput);
+        else if (stage.radix == 2)
+            Radix2Stage(subLength, stage.stride, pTwiddles, pInput, pOutput);
+        else
+            OddRadixStage(stage.radix, subLength, stage.stride, pTwiddles, pInput, pOutput);
+
+        // Stockham stages ping-pong between the two buffers.
+        Complex* pNextOutput = const_cast<Complex*>(pInput);
+        pInput = pOutput;
+        pOutput = pNextOutput;
+    }
+
+    if (pInput != pData)
+        std::memcpy(pData, pInput, sizeof(Complex) * m_size);
+}
+
+void CpuFFT::TransformBluestein(Complex* pData, Complex* pScratch) const
+{
+    const uint32_t paddedSize = m_pPaddedFFT->GetSize();
+    Complex* pPadded = pScratch;
+    Complex* pPaddedScratch = pScratch + paddedSize;
+
+    for (uint32_t n = 0; n < m_size; ++n)
+        pPadded[n] = pData[n] * m_chirp[n];
+    for (uint32_t n = m_size; n < paddedSize; ++n)
+        pPadded[n] = Complex(0.0f, 0.0f);
+
+    m_pPaddedFFT->Transform(pPadded, pPaddedScratch);
+
+    // Convolve with the chirp filter, then inverse transform as conj(FFT(conj(x))).
+    for (uint32_t k = 0; k < paddedSize; ++k)
+        pPadded[k] = Conjugate(pPadded[k] * m_chirpFilter[k]);
+
+    m_pPaddedFFT->Transform(pPadded, pPaddedScratch);
+
+    for (uint32_t k = 0; k < m_size; ++k)
+        pData[k] = Conjugate(pPadded[k]) * m_chirp[k];
+}
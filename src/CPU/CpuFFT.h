@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace CS570
+{
+    // Plain complex value. std::complex<float> multiplication checks for NaN/inf on most compilers,
+    // which keeps the butterflies from inlining.
+    struct Complex
+    {
+        float re;
+        float im;
+
+        Complex() {}
+        Complex(float real, float imaginary) : re(real), im(imaginary) {}
+
+        friend Complex operator+(Complex a, Complex b) { return Complex(a.re + b.re, a.im + b.im); }
+        friend Complex operator-(Complex a, Complex b) { return Complex(a.re - b.re, a.im - b.im); }
+        friend Complex operator*(Complex a, Complex b) { return Complex(a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re); }
+        friend Complex operator*(Complex a, float b) { return Complex(a.re * b, a.im * b); }
+    };
+
+    inline Complex Conjugate(Complex a) { return Complex(a.re, -a.im); }
+
+    // Forward 1D FFT plan, X[k] = sum x[n] e^(-2 PI i k n / N), for any size N. Sizes made of the
+    // factors 2, 3, 5 and 7 (which covers the common image sizes, e.g. 3840 and 2160) run a Stockham
+    // autosort FFT built from radix-8/4/2 butterflies plus small odd radix stages, with per-stage
+    // twiddle tables. Any other size goes through Bluestein's algorithm on top of a power of two
+    // plan. The plan is immutable after OnCreate, so one plan can be shared by every thread.
+    class CpuFFT
+    {
+    public:
+        void OnCreate(uint32_t size);
+        void OnDestroy();
+
+        uint32_t GetSize() const { return m_size; }
+
+        // Number of Complex values Transform needs in pScratch.
+        size_t GetScratchSize() const;
+
+        // Transforms pData in place.
+        void Transform(Complex* pData, Complex* pScratch) const;
+
+    private:
+        struct Stage
+        {
+            uint32_t radix;
+            uint32_t length;  // n, the sub-transform length this stage splits
+            uint32_t stride;  // s, the number of interleaved sub-transforms
+            size_t twiddleOffset;
+        };
+
+        void CreateStages();
+        void TransformStockham(Complex* pData, Complex* pScratch) const;
+        void TransformBluestein(Complex* pData, Complex* pScratch) const;
+
+        uint32_t m_size = 0u;
+
+        std::vector<Stage> m_stages;
+        // For each stage and each p < length / radix, W_n^(k p) for k in [1, radix).
+        std::vector<Complex> m_twiddles;
+
+        // Bluestein: e^(-PI i n^2 / N), and the FFT of the conjugate chirp zero padded to the power of
+        // two size of m_pPaddedFFT.
+        std::unique_ptr<CpuFFT> m_pPaddedFFT;
+        std::vector<Complex> m_chirp;
+        std::vector<Complex> m_chirpFilter;
+    };
+}
@@ -0,0 +1,149 @@
+#include "CpuFourierTransform.h"
+
+#include "CpuParallel.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace CS570;
+
+// Multiplying by (-1)^x shifts the spectrum by half its size. For even sizes that is exactly a
+// rotation of the output indices, so the multiply is replaced by writing F(u) at (u + N/2) mod N.
+// Odd sizes would need a half texel shift, so those keep the sign flip on the input.
+static bool CenterByRemap(uint32_t size)
+{
+    return (size & 1) == 0;
+}
+
+void CpuFourierTransform::OnCreate(const CpuImage& input)
+{
+    m_pInput = &input;
+
+    m_rowFFT.OnCreate(input.GetWidth());
+    m_columnFFT.OnCreate(input.GetHeight());
+
+    m_fOfUy.resize(input.GetPixelCount());
+    m_fOfUv.Resize(input.GetWidth(), input.GetHeight());
+}
+
+void CpuFourierTransform::OnDestroy()
+{
+    m_rowFFT.OnDestroy();
+    m_columnFFT.OnDestroy();
+    std::vector<Complex>().swap(m_fOfUy);
+    m_fOfUv.Release();
+    m_pInput = nullptr;
+}
+
+void CpuFourierTransform::Execute()
+{
+    assert(m_pInput != nullptr);
+
+    RowPass();
+    ColumnPass();
+}
+
+void CpuFourierTransform::RowPass()
+{
+    const CpuImage& input = *m_pInput;
+    const uint32_t width = input.GetWidth();
+    const uint32_t height = input.GetHeight();
+    const bool flipColumns = !CenterByRemap(width);
+    const bool flipRows = !CenterByRemap(height);
+
+    // The input is real, so two rows are transformed at once as row0 + i * row1 and separated
+    // afterwards using the conjugate symmetry of real spectra.
+    const size_t rowPairCount = (height + 1) / 2;
+    ParallelFor(0, rowPairCount, 8, [&](size_t pairBegin, size_t pairEnd) {
+        std::vector<Complex> packed(width);
+        std::vector<Complex> scratch(m_rowFFT.GetScratchSize());
+        std::vector<float> reds0(width);
+        std::vector<float> reds1(width);
+        for (size_t pair = pairBegin; pair < pairEnd; ++pair)
+        {
+            const uint32_t y0 = static_cast<uint32_t>(pair * 2);
+            const uint32_t y1 = y0 + 1;
+            const bool hasSecondRow = y1 < height;
+            LoadRedRow(input, y0, reds0.data());
+            if (hasSecondRow)
+                LoadRedRow(input, y1, reds1.data());
+            const float rowSign = (flipRows && (y0 & 1)) ? -1.0f : 1.0f;
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                float sign = (flipColumns && (x & 1)) ? -rowSign : rowSign;
+                float value0 = reds0[x] * sign;
+                // y1 = y0 + 1, so its row sign is the opposite one.
+                float value1 = hasSecondRow ? reds1[x] * (flipRows ? -sign : sign) : 0.0f;
+                packed[x] = Complex(value0, value1);
+            }
+
+            m_rowFFT.Transform(packed.data(), scratch.data());
+
+            Complex* pOutput0 = m_fOfUy.data() + size_t(y0) * width;
+            Complex* pOutput1 = hasSecondRow ? pOutput0 + width : nullptr;
+            for (uint32_t u = 0; u < width; ++u)
+            {
+                const Complex z = packed[u];
+                const Complex zMirror = Conjugate(packed[u == 0 ? 0 : width - u]);
+                pOutput0[u] = (z + zMirror) * 0.5f;
+                if (hasSecondRow)
+                {
+                    // (z - zMirror) / 2i
+                    const Complex difference = z - zMirror;
+                    pOutput1[u] = Complex(difference.im * 0.5f, -difference.re * 0.5f);
+                }
+            }
+        }
+    });
+}
+
+void CpuFourierTransform::ColumnPass()
+{
+    const uint32_t width = m_fOfUv.GetWidth();
+    const uint32_t height = m_fOfUv.GetHeight();
+    const uint32_t columnShift = CenterByRemap(width) ? width / 2 : 0;
+    const uint32_t rowShift = CenterByRemap(height) ? height / 2 : 0;
+
+    // Columns are gathered in blocks so every row read touches whole cache lines.
+    const uint32_t k_blockWidth = 8;
+    const size_t blockCount = (width + k_blockWidth - 1) / k_blockWidth;
+    ParallelFor(0, blockCount, 1, [&](size_t blockBegin, size_t blockEnd) {
+        std::vector<Complex> columns(size_t(k_blockWidth) * height);
+        std::vector<Complex> scratch(m_columnFFT.GetScratchSize());
+        for (size_t block = blockBegin; block < blockEnd; ++block)
+        {
+            const uint32_t u0 = static_cast<uint32_t>(block * k_blockWidth);
+            const uint32_t blockWidth = std::min(k_blockWidth, width - u0);
+
+            for (uint32_t y = 0; y < height; ++y)
+            {
+                const Complex* pRow = m_fOfUy.data() + size_t(y) * width + u0;
+                for (uint32_t column = 0; column < blockWidth; ++column)
+                    columns[size_t(column) * height + y] = pRow[column];
+            }
+
+            for (uint32_t column = 0; column < blockWidth; ++column)
+                m_columnFFT.Transform(columns.data() + size_t(column) * height, scratch.data());
+
+            for (uint32_t v = 0; v < height; ++v)
+            {
+                uint32_t outputRow = v + rowShift;
+                if (outputRow >= height)
+                    outputRow -= height;
+                float* pOutputRow = m_fOfUv.GetRow(outputRow);
+                for (uint32_t column = 0; column < blockWidth; ++column)
+                {
+                    uint32_t outputColumn = u0 + column + columnShift;
+                    if (outputColumn >= width)
+                        outputColumn -= width;
+                    const Complex value = columns[size_t(column) * height + v];
+                    float* pOutput = pOutputRow + size_t(outputColumn) * CpuImage::k_channelCount;
+                    pOutput[0] = value.re;
+                    pOutput[1] = value.im;
+                    pOutput[2] = 0.0f;
+                    pOutput[3] = 1.0f;
+                }
+            }
+        }
+    });
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "CpuFFT.h"
+#include "CpuImageProcessor.h"
+
+#include <vector>
+
+namespace CS570
+{
+    // CPU version of FourierTransform.hlsl. Computes the centered spectrum
+    // F(u,v) = sum f(x,y) (-1)^(x+y) e^(-2 PI i (ux/W + vy/H)) of the red channel with a row-column
+    // FFT and stores it as (real, imaginary, 0, 1).
+    class CpuFourierTransform : public BaseCpuImageProcessor
+    {
+    public:
+        void OnCreate(const CpuImage& input);
+        void OnDestroy();
+
+        void Execute() override;
+
+        CpuImage& GetOutputImage() override { return m_fOfUv; }
+
+    private:
+        void RowPass();
+        void ColumnPass();
+
+        const CpuImage* m_pInput = nullptr;
+
+        CpuFFT m_rowFFT;
+        CpuFFT m_columnFFT;
+
+        // Row transforms F(u,y), one row of W complex values per image row.
+        std::vector<Complex> m_fOfUy;
+
+        CpuImage m_fOfUv;
+    };
+}
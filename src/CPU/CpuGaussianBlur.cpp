@@ -0,0 +1,221 @@
+#include "CpuGaussianBlur.h"
+
+#include "CpuParallel.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace CS570;
+
+void CS570::ComputeGaussianWeights(uint32_t blurKernelSize, float blurKernelVariance, std::vector<float>* pWeights)
+{
+    const float sigmaSquared = blurKernelVariance * blurKernelVariance;
+    const float powerDenominator = 0.5f / sigmaSquared;
+    const int center = static_cast<int>(blurKernelSize >> 1);
+
+    pWeights->resize(size_t(blurKernelSize) * blurKernelSize);
+    for (uint32_t row = 0; row < blurKernelSize; ++row)
+    {
+        for (uint32_t col = 0; col < blurKernelSize; ++col)
+        {
+            float x = static_cast<float>(static_cast<int>(col) - center);
+            float y = static_cast<float>(static_cast<int>(row) - center);
+            (*pWeights)[size_t(row) * blurKernelSize + col] = std::exp(-(x * x + y * y) * powerDenominator);
+        }
+    }
+}
+
+void CS570::ComputeNormalizedGaussianWeights1D(uint32_t blurKernelSize, float blurKernelVariance, std::vector<float>* pWeights)
+{
+    const float sigmaSquared = blurKernelVariance * blurKernelVariance;
+    const float powerDenominator = 0.5f / sigmaSquared;
+    const int center = static_cast<int>(blurKernelSize >> 1);
+
+    pWeights->resize(blurKernelSize);
+    float weightsSum = 0.0f;
+    for (uint32_t i = 0; i < blurKernelSize; ++i)
+    {
+        float x = static_cast<float>(static_cast<int>(i) - center);
+        (*pWeights)[i] = std::exp(-(x * x) * powerDenominator);
+        weightsSum += (*pWeights)[i];
+    }
+
+    const float normalizationFactor = 1.0f / weightsSum;
+    for (float& weight : *pWeights)
+        weight *= normalizationFactor;
+}
+
+GaussianBlurAlgorithm CS570::ResolveGaussianBlurAlgorithm(
+    GaussianBlurAlgorithm algorithm, uint32_t blurKernelSize, float blurKernelVariance)
+{
+    if (algorithm != GaussianBlurAlgorithm::Auto)
+        return algorithm;
+
+    const float sigma = std::fabs(blurKernelVariance);
+    if (sigma >= k_recursiveGaussianSigmaThreshold && static_cast<float>(blurKernelSize >> 1) >= 2.0f * sigma)
+        return GaussianBlurAlgorithm::Recursive;
+
+    return GaussianBlurAlgorithm::Separable;
+}
+
+void CpuGaussianBlur::OnCreate(
+    const CpuImage& input,
+    uint32_t blurKernelSize,
+    float blurKernelVariance)
+{
+    m_pInput = &input;
+    m_kernelSize = blurKernelSize;
+    m_variance = blurKernelVariance;
+
+    // Only red is blurred, so the output is a single grey plane.
+    m_blurredOutput.Resize(input.GetWidth(), input.GetHeight(), CpuPixelFormat::R32F);
+}
+
+void CpuGaussianBlur::OnDestroy()
+{
+    m_blurredOutput.Release();
+    m_pWeights.reset();
+    std::vector<float>().swap(m_paddedInput);
+    std::vector<float>().swap(m_horizontalPass);
+    m_pInput = nullptr;
+}
+
+void CpuGaussianBlur::Execute()
+{
+    assert(m_pInput != nullptr);
+
+    switch (ResolveGaussianBlurAlgorithm(m_algorithm, m_kernelSize, m_variance))
+    {
+    case GaussianBlurAlgorithm::Direct:
+        Blur2D();
+        break;
+    case GaussianBlurAlgorithm::Recursive:
+        BlurRecursive();
+        break;
+    default:
+        BlurSeparable();
+        break;
+    }
+}
+
+void CpuGaussianBlur::BlurRecursive()
+{
+    if (m_recursiveVariance != m_variance)
+    {
+        ComputeRecursiveGaussianCoefficients(std::fabs(m_variance), &m_recursiveCoefficients);
+        m_recursiveVariance = m_variance;
+    }
+    const RecursiveGaussianCoefficients& coefficients = m_recursiveCoefficients;
+
+    const uint32_t width = m_blurredOutput.GetWidth();
+    const uint32_t height = m_blurredOutput.GetHeight();
+    const CpuImage& input = *m_pInput;
+
+    // Filtered in place in the output plane.
+    float* pPlane = m_blurredOutput.GetRowSamples<float>(0);
+
+    ParallelFor(0, height, 16, [&](size_t rowBegin, size_t rowEnd) {
+        for (size_t y = rowBegin; y < rowEnd; ++y)
+        {
+            float* pRow = pPlane + y * width;
+            LoadRedRow(input, static_cast<uint32_t>(y), pRow);
+            RecursiveGaussianFilterRow(coefficients, pRow, pRow, width);
+        }
+    });
+
+    // Blocks of columns are filtered a row at a time, so every pass streams through memory.
+    ParallelFor(0, width, 64, [&](size_t columnBegin, size_t columnEnd) {
+        RecursiveGaussianFilterColumns(coefficients, pPlane, width, height, columnBegin, columnEnd);
+    });
+}
+
+void CpuGaussianBlur::BlurSeparable()
+{
+    m_pWeights = GetGaussianKernel(m_kernelSize, m_variance, true, GaussianKernelShape::Separable);
+
+    const uint32_t halfSize = m_kernelSize >> 1;
+    const uint32_t width = m_blurredOutput.GetWidth();
+    const uint32_t height = m_blurredOutput.GetHeight();
+    const uint32_t kernelSize = m_kernelSize;
+    const float* pWeights = m_pWeights->data();
+    const CpuImage& input = *m_pInput;
+
+    // The vertical pass gets its out of bounds zeros from the border rows of m_horizontalPass.
+    m_horizontalPass.resize(size_t(width) * (height + 2 * halfSize));
+    std::fill(m_horizontalPass.begin(), m_horizontalPass.begin() + size_t(width) * halfSize, 0.0f);
+    std::fill(m_horizontalPass.end() - size_t(width) * halfSize, m_horizontalPass.end(), 0.0f);
+    float* pHorizontalPass = m_horizontalPass.data();
+
+    ParallelFor(0, height, 16, [&](size_t rowBegin, size_t rowEnd) {
+        // Red channel of one row with halfSize zeros on either side.
+        std::vector<float> paddedRow(size_t(width) + 2 * halfSize, 0.0f);
+        for (size_t y = rowBegin; y < rowEnd; ++y)
+        {
+            LoadRedRow(input, static_cast<uint32_t>(y), paddedRow.data() + halfSize);
+
+            const float* pSrc = paddedRow.data();
+            float* pDst = pHorizontalPass + (y + halfSize) * width;
+            for (uint32_t x = 0; x < width; ++x)
+                pDst[x] = pSrc[x] * pWeights[0];
+            for (uint32_t col = 1; col < kernelSize; ++col)
+            {
+                const float weight = pWeights[col];
+                for (uint32_t x = 0; x < width; ++x)
+                    pDst[x] += pSrc[x + col] * weight;
+            }
+        }
+    });
+
+    // Each output row accumulates kernelSize neighboring rows, which stay in cache across the
+    // rows of a chunk, so no transpose is needed for the vertical pass.
+    ParallelFor(0, height, 16, [&](size_t rowBegin, size_t rowEnd) {
+        for (size_t y = rowBegin; y < rowEnd; ++y)
+        {
+            float* pBlurredRow = m_blurredOutput.GetRowSamples<float>(static_cast<uint32_t>(y));
+            std::fill(pBlurredRow, pBlurredRow + width, 0.0f);
+            for (uint32_t row = 0; row < kernelSize; ++row)
+            {
+                const float weight = pWeights[row];
+                const float* pSrc = pHorizontalPass + (y + row) * width;
+                for (uint32_t x = 0; x < width; ++x)
+                    pBlurredRow[x] += pSrc[x] * weight;
+            }
+        }
+    });
+}
+
+void CpuGaussianBlur::Blur2D()
+{
+    m_pWeights = GetGaussianKernel(m_kernelSize, m_variance, true, GaussianKernelShape::Square);
+
+    const uint32_t halfSize = m_kernelSize >> 1;
+    ExtractPaddedRed(*m_pInput, halfSize, &m_paddedInput);
+
+    const uint32_t width = m_blurredOutput.GetWidth();
+    const uint32_t height = m_blurredOutput.GetHeight();
+    const size_t planePitch = size_t(width) + 2 * halfSize;
+    const uint32_t kernelSize = m_kernelSize;
+    const float* pWeights = m_pWeights->data();
+    const float* pPlane = m_paddedInput.data();
+
+    ParallelFor(0, height, 8, [&](size_t rowBegin, size_t rowEnd) {
+        for (size_t y = rowBegin; y < rowEnd; ++y)
+        {
+            float* pBlurredRow = m_blurredOutput.GetRowSamples<float>(static_cast<uint32_t>(y));
+            std::fill(pBlurredRow, pBlurredRow + width, 0.0f);
+            // Tap-major order keeps the inner loop a contiguous multiply-add over the row.
+            for (uint32_t row = 0; row < kernelSize; ++row)
+            {
+                const float* pTapRow = pPlane + (y + row) * planePitch;
+                for (uint32_t col = 0; col < kernelSize; ++col)
+                {
+                    const float weight = pWeights[size_t(row) * kernelSize + col];
+                    const float* pSrc = pTapRow + col;
+                    for (uint32_t x = 0; x < width; ++x)
+                        pBlurredRow[x] += pSrc[x] * weight;
+                }
+            }
+        }
+    });
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "CpuGaussianKernelCache.h"
+#include "CpuImageProcessor.h"
+#include "CpuRecursiveGaussian.h"
+
+#include <vector>
+
+namespace CS570
+{
+    // Equivalent of ComputeGaussianWeights.hlsl: fills a blurKernelSize x blurKernelSize grid of
+    // unnormalized weights exp(-(x^2 + y^2) / (2 * variance^2)) centered on blurKernelSize >> 1.
+    void ComputeGaussianWeights(uint32_t blurKernelSize, float blurKernelVariance, std::vector<float>* pWeights);
+
+    // One axis of the same kernel, normalized to sum to one. The 2D kernel is the outer product of
+    // this with itself, so blurring rows then columns with it matches the normalized 2D blur.
+    void ComputeNormalizedGaussianWeights1D(uint32_t blurKernelSize, float blurKernelVariance, std::vector<float>* pWeights);
+
+    enum class GaussianBlurAlgorithm
+    {
+        Auto,
+        // blurKernelSize x blurKernelSize gather, O(k^2) per pixel.
+        Direct,
+        // Horizontal then vertical 1D pass, O(k) per pixel.
+        Separable,
+        // Young - van Vliet IIR approximation (see CpuRecursiveGaussian.h), O(1) per pixel. It
+        // approximates the untruncated Gaussian, so blurKernelSize is ignored.
+        Recursive
+    };
+
+    // Auto picks Recursive once sigma reaches k_recursiveGaussianSigmaThreshold and the kernel is wide
+    // enough (at least 2 sigma per side) that truncating it doesn't change the filter much;
+    // otherwise Separable. Any other algorithm is returned as is.
+    GaussianBlurAlgorithm ResolveGaussianBlurAlgorithm(
+        GaussianBlurAlgorithm algorithm, uint32_t blurKernelSize, float blurKernelVariance);
+
+    class CpuGaussianBlur : public BaseCpuImageProcessor
+    {
+    public:
+        void OnCreate(
+            const CpuImage& input,
+            uint32_t blurKernelSize,
+            float blurKernelVariance);
+        void OnDestroy();
+
+        void Execute() override;
+
+        CpuImage& GetOutputImage() override { return m_blurredOutput; }
+
+        void SetVariance(float variance) { m_variance = variance; }
+
+        void SetAlgorithm(GaussianBlurAlgorithm algorithm) { m_algorithm = algorithm; }
+        GaussianBlurAlgorithm GetAlgorithm() const { return m_algorithm; }
+
+    private:
+        void Blur2D();
+        void BlurSeparable();
+        void BlurRecursive();
+
+        const CpuImage* m_pInput = nullptr;
+
+        uint32_t m_kernelSize = 3u;
+        float m_variance = 1.0f;
+        GaussianBlurAlgorithm m_algorithm = GaussianBlurAlgorithm::Auto;
+
+        // Fetched from the kernel cache each Execute, so it tracks SetVariance without rebuilding.
+        GaussianKernelPtr m_pWeights;
+        // Recomputed only when the variance changes.
+        RecursiveGaussianCoefficients m_recursiveCoefficients = {};
+        float m_recursiveVariance = -1.0f;
+        std::vector<float> m_paddedInput;
+        // Horizontal pass output of the separable blur, with kernelSize / 2 zero rows above and
+        // below. The recursive blur doesn't use it; it filters in place in m_blurredOutput.
+        std::vector<float> m_horizontalPass;
+
+        CpuImage m_blurredOutput;
+    };
+}
@@ -0,0 +1,171 @@
+#include "CpuGaussianKernelCache.h"
+
+#include "CpuGaussianBlur.h"
+
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace CS570
+{
+    namespace
+    {
+        struct KernelKey
+        {
+            uint32_t size;
+            uint32_t varianceBits;
+            bool normalized;
+            GaussianKernelShape shape;
+
+            bool operator==(const KernelKey& other) const
+            {
+                return size == other.size && varianceBits == other.varianceBits &&
+                    normalized == other.normalized && shape == other.shape;
+            }
+        };
+
+        struct KernelKeyHash
+        {
+            size_t operator()(const KernelKey& key) const
+            {
+                size_t hash = key.size;
+                hash = hash * 31 + key.varianceBits;
+                hash = hash * 31 + (key.normalized ? 1 : 0);
+                hash = hash * 31 + static_cast<size_t>(key.shape);
+                return hash;
+            }
+        };
+
+        GaussianKernelPtr BuildKernel(const KernelKey& key, float variance)
+        {
+            std::shared_ptr<std::vector<float>> pWeights = std::make_shared<std::vector<float>>();
+            if (key.shape == GaussianKernelShape::Separable)
+            {
+                ComputeNormalizedGaussianWeights1D(key.size, variance, pWeights.get());
+                if (!key.normalized)
+                {
+                    // Undo the normalization, the center weight of the raw kernel is exp(0) = 1.
+                    const float center = (*pWeights)[key.size >> 1];
+                    for (float& weight : *pWeights)
+                        weight /= center;
+                }
+            }
+            else
+            {
+                ComputeGaussianWeights(key.size, variance, pWeights.get());
+                if (key.normalized)
+                {
+                    float weightsSum = 0.0f;
+                    for (float weight : *pWeights)
+                        weightsSum += weight;
+
+                    const float normalizationFactor = 1.0f / weightsSum;
+                    for (float& weight : *pWeights)
+                        weight *= normalizationFactor;
+                }
+            }
+            return pWeights;
+        }
+
+        class GaussianKernelCache
+        {
+        public:
+            GaussianKernelPtr Get(uint32_t size, float variance, bool normalized, GaussianKernelShape shape)
+            {
+                KernelKey key;
+                key.size = size;
+                std::memcpy(&key.varianceBits, &variance, sizeof(variance));
+                key.normalized = normalized;
+                key.shape = shape;
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto it = m_entries.find(key);
+                if (it != m_entries.end())
+                {
+                    m_lru.splice(m_lru.begin(), m_lru, it->second.lruPosition);
+                    return it->second.pKernel;
+                }
+
+                // Kernels are at most a few thousand weights, cheap enough to build under the lock.
+                Entry entry;
+                entry.pKernel = BuildKernel(key, variance);
+                m_lru.push_front(key);
+                entry.lruPosition = m_lru.begin();
+                GaussianKernelPtr pKernel = entry.pKernel;
+                m_entries.emplace(key, entry);
+                Evict();
+                return pKernel;
+            }
+
+            void SetCapacity(size_t capacity)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_capacity = capacity;
+                Evict();
+            }
+
+            size_t GetCapacity()
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                return m_capacity;
+            }
+
+            void Clear()
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_entries.clear();
+                m_lru.clear();
+            }
+
+        private:
+            struct Entry
+            {
+                GaussianKernelPtr pKernel;
+                std::list<KernelKey>::iterator lruPosition;
+            };
+
+            void Evict()
+            {
+                while (m_entries.size() > m_capacity)
+                {
+                    m_entries.erase(m_lru.back());
+                    m_lru.pop_back();
+                }
+            }
+
+            size_t m_capacity = 64;
+            std::unordered_map<KernelKey, Entry, KernelKeyHash> m_entries;
+            // Most recently used first.
+            std::list<KernelKey> m_lru;
+            std::mutex m_mutex;
+        };
+
+        GaussianKernelCache& GetGaussianKernelCache()
+        {
+            static GaussianKernelCache s_cache;
+            return s_cache;
+        }
+    }
+
+    GaussianKernelPtr GetGaussianKernel(
+        uint32_t blurKernelSize, float blurKernelVariance, bool normalized, GaussianKernelShape shape)
+    {
+        return GetGaussianKernelCache().Get(blurKernelSize, blurKernelVariance, normalized, shape);
+    }
+
+    void SetGaussianKernelCacheCapacity(size_t capacity)
+    {
+        GetGaussianKernelCache().SetCapacity(capacity);
+    }
+
+    size_t GetGaussianKernelCacheCapacity()
+    {
+        return GetGaussianKernelCache().GetCapacity();
+    }
+
+    void ClearGaussianKernelCache()
+    {
+        GetGaussianKernelCache().Clear();
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace CS570
+{
+    // Immutable Gaussian weights shared by every blur that uses the same kernel.
+    typedef std::shared_ptr<const std::vector<float>> GaussianKernelPtr;
+
+    enum class GaussianKernelShape
+    {
+        // blurKernelSize weights, the outer product of which is the 2D kernel.
+        Separable,
+        // blurKernelSize x blurKernelSize weights, row major.
+        Square
+    };
+
+    // Returns the kernel from a process-wide cache, building it on first use. Normalized kernels sum to
+    // one; unnormalized ones are the raw exp(-(x^2 + y^2) / (2 * variance^2)) values that
+    // ComputeGaussianWeights.hlsl writes. The least recently used kernels are evicted once more than
+    // GetGaussianKernelCacheCapacity() are cached; callers holding a GaussianKernelPtr keep theirs alive.
+    GaussianKernelPtr GetGaussianKernel(
+        uint32_t blurKernelSize, float blurKernelVariance, bool normalized, GaussianKernelShape shape);
+
+    void SetGaussianKernelCacheCapacity(size_t capacity);
+    size_t GetGaussianKernelCacheCapacity();
+    void ClearGaussianKernelCache();
+}
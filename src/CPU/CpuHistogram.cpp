@@ -0,0 +1,295 @@
+#include "CpuHistogram.h"
+
+#include "CpuParallel.h"
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <mutex>
+
+using namespace CS570;
+
+namespace
+{
+    // Sub-histogram of one chunk with a counter for every bin.
+    class FlatBins
+    {
+    public:
+        explicit FlatBins(size_t binCount) : m_counts(binCount, 0u) {}
+
+        void Add(uint32_t index) { ++m_counts[index]; }
+
+        void SumInto(size_t begin, size_t end, uint32_t* pCounts) const
+        {
+            for (size_t index = begin; index < end; ++index)
+                pCounts[index] += m_counts[index];
+        }
+
+    private:
+        std::vector<uint32_t> m_counts;
+    };
+
+    // Sub-histogram of one chunk made of 256 bin pages, allocated when first hit.
+    class PagedBins
+    {
+    public:
+        static const uint32_t k_pageShift = 8;
+        static const uint32_t k_pageSize = 1u << k_pageShift;
+
+        explicit PagedBins(size_t binCount) : m_pages((binCount + k_pageSize - 1) / k_pageSize) {}
+
+        void Add(uint32_t index)
+        {
+            std::unique_ptr<uint32_t[]>& pPage = m_pages[index >> k_pageShift];
+            if (!pPage)
+                pPage.reset(new uint32_t[k_pageSize]());
+            ++pPage[index & (k_pageSize - 1)];
+        }
+
+        void SumInto(size_t begin, size_t end, uint32_t* pCounts) const
+        {
+            for (size_t page = begin >> k_pageShift; page < m_pages.size() && (page << k_pageShift) < end; ++page)
+            {
+                if (!m_pages[page])
+                    continue;
+
+                size_t pageBegin = std::max(begin, page << k_pageShift);
+                size_t pageEnd = std::min(end, (page + 1) << k_pageShift);
+                for (size_t index = pageBegin; index < pageEnd; ++index)
+                    pCounts[index] += m_pages[page][index & (k_pageSize - 1)];
+            }
+        }
+
+    private:
+        std::vector<std::unique_ptr<uint32_t[]>> m_pages;
+    };
+
+    // Counts straight into the caller's bins.
+    class CountPointer
+    {
+    public:
+        explicit CountPointer(uint32_t* pCounts) : m_pCounts(pCounts) {}
+        void Add(uint32_t index) { ++m_pCounts[index]; }
+
+    private:
+        uint32_t* m_pCounts;
+    };
+
+    template <uint32_t BinCount, typename T, uint32_t ChannelCount, typename Bins>
+    void CountRows(
+        const CpuImage& input,
+        HistogramMode mode,
+        uint32_t columnBegin,
+        uint32_t columnEnd,
+        uint32_t rowBegin,
+        uint32_t rowEnd,
+        Bins* pBins)
+    {
+        // A grey pixel's one sample is all three of its color channels.
+        const uint32_t green = ChannelCount == 1 ? 0u : 1u;
+        const uint32_t blue = ChannelCount == 1 ? 0u : 2u;
+        for (uint32_t y = rowBegin; y < rowEnd; ++y)
+        {
+            const T* pPixel = input.GetRowSamples<T>(y) + size_t(columnBegin) * ChannelCount;
+            const T* pRowEnd = pPixel + size_t(columnEnd - columnBegin) * ChannelCount;
+            switch (mode)
+            {
+            case HistogramMode::Red:
+                for (; pPixel < pRowEnd; pPixel += ChannelCount)
+                    pBins->Add(ComputeBinNumber<BinCount>(LoadSample(pPixel[0])));
+                break;
+            case HistogramMode::PerChannel:
+                for (; pPixel < pRowEnd; pPixel += ChannelCount)
+                {
+                    pBins->Add(ComputeBinNumber<BinCount>(LoadSample(pPixel[0])));
+                    pBins->Add(BinCount + ComputeBinNumber<BinCount>(LoadSample(pPixel[green])));
+                    pBins->Add(2 * BinCount + ComputeBinNumber<BinCount>(LoadSample(pPixel[blue])));
+                }
+                break;
+            case HistogramMode::Luminance:
+                for (; pPixel < pRowEnd; pPixel += ChannelCount)
+                {
+                    const float rgb[3] = { LoadSample(pPixel[0]), LoadSample(pPixel[green]), LoadSample(pPixel[blue]) };
+                    pBins->Add(ComputeBinNumber<BinCount>(ComputeLuminance(rgb)));
+                }
+                break;
+            }
+        }
+    }
+
+    template <uint32_t BinCount, typename Bins>
+    void CountRegion(
+        const CpuImage& input,
+        HistogramMode mode,
+        uint32_t columnBegin,
+        uint32_t columnEnd,
+        uint32_t rowBegin,
+        uint32_t rowEnd,
+        Bins* pBins)
+    {
+        DispatchPixelFormat(input.GetFormat(), [&](auto sample, auto channels) {
+            CountRows<BinCount, decltype(sample), decltype(channels)::value>(input, mode, columnBegin, columnEnd, rowBegin, rowEnd, pBins);
+        });
+    }
+
+    template <uint32_t BinCount, typename Bins>
+    void CountImage(const CpuImage& input, HistogramMode mode, std::vector<uint32_t>* pCounts)
+    {
+        const size_t binCount = size_t(BinCount) * GetHistogramChannelCount(mode);
+        pCounts->assign(binCount, 0u);
+
+        std::mutex partialsMutex;
+        std::vector<std::unique_ptr<Bins>> partials;
+        ParallelFor(0, input.GetHeight(), 64, [&](size_t rowBegin, size_t rowEnd) {
+            std::unique_ptr<Bins> pBins(new Bins(binCount));
+            CountRegion<BinCount>(
+                input, mode, 0u, input.GetWidth(), static_cast<uint32_t>(rowBegin), static_cast<uint32_t>(rowEnd), pBins.get());
+
+            std::lock_guard<std::mutex> lock(partialsMutex);
+            partials.push_back(std::move(pBins));
+        });
+
+        uint32_t* pSums = pCounts->data();
+        ParallelFor(0, binCount, 4096, [&](size_t begin, size_t end) {
+            for (const std::unique_ptr<Bins>& pBins : partials)
+                pBins->SumInto(begin, end, pSums);
+        });
+    }
+}
+
+uint32_t CS570::GetHistogramChannelCount(HistogramMode mode)
+{
+    return mode == HistogramMode::PerChannel ? 3u : 1u;
+}
+
+template <uint32_t BinCount>
+void CS570::AccumulateHistogram(
+    const CpuImage& input,
+    HistogramMode mode,
+    uint32_t columnBegin,
+    uint32_t columnEnd,
+    uint32_t rowBegin,
+    uint32_t rowEnd,
+    uint32_t* pCounts)
+{
+    assert(columnEnd <= input.GetWidth() && rowEnd <= input.GetHeight());
+
+    CountPointer counts(pCounts);
+    CountRegion<BinCount>(input, mode, columnBegin, columnEnd, rowBegin, rowEnd, &counts);
+}
+
+void CS570::AccumulateHistogram(
+    const CpuImage& input,
+    HistogramMode mode,
+    uint32_t binCount,
+    uint32_t columnBegin,
+    uint32_t columnEnd,
+    uint32_t rowBegin,
+    uint32_t rowEnd,
+    uint32_t* pCounts)
+{
+    switch (binCount)
+    {
+#define CS570_ACCUMULATE_HISTOGRAM(count) \
+    case count: AccumulateHistogram<count>(input, mode, columnBegin, columnEnd, rowBegin, rowEnd, pCounts); break;
+
+    CS570_ACCUMULATE_HISTOGRAM(8)
+    CS570_ACCUMULATE_HISTOGRAM(16)
+    CS570_ACCUMULATE_HISTOGRAM(32)
+    CS570_ACCUMULATE_HISTOGRAM(64)
+    CS570_ACCUMULATE_HISTOGRAM(128)
+    CS570_ACCUMULATE_HISTOGRAM(256)
+    CS570_ACCUMULATE_HISTOGRAM(512)
+    CS570_ACCUMULATE_HISTOGRAM(1024)
+    CS570_ACCUMULATE_HISTOGRAM(2048)
+    CS570_ACCUMULATE_HISTOGRAM(4096)
+    CS570_ACCUMULATE_HISTOGRAM(8192)
+    CS570_ACCUMULATE_HISTOGRAM(16384)
+    CS570_ACCUMULATE_HISTOGRAM(32768)
+    CS570_ACCUMULATE_HISTOGRAM(65536)
+
+#undef CS570_ACCUMULATE_HISTOGRAM
+    default: throw "Histogram bin count must be a power of two from 8 to 65536.";
+    }
+}
+
+template <uint32_t BinCount>
+static void CountHistogramOf(const CpuImage& input, HistogramMode mode, std::vector<uint32_t>* pCounts)
+{
+    CpuHistogram<BinCount> histogram;
+    histogram.OnCreate(input, mode);
+    histogram.Execute();
+    *pCounts = histogram.GetBinCounts();
+}
+
+void CS570::CountHistogram(const CpuImage& input, HistogramMode mode, uint32_t binCount, std::vector<uint32_t>* pCounts)
+{
+    switch (binCount)
+    {
+    case 8: CountHistogramOf<8>(input, mode, pCounts); break;
+    case 16: CountHistogramOf<16>(input, mode, pCounts); break;
+    case 32: CountHistogramOf<32>(input, mode, pCounts); break;
+    case 64: CountHistogramOf<64>(input, mode, pCounts); break;
+    case 128: CountHistogramOf<128>(input, mode, pCounts); break;
+    case 256: CountHistogramOf<256>(input, mode, pCounts); break;
+    case 512: CountHistogramOf<512>(input, mode, pCounts); break;
+    case 1024: CountHistogramOf<1024>(input, mode, pCounts); break;
+    case 2048: CountHistogramOf<2048>(input, mode, pCounts); break;
+    case 4096: CountHistogramOf<4096>(input, mode, pCounts); break;
+    case 8192: CountHistogramOf<8192>(input, mode, pCounts); break;
+    case 16384: CountHistogramOf<16384>(input, mode, pCounts); break;
+    case 32768: CountHistogramOf<32768>(input, mode, pCounts); break;
+    case 65536: CountHistogramOf<65536>(input, mode, pCounts); break;
+    default: throw "Histogram bin count must be a power of two from 8 to 65536.";
+    }
+}
+
+template <uint32_t BinCount>
+void CpuHistogram<BinCount>::OnCreate(const CpuImage& input, HistogramMode mode)
+{
+    m_pInput = &input;
+    m_mode = mode;
+    m_binCounts.assign(size_t(BinCount) * GetChannelCount(), 0u);
+}
+
+template <uint32_t BinCount>
+void CpuHistogram<BinCount>::OnDestroy()
+{
+    m_pInput = nullptr;
+    std::vector<uint32_t>().swap(m_binCounts);
+}
+
+template <uint32_t BinCount>
+void CpuHistogram<BinCount>::Execute()
+{
+    assert(m_pInput != nullptr);
+
+    if (BinCount <= k_maxFlatBinCount)
+        CountImage<BinCount, FlatBins>(*m_pInput, m_mode, &m_binCounts);
+    else
+        CountImage<BinCount, PagedBins>(*m_pInput, m_mode, &m_binCounts);
+}
+
+namespace CS570
+{
+#define CS570_INSTANTIATE_HISTOGRAM(binCount) \
+    template class CpuHistogram<binCount>; \
+    template void AccumulateHistogram<binCount>(const CpuImage&, HistogramMode, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t*);
+
+    CS570_INSTANTIATE_HISTOGRAM(8)
+    CS570_INSTANTIATE_HISTOGRAM(16)
+    CS570_INSTANTIATE_HISTOGRAM(32)
+    CS570_INSTANTIATE_HISTOGRAM(64)
+    CS570_INSTANTIATE_HISTOGRAM(128)
+    CS570_INSTANTIATE_HISTOGRAM(256)
+    CS570_INSTANTIATE_HISTOGRAM(512)
+    CS570_INSTANTIATE_HISTOGRAM(1024)
+    CS570_INSTANTIATE_HISTOGRAM(2048)
+    CS570_INSTANTIATE_HISTOGRAM(4096)
+    CS570_INSTANTIATE_HISTOGRAM(8192)
+    CS570_INSTANTIATE_HISTOGRAM(16384)
+    CS570_INSTANTIATE_HISTOGRAM(32768)
+    CS570_INSTANTIATE_HISTOGRAM(65536)
+
+#undef CS570_INSTANTIATE_HISTOGRAM
+}
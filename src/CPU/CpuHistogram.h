@@ -0,0 +1,111 @@
+#pragma once
+
+#include "CpuImage.h"
+
+#include <vector>
+
+namespace CS570
+{
+    enum class HistogramMode
+    {
+        // The red channel, what the equalize and match operations read.
+        Red,
+        // One histogram each for red, green and blue.
+        PerChannel,
+        // Rec. 709 luminance of red, green and blue.
+        Luminance,
+    };
+
+    uint32_t GetHistogramChannelCount(HistogramMode mode);
+
+    inline float ComputeLuminance(const float* pPixel)
+    {
+        return 0.2126f * pPixel[0] + 0.7152f * pPixel[1] + 0.0722f * pPixel[2];
+    }
+
+    // Bin of value in binCount bins over [0, 1]. Values outside the range and NaN clamp to the
+    // first or last bin, as ComputeBinNumber does in the histogram shaders.
+    inline uint32_t ComputeBinNumber(float value, uint32_t binCount)
+    {
+        float bin = static_cast<float>(binCount) * value;
+        if (!(bin > 0.0f))
+            return 0u;
+        return bin < static_cast<float>(binCount - 1) ? static_cast<uint32_t>(bin) : binCount - 1;
+    }
+
+    template <uint32_t BinCount>
+    inline uint32_t ComputeBinNumber(float value)
+    {
+        return ComputeBinNumber(value, BinCount);
+    }
+
+    // The bin counts CpuHistogram is instantiated for, powers of two from 8 to 65536.
+    inline bool IsSupportedHistogramBinCount(uint32_t binCount)
+    {
+        return binCount >= 8 && binCount <= 65536 && (binCount & (binCount - 1)) == 0;
+    }
+
+    // Adds the histogram of rows [rowBegin, rowEnd) and columns [columnBegin, columnEnd) to pCounts,
+    // which holds BinCount counts per channel of the mode. Single threaded, for callers that
+    // already split the image, e.g. per tile.
+    template <uint32_t BinCount>
+    void AccumulateHistogram(
+        const CpuImage& input,
+        HistogramMode mode,
+        uint32_t columnBegin,
+        uint32_t columnEnd,
+        uint32_t rowBegin,
+        uint32_t rowEnd,
+        uint32_t* pCounts);
+
+    // AccumulateHistogram for bin counts chosen at run time. Throws for unsupported bin counts.
+    void AccumulateHistogram(
+        const CpuImage& input,
+        HistogramMode mode,
+        uint32_t binCount,
+        uint32_t columnBegin,
+        uint32_t columnEnd,
+        uint32_t rowBegin,
+        uint32_t rowEnd,
+        uint32_t* pCounts);
+
+    // Runs CpuHistogram<binCount> on input and returns its counts, for bin counts chosen at run
+    // time. Throws for unsupported bin counts.
+    void CountHistogram(const CpuImage& input, HistogramMode mode, uint32_t binCount, std::vector<uint32_t>* pCounts);
+
+    // Histogram with BinCount bins per channel, a power of two from 8 to 65536.
+    //
+    // Each ParallelFor chunk of rows counts into private sub-histograms which are summed in parallel
+    // at the end, so counting never contends and the memory is O(bins x threads) rather than
+    // O(pixels). Above k_maxFlatBinCount bins (16-bit data) the sub-histograms are two-level:
+    // pages of 256 bins allocated the first time one of their bins is hit, so data that covers a
+    // narrow range only pays for the pages it touches.
+    template <uint32_t BinCount>
+    class CpuHistogram
+    {
+        static_assert(BinCount >= 8 && BinCount <= 65536 && (BinCount & (BinCount - 1)) == 0,
+            "CpuHistogram bin count must be a power of two from 8 to 65536.");
+
+    public:
+        static const uint32_t k_binCount = BinCount;
+        static const uint32_t k_maxFlatBinCount = 4096;
+
+        void OnCreate(const CpuImage& input, HistogramMode mode = HistogramMode::Red);
+        void OnDestroy();
+
+        void Execute();
+
+        HistogramMode GetMode() const { return m_mode; }
+        uint32_t GetChannelCount() const { return GetHistogramChannelCount(m_mode); }
+
+        // The counts of channel c are at [c * BinCount, (c + 1) * BinCount).
+        const std::vector<uint32_t>& GetBinCounts() const { return m_binCounts; }
+        const uint32_t* GetBinCounts(uint32_t channel) const { return m_binCounts.data() + size_t(channel) * BinCount; }
+
+    private:
+        const CpuImage* m_pInput = nullptr;
+        HistogramMode m_mode = HistogramMode::Red;
+
+        std::vector<uint32_t> m_binCounts;
+    };
+}
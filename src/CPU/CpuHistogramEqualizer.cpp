@@ -0,0 +1,36 @@
+#include "CpuHistogramEqualizer.h"
+
+#include <cassert>
+
+using namespace CS570;
+
+void CpuHistogramEqualizer::OnCreate(const CpuImage& input, uint32_t binCount)
+{
+    m_pInput = &input;
+
+    m_computeHistogram.OnCreate(input, binCount);
+
+    m_equalizedOutput.Resize(input.GetWidth(), input.GetHeight(), CpuPixelFormat::R32F);
+}
+
+void CpuHistogramEqualizer::OnDestroy()
+{
+    m_computeHistogram.OnDestroy();
+    m_equalizedOutput.Release();
+    m_pInput = nullptr;
+}
+
+void CpuHistogramEqualizer::Execute()
+{
+    assert(m_pInput != nullptr);
+
+    m_computeHistogram.Execute();
+
+    const uint32_t binCount = m_computeHistogram.GetBinCount();
+    const std::vector<uint32_t>& lut = m_computeHistogram.GetLUT();
+    std::vector<float> binValues(binCount);
+    for (uint32_t bin = 0; bin < binCount; ++bin)
+        binValues[bin] = GetRemappedBinValue(lut[bin], binCount);
+
+    RemapBins(*m_pInput, binCount, binValues.data(), &m_equalizedOutput);
+}
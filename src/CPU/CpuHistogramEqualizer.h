@@ -0,0 +1,29 @@
+#pragma once
+
+#include "CpuComputeHistogram.h"
+#include "CpuImageProcessor.h"
+
+namespace CS570
+{
+    // Implements the Equalize entry point of HistogramEqualize.hlsl.
+    class CpuHistogramEqualizer : public BaseCpuImageProcessor
+    {
+    public:
+        void OnCreate(const CpuImage& input, uint32_t binCount = CpuComputeHistogram::k_defaultBinCount);
+        void OnDestroy();
+
+        // Bins and output levels, a power of two from 8 to 65536.
+        void SetBinCount(uint32_t binCount) { m_computeHistogram.OnCreate(*m_pInput, binCount); }
+
+        void Execute() override;
+
+        CpuImage& GetOutputImage() override { return m_equalizedOutput; }
+
+    private:
+        const CpuImage* m_pInput = nullptr;
+
+        CpuImage m_equalizedOutput;
+
+        CpuComputeHistogram m_computeHistogram;
+    };
+}
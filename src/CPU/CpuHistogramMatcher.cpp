@@ -0,0 +1,69 @@
+#include "CpuHistogramMatcher.h"
+
+#include <cassert>
+
+using namespace CS570;
+
+void CpuHistogramMatcher::OnCreate(const CpuImage& input, const CpuImage& match, uint32_t binCount)
+{
+    m_pMatch = &match;
+    m_binCount = binCount;
+    m_pReference.reset();
+
+    SetInput(input);
+}
+
+void CpuHistogramMatcher::SetBinCount(uint32_t binCount)
+{
+    m_binCount = binCount;
+    if (m_pInput != nullptr)
+        m_computeHistogramLUT.OnCreate(*m_pInput, binCount);
+    m_pReference.reset();
+}
+
+void CpuHistogramMatcher::SetInput(const CpuImage& input)
+{
+    m_pInput = &input;
+    m_computeHistogramLUT.OnCreate(input, m_binCount);
+    m_matchedOutput.Resize(input.GetWidth(), input.GetHeight(), CpuPixelFormat::R32F);
+}
+
+void CpuHistogramMatcher::SetMatch(const CpuImage& match)
+{
+    m_pMatch = &match;
+    m_pReference.reset();
+}
+
+void CpuHistogramMatcher::SetReference(const HistogramMatchReferencePtr& pReference)
+{
+    assert(pReference != nullptr);
+
+    if (m_pInput != nullptr && pReference->binCount != m_binCount)
+        m_computeHistogramLUT.OnCreate(*m_pInput, pReference->binCount);
+    m_binCount = pReference->binCount;
+    m_pReference = pReference;
+}
+
+void CpuHistogramMatcher::OnDestroy()
+{
+    m_computeHistogramLUT.OnDestroy();
+    m_pReference.reset();
+    std::vector<float>().swap(m_matchLUT);
+    m_matchedOutput.Release();
+    m_pInput = nullptr;
+    m_pMatch = nullptr;
+}
+
+void CpuHistogramMatcher::Execute()
+{
+    assert(m_pInput != nullptr && m_pMatch != nullptr);
+
+    if (!m_pReference)
+        m_pReference = BuildHistogramMatchReference(*m_pMatch, m_binCount);
+
+    m_computeHistogramLUT.Execute();
+
+    BuildHistogramMatchLUT(m_computeHistogramLUT.GetLUT(), *m_pReference, &m_matchLUT);
+
+    RemapBins(*m_pInput, m_computeHistogramLUT.GetBinCount(), m_matchLUT.data(), &m_matchedOutput);
+}
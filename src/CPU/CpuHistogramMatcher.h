@@ -0,0 +1,51 @@
+#pragma once
+
+#include "CpuComputeHistogram.h"
+#include "CpuImageProcessor.h"
+
+namespace CS570
+{
+    // Implements the ComposeLUT and Match entry points of HistogramComposeLUT.hlsl and
+    // HistogramMatch.hlsl. The reference built from the match image is kept until the match image
+    // or the bin count changes, so only the input histogram is counted again on every Execute.
+    class CpuHistogramMatcher : public BaseCpuImageProcessor
+    {
+    public:
+        void OnCreate(
+            const CpuImage& input,
+            const CpuImage& match,
+            uint32_t binCount = CpuComputeHistogram::k_defaultBinCount);
+        void OnDestroy();
+
+        // Bins and output levels, a power of two from 8 to 65536. Like SetMatch and SetReference, it
+        // may be called before the input is set; the input histogram is sized on SetInput.
+        void SetBinCount(uint32_t binCount);
+
+        // Matches another image to the same reference, e.g. the next image of a batch.
+        void SetInput(const CpuImage& input);
+        void SetMatch(const CpuImage& match);
+
+        // Shares a reference between matchers; its bin count replaces the matcher's.
+        void SetReference(const HistogramMatchReferencePtr& pReference);
+        // Built on the first Execute if not set.
+        const HistogramMatchReferencePtr& GetReference() const { return m_pReference; }
+
+        void Execute() override;
+
+        CpuImage& GetOutputImage() override { return m_matchedOutput; }
+
+        // Output value of every input bin, from the last Execute.
+        const std::vector<float>& GetMatchLUT() const { return m_matchLUT; }
+
+    private:
+        const CpuImage* m_pInput = nullptr;
+        const CpuImage* m_pMatch = nullptr;
+        uint32_t m_binCount = CpuComputeHistogram::k_defaultBinCount;
+
+        CpuImage m_matchedOutput;
+
+        CpuComputeHistogram m_computeHistogramLUT;
+        HistogramMatchReferencePtr m_pReference;
+        std::vector<float> m_matchLUT;
+    };
+}
@@ -0,0 +1,78 @@
+#include "CpuImage.h"
+
+#include "CpuParallel.h"
+
+#include <algorithm>
+
+namespace CS570
+{
+    CpuImage& CpuImage::operator=(const CpuImage& other)
+    {
+        if (this == &other)
+            return *this;
+
+        m_pExternalStorage = nullptr;
+        m_externalCapacity = 0;
+        Resize(other.m_width, other.m_height, other.m_format);
+        std::copy(other.GetBytes(), other.GetBytes() + other.GetSizeInBytes(), GetBytes());
+        return *this;
+    }
+
+    CpuImage& CpuImage::operator=(CpuImage&& other)
+    {
+        if (this == &other)
+            return *this;
+
+        m_width = other.m_width;
+        m_height = other.m_height;
+        m_format = other.m_format;
+        m_pixels = std::move(other.m_pixels);
+        m_pExternalStorage = other.m_pExternalStorage;
+        m_externalCapacity = other.m_externalCapacity;
+        m_pData = other.m_pData == other.m_pExternalStorage && m_pExternalStorage != nullptr ? m_pExternalStorage : m_pixels.data();
+        other.Release();
+        return *this;
+    }
+
+    void LoadRow(const CpuImage& image, uint32_t y, float* pDst)
+    {
+        ConvertPixelsToFloat(image.GetBytes() + size_t(y) * image.GetWidth() * GetPixelSize(image.GetFormat()), image.GetWidth(),
+            image.GetFormat(), pDst);
+    }
+
+    template <typename T, uint32_t ChannelCount>
+    static void LoadRedSamples(const T* pSrc, uint32_t width, PixelChannels<ChannelCount>, float* pDst)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+            pDst[x] = LoadSample(pSrc[size_t(x) * ChannelCount]);
+    }
+
+    void LoadRedRow(const CpuImage& image, uint32_t y, float* pDst)
+    {
+        // A R32F row is the red samples already.
+        if (image.GetFormat() == CpuPixelFormat::R32F)
+        {
+            std::memcpy(pDst, image.GetRowSamples<float>(y), image.GetWidth() * sizeof(float));
+            return;
+        }
+
+        DispatchPixelFormat(image.GetFormat(), [&](auto sample, auto channels) {
+            LoadRedSamples(image.GetRowSamples<decltype(sample)>(y), image.GetWidth(), channels, pDst);
+        });
+    }
+
+    void ExtractPaddedRed(const CpuImage& image, uint32_t border, std::vector<float>* pPlane)
+    {
+        const uint32_t width = image.GetWidth();
+        const uint32_t height = image.GetHeight();
+        const size_t planePitch = size_t(width) + 2 * border;
+        const size_t planeHeight = size_t(height) + 2 * border;
+        pPlane->assign(planePitch * planeHeight, 0.0f);
+
+        float* pPlaneData = pPlane->data();
+        ParallelFor(0, height, 64, [&](size_t rowBegin, size_t rowEnd) {
+            for (size_t y = rowBegin; y < rowEnd; ++y)
+                LoadRedRow(image, static_cast<uint32_t>(y), pPlaneData + (y + border) * planePitch + border);
+        });
+    }
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "CpuPixelFormat.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace CS570
+{
+    // Host side image used by the CPU backend. Pixels are stored as interleaved RGBA in one of the
+    // CpuPixelFormat sample types, the same layout the GPU path uploads, so a CpuImage can be handed
+    // to Texture::InitFromData, or as a single plane of grey samples, which uploads as an R format
+    // texture read as (g, g, g, 1) and is expanded to RGB on export. Images read from files keep the
+    // file's sample type; kernels read them through GetRowSamples and write RGBA32F outputs, which
+    // GetData and GetRow access, or R32F outputs for the operations that only produce grey.
+    class CpuImage
+    {
+    public:
+        static const uint32_t k_channelCount = 4;
+
+        CpuImage() {}
+        CpuImage(uint32_t width, uint32_t height, CpuPixelFormat format = CpuPixelFormat::RGBA32F) { Resize(width, height, format); }
+
+        // Copies always own their pixels; moves keep external storage.
+        CpuImage(const CpuImage& other) { *this = other; }
+        CpuImage(CpuImage&& other) { *this = std::move(other); }
+        CpuImage& operator=(const CpuImage& other);
+        CpuImage& operator=(CpuImage&& other);
+
+        void Resize(uint32_t width, uint32_t height, CpuPixelFormat format = CpuPixelFormat::RGBA32F)
+        {
+            m_width = width;
+            m_height = height;
+            m_format = format;
+            // Storage is counted in floats whatever the format.
+            const size_t floatCount = (size_t(width) * size_t(height) * GetPixelSize(format) + sizeof(float) - 1) / sizeof(float);
+            if (m_pExternalStorage != nullptr && floatCount <= m_externalCapacity)
+            {
+                m_pData = m_pExternalStorage;
+                return;
+            }
+
+            m_pExternalStorage = nullptr;
+            m_externalCapacity = 0;
+            m_pixels.resize(floatCount);
+            m_pData = m_pixels.data();
+        }
+
+        // Makes the next Resize place the pixels in caller owned memory of `capacity` floats instead
+        // of allocating, e.g. a slot of a MemoryPlanner arena. The memory must outlive the image or
+        // its next Release. Resizing beyond the capacity falls back to owned pixels.
+        void SetExternalStorage(float* pStorage, size_t capacity)
+        {
+            m_pExternalStorage = pStorage;
+            m_externalCapacity = capacity;
+        }
+
+        void Release()
+        {
+            m_width = 0;
+            m_height = 0;
+            m_format = CpuPixelFormat::RGBA32F;
+            m_pData = nullptr;
+            m_pExternalStorage = nullptr;
+            m_externalCapacity = 0;
+            std::vector<float>().swap(m_pixels);
+        }
+
+        uint32_t GetWidth() const { return m_width; }
+        uint32_t GetHeight() const { return m_height; }
+        CpuPixelFormat GetFormat() const { return m_format; }
+        size_t GetPixelCount() const { return size_t(m_width) * size_t(m_height); }
+        // Samples per row.
+        size_t GetRowPitch() const { return size_t(m_width) * GetChannelCount(m_format); }
+        size_t GetSizeInBytes() const { return GetPixelCount() * GetPixelSize(m_format); }
+        bool IsEmpty() const { return GetPixelCount() == 0; }
+
+        // RGBA32F images only.
+        float* GetData() { assert(m_format == CpuPixelFormat::RGBA32F); return m_pData; }
+        const float* GetData() const { assert(m_format == CpuPixelFormat::RGBA32F); return m_pData; }
+
+        float* GetRow(uint32_t y) { return GetData() + size_t(y) * GetRowPitch(); }
+        const float* GetRow(uint32_t y) const { return GetData() + size_t(y) * GetRowPitch(); }
+
+        float* GetPixel(uint32_t x, uint32_t y) { return GetRow(y) + size_t(x) * k_channelCount; }
+        const float* GetPixel(uint32_t x, uint32_t y) const { return GetRow(y) + size_t(x) * k_channelCount; }
+
+        // Any format, T being its sample type.
+        uint8_t* GetBytes() { return reinterpret_cast<uint8_t*>(m_pData); }
+        const uint8_t* GetBytes() const { return reinterpret_cast<const uint8_t*>(m_pData); }
+
+        template <typename T>
+        T* GetRowSamples(uint32_t y) { return reinterpret_cast<T*>(m_pData) + size_t(y) * GetRowPitch(); }
+        template <typename T>
+        const T* GetRowSamples(uint32_t y) const { return reinterpret_cast<const T*>(m_pData) + size_t(y) * GetRowPitch(); }
+
+        // Mirrors Texture2D::Load, which returns zero for texels outside of the texture.
+        float LoadRed(int x, int y) const
+        {
+            if (x < 0 || y < 0 || x >= static_cast<int>(m_width) || y >= static_cast<int>(m_height))
+                return 0.0f;
+
+            float red = 0.0f;
+            DispatchPixelFormat(m_format, [&](auto sample, auto channels) {
+                red = LoadSample(GetRowSamples<decltype(sample)>(static_cast<uint32_t>(y))[size_t(x) * channels]);
+            });
+            return red;
+        }
+
+    private:
+        uint32_t m_width = 0u;
+        uint32_t m_height = 0u;
+        CpuPixelFormat m_format = CpuPixelFormat::RGBA32F;
+        // m_pixels.data() or m_pExternalStorage.
+        float* m_pData = nullptr;
+        std::vector<float> m_pixels;
+        float* m_pExternalStorage = nullptr;
+        size_t m_externalCapacity = 0;
+    };
+
+    // Converts row y of any format to RGBA32F, widening the samples, or to just its red channel.
+    void LoadRow(const CpuImage& image, uint32_t y, float* pDst);
+    void LoadRedRow(const CpuImage& image, uint32_t y, float* pDst);
+
+    // Copies the red channel into a single channel plane surrounded by `border` zero texels on every
+    // side, so neighborhood kernels can read out of bounds texels the way Texture2D::Load does
+    // without per-tap bounds checks. The plane row pitch is width + 2 * border.
+    void ExtractPaddedRed(const CpuImage& image, uint32_t border, std::vector<float>* pPlane);
+}
@@ -0,0 +1,130 @@
+#include "CpuImageProcessor.h"
+
+#include "CpuParallel.h"
+#include "CpuSimd.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace CS570;
+
+static void ComputeSampleIndices(uint32_t outputSize, uint32_t inputSize, std::vector<uint32_t>* pIndices)
+{
+    pIndices->resize(outputSize);
+    for (uint32_t i = 0; i < outputSize; ++i)
+    {
+        uint64_t index = (uint64_t(i) * inputSize) / outputSize;
+        (*pIndices)[i] = static_cast<uint32_t>(std::min<uint64_t>(index, inputSize - 1));
+    }
+}
+
+void CpuImageProcessor::OnCreate(
+    const std::string& shaderEntryFunc,
+    const CpuImage& input1,
+    const CpuImage& input2)
+{
+    if (shaderEntryFunc == "Add") m_operation = Operation::Add;
+    else if (shaderEntryFunc == "Subtract") m_operation = Operation::Subtract;
+    else if (shaderEntryFunc == "Product") m_operation = Operation::Product;
+    else if (shaderEntryFunc == "Negative") m_operation = Operation::Negative;
+    else if (shaderEntryFunc == "Log") m_operation = Operation::Log;
+    else if (shaderEntryFunc == "Power") m_operation = Operation::Power;
+    else
+        throw "Unknown CpuImageProcessor operation.";
+
+    m_pInput1 = &input1;
+    m_pInput2 = &input2;
+
+    uint32_t newWidth = std::max(input1.GetWidth(), input2.GetWidth());
+    uint32_t newHeight = std::max(input1.GetHeight(), input2.GetHeight());
+    m_outputImage.Resize(newWidth, newHeight);
+
+    ComputeSampleIndices(newWidth, input1.GetWidth(), &m_input1Columns);
+    ComputeSampleIndices(newWidth, input2.GetWidth(), &m_input2Columns);
+}
+
+void CpuImageProcessor::OnDestroy()
+{
+    m_outputImage.Release();
+    m_input1Columns.clear();
+    m_input2Columns.clear();
+    m_pInput1 = nullptr;
+    m_pInput2 = nullptr;
+}
+
+template <typename Kernel>
+void CpuImageProcessor::ExecuteKernel(const Kernel& kernel)
+{
+    DispatchPixelFormat(m_pInput1->GetFormat(), [&](auto sample1, auto channels1) {
+        DispatchPixelFormat(m_pInput2->GetFormat(), [&](auto sample2, auto channels2) {
+            ExecuteRows<decltype(sample1), decltype(channels1)::value, decltype(sample2), decltype(channels2)::value>(kernel);
+        });
+    });
+}
+
+template <typename T1, uint32_t ChannelCount1, typename T2, uint32_t ChannelCount2, typename Kernel>
+void CpuImageProcessor::ExecuteRows(const Kernel& kernel)
+{
+    const CpuImage& input1 = *m_pInput1;
+    const CpuImage& input2 = *m_pInput2;
+    const uint32_t width = m_outputImage.GetWidth();
+    const uint32_t height = m_outputImage.GetHeight();
+    const bool input1Direct = input1.GetWidth() == width && input1.GetHeight() == height;
+    const bool input2Direct = input2.GetWidth() == width && input2.GetHeight() == height;
+
+    ParallelFor(0, height, 16, [&](size_t rowBegin, size_t rowEnd) {
+        for (size_t row = rowBegin; row < rowEnd; ++row)
+        {
+            uint32_t y = static_cast<uint32_t>(row);
+            const T1* pRow1 = input1.GetRowSamples<T1>(static_cast<uint32_t>((uint64_t(y) * input1.GetHeight()) / height));
+            const T2* pRow2 = input2.GetRowSamples<T2>(static_cast<uint32_t>((uint64_t(y) * input2.GetHeight()) / height));
+            float* pOutput = m_outputImage.GetRow(y);
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                Float4 color1 = LoadPixel(pRow1 + size_t(input1Direct ? x : m_input1Columns[x]) * ChannelCount1, PixelChannels<ChannelCount1>());
+                Float4 color2 = LoadPixel(pRow2 + size_t(input2Direct ? x : m_input2Columns[x]) * ChannelCount2, PixelChannels<ChannelCount2>());
+                kernel(color1, color2).Store(pOutput);
+                pOutput += CpuImage::k_channelCount;
+            }
+        }
+    });
+}
+
+void CpuImageProcessor::Execute()
+{
+    assert(m_pInput1 != nullptr && m_pInput2 != nullptr);
+
+    const Float4 weight1(m_constants.weightInput1);
+    const Float4 weight2(m_constants.weightInput2);
+    const Float4 one(1.0f);
+    const float logConstant = m_constants.logConstant;
+    const float powerConstant = m_constants.powerConstant;
+    const float powerRaise = m_constants.powerRaise;
+
+    switch (m_operation)
+    {
+    case Operation::Add:
+        ExecuteKernel([=](Float4 color1, Float4 color2) { return color1 * weight1 + color2 * weight2; });
+        break;
+    case Operation::Subtract:
+        ExecuteKernel([=](Float4 color1, Float4 color2) { return color1 * weight1 - color2 * weight2; });
+        break;
+    case Operation::Product:
+        ExecuteKernel([=](Float4 color1, Float4 color2) { return (color1 * weight1) * (color2 * weight2); });
+        break;
+    case Operation::Negative:
+        ExecuteKernel([=](Float4 color, Float4) { return one - color; });
+        break;
+    case Operation::Log:
+        ExecuteKernel([=](Float4 color, Float4) {
+            return PerLane(color, [logConstant](float c) { return logConstant * std::log(1.0f + c); });
+        });
+        break;
+    case Operation::Power:
+        ExecuteKernel([=](Float4 color, Float4) {
+            return PerLane(color, [powerConstant, powerRaise](float c) { return powerConstant * std::pow(c + 0.001f, powerRaise); });
+        });
+        break;
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "CpuImage.h"
+
+#include <string>
+#include <vector>
+
+namespace CS570
+{
+    // CPU counterpart of BaseImageProcessor. Execute() does the work that Draw() records on the GPU.
+    class BaseCpuImageProcessor
+    {
+    public:
+        virtual ~BaseCpuImageProcessor() {}
+        virtual void Execute() = 0;
+        virtual CpuImage& GetOutputImage() = 0;
+    };
+
+    // Implements the entry points of ImageProcessor.hlsl: Add, Subtract, Product, Negative, Log and Power.
+    class CpuImageProcessor : public BaseCpuImageProcessor
+    {
+    public:
+        void OnCreate(
+            const std::string& shaderEntryFunc,
+            const CpuImage& input1,
+            const CpuImage& input2);
+
+        void OnDestroy();
+
+        void Execute() override;
+
+        void SetLogConstant(float logConstant) { m_constants.logConstant = logConstant; }
+        void SetPowerConstant(float powerConstant) { m_constants.powerConstant = powerConstant; }
+        void SetPowerRaise(float powerRaise) { m_constants.powerRaise = powerRaise; }
+        void SetWeightInput1(float weightInput1) { m_constants.weightInput1 = weightInput1; }
+        void SetWeightInput2(float weightInput2) { m_constants.weightInput2 = weightInput2; }
+
+        CpuImage& GetOutputImage() override { return m_outputImage; }
+
+    private:
+        enum class Operation
+        {
+            Add,
+            Subtract,
+            Product,
+            Negative,
+            Log,
+            Power
+        };
+
+        // Picks the instance of ExecuteRows for the sample types and channel counts of the inputs.
+        template <typename Kernel>
+        void ExecuteKernel(const Kernel& kernel);
+        template <typename T1, uint32_t ChannelCount1, typename T2, uint32_t ChannelCount2, typename Kernel>
+        void ExecuteRows(const Kernel& kernel);
+
+        Operation m_operation = Operation::Add;
+
+        const CpuImage* m_pInput1 = nullptr;
+        const CpuImage* m_pInput2 = nullptr;
+
+        // Column of the input texel sampled for each output column, the equivalent of the point
+        // sampler lookup at dispatchId / outputSize when the inputs differ in size.
+        std::vector<uint32_t> m_input1Columns;
+        std::vector<uint32_t> m_input2Columns;
+
+        CpuImage m_outputImage;
+
+        struct Constants
+        {
+            float logConstant = 1.0f;
+            float powerConstant = 1.0f;
+            float powerRaise = 1.0f;
+            float weightInput1 = 1.0f;
+            float weightInput2 = 1.0f;
+        };
+
+        Constants m_constants;
+    };
+}
@@ -0,0 +1,116 @@
+#include "CpuMappedFile.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace CS570;
+
+#ifdef _WIN32
+
+void CpuMappedFile::Open(const std::string& file, Access access)
+{
+    Close();
+
+    const DWORD flags = access == Access::Random ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN;
+    HANDLE hFile = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+        throw "Failed to open file.";
+    m_hFile = hFile;
+
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(hFile, &size))
+    {
+        Close();
+        throw "Failed to read file size.";
+    }
+    if (size.QuadPart == 0)
+        return;
+
+    HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (hMapping == nullptr)
+    {
+        Close();
+        throw "Failed to map file.";
+    }
+    m_hMapping = hMapping;
+
+    m_pData = static_cast<const uint8_t*>(MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0));
+    if (m_pData == nullptr)
+    {
+        Close();
+        throw "Failed to map file.";
+    }
+    m_size = static_cast<size_t>(size.QuadPart);
+}
+
+void CpuMappedFile::Close()
+{
+    if (m_pData != nullptr)
+        UnmapViewOfFile(m_pData);
+    if (m_hMapping != nullptr)
+        CloseHandle(m_hMapping);
+    if (m_hFile != nullptr)
+        CloseHandle(m_hFile);
+
+    m_pData = nullptr;
+    m_size = 0u;
+    m_hMapping = nullptr;
+    m_hFile = nullptr;
+}
+
+#else
+
+void CpuMappedFile::Open(const std::string& file, Access access)
+{
+    Close();
+
+    m_fileDescriptor = open(file.c_str(), O_RDONLY);
+    if (m_fileDescriptor < 0)
+        throw "Failed to open file.";
+
+    struct stat status = {};
+    if (fstat(m_fileDescriptor, &status) != 0)
+    {
+        Close();
+        throw "Failed to read file size.";
+    }
+    if (status.st_size == 0)
+        return;
+
+    void* pData = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, m_fileDescriptor, 0);
+    if (pData == MAP_FAILED)
+    {
+        Close();
+        throw "Failed to map file.";
+    }
+    madvise(pData, static_cast<size_t>(status.st_size), access == Access::Random ? MADV_RANDOM : MADV_SEQUENTIAL);
+
+    m_pData = static_cast<const uint8_t*>(pData);
+    m_size = static_cast<size_t>(status.st_size);
+}
+
+void CpuMappedFile::Close()
+{
+    if (m_pData != nullptr)
+        munmap(const_cast<uint8_t*>(m_pData), m_size);
+    if (m_fileDescriptor >= 0)
+        close(m_fileDescriptor);
+
+    m_pData = nullptr;
+    m_size = 0u;
+    m_fileDescriptor = -1;
+}
+
+#endif
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace CS570
+{
+    // Read only view of a whole file mapped into memory, so reading it costs no copy into a buffer
+    // and only the pages that are touched are read from disk.
+    class CpuMappedFile
+    {
+    public:
+        CpuMappedFile() {}
+        ~CpuMappedFile() { Close(); }
+
+        CpuMappedFile(const CpuMappedFile&) = delete;
+        CpuMappedFile& operator=(const CpuMappedFile&) = delete;
+
+        // How the mapping will be read, so the OS can read ahead or not.
+        enum class Access
+        {
+            Sequential,
+            Random,
+        };
+
+        // Throws a const char* when the file can't be opened or mapped. An empty file maps to no data.
+        void Open(const std::string& file, Access access = Access::Sequential);
+        void Close();
+
+        const uint8_t* GetData() const { return m_pData; }
+        size_t GetSize() const { return m_size; }
+
+    private:
+        const uint8_t* m_pData = nullptr;
+        size_t m_size = 0u;
+#ifdef _WIN32
+        void* m_hFile = nullptr;
+        void* m_hMapping = nullptr;
+#else
+        int m_fileDescriptor = -1;
+#endif
+    };
+}
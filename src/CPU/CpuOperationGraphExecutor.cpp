@@ -0,0 +1,369 @@
+#include "CpuOperationGraphExecutor.h"
+
+#include "CpuParallel.h"
+#include "CpuSimd.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace CS570;
+
+const uint32_t CpuOperationGraphExecutor::k_tileWidth;
+
+namespace
+{
+    const uint32_t k_noSlot = 0xFFFFFFFFu;
+
+    // A materialized image the stage reads per tile, point sampled like ImageProcessor when it is
+    // smaller than the stage.
+    struct TileSource
+    {
+        const CpuImage* pImage;
+        uint32_t slot;
+        bool direct;
+        std::vector<uint32_t> columns;
+    };
+
+    // A neighborhood node and the per chunk scratch rows it reads from.
+    struct NeighborhoodNode
+    {
+        uint32_t node;
+        const CpuImage* pImage;
+        uint32_t halfSize;
+        const float* pWeights;
+    };
+}
+
+static void EvaluatePointwise(
+    const OperationNode& node, const Float4* pInput1, const Float4* pInput2, Float4* pOutput, uint32_t count)
+{
+    const Float4 weight1(node.constants.weightInput1);
+    const Float4 weight2(node.constants.weightInput2);
+    const Float4 one(1.0f);
+    const float logConstant = node.constants.logConstant;
+    const float powerConstant = node.constants.powerConstant;
+    const float powerRaise = node.constants.powerRaise;
+
+    // Same expressions as CpuImageProcessor, so a fused chain matches running the nodes one by one.
+    switch (node.type)
+    {
+    case OperationType::Add:
+        for (uint32_t i = 0; i < count; ++i)
+            pOutput[i] = pInput1[i] * weight1 + pInput2[i] * weight2;
+        break;
+    case OperationType::Subtract:
+        for (uint32_t i = 0; i < count; ++i)
+            pOutput[i] = pInput1[i] * weight1 - pInput2[i] * weight2;
+        break;
+    case OperationType::Product:
+        for (uint32_t i = 0; i < count; ++i)
+            pOutput[i] = (pInput1[i] * weight1) * (pInput2[i] * weight2);
+        break;
+    case OperationType::Negative:
+        for (uint32_t i = 0; i < count; ++i)
+            pOutput[i] = one - pInput1[i];
+        break;
+    case OperationType::Log:
+        for (uint32_t i = 0; i < count; ++i)
+            pOutput[i] = PerLane(pInput1[i], [logConstant](float c) { return logConstant * std::log(1.0f + c); });
+        break;
+    case OperationType::Power:
+        for (uint32_t i = 0; i < count; ++i)
+            pOutput[i] = PerLane(pInput1[i], [powerConstant, powerRaise](float c) { return powerConstant * std::pow(c + 0.001f, powerRaise); });
+        break;
+    default:
+        assert(false);
+        break;
+    }
+}
+
+// Loads count pixels of a source row from tile column x0 on, widened to f32.
+template <typename T, uint32_t ChannelCount>
+static void LoadSourceTile(
+    const TileSource& source, PixelChannels<ChannelCount> channels, uint32_t sourceY, uint32_t x0, uint32_t count, Float4* pTile)
+{
+    const T* pRow = source.pImage->GetRowSamples<T>(sourceY);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const uint32_t x = source.direct ? x0 + i : source.columns[x0 + i];
+        pTile[i] = LoadPixel(pRow + size_t(x) * ChannelCount, channels);
+    }
+}
+
+// Horizontal blur pass of image rows rowBegin - halfSize to rowEnd + halfSize, zero outside the image.
+static void PrepareBlurRows(
+    const NeighborhoodNode& blur, size_t rowBegin, size_t rowEnd, std::vector<float>* pRows)
+{
+    const CpuImage& image = *blur.pImage;
+    const uint32_t width = image.GetWidth();
+    const size_t height = image.GetHeight();
+    const uint32_t halfSize = blur.halfSize;
+    const uint32_t kernelSize = 2 * halfSize + 1;
+
+    pRows->assign(((rowEnd - rowBegin) + 2 * halfSize) * width, 0.0f);
+    std::vector<float> paddedRow(size_t(width) + 2 * halfSize, 0.0f);
+
+    const size_t firstRow = rowBegin >= halfSize ? rowBegin - halfSize : 0;
+    const size_t lastRow = std::min(rowEnd + halfSize, height);
+    for (size_t y = firstRow; y < lastRow; ++y)
+    {
+        LoadRedRow(image, static_cast<uint32_t>(y), paddedRow.data() + halfSize);
+
+        const float* pSrc = paddedRow.data();
+        float* pDst = pRows->data() + (y + halfSize - rowBegin) * width;
+        for (uint32_t col = 0; col < kernelSize; ++col)
+        {
+            const float weight = blur.pWeights[col];
+            for (uint32_t x = 0; x < width; ++x)
+                pDst[x] += pSrc[x + col] * weight;
+        }
+    }
+}
+
+// Red channel of image rows rowBegin - 1 to rowEnd + 1 with a zero texel on either side.
+static void PrepareSobelRows(
+    const NeighborhoodNode& sobel, size_t rowBegin, size_t rowEnd, std::vector<float>* pRows)
+{
+    const CpuImage& image = *sobel.pImage;
+    const uint32_t width = image.GetWidth();
+    const size_t rowPitch = size_t(width) + 2;
+
+    pRows->assign(((rowEnd - rowBegin) + 2) * rowPitch, 0.0f);
+    for (size_t row = 0; row < (rowEnd - rowBegin) + 2; ++row)
+    {
+        const int y = static_cast<int>(rowBegin + row) - 1;
+        if (y < 0 || y >= static_cast<int>(image.GetHeight()))
+            continue;
+
+        LoadRedRow(image, static_cast<uint32_t>(y), pRows->data() + row * rowPitch + 1);
+    }
+}
+
+static void EvaluateBlur(
+    const NeighborhoodNode& blur, const float* pRows, size_t chunkRow, uint32_t x0, Float4* pOutput, uint32_t count)
+{
+    const uint32_t width = blur.pImage->GetWidth();
+    const uint32_t kernelSize = 2 * blur.halfSize + 1;
+
+    float blurred[CpuOperationGraphExecutor::k_tileWidth] = {};
+    for (uint32_t row = 0; row < kernelSize; ++row)
+    {
+        const float weight = blur.pWeights[row];
+        const float* pSrc = pRows + (chunkRow + row) * width + x0;
+        for (uint32_t i = 0; i < count; ++i)
+            blurred[i] += pSrc[i] * weight;
+    }
+
+    for (uint32_t i = 0; i < count; ++i)
+        pOutput[i] = Float4(blurred[i], blurred[i], blurred[i], 1.0f);
+}
+
+static void EvaluateSobel(
+    const NeighborhoodNode& sobel, const float* pRows, size_t chunkRow, uint32_t x0, Float4* pOutput, uint32_t count)
+{
+    const size_t rowPitch = size_t(sobel.pImage->GetWidth()) + 2;
+    const float* pAbove = pRows + chunkRow * rowPitch + x0;
+    const float* pCenter = pAbove + rowPitch;
+    const float* pBelow = pCenter + rowPitch;
+
+    for (uint32_t x = 0; x < count; ++x)
+    {
+        float horiz =
+            (pAbove[x + 2] - pAbove[x]) +
+            2.0f * (pCenter[x + 2] - pCenter[x]) +
+            (pBelow[x + 2] - pBelow[x]);
+        float vert =
+            (pAbove[x] + 2.0f * pAbove[x + 1] + pAbove[x + 2]) -
+            (pBelow[x] + 2.0f * pBelow[x + 1] + pBelow[x + 2]);
+        float magnitude = std::sqrt(horiz * horiz + vert * vert);
+        pOutput[x] = Float4(magnitude, magnitude, magnitude, 1.0f);
+    }
+}
+
+void CpuOperationGraphExecutor::OnCreate(const OperationGraph& graph, const std::vector<const CpuImage*>& inputs)
+{
+    if (inputs.size() != graph.GetInputCount())
+        throw "OperationGraph input count mismatch.";
+
+    m_graph = graph;
+    m_inputs = inputs;
+    m_stages = graph.Fuse();
+
+    m_images.clear();
+    m_images.resize(graph.GetNodeCount());
+    m_blurWeights.clear();
+    m_blurWeights.resize(graph.GetNodeCount());
+    for (uint32_t node = 0; node < graph.GetNodeCount(); ++node)
+    {
+        const OperationNode& current = graph.GetNode(node);
+        if (current.type == OperationType::Input)
+        {
+            const CpuImage* pInput = inputs[current.imageIndex];
+            if (pInput == nullptr || pInput->GetWidth() != current.width || pInput->GetHeight() != current.height)
+                throw "OperationGraph input image size mismatch.";
+        }
+        else if (current.type == OperationType::GaussianBlur)
+        {
+            if ((current.blurKernelSize & 1u) == 0)
+                throw "OperationGraph blur kernel size must be odd.";
+        }
+    }
+
+    for (const FusedStage& stage : m_stages)
+    {
+        const OperationNode& output = graph.GetNode(stage.GetOutputNode());
+        m_images[stage.GetOutputNode()].Resize(output.width, output.height);
+    }
+}
+
+void CpuOperationGraphExecutor::OnDestroy()
+{
+    m_images.clear();
+    m_blurWeights.clear();
+    m_stages.clear();
+    m_inputs.clear();
+    m_graph = OperationGraph();
+}
+
+CpuImage& CpuOperationGraphExecutor::GetOutputImage()
+{
+    return GetNodeImage(m_graph.GetOutputs().front());
+}
+
+CpuImage& CpuOperationGraphExecutor::GetNodeImage(uint32_t node)
+{
+    assert(!m_images[node].IsEmpty());
+    return m_images[node];
+}
+
+const CpuImage& CpuOperationGraphExecutor::GetSourceImage(uint32_t node) const
+{
+    const OperationNode& source = m_graph.GetNode(node);
+    if (source.type == OperationType::Input)
+        return *m_inputs[source.imageIndex];
+    return m_images[node];
+}
+
+void CpuOperationGraphExecutor::Execute()
+{
+    // Fetched each Execute like CpuGaussianBlur, so the cache capacity can change between runs.
+    for (uint32_t node = 0; node < m_graph.GetNodeCount(); ++node)
+    {
+        const OperationNode& current = m_graph.GetNode(node);
+        if (current.type == OperationType::GaussianBlur)
+            m_blurWeights[node] = GetGaussianKernel(current.blurKernelSize, current.blurVariance, true, GaussianKernelShape::Separable);
+    }
+
+    for (const FusedStage& stage : m_stages)
+        ExecuteStage(stage);
+}
+
+void CpuOperationGraphExecutor::ExecuteStage(const FusedStage& stage)
+{
+    CpuImage& output = m_images[stage.GetOutputNode()];
+    const uint32_t width = output.GetWidth();
+    const uint32_t height = output.GetHeight();
+
+    // Every source read by a pointwise node and every node of the stage gets a tile of registers.
+    std::vector<uint32_t> slots(m_graph.GetNodeCount(), k_noSlot);
+    uint32_t slotCount = 0;
+    std::vector<TileSource> tileSources;
+    std::vector<NeighborhoodNode> neighborhoodNodes;
+    for (uint32_t node : stage.nodes)
+    {
+        const OperationNode& current = m_graph.GetNode(node);
+        if (IsNeighborhoodOperation(current.type))
+        {
+            NeighborhoodNode neighborhood;
+            neighborhood.node = node;
+            neighborhood.pImage = &GetSourceImage(current.inputs[0]);
+            neighborhood.halfSize = current.type == OperationType::GaussianBlur ? current.blurKernelSize >> 1 : 1u;
+            neighborhood.pWeights = current.type == OperationType::GaussianBlur ? m_blurWeights[node]->data() : nullptr;
+            neighborhoodNodes.push_back(neighborhood);
+        }
+        else
+        {
+            for (uint32_t input : current.inputs)
+            {
+                if (input == OperationNode::k_invalidNode || slots[input] != k_noSlot)
+                    continue;
+                if (std::find(stage.sources.begin(), stage.sources.end(), input) == stage.sources.end())
+                    continue;
+
+                const CpuImage& image = GetSourceImage(input);
+                TileSource source;
+                source.pImage = &image;
+                source.slot = slotCount;
+                source.direct = image.GetWidth() == width && image.GetHeight() == height;
+                source.columns.resize(width);
+                for (uint32_t x = 0; x < width; ++x)
+                    source.columns[x] = static_cast<uint32_t>((uint64_t(x) * image.GetWidth()) / width);
+                tileSources.push_back(source);
+                slots[input] = slotCount++;
+            }
+        }
+        slots[node] = slotCount++;
+    }
+
+    ParallelFor(0, height, 16, [&](size_t rowBegin, size_t rowEnd) {
+        std::vector<Float4> tiles(size_t(slotCount) * k_tileWidth);
+        std::vector<std::vector<float>> neighborhoodRows(neighborhoodNodes.size());
+        for (size_t i = 0; i < neighborhoodNodes.size(); ++i)
+        {
+            const NeighborhoodNode& neighborhood = neighborhoodNodes[i];
+            if (m_graph.GetNode(neighborhood.node).type == OperationType::GaussianBlur)
+                PrepareBlurRows(neighborhood, rowBegin, rowEnd, &neighborhoodRows[i]);
+            else
+                PrepareSobelRows(neighborhood, rowBegin, rowEnd, &neighborhoodRows[i]);
+        }
+
+        for (size_t row = rowBegin; row < rowEnd; ++row)
+        {
+            const uint32_t y = static_cast<uint32_t>(row);
+            for (uint32_t x0 = 0; x0 < width; x0 += k_tileWidth)
+            {
+                const uint32_t count = std::min(k_tileWidth, width - x0);
+
+                for (const TileSource& source : tileSources)
+                {
+                    const CpuImage& image = *source.pImage;
+                    const uint32_t sourceY = static_cast<uint32_t>((uint64_t(y) * image.GetHeight()) / height);
+                    Float4* pTile = tiles.data() + size_t(source.slot) * k_tileWidth;
+                    DispatchPixelFormat(image.GetFormat(), [&](auto sample, auto channels) {
+                        LoadSourceTile<decltype(sample)>(source, channels, sourceY, x0, count, pTile);
+                    });
+                }
+
+                size_t neighborhoodIndex = 0;
+                for (uint32_t node : stage.nodes)
+                {
+                    const OperationNode& current = m_graph.GetNode(node);
+                    Float4* pTile = tiles.data() + size_t(slots[node]) * k_tileWidth;
+                    if (IsNeighborhoodOperation(current.type))
+                    {
+                        const NeighborhoodNode& neighborhood = neighborhoodNodes[neighborhoodIndex];
+                        const float* pRows = neighborhoodRows[neighborhoodIndex].data();
+                        ++neighborhoodIndex;
+                        if (current.type == OperationType::GaussianBlur)
+                            EvaluateBlur(neighborhood, pRows, row - rowBegin, x0, pTile, count);
+                        else
+                            EvaluateSobel(neighborhood, pRows, row - rowBegin, x0, pTile, count);
+                    }
+                    else
+                    {
+                        const Float4* pInput1 = tiles.data() + size_t(slots[current.inputs[0]]) * k_tileWidth;
+                        const Float4* pInput2 = current.inputs[1] == OperationNode::k_invalidNode ?
+                            pInput1 : tiles.data() + size_t(slots[current.inputs[1]]) * k_tileWidth;
+                        EvaluatePointwise(current, pInput1, pInput2, pTile, count);
+                    }
+                }
+
+                const Float4* pResult = tiles.data() + size_t(slots[stage.GetOutputNode()]) * k_tileWidth;
+                float* pOutput = output.GetPixel(x0, y);
+                for (uint32_t i = 0; i < count; ++i)
+                    pResult[i].Store(pOutput + size_t(i) * CpuImage::k_channelCount);
+            }
+        }
+    });
+}
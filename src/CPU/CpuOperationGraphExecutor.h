@@ -0,0 +1,47 @@
+#pragma once
+
+#include "CpuGaussianKernelCache.h"
+#include "CpuImageProcessor.h"
+#include "OperationGraph.h"
+
+#include <vector>
+
+namespace CS570
+{
+    // Runs an OperationGraph one fused stage at a time. Each stage walks its rows in parallel chunks
+    // and evaluates all of its nodes on a tile of k_tileWidth pixels before moving on, so the
+    // intermediate results of a fused chain stay in a few KB of cache instead of full size images.
+    // Only the nodes OperationGraph::Fuse materializes get a CpuImage.
+    //
+    // Gaussian blur nodes always use the separable kernel; the recursive filter needs whole rows and
+    // columns and is left to CpuGaussianBlur.
+    class CpuOperationGraphExecutor : public BaseCpuImageProcessor
+    {
+    public:
+        static const uint32_t k_tileWidth = 256u;
+
+        // inputs[i] is bound to the graph input with imageIndex i and must match its size.
+        void OnCreate(const OperationGraph& graph, const std::vector<const CpuImage*>& inputs);
+        void OnDestroy();
+
+        void Execute() override;
+
+        // The first graph output.
+        CpuImage& GetOutputImage() override;
+        CpuImage& GetNodeImage(uint32_t node);
+
+        const std::vector<FusedStage>& GetStages() const { return m_stages; }
+
+    private:
+        const CpuImage& GetSourceImage(uint32_t node) const;
+        void ExecuteStage(const FusedStage& stage);
+
+        OperationGraph m_graph;
+        std::vector<FusedStage> m_stages;
+        std::vector<const CpuImage*> m_inputs;
+
+        // Indexed by node; empty for the nodes that were fused away.
+        std::vector<CpuImage> m_images;
+        std::vector<GaussianKernelPtr> m_blurWeights;
+    };
+}
@@ -0,0 +1,87 @@
+#include "CpuOperationSet.h"
+
+using namespace CS570;
+
+void CpuOperationSet::OnCreate(
+    const CpuImage& input1,
+    const CpuImage& input2,
+    uint32_t blurKernelSize,
+    float blurVariance)
+{
+    m_addOperation.OnCreate("Add", input1, input2);
+    m_subtractOperation.OnCreate("Subtract", input1, input2);
+    m_productOperation.OnCreate("Product", input1, input2);
+    m_negativeOperation.OnCreate("Negative", input1, input2);
+    m_logOperation.OnCreate("Log", input1, input2);
+    m_powerOperation.OnCreate("Power", input1, input2);
+
+    m_histogramEqualizer.OnCreate(input1);
+
+    m_histogramMatcher.OnCreate(input1, input2);
+
+    m_adaptiveHistogramEqualizer.OnCreate(input1);
+
+    m_gaussianBlur.OnCreate(input1, blurKernelSize, blurVariance);
+
+    m_sobelFilter.OnCreate(input1);
+
+    m_unsharpMask.OnCreate(input1, blurKernelSize, blurVariance);
+
+    m_fourierTransform.OnCreate(input1);
+}
+
+void CpuOperationSet::OnDestroy()
+{
+    m_addOperation.OnDestroy();
+    m_subtractOperation.OnDestroy();
+    m_productOperation.OnDestroy();
+    m_negativeOperation.OnDestroy();
+    m_logOperation.OnDestroy();
+    m_powerOperation.OnDestroy();
+
+    m_histogramEqualizer.OnDestroy();
+    m_histogramMatcher.OnDestroy();
+    m_adaptiveHistogramEqualizer.OnDestroy();
+
+    m_gaussianBlur.OnDestroy();
+
+    m_sobelFilter.OnDestroy();
+
+    m_unsharpMask.OnDestroy();
+
+    m_fourierTransform.OnDestroy();
+}
+
+BaseCpuImageProcessor* CpuOperationSet::GetOperation(const std::string& operation)
+{
+    if (operation == "Add") return &m_addOperation;
+    else if (operation == "Subtract") return &m_subtractOperation;
+    else if (operation == "Product") return &m_productOperation;
+    else if (operation == "Negative") return &m_negativeOperation;
+    else if (operation == "Log") return &m_logOperation;
+    else if (operation == "Power") return &m_powerOperation;
+    else if (operation == "Histogram Equalization") return &m_histogramEqualizer;
+    else if (operation == "Histogram Match") return &m_histogramMatcher;
+    else if (operation == "Adaptive Histogram Equalization") return &m_adaptiveHistogramEqualizer;
+    else if (operation == "Gaussian Blur") return &m_gaussianBlur;
+    else if (operation == "Sobel Filter") return &m_sobelFilter;
+    else if (operation == "Unsharp Mask") return &m_unsharpMask;
+    else if (operation == "Fourier Transform") return &m_fourierTransform;
+
+    return nullptr;
+}
+
+void CpuOperationSet::SetWeightInput1(float weight)
+{
+    m_addOperation.SetWeightInput1(weight);
+    m_subtractOperation.SetWeightInput1(weight);
+    m_productOperation.SetWeightInput1(weight);
+    m_unsharpMask.SetWeight(weight);
+}
+
+void CpuOperationSet::SetWeightInput2(float weight)
+{
+    m_addOperation.SetWeightInput2(weight);
+    m_subtractOperation.SetWeightInput2(weight);
+    m_productOperation.SetWeightInput2(weight);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "CpuAdaptiveHistogramEqualizer.h"
+#include "CpuFourierTransform.h"
+#include "CpuGaussianBlur.h"
+#include "CpuHistogramEqualizer.h"
+#include "CpuHistogramMatcher.h"
+#include "CpuImageProcessor.h"
+#include "CpuSobelFilter.h"
+#include "CpuUnsharpMask.h"
+
+#include <string>
+
+namespace CS570
+{
+    // Every CPU operation wired up to a pair of input images, looked up by the same operation names
+    // SampleRenderer uses. Shared by the CPU backend of SampleRenderer and the headless executable.
+    class CpuOperationSet
+    {
+    public:
+        void OnCreate(
+            const CpuImage& input1,
+            const CpuImage& input2,
+            uint32_t blurKernelSize,
+            float blurVariance);
+        void OnDestroy();
+
+        // Returns nullptr for unknown operation names.
+        BaseCpuImageProcessor* GetOperation(const std::string& operation);
+
+        void SetWeightInput1(float weight);
+        void SetWeightInput2(float weight);
+
+        void SetLogConstant(float constant) { m_logOperation.SetLogConstant(constant); }
+        void SetPowerConstant(float constant) { m_powerOperation.SetPowerConstant(constant); }
+        void SetPowerRaise(float raise) { m_powerOperation.SetPowerRaise(raise); }
+
+        void SetBlurVariance(float blurVariance)
+        {
+            m_gaussianBlur.SetVariance(blurVariance);
+            m_unsharpMask.SetBlurVariance(blurVariance);
+        }
+
+        void SetBlurAlgorithm(GaussianBlurAlgorithm algorithm)
+        {
+            m_gaussianBlur.SetAlgorithm(algorithm);
+        }
+
+        void SetHistogramBinCount(uint32_t binCount)
+        {
+            m_histogramEqualizer.SetBinCount(binCount);
+            m_histogramMatcher.SetBinCount(binCount);
+        }
+
+        void SetAdaptiveTileCount(uint32_t tileCount) { m_adaptiveHistogramEqualizer.SetTileCount(tileCount); }
+        void SetAdaptiveClipLimit(float clipLimit) { m_adaptiveHistogramEqualizer.SetClipLimit(clipLimit); }
+        void SetAdaptiveBinCount(uint32_t binCount) { m_adaptiveHistogramEqualizer.SetBinCount(binCount); }
+
+    private:
+        CpuImageProcessor m_addOperation;
+        CpuImageProcessor m_subtractOperation;
+        CpuImageProcessor m_productOperation;
+        CpuImageProcessor m_negativeOperation;
+        CpuImageProcessor m_logOperation;
+        CpuImageProcessor m_powerOperation;
+
+        CpuHistogramEqualizer m_histogramEqualizer;
+        CpuHistogramMatcher m_histogramMatcher;
+        CpuAdaptiveHistogramEqualizer m_adaptiveHistogramEqualizer;
+
+        CpuGaussianBlur m_gaussianBlur;
+
+        CpuSobelFilter m_sobelFilter;
+
+        CpuUnsharpMask m_unsharpMask;
+
+        CpuFourierTransform m_fourierTransform;
+    };
+}
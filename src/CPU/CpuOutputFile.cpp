@@ -0,0 +1,126 @@
+#include "CpuOutputFile.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace CS570;
+
+#ifdef _WIN32
+
+void CpuOutputFile::Open(const std::string& file, uint64_t size)
+{
+    Close();
+
+    // Overlapped so that threads writing different ranges don't queue behind each other on the
+    // handle; Write waits for each of its own writes.
+    HANDLE hFile = CreateFileA(
+        file.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+        throw "Failed to open file for writing.";
+    m_hFile = hFile;
+
+    // Overlapped handles have no file pointer to size the file with.
+    FILE_END_OF_FILE_INFO endOfFile = {};
+    endOfFile.EndOfFile.QuadPart = static_cast<LONGLONG>(size);
+    if (!SetFileInformationByHandle(hFile, FileEndOfFileInfo, &endOfFile, sizeof(endOfFile)))
+    {
+        Close();
+        throw "Failed to size file for writing.";
+    }
+}
+
+void CpuOutputFile::Close()
+{
+    if (m_hFile != nullptr)
+        CloseHandle(m_hFile);
+    m_hFile = nullptr;
+}
+
+void CpuOutputFile::Write(uint64_t offset, const void* pData, size_t size)
+{
+    HANDLE hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    if (hEvent == nullptr)
+        throw "Failed to write file.";
+
+    const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+    bool failed = false;
+    while (size > 0 && !failed)
+    {
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(offset);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        overlapped.hEvent = hEvent;
+
+        const DWORD chunkSize = static_cast<DWORD>(std::min<size_t>(size, 1u << 30));
+        DWORD writtenSize = 0;
+        if (!WriteFile(m_hFile, pBytes, chunkSize, nullptr, &overlapped) && GetLastError() != ERROR_IO_PENDING)
+            failed = true;
+        else if (!GetOverlappedResult(m_hFile, &overlapped, &writtenSize, TRUE) || writtenSize == 0)
+            failed = true;
+
+        pBytes += writtenSize;
+        offset += writtenSize;
+        size -= writtenSize;
+    }
+
+    CloseHandle(hEvent);
+    if (failed)
+        throw "Failed to write file.";
+}
+
+#else
+
+void CpuOutputFile::Open(const std::string& file, uint64_t size)
+{
+    Close();
+
+    m_fileDescriptor = open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (m_fileDescriptor < 0)
+        throw "Failed to open file for writing.";
+
+    if (ftruncate(m_fileDescriptor, static_cast<off_t>(size)) != 0)
+    {
+        Close();
+        throw "Failed to size file for writing.";
+    }
+}
+
+void CpuOutputFile::Close()
+{
+    if (m_fileDescriptor >= 0)
+        close(m_fileDescriptor);
+    m_fileDescriptor = -1;
+}
+
+void CpuOutputFile::Write(uint64_t offset, const void* pData, size_t size)
+{
+    const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+    while (size > 0)
+    {
+        const ssize_t writtenSize = pwrite(m_fileDescriptor, pBytes, size, static_cast<off_t>(offset));
+        if (writtenSize < 0 && errno == EINTR)
+            continue;
+        if (writtenSize <= 0)
+            throw "Failed to write file.";
+
+        pBytes += writtenSize;
+        offset += static_cast<uint64_t>(writtenSize);
+        size -= static_cast<size_t>(writtenSize);
+    }
+}
+
+#endif
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace CS570
+{
+    // Output file of a known size that several threads fill at once: every Write goes to an explicit
+    // offset (pwrite, or an overlapped WriteFile on Windows), so disjoint ranges need no locking.
+    class CpuOutputFile
+    {
+    public:
+        CpuOutputFile() {}
+        ~CpuOutputFile() { Close(); }
+
+        CpuOutputFile(const CpuOutputFile&) = delete;
+        CpuOutputFile& operator=(const CpuOutputFile&) = delete;
+
+        // Creates or truncates the file and extends it to size bytes. Throws a const char* when the
+        // file can't be created.
+        void Open(const std::string& file, uint64_t size);
+        void Close();
+
+        // Thread safe for non-overlapping ranges, and writing past the end extends the file. Throws a
+        // const char* when the write fails.
+        void Write(uint64_t offset, const void* pData, size_t size);
+
+    private:
+#ifdef _WIN32
+        void* m_hFile = nullptr;
+#else
+        int m_fileDescriptor = -1;
+#endif
+    };
+}
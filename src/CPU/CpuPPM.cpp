@@ -0,0 +1,824 @@
+#include "CpuPPM.h"
+
+#include "CpuParallel.h"
+#include "CpuSimd.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+using namespace CS570;
+
+// P3 pixel data is read this many bytes at a time, and parsed in parallel in ranges no smaller than
+// k_textRangeSize.
+static const size_t k_textBlockSize = 8 << 20;
+static const size_t k_textRangeSize = 256 << 10;
+
+// Space and every control character, which covers the ppm whitespace characters in one compare.
+static bool IsPPMWhitespace(char c)
+{
+    return static_cast<uint8_t>(c) <= ' ';
+}
+
+// Parses the leading digits of the 8 bytes at pText and returns how many there were, SWAR style:
+// the non-digit bytes are found with two adds, their first one positioned with a multiply, and the
+// digits combined in three more multiplies. 8 means there may be more digits than the word holds.
+static uint32_t ParseDigits8(const char* pText, uint32_t* pValue)
+{
+    uint64_t bytes;
+    std::memcpy(&bytes, pText, sizeof(bytes));
+
+    // Every byte's high bit: above '9', below '0' or not ASCII.
+    const uint64_t low7 = bytes & 0x7F7F7F7F7F7F7F7Full;
+    const uint64_t nonDigits = ((low7 + 0x4646464646464646ull) | ~(low7 + 0x5050505050505050ull) | bytes) & 0x8080808080808080ull;
+    if (nonDigits == 0)
+        return 8;
+
+    const uint64_t firstNonDigit = (nonDigits & (0 - nonDigits)) >> 7;
+    const uint32_t digitCount = static_cast<uint32_t>((firstNonDigit * 0x0001020304050607ull) >> 56);
+    if (digitCount == 0)
+        return 0;
+
+    // Right align the digits as an 8 digit number with leading zeros. Little endian, so the first
+    // character is the lowest byte.
+    uint64_t digits = (bytes - 0x3030303030303030ull) << (8 * (8 - digitCount));
+    digits = digits * 10 + (digits >> 8);
+    digits = (((digits & 0x000000FF000000FFull) * (100 + (1000000ull << 32))) +
+        (((digits >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32)))) >> 32;
+    *pValue = static_cast<uint32_t>(digits);
+    return digitCount;
+}
+
+// Number of whitespace separated tokens in [pBegin, pEnd).
+static size_t CountPPMTextSamples(const char* pBegin, const char* pEnd)
+{
+    size_t tokenCount = 0;
+    bool previousIsSpace = true;
+    for (const char* pRead = pBegin; pRead < pEnd; ++pRead)
+    {
+        const bool isSpace = IsPPMWhitespace(*pRead);
+        tokenCount += previousIsSpace & !isSpace;
+        previousIsSpace = isSpace;
+    }
+    return tokenCount;
+}
+
+// A P3 sample scaled to [0, 1], or kept as it is in RGBA8 and RGBA16, whose maximum is the file's.
+static void StorePPMTextSample(uint32_t value, float invMaxValue, float* pDst)
+{
+    *pDst = static_cast<float>(value) * invMaxValue;
+}
+
+static void StorePPMTextSample(uint32_t value, float, uint8_t* pDst)
+{
+    if (value > 255)
+        throw "Invalid ppm file, pixel value larger than the max value.";
+    *pDst = static_cast<uint8_t>(value);
+}
+
+static void StorePPMTextSample(uint32_t value, float, uint16_t* pDst)
+{
+    *pDst = static_cast<uint16_t>(value);
+}
+
+static float GetPPMAlpha(float*) { return 1.0f; }
+static uint8_t GetPPMAlpha(uint8_t*) { return 0xFF; }
+static uint16_t GetPPMAlpha(uint16_t*) { return 0xFFFF; }
+
+// Parses the samples of [pBegin, pEnd), which starts and ends on a sample boundary, as samples
+// sampleIndex onwards, stopping at sampleCount, into rows of width pixels rowPitch samples apart.
+// Returns how many were parsed.
+template <typename T>
+static size_t ParsePPMTextSamples(
+    const char* pBegin,
+    const char* pEnd,
+    float invMaxValue,
+    size_t sampleIndex,
+    size_t sampleCount,
+    uint32_t width,
+    size_t rowPitch,
+    T* pImageBuffer)
+{
+    const T alpha = GetPPMAlpha(pImageBuffer);
+    const size_t firstSample = sampleIndex;
+    uint32_t channel = static_cast<uint32_t>(sampleIndex % 3);
+    uint32_t x = static_cast<uint32_t>((sampleIndex / 3) % width);
+    T* pRow = pImageBuffer + (sampleIndex / 3 / width) * rowPitch;
+    T* pWritePtr = pRow + size_t(x) * 4 + channel;
+
+    const char* pRead = pBegin;
+    while (sampleIndex < sampleCount)
+    {
+        while (pRead < pEnd && IsPPMWhitespace(*pRead))
+            ++pRead;
+        if (pRead == pEnd)
+            break;
+
+        const char* pDigits = pRead;
+        uint32_t value = 0;
+        uint32_t digitCount = ParseDigits8(pRead, &value);
+        if (digitCount < 8 && digitCount <= static_cast<size_t>(pEnd - pRead))
+        {
+            pRead += digitCount;
+        }
+        else
+        {
+            // Leading zeros, or the bytes past the end of the data looked like digits too. The value
+            // saturates just past 65535, so any number of leading zeros is fine.
+            uint32_t digit = 0;
+            value = 0;
+            while (pRead < pEnd && (digit = static_cast<uint32_t>(*pRead - '0')) < 10)
+            {
+                value = std::min<uint32_t>(value * 10 + digit, 0x10000u);
+                ++pRead;
+            }
+        }
+        if (pRead == pDigits || (pRead < pEnd && !IsPPMWhitespace(*pRead)))
+            throw "Invalid ppm file, unexpected character in pixel data.";
+        if (value > 0xFFFF)
+            throw "Invalid ppm file, pixel value larger than 65535.";
+
+        StorePPMTextSample(value, invMaxValue, pWritePtr);
+        ++pWritePtr;
+        ++sampleIndex;
+        if (++channel == 3)
+        {
+            *pWritePtr = alpha;
+            ++pWritePtr;
+            channel = 0;
+            if (++x == width)
+            {
+                x = 0;
+                pRow += rowPitch;
+                pWritePtr = pRow;
+            }
+        }
+    }
+
+    return sampleIndex - firstSample;
+}
+
+// Copies the P3 samples a block at a time out of the mapped file, so ParseDigits8 can read past the
+// end of the data, and parses them in place, with no per-sample allocation or locale lookups. A
+// block is only parsed up to its last whitespace; the digits of a sample cut off at the end move to
+// the front of the next block. With several workers a block is cut into ranges at whitespace, the
+// samples of every range counted to find where it writes, and the ranges parsed in parallel.
+template <typename T>
+static void LoadPPMTextData(
+    const uint8_t* pData,
+    size_t dataSize,
+    uint32_t width,
+    uint32_t height,
+    uint32_t maxValue,
+    T* pImageBuffer,
+    size_t rowPitch)
+{
+    float invMaxValue = 1.0f / static_cast<float>(maxValue);
+
+    const size_t sampleCount = size_t(width) * height * 3;
+    size_t sampleIndex = 0;
+
+    // ParseDigits8 may read up to 8 bytes past the parsed end.
+    std::vector<char> block(k_textBlockSize + 8);
+    std::vector<const char*> rangeBegins;
+    std::vector<size_t> rangeSamples;
+    std::vector<const char*> rangeErrors;
+    size_t carriedBytes = 0;
+    bool atEnd = false;
+    while (sampleIndex < sampleCount && !atEnd)
+    {
+        const size_t requestedBytes = k_textBlockSize - carriedBytes;
+        const size_t readBytes = std::min(requestedBytes, dataSize);
+        std::memcpy(block.data() + carriedBytes, pData, readBytes);
+        pData += readBytes;
+        dataSize -= readBytes;
+        atEnd = dataSize == 0;
+
+        size_t parseEnd = carriedBytes + readBytes;
+        if (!atEnd)
+        {
+            while (parseEnd > 0 && !IsPPMWhitespace(block[parseEnd - 1]))
+                --parseEnd;
+            if (parseEnd == 0)
+                throw "Invalid ppm file, pixel value too long.";
+        }
+
+        const char* pParseBegin = block.data();
+        const char* pParseEnd = pParseBegin + parseEnd;
+        const size_t rangeCount = std::max<size_t>(std::min<size_t>(GetCpuWorkerCount(), parseEnd / k_textRangeSize), 1);
+        if (rangeCount == 1)
+        {
+            sampleIndex += ParsePPMTextSamples(pParseBegin, pParseEnd, invMaxValue, sampleIndex, sampleCount, width, rowPitch, pImageBuffer);
+        }
+        else
+        {
+            rangeBegins.resize(rangeCount + 1);
+            rangeSamples.resize(rangeCount + 1);
+            rangeBegins[0] = pParseBegin;
+            rangeBegins[rangeCount] = pParseEnd;
+            for (size_t range = 1; range < rangeCount; ++range)
+            {
+                const char* pBegin = std::max(pParseBegin + parseEnd * range / rangeCount, rangeBegins[range - 1]);
+                while (pBegin < pParseEnd && !IsPPMWhitespace(*pBegin))
+                    ++pBegin;
+                rangeBegins[range] = pBegin;
+            }
+
+            ParallelFor(0, rangeCount, 1, [&](size_t begin, size_t end) {
+                for (size_t range = begin; range < end; ++range)
+                    rangeSamples[range + 1] = CountPPMTextSamples(rangeBegins[range], rangeBegins[range + 1]);
+            });
+            rangeSamples[0] = sampleIndex;
+            for (size_t range = 0; range < rangeCount; ++range)
+                rangeSamples[range + 1] += rangeSamples[range];
+
+            // Workers can't throw through ParallelFor, so the first error is rethrown here.
+            rangeErrors.assign(rangeCount, nullptr);
+            ParallelFor(0, rangeCount, 1, [&](size_t begin, size_t end) {
+                for (size_t range = begin; range < end; ++range)
+                {
+                    try
+                    {
+                        ParsePPMTextSamples(rangeBegins[range], rangeBegins[range + 1], invMaxValue, rangeSamples[range],
+                            sampleCount, width, rowPitch, pImageBuffer);
+                    }
+                    catch (const char* pError)
+                    {
+                        rangeErrors[range] = pError;
+                    }
+                }
+            });
+            for (const char* pError : rangeErrors)
+            {
+                if (pError != nullptr)
+                    throw pError;
+            }
+            sampleIndex = std::min(rangeSamples[rangeCount], sampleCount);
+        }
+
+        carriedBytes = block.data() + carriedBytes + readBytes - pParseEnd;
+        std::memmove(block.data(), pParseEnd, carriedBytes);
+    }
+
+    if (sampleIndex < sampleCount)
+        throw "Invalid ppm file, ran out of pixel data.";
+}
+
+// Sample i of a binary row, 16 bit samples being big endian.
+template <typename T>
+static uint32_t ReadPPMSample(const uint8_t* pRow, size_t i);
+
+template <>
+uint32_t ReadPPMSample<uint8_t>(const uint8_t* pRow, size_t i)
+{
+    return pRow[i];
+}
+
+template <>
+uint32_t ReadPPMSample<uint16_t>(const uint8_t* pRow, size_t i)
+{
+    return (uint32_t(pRow[2 * i]) << 8) | pRow[2 * i + 1];
+}
+
+#if CS570_CPU_SSE2
+// The first four samples at pSrc as floats.
+template <typename T>
+static __m128 LoadPPMSamples4(const uint8_t* pSrc);
+
+template <>
+__m128 LoadPPMSamples4<uint8_t>(const uint8_t* pSrc)
+{
+    int32_t bytes;
+    std::memcpy(&bytes, pSrc, sizeof(bytes));
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i words = _mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero);
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+}
+
+template <>
+__m128 LoadPPMSamples4<uint16_t>(const uint8_t* pSrc)
+{
+    __m128i words = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pSrc));
+    words = _mm_or_si128(_mm_slli_epi16(words, 8), _mm_srli_epi16(words, 8));
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, _mm_setzero_si128()));
+}
+#endif
+
+// Converts one row of P6 (3 channel) or P5 (1 channel) samples to RGBA32F with alpha 1, grey
+// samples going to all three color channels.
+template <typename T, uint32_t ChannelCount>
+static void ConvertPPMBinaryRow(const uint8_t* pRow, uint32_t width, float invMaxValue, float* pDst)
+{
+    uint32_t x = 0;
+#if CS570_CPU_SSE2
+    const __m128 one = _mm_set1_ps(1.0f);
+    if (ChannelCount == 3)
+    {
+        // A pixel's four samples run into the next pixel's red, so every pixel but the last loads
+        // with one instruction; alpha comes from the scale zeroing it and the bias adding 1.
+        const __m128 scale = _mm_setr_ps(invMaxValue, invMaxValue, invMaxValue, 0.0f);
+        const __m128 bias = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+        for (; x + 1 < width; ++x)
+        {
+            const __m128 samples = LoadPPMSamples4<T>(pRow + size_t(x) * 3 * sizeof(T));
+            _mm_storeu_ps(pDst + size_t(x) * 4, _mm_add_ps(_mm_mul_ps(samples, scale), bias));
+        }
+    }
+    else
+    {
+        const __m128 scale = _mm_set1_ps(invMaxValue);
+        for (; x + 4 <= width; x += 4)
+        {
+            const __m128 grey = _mm_mul_ps(LoadPPMSamples4<T>(pRow + size_t(x) * sizeof(T)), scale);
+            const __m128 grey01 = _mm_unpacklo_ps(grey, one);
+            const __m128 grey23 = _mm_unpackhi_ps(grey, one);
+            float* pPixel = pDst + size_t(x) * 4;
+            _mm_storeu_ps(pPixel + 0, _mm_shuffle_ps(grey01, grey01, _MM_SHUFFLE(1, 0, 0, 0)));
+            _mm_storeu_ps(pPixel + 4, _mm_shuffle_ps(grey01, grey01, _MM_SHUFFLE(3, 2, 2, 2)));
+            _mm_storeu_ps(pPixel + 8, _mm_shuffle_ps(grey23, grey23, _MM_SHUFFLE(1, 0, 0, 0)));
+            _mm_storeu_ps(pPixel + 12, _mm_shuffle_ps(grey23, grey23, _MM_SHUFFLE(3, 2, 2, 2)));
+        }
+    }
+#endif
+
+    for (; x < width; ++x)
+    {
+        float* pPixel = pDst + size_t(x) * 4;
+        if (ChannelCount == 3)
+        {
+            pPixel[0] = static_cast<float>(ReadPPMSample<T>(pRow, size_t(x) * 3 + 0)) * invMaxValue;
+            pPixel[1] = static_cast<float>(ReadPPMSample<T>(pRow, size_t(x) * 3 + 1)) * invMaxValue;
+            pPixel[2] = static_cast<float>(ReadPPMSample<T>(pRow, size_t(x) * 3 + 2)) * invMaxValue;
+        }
+        else
+        {
+            const float grey = static_cast<float>(ReadPPMSample<T>(pRow, x)) * invMaxValue;
+            pPixel[0] = grey;
+            pPixel[1] = grey;
+            pPixel[2] = grey;
+        }
+        pPixel[3] = 1.0f; // alpha
+    }
+}
+
+// Copies one row of P6 or P5 samples to RGBA8 or RGBA16 as they are, the file's max value being
+// the format's, with alpha at the maximum.
+template <typename T, uint32_t ChannelCount, typename Sample>
+static void ConvertPPMBinaryRow(const uint8_t* pRow, uint32_t width, float, Sample* pDst)
+{
+    const Sample alpha = GetPPMAlpha(pDst);
+    for (uint32_t x = 0; x < width; ++x)
+    {
+        Sample* pPixel = pDst + size_t(x) * 4;
+        if (ChannelCount == 3)
+        {
+            pPixel[0] = static_cast<Sample>(ReadPPMSample<T>(pRow, size_t(x) * 3 + 0));
+            pPixel[1] = static_cast<Sample>(ReadPPMSample<T>(pRow, size_t(x) * 3 + 1));
+            pPixel[2] = static_cast<Sample>(ReadPPMSample<T>(pRow, size_t(x) * 3 + 2));
+        }
+        else
+        {
+            const Sample grey = static_cast<Sample>(ReadPPMSample<T>(pRow, x));
+            pPixel[0] = grey;
+            pPixel[1] = grey;
+            pPixel[2] = grey;
+        }
+        pPixel[3] = alpha;
+    }
+}
+
+// Copies the first sample of every pixel of a grey P5 or P6 row to a single channel row, scaled to
+// [0, 1] in R32F or kept as it is in R8 and R16.
+template <typename T, uint32_t ChannelCount>
+static void ConvertPPMBinaryGreyRow(const uint8_t* pRow, uint32_t width, float invMaxValue, float* pDst)
+{
+    for (uint32_t x = 0; x < width; ++x)
+        pDst[x] = static_cast<float>(ReadPPMSample<T>(pRow, size_t(x) * ChannelCount)) * invMaxValue;
+}
+
+template <typename T, uint32_t ChannelCount, typename Sample>
+static void ConvertPPMBinaryGreyRow(const uint8_t* pRow, uint32_t width, float, Sample* pDst)
+{
+    for (uint32_t x = 0; x < width; ++x)
+        pDst[x] = static_cast<Sample>(ReadPPMSample<T>(pRow, size_t(x) * ChannelCount));
+}
+
+// Converts the rows straight out of the mapped file, blocks of rows in parallel, to rows of one
+// sample per pixel for grey images and four otherwise.
+template <typename T, uint32_t ChannelCount, typename Sample>
+static void LoadPPMBinaryData(
+    const uint8_t* pData,
+    uint32_t width,
+    uint32_t height,
+    uint32_t maxValue,
+    Sample* pImageBuffer,
+    size_t rowPitch,
+    bool isGrey)
+{
+    float invMaxValue = 1.0f / static_cast<float>(maxValue);
+
+    const size_t rowSize = size_t(width) * ChannelCount * sizeof(T);
+    ParallelFor(0, height, 16, [&](size_t rowBegin, size_t rowEnd) {
+        for (size_t row = rowBegin; row < rowEnd; ++row)
+        {
+            if (isGrey)
+                ConvertPPMBinaryGreyRow<T, ChannelCount>(pData + row * rowSize, width, invMaxValue, pImageBuffer + row * rowPitch);
+            else
+                ConvertPPMBinaryRow<T, ChannelCount>(pData + row * rowSize, width, invMaxValue, pImageBuffer + row * rowPitch);
+        }
+    });
+}
+
+template <typename T, typename Sample>
+static void LoadPPMBinaryData(
+    const uint8_t* pData,
+    uint32_t channelCount,
+    uint32_t width,
+    uint32_t height,
+    uint32_t maxValue,
+    Sample* pImageBuffer,
+    size_t rowPitch,
+    bool isGrey)
+{
+    if (channelCount == 3)
+        LoadPPMBinaryData<T, 3>(pData, width, height, maxValue, pImageBuffer, rowPitch, isGrey);
+    else
+        LoadPPMBinaryData<T, 1>(pData, width, height, maxValue, pImageBuffer, rowPitch, isGrey);
+}
+
+// Whether every pixel of the P6 data has equal red, green and blue. Rows are checked in parallel
+// until one that isn't is found, which for a color image is usually in the first block.
+template <typename T>
+static bool IsGreyPPMBinaryData(const uint8_t* pData, uint32_t width, uint32_t height)
+{
+    const size_t rowSize = size_t(width) * 3 * sizeof(T);
+    std::atomic<bool> isGrey(true);
+    ParallelFor(0, height, 64, [&](size_t rowBegin, size_t rowEnd) {
+        for (size_t row = rowBegin; row < rowEnd && isGrey.load(std::memory_order_relaxed); ++row)
+        {
+            const uint8_t* pRow = pData + row * rowSize;
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                const uint32_t red = ReadPPMSample<T>(pRow, size_t(x) * 3);
+                if (ReadPPMSample<T>(pRow, size_t(x) * 3 + 1) != red || ReadPPMSample<T>(pRow, size_t(x) * 3 + 2) != red)
+                {
+                    isGrey.store(false, std::memory_order_relaxed);
+                    break;
+                }
+            }
+        }
+    });
+    return isGrey.load();
+}
+
+// Skips whitespace and comments, which run from '#' to the end of the line, and parses the decimal
+// header value after them. Returns false if there is none.
+static bool ReadPPMHeaderValue(const uint8_t* pData, size_t dataSize, size_t* pOffset, uint32_t* pValue)
+{
+    size_t offset = *pOffset;
+    while (offset < dataSize)
+    {
+        if (pData[offset] == '#')
+        {
+            while (offset < dataSize && pData[offset] != '\n' && pData[offset] != '\r')
+                ++offset;
+        }
+        else if (IsPPMWhitespace(static_cast<char>(pData[offset])))
+        {
+            ++offset;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    uint64_t value = 0;
+    const size_t digitsBegin = offset;
+    while (offset < dataSize && pData[offset] >= '0' && pData[offset] <= '9' && value <= 0xFFFFFFFFu)
+    {
+        value = value * 10 + (pData[offset] - '0');
+        ++offset;
+    }
+    if (offset == digitsBegin || value > 0xFFFFFFFFu)
+        return false;
+
+    *pOffset = offset;
+    *pValue = static_cast<uint32_t>(value);
+    return true;
+}
+
+void CpuPPMReader::Open(const std::string& imageFile, bool checkGreyP6)
+{
+    Close();
+    try
+    {
+        m_file.Open(imageFile);
+    }
+    catch (const char*)
+    {
+        throw "Failed to open ppm file.";
+    }
+
+    const uint8_t* pData = m_file.GetData();
+    const size_t fileSize = m_file.GetSize();
+    if (fileSize < 2 || pData[0] != 'P' || (pData[1] != '3' && pData[1] != '5' && pData[1] != '6'))
+        throw "Invalid ppm file, only P3, P5 and P6 are supported.";
+    const char imageType = static_cast<char>(pData[1]);
+
+    size_t offset = 2;
+    uint32_t width = 0u;
+    uint32_t height = 0u;
+    if (!ReadPPMHeaderValue(pData, fileSize, &offset, &width) || !ReadPPMHeaderValue(pData, fileSize, &offset, &height))
+        throw "Invalid ppm file, failed to parse width and height from header.";
+
+    uint32_t maxPixelValue = 0u;
+    if (!ReadPPMHeaderValue(pData, fileSize, &offset, &maxPixelValue))
+        throw "Invalid ppm file, failed to parse max value from header.";
+
+    if (width == 0 || height == 0 || maxPixelValue == 0 || maxPixelValue > 0xFFFF)
+        throw "Invalid ppm file, bad dimensions or max value.";
+
+    // A single whitespace character ends the header.
+    if (offset == fileSize || !IsPPMWhitespace(static_cast<char>(pData[offset])))
+        throw "Invalid ppm file, ran out of pixel data.";
+    ++offset;
+
+    m_isText = imageType == '3';
+    m_channelCount = imageType == '5' ? 1u : 3u;
+    m_sampleSize = maxPixelValue > 255 ? 2u : 1u;
+    if (!m_isText)
+    {
+        const uint64_t dataSize = uint64_t(width) * height * m_channelCount * m_sampleSize;
+        // Files written with "\r\n" line ends have one more byte after the header.
+        if (fileSize - offset == dataSize + 1 && pData[offset - 1] == '\r' && pData[offset] == '\n')
+            ++offset;
+        if (fileSize - offset < dataSize)
+            throw "Invalid ppm file, ran out of pixel data.";
+    }
+
+    // P3 files are parsed whole into RGBA, so only binary ones are checked for grey.
+    m_isGrey = m_channelCount == 1;
+    if (imageType == '6' && checkGreyP6)
+    {
+        m_isGrey = m_sampleSize == 2 ?
+            IsGreyPPMBinaryData<uint16_t>(pData + offset, width, height) : IsGreyPPMBinaryData<uint8_t>(pData + offset, width, height);
+    }
+
+    m_width = width;
+    m_height = height;
+    m_maxValue = maxPixelValue;
+    m_dataOffset = offset;
+}
+
+void CpuPPMReader::Close()
+{
+    m_file.Close();
+    m_width = 0u;
+    m_height = 0u;
+    m_isGrey = false;
+}
+
+CpuPixelFormat CpuPPMReader::GetFormat() const
+{
+    if (m_maxValue == 255)
+        return m_isGrey ? CpuPixelFormat::R8 : CpuPixelFormat::RGBA8;
+    if (m_maxValue == 65535)
+        return m_isGrey ? CpuPixelFormat::R16 : CpuPixelFormat::RGBA16;
+    return m_isGrey ? CpuPixelFormat::R32F : CpuPixelFormat::RGBA32F;
+}
+
+void CpuPPMReader::ReadRows(uint32_t rowBegin, uint32_t rowEnd, CpuImage* pImage) const
+{
+    pImage->Resize(m_width, rowEnd - rowBegin, GetFormat());
+    ReadRows(rowBegin, rowEnd, pImage->GetBytes(), size_t(m_width) * GetPixelSize(GetFormat()));
+}
+
+void CpuPPMReader::ReadRows(uint32_t rowBegin, uint32_t rowEnd, uint8_t* pDest, size_t rowPitch) const
+{
+    assert(rowBegin <= rowEnd && rowEnd <= m_height);
+    assert(rowPitch >= size_t(m_width) * GetPixelSize(GetFormat()));
+
+    switch (GetFormat())
+    {
+    case CpuPixelFormat::RGBA8:
+    case CpuPixelFormat::R8:
+        ReadSamples(rowBegin, rowEnd, pDest, rowPitch);
+        break;
+    case CpuPixelFormat::RGBA16:
+    case CpuPixelFormat::R16:
+        assert(rowPitch % sizeof(uint16_t) == 0);
+        ReadSamples(rowBegin, rowEnd, reinterpret_cast<uint16_t*>(pDest), rowPitch / sizeof(uint16_t));
+        break;
+    default:
+        assert(rowPitch % sizeof(float) == 0);
+        ReadSamples(rowBegin, rowEnd, reinterpret_cast<float*>(pDest), rowPitch / sizeof(float));
+        break;
+    }
+}
+
+template <typename T>
+void CpuPPMReader::ReadSamples(uint32_t rowBegin, uint32_t rowEnd, T* pDest, size_t rowPitch) const
+{
+    const uint8_t* pData = m_file.GetData() + m_dataOffset;
+    if (m_isText)
+    {
+        if (rowBegin != 0 || rowEnd != m_height)
+            throw "Text ppm files can only be read whole.";
+
+        LoadPPMTextData(pData, m_file.GetSize() - m_dataOffset, m_width, m_height, m_maxValue, pDest, rowPitch);
+        return;
+    }
+
+    pData += uint64_t(rowBegin) * m_width * m_channelCount * m_sampleSize;
+    if (m_sampleSize == 2)
+        LoadPPMBinaryData<uint16_t>(pData, m_channelCount, m_width, rowEnd - rowBegin, m_maxValue, pDest, rowPitch, m_isGrey);
+    else
+        LoadPPMBinaryData<uint8_t>(pData, m_channelCount, m_width, rowEnd - rowBegin, m_maxValue, pDest, rowPitch, m_isGrey);
+}
+
+void CS570::LoadPPM(const std::string& imageFile, CpuImage* pImage)
+{
+    // The whole image is read anyway, so grey P6 files are worth finding.
+    CpuPPMReader reader;
+    reader.Open(imageFile, true);
+    reader.ReadRows(0, reader.GetHeight(), pImage);
+}
+
+// Rows are written to the ppm in blocks of about this many bytes.
+static const size_t k_writeBlockSize = 4 << 20;
+
+static uint8_t ToUnorm8(float value)
+{
+    value = std::min(std::max(value, 0.0f), 1.0f);
+    return static_cast<uint8_t>(value * 255.0f + 0.5f);
+}
+
+// Converts RGBA32F pixels to RGBA8 the way ToUnorm8 does.
+static void ConvertRowToRGBA8(const float* pSrc, uint32_t width, uint8_t* pDst)
+{
+    uint32_t x = 0;
+#if CS570_CPU_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(255.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    auto toInt = [&](const float* pPixel) {
+        const __m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(pPixel), zero), one);
+        return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, scale), half));
+    };
+    for (; x + 4 <= width; x += 4)
+    {
+        const float* pPixel = pSrc + size_t(x) * 4;
+        const __m128i pixels01 = _mm_packs_epi32(toInt(pPixel + 0), toInt(pPixel + 4));
+        const __m128i pixels23 = _mm_packs_epi32(toInt(pPixel + 8), toInt(pPixel + 12));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + size_t(x) * 4), _mm_packus_epi16(pixels01, pixels23));
+    }
+#endif
+
+    for (; x < width; ++x)
+    {
+        for (uint32_t channel = 0; channel < 4; ++channel)
+            pDst[size_t(x) * 4 + channel] = ToUnorm8(pSrc[size_t(x) * 4 + channel]);
+    }
+}
+
+void CS570::PackRGBA8ToRGB8(const uint8_t* pRgba, uint32_t width, uint8_t* pRgb)
+{
+    // Four pixels at a time as 32 bit words shifted together into 12 bytes, little endian.
+    uint32_t x = 0;
+    for (; x + 4 <= width; x += 4)
+    {
+        uint32_t pixels[4];
+        std::memcpy(pixels, pRgba + size_t(x) * 4, sizeof(pixels));
+        const uint64_t low = uint64_t(pixels[0] & 0xFFFFFFu) | (uint64_t(pixels[1] & 0xFFFFFFu) << 24) |
+            (uint64_t(pixels[2]) << 48);
+        const uint32_t high = ((pixels[2] >> 16) & 0xFFu) | (pixels[3] << 8);
+        std::memcpy(pRgb + size_t(x) * 3, &low, sizeof(low));
+        std::memcpy(pRgb + size_t(x) * 3 + 8, &high, sizeof(high));
+    }
+
+    for (; x < width; ++x)
+    {
+        pRgb[size_t(x) * 3 + 0] = pRgba[size_t(x) * 4 + 0];
+        pRgb[size_t(x) * 3 + 1] = pRgba[size_t(x) * 4 + 1];
+        pRgb[size_t(x) * 3 + 2] = pRgba[size_t(x) * 4 + 2];
+    }
+}
+
+void CpuPPMWriter::Open(const std::string& imageFile, uint32_t width, uint32_t height)
+{
+    int maxValue = 255;
+    std::stringstream headerStream;
+    headerStream << "P6" << " " << width << " " << height << " " << maxValue << " ";
+    const std::string header = headerStream.str();
+
+    m_width = width;
+    m_height = height;
+    m_dataOffset = header.size();
+    try
+    {
+        m_file.Open(imageFile, m_dataOffset + uint64_t(width) * 3 * height);
+    }
+    catch (const char*)
+    {
+        throw "Failed to open ppm file for writing.";
+    }
+    m_file.Write(0, header.data(), header.size());
+}
+
+void CpuPPMWriter::Close()
+{
+    m_file.Close();
+    m_width = 0u;
+    m_height = 0u;
+}
+
+void CpuPPMWriter::WriteRows(uint32_t rowBegin, uint32_t rowEnd, const std::function<void(uint32_t, uint8_t*)>& convertRow)
+{
+    assert(rowBegin <= rowEnd && rowEnd <= m_height);
+
+    const size_t rowSize = size_t(m_width) * 3;
+    if (rowSize == 0 || rowBegin == rowEnd)
+        return;
+
+    const uint32_t blockRows = static_cast<uint32_t>(std::max<size_t>(k_writeBlockSize / rowSize, 1));
+    const uint32_t blockCount = (rowEnd - rowBegin + blockRows - 1) / blockRows;
+    // Workers can't throw through ParallelFor, so the first error is rethrown here.
+    std::vector<const char*> blockErrors(blockCount, nullptr);
+    ParallelFor(0, blockCount, 1, [&](size_t blockBegin, size_t blockEnd) {
+        std::vector<uint8_t> blockBytes(size_t(blockRows) * rowSize);
+        for (size_t block = blockBegin; block < blockEnd; ++block)
+        {
+            const uint32_t blockRowBegin = rowBegin + static_cast<uint32_t>(block * blockRows);
+            const uint32_t blockRowEnd = std::min(blockRowBegin + blockRows, rowEnd);
+            for (uint32_t row = blockRowBegin; row < blockRowEnd; ++row)
+                convertRow(row, blockBytes.data() + size_t(row - blockRowBegin) * rowSize);
+
+            try
+            {
+                m_file.Write(m_dataOffset + uint64_t(blockRowBegin) * rowSize, blockBytes.data(),
+                    size_t(blockRowEnd - blockRowBegin) * rowSize);
+            }
+            catch (const char* pError)
+            {
+                blockErrors[block] = pError;
+            }
+        }
+    });
+    for (const char* pError : blockErrors)
+    {
+        if (pError != nullptr)
+            throw pError;
+    }
+}
+
+void CpuPPMWriter::WriteRows(uint32_t rowBegin, uint32_t rowEnd, const CpuImage& image, uint32_t imageRow)
+{
+    assert(image.GetWidth() == m_width && imageRow + (rowEnd - rowBegin) <= image.GetHeight());
+
+    const uint32_t width = m_width;
+    WriteRows(rowBegin, rowEnd, [&image, width, rowBegin, imageRow](uint32_t row, uint8_t* pRowBytes) {
+        // Through small buffers that stay in L1, a span of pixels at a time. Compact images are
+        // widened to f32 first so they saturate and round the same way.
+        const uint32_t k_spanPixels = 256;
+        uint8_t rgbaSpan[k_spanPixels * 4];
+        float floatSpan[k_spanPixels * CpuImage::k_channelCount];
+        const CpuPixelFormat format = image.GetFormat();
+        const uint32_t pixelSize = GetPixelSize(format);
+        const uint8_t* pRow = image.GetBytes() + size_t(row - rowBegin + imageRow) * width * pixelSize;
+        for (uint32_t x = 0; x < width; x += k_spanPixels)
+        {
+            const uint32_t spanWidth = std::min(k_spanPixels, width - x);
+            const float* pSpan = reinterpret_cast<const float*>(pRow + size_t(x) * pixelSize);
+            if (format != CpuPixelFormat::RGBA32F)
+            {
+                ConvertPixelsToFloat(pRow + size_t(x) * pixelSize, spanWidth, format, floatSpan);
+                pSpan = floatSpan;
+            }
+            ConvertRowToRGBA8(pSpan, spanWidth, rgbaSpan);
+            PackRGBA8ToRGB8(rgbaSpan, spanWidth, pRowBytes + size_t(x) * 3);
+        }
+    });
+}
+
+void CS570::WritePPM(
+    const std::string& imageFile,
+    uint32_t width,
+    uint32_t height,
+    const std::function<void(uint32_t, uint8_t*)>& convertRow)
+{
+    CpuPPMWriter writer;
+    writer.Open(imageFile, width, height);
+    writer.WriteRows(0, height, convertRow);
+}
+
+void CS570::WritePPM(const std::string& imageFile, const CpuImage& image)
+{
+    CpuPPMWriter writer;
+    writer.Open(imageFile, image.GetWidth(), image.GetHeight());
+    writer.WriteRows(0, image.GetHeight(), image, 0);
+}
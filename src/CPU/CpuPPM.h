@@ -0,0 +1,96 @@
+#pragma once
+
+#include "CpuImage.h"
+#include "CpuMappedFile.h"
+#include "CpuOutputFile.h"
+
+#include <functional>
+#include <string>
+
+namespace CS570
+{
+    // Loads a P3 (text), P6 or P5 (8 or 16 bit binary, big endian) ppm or pgm file into an image in
+    // the format CpuPPMReader::GetFormat picks, a single plane for grey files and RGBA with alpha 1
+    // otherwise. Throws a const char* describing the problem when the file can't be parsed.
+    void LoadPPM(const std::string& imageFile, CpuImage* pImage);
+
+    // Writes the RGB channels as an 8 bit P6 ppm, saturating the way a UNORM render target does.
+    void WritePPM(const std::string& imageFile, const CpuImage& image);
+
+    // Writes an 8 bit P6 ppm whose rows convertRow(row, pRowBytes) fills in as packed RGB. The file is
+    // sized up front and blocks of rows are converted and written at their offsets in parallel, so
+    // convertRow is called from several threads.
+    void WritePPM(
+        const std::string& imageFile,
+        uint32_t width,
+        uint32_t height,
+        const std::function<void(uint32_t, uint8_t*)>& convertRow);
+
+    // Packs width RGBA8 pixels into RGB8, dropping alpha.
+    void PackRGBA8ToRGB8(const uint8_t* pRgba, uint32_t width, uint8_t* pRgb);
+
+    // Reads a ppm through a memory mapping, binary ones a band of rows at a time if need be, so an
+    // image doesn't have to fit in memory as RGBA32F to be processed.
+    class CpuPPMReader
+    {
+    public:
+        // Parses the header. Throws a const char* like LoadPPM. A P6 file is only checked for grey
+        // when checkGreyP6 is set, as that reads every pixel; streamed inputs, which may be larger
+        // than memory, leave it off and read P6 files as RGBA.
+        void Open(const std::string& imageFile, bool checkGreyP6 = false);
+        void Close();
+
+        uint32_t GetWidth() const { return m_width; }
+        uint32_t GetHeight() const { return m_height; }
+        uint32_t GetMaxValue() const { return m_maxValue; }
+        // P3 files can only be read whole.
+        bool IsText() const { return m_isText; }
+        // P5 files, and P6 files whose every pixel has equal red, green and blue when Open was asked
+        // to check.
+        bool IsGrey() const { return m_isGrey; }
+        // RGBA8 or RGBA16 when the max value is 255 or 65535, which hold the samples as they are,
+        // RGBA32F scaled to [0, 1] otherwise; R8, R16 or R32F for grey files.
+        CpuPixelFormat GetFormat() const;
+
+        // Converts rows [rowBegin, rowEnd) into pImage, resized to width x (rowEnd - rowBegin).
+        void ReadRows(uint32_t rowBegin, uint32_t rowEnd, CpuImage* pImage) const;
+        // Converts rows [rowBegin, rowEnd) straight into caller owned rows rowPitch bytes apart, e.g.
+        // upload heap memory, with no intermediate image.
+        void ReadRows(uint32_t rowBegin, uint32_t rowEnd, uint8_t* pDest, size_t rowPitch) const;
+
+    private:
+        template <typename T>
+        void ReadSamples(uint32_t rowBegin, uint32_t rowEnd, T* pDest, size_t rowPitch) const;
+
+        CpuMappedFile m_file;
+        uint64_t m_dataOffset = 0u;
+        uint32_t m_width = 0u;
+        uint32_t m_height = 0u;
+        uint32_t m_maxValue = 255u;
+        uint32_t m_channelCount = 3u;
+        uint32_t m_sampleSize = 1u;
+        bool m_isText = false;
+        bool m_isGrey = false;
+    };
+
+    // Writes an 8 bit P6 ppm sized up front, so bands of rows can be written in any order as they
+    // are produced.
+    class CpuPPMWriter
+    {
+    public:
+        // Throws a const char* when the file can't be created.
+        void Open(const std::string& imageFile, uint32_t width, uint32_t height);
+        void Close();
+
+        // Rows [rowBegin, rowEnd), filled in by convertRow as in WritePPM.
+        void WriteRows(uint32_t rowBegin, uint32_t rowEnd, const std::function<void(uint32_t, uint8_t*)>& convertRow);
+        // Rows [rowBegin, rowEnd) from the rows of image starting at imageRow.
+        void WriteRows(uint32_t rowBegin, uint32_t rowEnd, const CpuImage& image, uint32_t imageRow);
+
+    private:
+        CpuOutputFile m_file;
+        uint64_t m_dataOffset = 0u;
+        uint32_t m_width = 0u;
+        uint32_t m_height = 0u;
+    };
+}
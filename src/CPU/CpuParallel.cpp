@@ -0,0 +1,188 @@
+#include "CpuParallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace CS570
+{
+    namespace
+    {
+        struct ParallelJob
+        {
+            const std::function<void(size_t, size_t)>* pBody = nullptr;
+            size_t begin = 0;
+            size_t end = 0;
+            size_t chunkSize = 0;
+            size_t chunkCount = 0;
+            std::atomic<size_t> nextChunk{ 0 };
+            std::atomic<size_t> finishedChunks{ 0 };
+            std::mutex doneMutex;
+            std::condition_variable doneCondition;
+
+            // Runs chunks until none are left. Returns once this thread can't claim any more work.
+            void Work()
+            {
+                while (true)
+                {
+                    size_t chunk = nextChunk.fetch_add(1);
+                    if (chunk >= chunkCount)
+                        return;
+
+                    size_t chunkBegin = begin + chunk * chunkSize;
+                    size_t chunkEnd = std::min(chunkBegin + chunkSize, end);
+                    (*pBody)(chunkBegin, chunkEnd);
+
+                    if (finishedChunks.fetch_add(1) + 1 == chunkCount)
+                    {
+                        std::lock_guard<std::mutex> lock(doneMutex);
+                        doneCondition.notify_all();
+                    }
+                }
+            }
+        };
+
+        class CpuWorkerPool
+        {
+        public:
+            ~CpuWorkerPool() { StopWorkers(); }
+
+            void SetWorkerCount(uint32_t workerCount)
+            {
+                if (workerCount == 0)
+                    workerCount = std::max(1u, std::thread::hardware_concurrency());
+
+                std::lock_guard<std::mutex> resizeLock(m_resizeMutex);
+                if (workerCount == m_workerCount.load())
+                    return;
+
+                StopWorkers();
+                m_workerCount = workerCount;
+                m_exiting = false;
+                // The calling thread always participates, so only workerCount - 1 helpers are needed.
+                for (uint32_t i = 1; i < workerCount; ++i)
+                    m_workers.push_back(std::thread(&CpuWorkerPool::WorkerLoop, this));
+            }
+
+            uint32_t GetWorkerCount()
+            {
+                if (m_workerCount.load() == 0)
+                    SetWorkerCount(0);
+                return m_workerCount.load();
+            }
+
+            void Run(const std::shared_ptr<ParallelJob>& job)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_queueMutex);
+                    m_queue.push_back(job);
+                }
+                m_queueCondition.notify_all();
+
+                job->Work();
+
+                {
+                    std::unique_lock<std::mutex> lock(job->doneMutex);
+                    job->doneCondition.wait(lock, [&job] { return job->finishedChunks.load() == job->chunkCount; });
+                }
+
+                std::lock_guard<std::mutex> lock(m_queueMutex);
+                auto it = std::find(m_queue.begin(), m_queue.end(), job);
+                if (it != m_queue.end())
+                    m_queue.erase(it);
+            }
+
+        private:
+            void WorkerLoop()
+            {
+                while (true)
+                {
+                    std::shared_ptr<ParallelJob> job;
+                    {
+                        std::unique_lock<std::mutex> lock(m_queueMutex);
+                        m_queueCondition.wait(lock, [this] { return m_exiting || !m_queue.empty(); });
+                        if (m_exiting)
+                            return;
+
+                        job = m_queue.front();
+                        // Once every chunk is claimed the job is of no use to the other workers.
+                        if (job->nextChunk.load() >= job->chunkCount)
+                        {
+                            m_queue.pop_front();
+                            continue;
+                        }
+                    }
+
+                    job->Work();
+                }
+            }
+
+            void StopWorkers()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_queueMutex);
+                    m_exiting = true;
+                }
+                m_queueCondition.notify_all();
+                for (auto& worker : m_workers)
+                    worker.join();
+                m_workers.clear();
+            }
+
+            std::atomic<uint32_t> m_workerCount{ 0 };
+            bool m_exiting = false;
+            std::vector<std::thread> m_workers;
+            std::deque<std::shared_ptr<ParallelJob>> m_queue;
+            std::mutex m_queueMutex;
+            std::condition_variable m_queueCondition;
+            std::mutex m_resizeMutex;
+        };
+
+        CpuWorkerPool& GetCpuWorkerPool()
+        {
+            static CpuWorkerPool s_pool;
+            return s_pool;
+        }
+    }
+
+    void SetCpuWorkerCount(uint32_t workerCount)
+    {
+        GetCpuWorkerPool().SetWorkerCount(workerCount);
+    }
+
+    uint32_t GetCpuWorkerCount()
+    {
+        return GetCpuWorkerPool().GetWorkerCount();
+    }
+
+    void ParallelFor(size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)>& body)
+    {
+        if (end <= begin)
+            return;
+
+        grainSize = std::max<size_t>(grainSize, 1);
+        size_t itemCount = end - begin;
+        size_t workerCount = GetCpuWorkerCount();
+        // A few chunks per worker keeps the load balanced when chunks take uneven time.
+        size_t chunkCount = std::min((itemCount + grainSize - 1) / grainSize, workerCount * 4);
+        if (chunkCount <= 1 || workerCount == 1)
+        {
+            body(begin, end);
+            return;
+        }
+
+        auto job = std::make_shared<ParallelJob>();
+        job->pBody = &body;
+        job->begin = begin;
+        job->end = end;
+        job->chunkSize = (itemCount + chunkCount - 1) / chunkCount;
+        job->chunkCount = (itemCount + job->chunkSize - 1) / job->chunkSize;
+
+        GetCpuWorkerPool().Run(job);
+    }
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace CS570
+{
+    // Sets the number of threads used by ParallelFor, including the calling thread.
+    // Zero selects std::thread::hardware_concurrency().
+    void SetCpuWorkerCount(uint32_t workerCount);
+    uint32_t GetCpuWorkerCount();
+
+    // Splits [begin, end) into chunks of at least grainSize items and runs body(chunkBegin, chunkEnd)
+    // on the worker threads. The calling thread works on chunks too and returns once all of them are
+    // done, so ParallelFor can be nested from inside a running chunk without starving the pool.
+    void ParallelFor(size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)>& body);
+}
@@ -0,0 +1,551 @@
+#include "CpuPipeline.h"
+
+#include "CpuAdaptiveHistogramEqualizer.h"
+#include "CpuFourierTransform.h"
+#include "CpuHistogramEqualizer.h"
+#include "CpuHistogramMatcher.h"
+#include "CpuParallel.h"
+#include "CpuSobelFilter.h"
+#include "CpuUnsharpMask.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace CS570;
+
+namespace
+{
+    // Owns the concrete operation so it is destroyed, and its output freed, with the node.
+    template <typename Operation>
+    struct PipelineOperation : public BaseCpuImageProcessor
+    {
+        Operation operation;
+
+        void Execute() override { operation.Execute(); }
+        CpuImage& GetOutputImage() override { return operation.GetOutputImage(); }
+    };
+
+    // Every operation sizes its output in OnCreate, so binding the storage first keeps it from
+    // allocating.
+    template <typename Operation>
+    Operation& MakePipelineOperation(
+        float* pStorage, size_t storageCapacity, std::unique_ptr<BaseCpuImageProcessor>* ppOperation)
+    {
+        PipelineOperation<Operation>* pOperation = new PipelineOperation<Operation>();
+        ppOperation->reset(pOperation);
+        if (pStorage != nullptr)
+            pOperation->operation.GetOutputImage().SetExternalStorage(pStorage, storageCapacity);
+        return pOperation->operation;
+    }
+}
+
+static bool IsBinaryOperation(const std::string& operation)
+{
+    return operation == "Add" || operation == "Subtract" || operation == "Product" || operation == "Histogram Match";
+}
+
+static bool IsKnownOperation(const std::string& operation)
+{
+    return IsBinaryOperation(operation) ||
+        operation == "Negative" || operation == "Log" || operation == "Power" ||
+        operation == "Histogram Equalization" || operation == "Adaptive Histogram Equalization" ||
+        operation == "Gaussian Blur" || operation == "Sobel Filter" || operation == "Unsharp Mask" ||
+        operation == "Fourier Transform";
+}
+
+// Rows above and below an output row that the operation reads.
+static uint32_t GetOperationRowHalo(const std::string& operation, const CpuPipelineParameters& parameters)
+{
+    if (operation == "Gaussian Blur")
+    {
+        const uint32_t radius = parameters.blurKernelSize >> 1;
+        if (ResolveGaussianBlurAlgorithm(parameters.blurAlgorithm, parameters.blurKernelSize, parameters.blurVariance) !=
+            GaussianBlurAlgorithm::Recursive)
+        {
+            return radius;
+        }
+
+        // The recursive filter's response never reaches zero and has a longer tail than the
+        // Gaussian; cutting it at 8 sigma keeps banded results within 1 LSB of the whole image.
+        return std::max(radius, static_cast<uint32_t>(std::ceil(8.0f * std::fabs(parameters.blurVariance))));
+    }
+    if (operation == "Unsharp Mask")
+        return parameters.blurKernelSize >> 1;
+    if (operation == "Sobel Filter")
+        return 1u;
+    if (operation == "Histogram Equalization" || operation == "Histogram Match" ||
+        operation == "Adaptive Histogram Equalization" || operation == "Fourier Transform")
+    {
+        throw "The histogram operations and the Fourier transform need the whole image and can't run in bands.";
+    }
+
+    return 0u;
+}
+
+// Channels of an operation's output image; the operations that only produce grey write one plane.
+static uint32_t GetOperationChannelCount(const std::string& operation)
+{
+    if (operation == "Gaussian Blur" || operation == "Sobel Filter" || operation == "Histogram Equalization" ||
+        operation == "Histogram Match" || operation == "Adaptive Histogram Equalization")
+    {
+        return 1u;
+    }
+    return CpuImage::k_channelCount;
+}
+
+static void CreateOperation(
+    const std::string& operation,
+    const CpuPipelineParameters& parameters,
+    const CpuImage& input1,
+    const CpuImage& input2,
+    float* pStorage,
+    size_t storageCapacity,
+    std::unique_ptr<BaseCpuImageProcessor>* ppOperation)
+{
+    if (operation == "Histogram Equalization")
+    {
+        MakePipelineOperation<CpuHistogramEqualizer>(pStorage, storageCapacity, ppOperation)
+            .OnCreate(input1, parameters.histogramBinCount);
+    }
+    else if (operation == "Histogram Match")
+    {
+        MakePipelineOperation<CpuHistogramMatcher>(pStorage, storageCapacity, ppOperation)
+            .OnCreate(input1, input2, parameters.histogramBinCount);
+    }
+    else if (operation == "Adaptive Histogram Equalization")
+    {
+        MakePipelineOperation<CpuAdaptiveHistogramEqualizer>(pStorage, storageCapacity, ppOperation)
+            .OnCreate(input1, parameters.adaptiveTileCount, parameters.adaptiveClipLimit, parameters.adaptiveBinCount);
+    }
+    else if (operation == "Gaussian Blur")
+    {
+        CpuGaussianBlur& blur = MakePipelineOperation<CpuGaussianBlur>(pStorage, storageCapacity, ppOperation);
+        blur.OnCreate(input1, parameters.blurKernelSize, parameters.blurVariance);
+        blur.SetAlgorithm(parameters.blurAlgorithm);
+    }
+    else if (operation == "Sobel Filter")
+    {
+        MakePipelineOperation<CpuSobelFilter>(pStorage, storageCapacity, ppOperation).OnCreate(input1);
+    }
+    else if (operation == "Unsharp Mask")
+    {
+        CpuUnsharpMask& unsharpMask = MakePipelineOperation<CpuUnsharpMask>(pStorage, storageCapacity, ppOperation);
+        unsharpMask.OnCreate(input1, parameters.blurKernelSize, parameters.blurVariance);
+        unsharpMask.SetWeight(parameters.weightInput1);
+    }
+    else if (operation == "Fourier Transform")
+    {
+        MakePipelineOperation<CpuFourierTransform>(pStorage, storageCapacity, ppOperation).OnCreate(input1);
+    }
+    else
+    {
+        CpuImageProcessor& processor = MakePipelineOperation<CpuImageProcessor>(pStorage, storageCapacity, ppOperation);
+        processor.OnCreate(operation, input1, input2);
+        processor.SetWeightInput1(parameters.weightInput1);
+        processor.SetWeightInput2(parameters.weightInput2);
+        processor.SetLogConstant(parameters.logConstant);
+        processor.SetPowerConstant(parameters.powerConstant);
+        processor.SetPowerRaise(parameters.powerRaise);
+    }
+}
+
+uint32_t CpuPipeline::AddInput(const CpuImage& image)
+{
+    m_nodes.emplace_back();
+    m_nodes.back().pImage = &image;
+    return static_cast<uint32_t>(m_nodes.size() - 1);
+}
+
+uint32_t CpuPipeline::AddOperation(
+    const std::string& operation,
+    uint32_t input1,
+    uint32_t input2,
+    const CpuPipelineParameters& parameters)
+{
+    if (!IsKnownOperation(operation))
+        throw "Unknown CpuPipeline operation.";
+    if (input1 >= m_nodes.size())
+        throw "Invalid CpuPipeline input node.";
+
+    if (!IsBinaryOperation(operation))
+        input2 = k_invalidNode;
+    else if (input2 >= m_nodes.size())
+        throw "CpuPipeline operation requires two inputs.";
+
+    m_nodes.emplace_back();
+    Node& node = m_nodes.back();
+    node.operation = operation;
+    node.inputs[0] = input1;
+    node.inputs[1] = input2;
+    node.parameters = parameters;
+    return static_cast<uint32_t>(m_nodes.size() - 1);
+}
+
+void CpuPipeline::AddOutput(uint32_t node)
+{
+    if (node >= m_nodes.size())
+        throw "Invalid CpuPipeline output node.";
+
+    if (!m_nodes[node].isOutput)
+    {
+        m_nodes[node].isOutput = true;
+        m_outputs.push_back(node);
+    }
+}
+
+void CpuPipeline::SetInput(uint32_t node, const CpuImage& image)
+{
+    assert(m_nodes[node].operation.empty());
+    m_nodes[node].pImage = &image;
+}
+
+void CpuPipeline::SetParameters(const CpuPipelineParameters& parameters)
+{
+    for (Node& node : m_nodes)
+        node.parameters = parameters;
+}
+
+void CpuPipeline::Clear()
+{
+    m_nodes.clear();
+    std::vector<float>().swap(m_arena);
+    m_outputs.clear();
+    m_pendingConsumers.reset();
+}
+
+uint32_t CpuPipeline::GetRowHalo() const
+{
+    // Nodes only depend on nodes added before them, so walking backwards from the outputs sees every
+    // consumer of a node before the node and can push its halo down to the inputs.
+    std::vector<uint8_t> live(m_nodes.size(), 0);
+    std::vector<uint32_t> halos(m_nodes.size(), 0u);
+    for (uint32_t output : m_outputs)
+        live[output] = 1;
+
+    uint32_t inputHalo = 0u;
+    for (size_t node = m_nodes.size(); node-- > 0;)
+    {
+        if (live[node] == 0)
+            continue;
+
+        const Node& current = m_nodes[node];
+        if (current.operation.empty())
+        {
+            inputHalo = std::max(inputHalo, halos[node]);
+            continue;
+        }
+
+        const uint32_t halo = halos[node] + GetOperationRowHalo(current.operation, current.parameters);
+        for (uint32_t input : current.inputs)
+        {
+            if (input == k_invalidNode)
+                continue;
+            live[input] = 1;
+            halos[input] = std::max(halos[input], halo);
+        }
+    }
+
+    return inputHalo;
+}
+
+std::vector<std::vector<uint32_t>> CpuPipeline::GetSchedule() const
+{
+    // Nodes only depend on nodes added before them, so one pass in index order finds the depth of
+    // every node; the outputs' dependencies are marked live walking backwards.
+    std::vector<uint8_t> live(m_nodes.size(), 0);
+    for (uint32_t output : m_outputs)
+        live[output] = 1;
+    for (size_t node = m_nodes.size(); node-- > 0;)
+    {
+        if (live[node] == 0)
+            continue;
+        for (uint32_t input : m_nodes[node].inputs)
+        {
+            if (input != k_invalidNode)
+                live[input] = 1;
+        }
+    }
+
+    std::vector<uint32_t> depth(m_nodes.size(), 0);
+    std::vector<std::vector<uint32_t>> waves;
+    for (uint32_t node = 0; node < m_nodes.size(); ++node)
+    {
+        if (live[node] == 0 || m_nodes[node].operation.empty())
+            continue;
+
+        uint32_t nodeDepth = 0;
+        for (uint32_t input : m_nodes[node].inputs)
+        {
+            if (input != k_invalidNode && !m_nodes[input].operation.empty())
+                nodeDepth = std::max(nodeDepth, depth[input] + 1);
+        }
+        depth[node] = nodeDepth;
+
+        if (waves.size() <= nodeDepth)
+            waves.resize(nodeDepth + 1);
+        waves[nodeDepth].push_back(node);
+    }
+
+    return waves;
+}
+
+std::vector<CpuPipeline::ImageSize> CpuPipeline::GetImageSizes() const
+{
+    std::vector<ImageSize> sizes(m_nodes.size());
+    for (size_t node = 0; node < m_nodes.size(); ++node)
+    {
+        const Node& current = m_nodes[node];
+        if (current.operation.empty())
+        {
+            sizes[node].width = current.pImage->GetWidth();
+            sizes[node].height = current.pImage->GetHeight();
+            continue;
+        }
+
+        assert(current.inputs[0] < node && (current.inputs[1] == k_invalidNode || current.inputs[1] < node));
+        sizes[node] = sizes[current.inputs[0]];
+        // Only the CpuImageProcessor operations take the larger of their inputs.
+        if (current.inputs[1] != k_invalidNode && current.operation != "Histogram Match")
+        {
+            sizes[node].width = std::max(sizes[node].width, sizes[current.inputs[1]].width);
+            sizes[node].height = std::max(sizes[node].height, sizes[current.inputs[1]].height);
+        }
+    }
+    return sizes;
+}
+
+void CpuPipeline::GetImageSize(uint32_t node, uint32_t* pWidth, uint32_t* pHeight) const
+{
+    const ImageSize size = GetImageSizes()[node];
+    *pWidth = size.width;
+    *pHeight = size.height;
+}
+
+MemoryPlan CpuPipeline::PlanMemory(std::vector<uint32_t>* pNodes) const
+{
+    return PlanMemory(GetImageSizes(), pNodes);
+}
+
+MemoryPlan CpuPipeline::PlanMemory(const std::vector<ImageSize>& sizes, std::vector<uint32_t>* pNodes) const
+{
+    std::vector<std::vector<uint32_t>> waves = GetSchedule();
+
+    // Written in the producer's wave, live through its last consumer's wave, or to the end for
+    // outputs.
+    std::vector<uint32_t> firstUse(m_nodes.size(), 0u);
+    std::vector<uint32_t> lastUse(m_nodes.size(), 0u);
+    std::vector<uint32_t> nodes;
+    for (uint32_t wave = 0; wave < waves.size(); ++wave)
+    {
+        for (uint32_t node : waves[wave])
+        {
+            firstUse[node] = wave;
+            lastUse[node] = m_nodes[node].isOutput ? static_cast<uint32_t>(waves.size()) : wave;
+            nodes.push_back(node);
+            for (uint32_t input : m_nodes[node].inputs)
+            {
+                if (input != k_invalidNode)
+                    lastUse[input] = std::max(lastUse[input], wave);
+            }
+        }
+    }
+
+    std::vector<TransientBuffer> buffers(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        const ImageSize& size = sizes[nodes[i]];
+        buffers[i].size = size_t(size.width) * size.height * GetOperationChannelCount(m_nodes[nodes[i]].operation) * sizeof(float);
+        buffers[i].firstUse = firstUse[nodes[i]];
+        buffers[i].lastUse = lastUse[nodes[i]];
+    }
+
+    if (pNodes != nullptr)
+        *pNodes = nodes;
+
+    // Whole cache lines, so concurrently written outputs never share one.
+    return PlanTransientMemory(buffers, 64);
+}
+
+void CpuPipeline::ExecuteNode(uint32_t node, float* pStorage, size_t storageCapacity)
+{
+    Node& current = m_nodes[node];
+    const CpuImage& input1 = GetImage(current.inputs[0]);
+    const CpuImage& input2 = GetImage(current.inputs[1] != k_invalidNode ? current.inputs[1] : current.inputs[0]);
+
+    CreateOperation(current.operation, current.parameters, input1, input2, pStorage, storageCapacity, &current.pOperation);
+    current.pOperation->Execute();
+
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        uint32_t input = current.inputs[i];
+        if (input == k_invalidNode || (i == 1 && input == current.inputs[0]))
+            continue;
+
+        Node& producer = m_nodes[input];
+        if (m_pendingConsumers[input].fetch_sub(1) == 1 && !producer.isOutput && !producer.operation.empty())
+            producer.pOperation.reset();
+    }
+}
+
+void CpuPipeline::Execute()
+{
+    if (m_outputs.empty())
+        throw "CpuPipeline has no outputs.";
+
+    std::vector<std::vector<uint32_t>> waves = GetSchedule();
+
+    m_pendingConsumers.reset(new std::atomic<uint32_t>[m_nodes.size()]);
+    for (size_t node = 0; node < m_nodes.size(); ++node)
+        m_pendingConsumers[node] = 0;
+    for (const std::vector<uint32_t>& wave : waves)
+    {
+        for (uint32_t node : wave)
+        {
+            const Node& current = m_nodes[node];
+            ++m_pendingConsumers[current.inputs[0]];
+            if (current.inputs[1] != k_invalidNode && current.inputs[1] != current.inputs[0])
+                ++m_pendingConsumers[current.inputs[1]];
+        }
+    }
+
+    // Outputs of the previous Execute may live in the arena.
+    for (Node& node : m_nodes)
+        node.pOperation.reset();
+
+    std::vector<float*> storage(m_nodes.size(), nullptr);
+    std::vector<size_t> storageCapacity(m_nodes.size(), 0);
+    if (m_planMemory)
+    {
+        const std::vector<ImageSize> sizes = GetImageSizes();
+        std::vector<uint32_t> plannedNodes;
+        MemoryPlan plan = PlanMemory(sizes, &plannedNodes);
+        // Padded so the arena can start on a cache line like the offsets.
+        m_arena.resize((plan.arenaSize + 64) / sizeof(float));
+        float* pArena = reinterpret_cast<float*>((reinterpret_cast<uintptr_t>(m_arena.data()) + 63) & ~uintptr_t(63));
+        for (size_t i = 0; i < plannedNodes.size(); ++i)
+        {
+            const ImageSize& size = sizes[plannedNodes[i]];
+            storage[plannedNodes[i]] = pArena + plan.offsets[i] / sizeof(float);
+            storageCapacity[plannedNodes[i]] = size_t(size.width) * size.height * GetOperationChannelCount(m_nodes[plannedNodes[i]].operation);
+        }
+    }
+    else
+    {
+        std::vector<float>().swap(m_arena);
+    }
+
+    for (const std::vector<uint32_t>& wave : waves)
+    {
+        ParallelFor(0, wave.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                ExecuteNode(wave[i], storage[wave[i]], storageCapacity[wave[i]]);
+        });
+    }
+}
+
+CpuImage& CpuPipeline::GetOutputImage()
+{
+    assert(!m_outputs.empty());
+    Node& output = m_nodes[m_outputs.front()];
+    if (output.operation.empty())
+        throw "CpuPipeline output is an input node.";
+    if (!output.pOperation)
+        throw "CpuPipeline has not been executed.";
+    return output.pOperation->GetOutputImage();
+}
+
+const CpuImage& CpuPipeline::GetImage(uint32_t node) const
+{
+    const Node& current = m_nodes[node];
+    if (current.operation.empty())
+        return *current.pImage;
+
+    assert(current.pOperation);
+    return current.pOperation->GetOutputImage();
+}
+
+static std::string TrimSpaces(const std::string& text)
+{
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos)
+        return std::string();
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(begin, end - begin + 1);
+}
+
+std::vector<PipelineRecipeStep> CS570::ParsePipelineRecipe(const std::string& recipe)
+{
+    std::vector<PipelineRecipeStep> steps;
+    size_t begin = 0;
+    while (begin < recipe.size())
+    {
+        size_t end = recipe.find(';', begin);
+        if (end == std::string::npos)
+            end = recipe.size();
+
+        std::string statement = TrimSpaces(recipe.substr(begin, end - begin));
+        begin = end + 1;
+        if (statement.empty())
+            continue;
+
+        size_t equals = statement.find('=');
+        size_t open = statement.find('(', equals);
+        size_t close = statement.rfind(')');
+        if (equals == std::string::npos || open == std::string::npos || close == std::string::npos || close < open)
+            throw "Malformed pipeline recipe step.";
+
+        PipelineRecipeStep step;
+        step.name = TrimSpaces(statement.substr(0, equals));
+        step.operation = TrimSpaces(statement.substr(equals + 1, open - equals - 1));
+
+        std::string arguments = statement.substr(open + 1, close - open - 1);
+        size_t comma = arguments.find(',');
+        step.inputs[0] = TrimSpaces(arguments.substr(0, comma));
+        if (comma != std::string::npos)
+            step.inputs[1] = TrimSpaces(arguments.substr(comma + 1));
+
+        if (step.name.empty() || step.operation.empty() || step.inputs[0].empty())
+            throw "Malformed pipeline recipe step.";
+
+        steps.push_back(step);
+    }
+
+    if (steps.empty())
+        throw "Empty pipeline recipe.";
+
+    return steps;
+}
+
+uint32_t CS570::AddPipelineRecipe(
+    const std::vector<PipelineRecipeStep>& steps,
+    const std::vector<std::string>& inputNames,
+    const std::vector<uint32_t>& inputNodes,
+    const CpuPipelineParameters& parameters,
+    CpuPipeline* pPipeline)
+{
+    assert(inputNames.size() == inputNodes.size());
+
+    std::vector<std::string> names = inputNames;
+    std::vector<uint32_t> nodes = inputNodes;
+    auto findNode = [&](const std::string& name) {
+        if (name.empty())
+            return CpuPipeline::k_invalidNode;
+
+        auto it = std::find(names.rbegin(), names.rend(), name);
+        if (it == names.rend())
+            throw "Unknown pipeline recipe input.";
+        return nodes[names.rend() - it - 1];
+    };
+
+    uint32_t node = CpuPipeline::k_invalidNode;
+    for (const PipelineRecipeStep& step : steps)
+    {
+        node = pPipeline->AddOperation(step.operation, findNode(step.inputs[0]), findNode(step.inputs[1]), parameters);
+        names.push_back(step.name);
+        nodes.push_back(node);
+    }
+
+    pPipeline->AddOutput(node);
+    return node;
+}
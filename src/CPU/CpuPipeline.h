@@ -0,0 +1,145 @@
+#pragma once
+
+#include "CpuGaussianBlur.h"
+#include "CpuImageProcessor.h"
+#include "MemoryPlanner.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace CS570
+{
+    // Parameters of one pipeline node, the same knobs CpuOperationSet exposes. Each operation only
+    // reads the ones it uses.
+    struct CpuPipelineParameters
+    {
+        uint32_t blurKernelSize = 3u;
+        float blurVariance = 1.0f;
+        GaussianBlurAlgorithm blurAlgorithm = GaussianBlurAlgorithm::Auto;
+        float weightInput1 = 1.0f;
+        float weightInput2 = 1.0f;
+        float logConstant = 1.0f;
+        float powerConstant = 1.0f;
+        float powerRaise = 1.0f;
+        uint32_t histogramBinCount = 8u;
+        uint32_t adaptiveTileCount = 8u;
+        float adaptiveClipLimit = 2.0f;
+        uint32_t adaptiveBinCount = 256u;
+    };
+
+    // DAG of CPU operations. Nodes are inputs or operations (by the CpuOperationSet names) and edges
+    // are the images passed between them. Execute runs the nodes in topological waves: every node
+    // whose inputs are ready runs concurrently on the ParallelFor workers, and an operation's own
+    // ParallelFor loops pick up whatever threads the wave leaves idle. Operations are created when
+    // they are scheduled and an intermediate image is freed as soon as its last consumer finishes,
+    // so only outputs outlive Execute.
+    //
+    // With memory planning on (the default), operation outputs aren't allocated per node: Execute
+    // plans their live ranges over the waves with PlanTransientMemory and places every output in
+    // one arena, so intermediates whose ranges don't overlap share memory. Scratch buffers internal
+    // to an operation are still its own and are freed with it.
+    class CpuPipeline : public BaseCpuImageProcessor
+    {
+    public:
+        static const uint32_t k_invalidNode = 0xFFFFFFFFu;
+
+        // The image must stay alive while the pipeline is executed.
+        uint32_t AddInput(const CpuImage& image);
+        // input2 is required by Add, Subtract, Product and Histogram Match, ignored otherwise.
+        uint32_t AddOperation(
+            const std::string& operation,
+            uint32_t input1,
+            uint32_t input2 = k_invalidNode,
+            const CpuPipelineParameters& parameters = CpuPipelineParameters());
+        void AddOutput(uint32_t node);
+
+        // Rebinds an input node, e.g. after the source image was reloaded.
+        void SetInput(uint32_t node, const CpuImage& image);
+        // Applies to every operation node; takes effect on the next Execute.
+        void SetParameters(const CpuPipelineParameters& parameters);
+
+        // Topological order of the nodes the outputs depend on, grouped into the waves Execute runs;
+        // the nodes of a wave don't depend on each other.
+        std::vector<std::vector<uint32_t>> GetSchedule() const;
+
+        // Rows of the inputs above and below a band of output rows that the outputs depend on, summed
+        // along the longest chain of operations: Gaussian Blur and Unsharp Mask need the kernel
+        // radius, Sobel Filter 1 and pointwise operations none. Throws for the operations that need
+        // the whole image, the histogram ones and the Fourier transform.
+        uint32_t GetRowHalo() const;
+
+        // Output size of a node, known before Execute from the input sizes.
+        void GetImageSize(uint32_t node, uint32_t* pWidth, uint32_t* pHeight) const;
+
+        // Plans the operation outputs of the current schedule; plan.offsets[i] belongs to
+        // pNodes[i]. Lets callers check the peak footprint (plan.arenaSize) before executing.
+        MemoryPlan PlanMemory(std::vector<uint32_t>* pNodes = nullptr) const;
+
+        void SetMemoryPlanning(bool enabled) { m_planMemory = enabled; }
+
+        void Execute() override;
+
+        // The first output.
+        CpuImage& GetOutputImage() override;
+        // Inputs, and outputs once Execute has run.
+        const CpuImage& GetImage(uint32_t node) const;
+
+        size_t GetNodeCount() const { return m_nodes.size(); }
+        void Clear();
+
+    private:
+        struct ImageSize
+        {
+            uint32_t width = 0u;
+            uint32_t height = 0u;
+        };
+
+        struct Node
+        {
+            std::string operation;
+            uint32_t inputs[2] = { k_invalidNode, k_invalidNode };
+            CpuPipelineParameters parameters;
+            const CpuImage* pImage = nullptr;
+            bool isOutput = false;
+            std::unique_ptr<BaseCpuImageProcessor> pOperation;
+        };
+
+        // Output sizes of every node, in one pass in node order, since a node's inputs are always
+        // added before it.
+        std::vector<ImageSize> GetImageSizes() const;
+        MemoryPlan PlanMemory(const std::vector<ImageSize>& sizes, std::vector<uint32_t>* pNodes) const;
+        void ExecuteNode(uint32_t node, float* pStorage, size_t storageCapacity);
+
+        std::vector<Node> m_nodes;
+        std::vector<uint32_t> m_outputs;
+        // Consumers of each node that haven't run yet in the current Execute.
+        std::unique_ptr<std::atomic<uint32_t>[]> m_pendingConsumers;
+
+        bool m_planMemory = true;
+        std::vector<float> m_arena;
+    };
+
+    // One "name = Operation(input[, input])" statement of a pipeline recipe.
+    struct PipelineRecipeStep
+    {
+        std::string name;
+        std::string operation;
+        std::string inputs[2];
+    };
+
+    // Parses a recipe of ';' separated steps, e.g.
+    //   blur = Gaussian Blur(input1); edges = Sobel Filter(blur); out = Add(blur, edges)
+    // Inputs name earlier steps or the pipeline inputs. Throws on malformed recipes.
+    std::vector<PipelineRecipeStep> ParsePipelineRecipe(const std::string& recipe);
+
+    // Adds the recipe steps to pPipeline, with inputNames[i] bound to inputNodes[i], and marks the
+    // last step as an output. Returns its node.
+    uint32_t AddPipelineRecipe(
+        const std::vector<PipelineRecipeStep>& steps,
+        const std::vector<std::string>& inputNames,
+        const std::vector<uint32_t>& inputNodes,
+        const CpuPipelineParameters& parameters,
+        CpuPipeline* pPipeline);
+}
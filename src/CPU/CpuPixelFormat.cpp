@@ -0,0 +1,43 @@
+#include "CpuPixelFormat.h"
+
+using namespace CS570;
+
+template <typename T, uint32_t ChannelCount>
+static void ConvertToFloat(const T* pSrc, size_t pixelCount, PixelChannels<ChannelCount> channels, float* pDst)
+{
+    for (size_t pixel = 0; pixel < pixelCount; ++pixel)
+        LoadPixel(pSrc + pixel * ChannelCount, channels).Store(pDst + pixel * 4);
+}
+
+template <typename T, uint32_t ChannelCount>
+static void ConvertFromFloat(const float* pSrc, size_t pixelCount, PixelChannels<ChannelCount> channels, T* pDst)
+{
+    for (size_t pixel = 0; pixel < pixelCount; ++pixel)
+        StorePixel(Float4::Load(pSrc + pixel * 4), pDst + pixel * ChannelCount, channels);
+}
+
+void CS570::ConvertPixelsToFloat(const uint8_t* pSrc, size_t pixelCount, CpuPixelFormat format, float* pDst)
+{
+    if (format == CpuPixelFormat::RGBA32F)
+    {
+        std::memcpy(pDst, pSrc, pixelCount * GetPixelSize(format));
+        return;
+    }
+
+    DispatchPixelFormat(format, [&](auto sample, auto channels) {
+        ConvertToFloat(reinterpret_cast<const decltype(sample)*>(pSrc), pixelCount, channels, pDst);
+    });
+}
+
+void CS570::ConvertPixelsFromFloat(const float* pSrc, size_t pixelCount, CpuPixelFormat format, uint8_t* pDst)
+{
+    if (format == CpuPixelFormat::RGBA32F)
+    {
+        std::memcpy(pDst, pSrc, pixelCount * GetPixelSize(format));
+        return;
+    }
+
+    DispatchPixelFormat(format, [&](auto sample, auto channels) {
+        ConvertFromFloat(pSrc, pixelCount, channels, reinterpret_cast<decltype(sample)*>(pDst));
+    });
+}
@@ -0,0 +1,269 @@
+#pragma once
+
+#include "CpuSimd.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace CS570
+{
+    // Sample types of a CpuImage or a tiled image, the formats the engine's textures use. Kernels
+    // compute in f32, widening samples as they load them, so an image can keep the sample type of
+    // its file: an 8 bit ppm stored as RGBA8 takes a quarter of the memory it takes as RGBA32F. The
+    // single channel formats hold grey images as one plane of red samples, which read back as
+    // (r, r, r, 1).
+    enum class CpuPixelFormat : uint32_t
+    {
+        // DXGI_FORMAT_R8G8B8A8_UNORM
+        RGBA8,
+        // DXGI_FORMAT_R16G16B16A16_UNORM
+        RGBA16,
+        // DXGI_FORMAT_R16G16B16A16_FLOAT
+        RGBA16F,
+        // DXGI_FORMAT_R32G32B32A32_FLOAT
+        RGBA32F,
+        // DXGI_FORMAT_R8_UNORM
+        R8,
+        // DXGI_FORMAT_R16_UNORM
+        R16,
+        // DXGI_FORMAT_R32_FLOAT
+        R32F,
+    };
+
+    // Sample type of RGBA16F.
+    struct Half
+    {
+        uint16_t bits;
+    };
+
+    // Bytes per pixel.
+    inline uint32_t GetPixelSize(CpuPixelFormat format)
+    {
+        switch (format)
+        {
+        case CpuPixelFormat::RGBA8: return 4u;
+        case CpuPixelFormat::RGBA16: return 8u;
+        case CpuPixelFormat::RGBA16F: return 8u;
+        case CpuPixelFormat::RGBA32F: return 16u;
+        case CpuPixelFormat::R8: return 1u;
+        case CpuPixelFormat::R16: return 2u;
+        case CpuPixelFormat::R32F: return 4u;
+        }
+        return 0u;
+    }
+
+    inline uint32_t GetChannelCount(CpuPixelFormat format)
+    {
+        return format == CpuPixelFormat::R8 || format == CpuPixelFormat::R16 || format == CpuPixelFormat::R32F ? 1u : 4u;
+    }
+
+    // The RGBA format with the same sample type, which a single channel image expands to for display
+    // and export.
+    inline CpuPixelFormat GetRgbaFormat(CpuPixelFormat format)
+    {
+        switch (format)
+        {
+        case CpuPixelFormat::R8: return CpuPixelFormat::RGBA8;
+        case CpuPixelFormat::R16: return CpuPixelFormat::RGBA16;
+        case CpuPixelFormat::R32F: return CpuPixelFormat::RGBA32F;
+        default: return format;
+        }
+    }
+
+    template <uint32_t ChannelCount>
+    using PixelChannels = std::integral_constant<uint32_t, ChannelCount>;
+
+    // Calls func with a value of the sample type of format (uint8_t, uint16_t, Half or float) and its
+    // channel count as a PixelChannels, so a kernel templated on both can be picked at run time:
+    // DispatchPixelFormat(format, [&](auto sample, auto channels) { Kernel<decltype(sample)>(..., channels); });
+    template <typename Func>
+    inline void DispatchPixelFormat(CpuPixelFormat format, Func&& func)
+    {
+        switch (format)
+        {
+        case CpuPixelFormat::RGBA8: func(uint8_t(), PixelChannels<4>()); break;
+        case CpuPixelFormat::RGBA16: func(uint16_t(), PixelChannels<4>()); break;
+        case CpuPixelFormat::RGBA16F: func(Half(), PixelChannels<4>()); break;
+        case CpuPixelFormat::RGBA32F: func(float(), PixelChannels<4>()); break;
+        case CpuPixelFormat::R8: func(uint8_t(), PixelChannels<1>()); break;
+        case CpuPixelFormat::R16: func(uint16_t(), PixelChannels<1>()); break;
+        case CpuPixelFormat::R32F: func(float(), PixelChannels<1>()); break;
+        }
+    }
+
+    // Round to nearest even, with overflow going to infinity.
+    inline uint16_t FloatToHalf(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        const uint32_t sign = (bits >> 16) & 0x8000u;
+        uint32_t magnitude = bits & 0x7FFFFFFFu;
+
+        // Infinity and NaN, and everything from 65536 up.
+        if (magnitude >= 0x47800000u)
+            return static_cast<uint16_t>(sign | (magnitude > 0x7F800000u ? 0x7E00u : 0x7C00u));
+
+        // Below the smallest normal half: adding 0.5 lines the half's denormal mantissa up with the
+        // bottom of the float's and rounds it.
+        if (magnitude < 0x38800000u)
+        {
+            float denormal;
+            std::memcpy(&denormal, &magnitude, sizeof(denormal));
+            denormal += 0.5f;
+            std::memcpy(&magnitude, &denormal, sizeof(magnitude));
+            return static_cast<uint16_t>(sign | (magnitude - 0x3F000000u));
+        }
+
+        // Rebias the exponent and round the 13 dropped mantissa bits.
+        const uint32_t mantissaOdd = (magnitude >> 13) & 1u;
+        magnitude += 0xC8000FFFu + mantissaOdd;
+        return static_cast<uint16_t>(sign | (magnitude >> 13));
+    }
+
+    inline float HalfToFloat(uint16_t half)
+    {
+        const uint32_t sign = uint32_t(half & 0x8000u) << 16;
+        const uint32_t exponent = (half >> 10) & 0x1Fu;
+        const uint32_t mantissa = half & 0x3FFu;
+
+        uint32_t bits;
+        if (exponent == 0x1F)
+        {
+            bits = sign | 0x7F800000u | (mantissa << 13);
+        }
+        else if (exponent != 0)
+        {
+            bits = sign | ((exponent + 112u) << 23) | (mantissa << 13);
+        }
+        else
+        {
+            const float denormal = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+            std::memcpy(&bits, &denormal, sizeof(bits));
+            bits |= sign;
+        }
+
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // A sample as f32, UNORM samples scaled to [0, 1].
+    inline float LoadSample(uint8_t sample) { return sample * (1.0f / 255.0f); }
+    inline float LoadSample(uint16_t sample) { return sample * (1.0f / 65535.0f); }
+    inline float LoadSample(Half sample) { return HalfToFloat(sample.bits); }
+    inline float LoadSample(float sample) { return sample; }
+
+    // An RGBA pixel as f32.
+    inline Float4 LoadPixel(const float* pSrc) { return Float4::Load(pSrc); }
+    inline Float4 LoadPixel(const Half* pSrc)
+    {
+        return Float4(HalfToFloat(pSrc[0].bits), HalfToFloat(pSrc[1].bits), HalfToFloat(pSrc[2].bits), HalfToFloat(pSrc[3].bits));
+    }
+
+#if CS570_CPU_SSE2
+    inline Float4 LoadPixel(const uint8_t* pSrc)
+    {
+        int32_t bytes;
+        std::memcpy(&bytes, pSrc, sizeof(bytes));
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i words = _mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero);
+        return Float4(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero)), _mm_set1_ps(1.0f / 255.0f)));
+    }
+
+    inline Float4 LoadPixel(const uint16_t* pSrc)
+    {
+        const __m128i words = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pSrc));
+        return Float4(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(words, _mm_setzero_si128())), _mm_set1_ps(1.0f / 65535.0f)));
+    }
+#else
+    inline Float4 LoadPixel(const uint8_t* pSrc)
+    {
+        return Float4(LoadSample(pSrc[0]), LoadSample(pSrc[1]), LoadSample(pSrc[2]), LoadSample(pSrc[3]));
+    }
+
+    inline Float4 LoadPixel(const uint16_t* pSrc)
+    {
+        return Float4(LoadSample(pSrc[0]), LoadSample(pSrc[1]), LoadSample(pSrc[2]), LoadSample(pSrc[3]));
+    }
+#endif
+
+    // A pixel of either layout as RGBA f32, grey samples going to all three color channels.
+    template <typename T>
+    inline Float4 LoadPixel(const T* pSrc, PixelChannels<4>) { return LoadPixel(pSrc); }
+    template <typename T>
+    inline Float4 LoadPixel(const T* pSrc, PixelChannels<1>)
+    {
+        const float grey = LoadSample(*pSrc);
+        return Float4(grey, grey, grey, 1.0f);
+    }
+
+    // Stores an RGBA pixel, saturating UNORM formats the way a UNORM render target does.
+    inline void StorePixel(Float4 pixel, float* pDst) { pixel.Store(pDst); }
+    inline void StorePixel(Float4 pixel, Half* pDst)
+    {
+        float lanes[4];
+        pixel.Store(lanes);
+        for (uint32_t i = 0; i < 4; ++i)
+            pDst[i].bits = FloatToHalf(lanes[i]);
+    }
+
+#if CS570_CPU_SSE2
+    inline void StorePixel(Float4 pixel, uint8_t* pDst)
+    {
+        const Float4 unorm = Min(Max(pixel, Float4(0.0f)), Float4(1.0f)) * Float4(255.0f) + Float4(0.5f);
+        const __m128i dwords = _mm_cvttps_epi32(unorm.v);
+        const __m128i words = _mm_packs_epi32(dwords, dwords);
+        const int32_t bytes = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+        std::memcpy(pDst, &bytes, sizeof(bytes));
+    }
+
+    inline void StorePixel(Float4 pixel, uint16_t* pDst)
+    {
+        // SSE2 can only pack to signed words, so the samples are offset into their range and back.
+        const Float4 unorm = Min(Max(pixel, Float4(0.0f)), Float4(1.0f)) * Float4(65535.0f) + Float4(0.5f);
+        const __m128i dwords = _mm_sub_epi32(_mm_cvttps_epi32(unorm.v), _mm_set1_epi32(32768));
+        const __m128i words = _mm_xor_si128(_mm_packs_epi32(dwords, dwords), _mm_set1_epi16(-32768));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(pDst), words);
+    }
+#else
+    inline void StorePixel(Float4 pixel, uint8_t* pDst)
+    {
+        float lanes[4];
+        Min(Max(pixel, Float4(0.0f)), Float4(1.0f)).Store(lanes);
+        for (uint32_t i = 0; i < 4; ++i)
+            pDst[i] = static_cast<uint8_t>(lanes[i] * 255.0f + 0.5f);
+    }
+
+    inline void StorePixel(Float4 pixel, uint16_t* pDst)
+    {
+        float lanes[4];
+        Min(Max(pixel, Float4(0.0f)), Float4(1.0f)).Store(lanes);
+        for (uint32_t i = 0; i < 4; ++i)
+            pDst[i] = static_cast<uint16_t>(lanes[i] * 65535.0f + 0.5f);
+    }
+#endif
+
+    // Stores the red channel of a pixel as a grey sample, saturating UNORM formats.
+    inline void StoreSample(float value, float* pDst) { *pDst = value; }
+    inline void StoreSample(float value, Half* pDst) { pDst->bits = FloatToHalf(value); }
+    inline void StoreSample(float value, uint8_t* pDst) { *pDst = static_cast<uint8_t>(std::fmin(std::fmax(value, 0.0f), 1.0f) * 255.0f + 0.5f); }
+    inline void StoreSample(float value, uint16_t* pDst) { *pDst = static_cast<uint16_t>(std::fmin(std::fmax(value, 0.0f), 1.0f) * 65535.0f + 0.5f); }
+
+    template <typename T>
+    inline void StorePixel(Float4 pixel, T* pDst, PixelChannels<4>) { StorePixel(pixel, pDst); }
+    template <typename T>
+    inline void StorePixel(Float4 pixel, T* pDst, PixelChannels<1>)
+    {
+        float lanes[4];
+        pixel.Store(lanes);
+        StoreSample(lanes[0], pDst);
+    }
+
+    // Converts pixelCount pixels of format to RGBA32F, and back, single channel formats expanding to
+    // (r, r, r, 1) and keeping just the red channel.
+    void ConvertPixelsToFloat(const uint8_t* pSrc, size_t pixelCount, CpuPixelFormat format, float* pDst);
+    void ConvertPixelsFromFloat(const float* pSrc, size_t pixelCount, CpuPixelFormat format, uint8_t* pDst);
+}
@@ -0,0 +1,145 @@
+#include "CpuRecursiveGaussian.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+using namespace CS570;
+
+void CS570::ComputeRecursiveGaussianCoefficients(float sigma, RecursiveGaussianCoefficients* pCoefficients)
+{
+    const double s = std::max(static_cast<double>(sigma), 0.5);
+    const double q = s >= 2.5 ? 0.98711 * s - 0.96330 : 3.97156 - 4.14554 * std::sqrt(1.0 - 0.26891 * s);
+    const double q2 = q * q;
+    const double q3 = q2 * q;
+
+    const double b0 = 1.57825 + 2.44413 * q + 1.4281 * q2 + 0.422205 * q3;
+    const double b1 = 2.44413 * q + 2.85619 * q2 + 1.26661 * q3;
+    const double b2 = -(1.4281 * q2 + 1.26661 * q3);
+    const double b3 = 0.422205 * q3;
+
+    const double a[3] = { b1 / b0, b2 / b0, b3 / b0 };
+    const double b = 1.0 - (a[0] + a[1] + a[2]);
+
+    pCoefficients->b = static_cast<float>(b);
+    for (int i = 0; i < 3; ++i)
+        pCoefficients->a[i] = static_cast<float>(a[i]);
+
+    // Run the zero input tail of the causal pass for each unit state, then the anti-causal pass back
+    // over it, to find how the last causal outputs map to the anti-causal initial state. The tail
+    // only has to be long enough for the filter response to die out, a few sigma.
+    const size_t tailLength = static_cast<size_t>(std::ceil(12.0 * s)) + 32;
+    std::vector<double> w(tailLength + 3);
+    std::vector<double> v(tailLength + 6);
+    for (int column = 0; column < 3; ++column)
+    {
+        // w[0], w[1], w[2] are w[N-3], w[N-2], w[N-1].
+        std::fill(w.begin(), w.end(), 0.0);
+        w[2 - column] = 1.0;
+        for (size_t n = 3; n < w.size(); ++n)
+            w[n] = a[0] * w[n - 1] + a[1] * w[n - 2] + a[2] * w[n - 3];
+
+        std::fill(v.begin(), v.end(), 0.0);
+        for (size_t n = w.size(); n-- > 3;)
+            v[n] = b * w[n] + a[0] * v[n + 1] + a[1] * v[n + 2] + a[2] * v[n + 3];
+
+        for (int row = 0; row < 3; ++row)
+            pCoefficients->boundary[row * 3 + column] = static_cast<float>(v[3 + row]);
+    }
+}
+
+void CS570::RecursiveGaussianFilterRow(
+    const RecursiveGaussianCoefficients& coefficients, const float* pInput, float* pOutput, size_t count)
+{
+    if (count == 0)
+        return;
+
+    const float b = coefficients.b;
+    const float a0 = coefficients.a[0];
+    const float a1 = coefficients.a[1];
+    const float a2 = coefficients.a[2];
+
+    float w1 = 0.0f, w2 = 0.0f, w3 = 0.0f;
+    for (size_t n = 0; n < count; ++n)
+    {
+        float w = b * pInput[n] + a0 * w1 + a1 * w2 + a2 * w3;
+        w3 = w2;
+        w2 = w1;
+        w1 = w;
+        pOutput[n] = w;
+    }
+
+    // w1, w2, w3 now hold w[N-1], w[N-2], w[N-3].
+    const float* m = coefficients.boundary;
+    float v1 = m[0] * w1 + m[1] * w2 + m[2] * w3;
+    float v2 = m[3] * w1 + m[4] * w2 + m[5] * w3;
+    float v3 = m[6] * w1 + m[7] * w2 + m[8] * w3;
+    for (size_t n = count; n-- > 0;)
+    {
+        float v = b * pOutput[n] + a0 * v1 + a1 * v2 + a2 * v3;
+        v3 = v2;
+        v2 = v1;
+        v1 = v;
+        pOutput[n] = v;
+    }
+}
+
+void CS570::RecursiveGaussianFilterColumns(
+    const RecursiveGaussianCoefficients& coefficients,
+    float* pPlane,
+    size_t rowPitch,
+    size_t rowCount,
+    size_t columnBegin,
+    size_t columnEnd)
+{
+    if (rowCount == 0 || columnEnd <= columnBegin)
+        return;
+
+    const float b = coefficients.b;
+    const float a0 = coefficients.a[0];
+    const float a1 = coefficients.a[1];
+    const float a2 = coefficients.a[2];
+    const size_t columnCount = columnEnd - columnBegin;
+
+    // Three previous rows of state per column, so the inner loops run along a row.
+    std::vector<float> state(columnCount * 3, 0.0f);
+    float* s1 = state.data();
+    float* s2 = s1 + columnCount;
+    float* s3 = s2 + columnCount;
+
+    for (size_t y = 0; y < rowCount; ++y)
+    {
+        float* pRow = pPlane + y * rowPitch + columnBegin;
+        for (size_t x = 0; x < columnCount; ++x)
+        {
+            float w = b * pRow[x] + a0 * s1[x] + a1 * s2[x] + a2 * s3[x];
+            s3[x] = s2[x];
+            s2[x] = s1[x];
+            s1[x] = w;
+            pRow[x] = w;
+        }
+    }
+
+    const float* m = coefficients.boundary;
+    for (size_t x = 0; x < columnCount; ++x)
+    {
+        float w1 = s1[x], w2 = s2[x], w3 = s3[x];
+        s1[x] = m[0] * w1 + m[1] * w2 + m[2] * w3;
+        s2[x] = m[3] * w1 + m[4] * w2 + m[5] * w3;
+        s3[x] = m[6] * w1 + m[7] * w2 + m[8] * w3;
+    }
+
+    for (size_t y = rowCount; y-- > 0;)
+    {
+        float* pRow = pPlane + y * rowPitch + columnBegin;
+        for (size_t x = 0; x < columnCount; ++x)
+        {
+            float v = b * pRow[x] + a0 * s1[x] + a1 * s2[x] + a2 * s3[x];
+            s3[x] = s2[x];
+            s2[x] = s1[x];
+            s1[x] = v;
+            pRow[x] = v;
+        }
+    }
+}
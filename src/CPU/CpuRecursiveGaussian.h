@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace CS570
+{
+    // Young - van Vliet recursive Gaussian (Signal Processing 44, 1995): a causal and an anti-causal
+    // third order IIR pass per axis, so the cost per pixel is the same for every sigma. Out of bounds
+    // input is zero, like Texture2D::Load in the direct blur, and the anti-causal pass starts from the
+    // exact state the causal pass would reach on that zero tail (Triggs and Sdika, 2006).
+    //
+    // Accuracy: against the untruncated, normalized 2D Gaussian of the same sigma, the worst case
+    // absolute error for any input in [0, 1] (half the L1 norm of the impulse response difference)
+    // is below k_recursiveGaussianMaxError for sigma >= k_recursiveGaussianSigmaThreshold, and falls
+    // to about 0.02 by sigma 16. Below the threshold it grows quickly (0.067 at sigma 2, 0.12 at
+    // sigma 1), while a direct kernel is cheap there anyway.
+    static const float k_recursiveGaussianSigmaThreshold = 3.0f;
+    static const float k_recursiveGaussianMaxError = 0.05f;
+
+    struct RecursiveGaussianCoefficients
+    {
+        float b;      // input gain B
+        float a[3];   // feedback b1/b0, b2/b0, b3/b0
+        // Anti-causal initial state (v[N], v[N+1], v[N+2]) = boundary * (w[N-1], w[N-2], w[N-3]),
+        // row major.
+        float boundary[9];
+    };
+
+    void ComputeRecursiveGaussianCoefficients(float sigma, RecursiveGaussianCoefficients* pCoefficients);
+
+    // Filters count contiguous values. pInput and pOutput may be the same buffer.
+    void RecursiveGaussianFilterRow(
+        const RecursiveGaussianCoefficients& coefficients, const float* pInput, float* pOutput, size_t count);
+
+    // Filters columns [columnBegin, columnEnd) of a row major plane in place, walking whole rows so
+    // the columns are processed side by side.
+    void RecursiveGaussianFilterColumns(
+        const RecursiveGaussianCoefficients& coefficients,
+        float* pPlane,
+        size_t rowPitch,
+        size_t rowCount,
+        size_t columnBegin,
+        size_t columnEnd);
+}
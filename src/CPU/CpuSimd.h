@@ -0,0 +1,71 @@
+#pragma once
+
+// Minimal 4-wide float vector for the CPU backend. One Float4 holds exactly one RGBA32F pixel, so
+// the pointwise kernels process a pixel per instruction. Falls back to scalar code when SSE2 isn't
+// available (e.g. ARM build nodes).
+
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CS570_CPU_SSE2 1
+#include <emmintrin.h>
+#else
+#define CS570_CPU_SSE2 0
+#endif
+
+namespace CS570
+{
+#if CS570_CPU_SSE2
+    struct Float4
+    {
+        __m128 v;
+
+        Float4() {}
+        Float4(__m128 value) : v(value) {}
+        explicit Float4(float scalar) : v(_mm_set1_ps(scalar)) {}
+        Float4(float x, float y, float z, float w) : v(_mm_setr_ps(x, y, z, w)) {}
+
+        static Float4 Load(const float* pSrc) { return Float4(_mm_loadu_ps(pSrc)); }
+        void Store(float* pDst) const { _mm_storeu_ps(pDst, v); }
+
+        float X() const { return _mm_cvtss_f32(v); }
+
+        friend Float4 operator+(Float4 a, Float4 b) { return Float4(_mm_add_ps(a.v, b.v)); }
+        friend Float4 operator-(Float4 a, Float4 b) { return Float4(_mm_sub_ps(a.v, b.v)); }
+        friend Float4 operator*(Float4 a, Float4 b) { return Float4(_mm_mul_ps(a.v, b.v)); }
+        friend Float4 Min(Float4 a, Float4 b) { return Float4(_mm_min_ps(a.v, b.v)); }
+        friend Float4 Max(Float4 a, Float4 b) { return Float4(_mm_max_ps(a.v, b.v)); }
+        friend Float4 Sqrt(Float4 a) { return Float4(_mm_sqrt_ps(a.v)); }
+    };
+#else
+    struct Float4
+    {
+        float v[4];
+
+        Float4() {}
+        explicit Float4(float scalar) { v[0] = v[1] = v[2] = v[3] = scalar; }
+        Float4(float x, float y, float z, float w) { v[0] = x; v[1] = y; v[2] = z; v[3] = w; }
+
+        static Float4 Load(const float* pSrc) { return Float4(pSrc[0], pSrc[1], pSrc[2], pSrc[3]); }
+        void Store(float* pDst) const { pDst[0] = v[0]; pDst[1] = v[1]; pDst[2] = v[2]; pDst[3] = v[3]; }
+
+        float X() const { return v[0]; }
+
+        friend Float4 operator+(Float4 a, Float4 b) { return Float4(a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]); }
+        friend Float4 operator-(Float4 a, Float4 b) { return Float4(a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]); }
+        friend Float4 operator*(Float4 a, Float4 b) { return Float4(a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]); }
+        friend Float4 Min(Float4 a, Float4 b) { return Float4(std::fmin(a.v[0], b.v[0]), std::fmin(a.v[1], b.v[1]), std::fmin(a.v[2], b.v[2]), std::fmin(a.v[3], b.v[3])); }
+        friend Float4 Max(Float4 a, Float4 b) { return Float4(std::fmax(a.v[0], b.v[0]), std::fmax(a.v[1], b.v[1]), std::fmax(a.v[2], b.v[2]), std::fmax(a.v[3], b.v[3])); }
+        friend Float4 Sqrt(Float4 a) { return Float4(std::sqrt(a.v[0]), std::sqrt(a.v[1]), std::sqrt(a.v[2]), std::sqrt(a.v[3])); }
+    };
+#endif
+
+    // log/pow have no SSE2 instruction, apply them per lane.
+    template <typename Func>
+    inline Float4 PerLane(Float4 a, Func func)
+    {
+        float lanes[4];
+        a.Store(lanes);
+        return Float4(func(lanes[0]), func(lanes[1]), func(lanes[2]), func(lanes[3]));
+    }
+}
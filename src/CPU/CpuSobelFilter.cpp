@@ -0,0 +1,111 @@
+#include "CpuSobelFilter.h"
+
+#include "CpuParallel.h"
+
+#include <cassert>
+#include <cmath>
+
+using namespace CS570;
+
+// Red channel of image row y with a zero texel on either side, zeros when y is outside the image.
+static void LoadPaddedRedRow(const CpuImage& image, int y, float* pRow)
+{
+    const uint32_t width = image.GetWidth();
+    pRow[0] = 0.0f;
+    pRow[width + 1] = 0.0f;
+    if (y < 0 || y >= static_cast<int>(image.GetHeight()))
+    {
+        for (uint32_t x = 0; x < width; ++x)
+            pRow[x + 1] = 0.0f;
+        return;
+    }
+
+    LoadRedRow(image, static_cast<uint32_t>(y), pRow + 1);
+}
+
+void CpuSobelFilter::OnCreate(const CpuImage& input, uint32_t planeOutputs)
+{
+    m_pInput = &input;
+    m_planeOutputs = planeOutputs;
+
+    m_combinedOutput.Resize(input.GetWidth(), input.GetHeight(), CpuPixelFormat::R32F);
+    for (uint32_t plane = 0; plane < k_sobelOutputPlaneCount; ++plane)
+    {
+        // Planes left over from an earlier OnCreate are released so none of them outlives its bit.
+        if ((planeOutputs & (1u << plane)) != 0)
+            m_planes[plane].resize(input.GetPixelCount());
+        else
+            std::vector<float>().swap(m_planes[plane]);
+    }
+}
+
+void CpuSobelFilter::OnDestroy()
+{
+    m_combinedOutput.Release();
+    for (std::vector<float>& plane : m_planes)
+        std::vector<float>().swap(plane);
+    m_planeOutputs = 0u;
+    m_pInput = nullptr;
+}
+
+const std::vector<float>& CpuSobelFilter::GetPlane(uint32_t output) const
+{
+    uint32_t plane = GetSobelPlaneIndex(output);
+    assert((m_planeOutputs & output) != 0);
+    return m_planes[plane];
+}
+
+void CpuSobelFilter::Execute()
+{
+    assert(m_pInput != nullptr);
+
+    const CpuImage& input = *m_pInput;
+    const uint32_t width = m_combinedOutput.GetWidth();
+    const size_t rowPitch = size_t(width) + 2;
+
+    float* pGradientXPlane = (m_planeOutputs & k_sobelOutputGradientX) != 0 ? m_planes[0].data() : nullptr;
+    float* pGradientYPlane = (m_planeOutputs & k_sobelOutputGradientY) != 0 ? m_planes[1].data() : nullptr;
+    float* pOrientationPlane = (m_planeOutputs & k_sobelOutputOrientation) != 0 ? m_planes[2].data() : nullptr;
+
+    ParallelFor(0, m_combinedOutput.GetHeight(), 32, [&](size_t rowBegin, size_t rowEnd) {
+        // Rows y - 1, y and y + 1, rotated as the chunk moves down so each input row is read once
+        // (plus the two halo rows at the chunk edges).
+        std::vector<float> window(rowPitch * 3);
+        float* pAbove = window.data();
+        float* pCenter = pAbove + rowPitch;
+        float* pBelow = pCenter + rowPitch;
+        LoadPaddedRedRow(input, static_cast<int>(rowBegin) - 1, pAbove);
+        LoadPaddedRedRow(input, static_cast<int>(rowBegin), pCenter);
+
+        for (size_t y = rowBegin; y < rowEnd; ++y)
+        {
+            LoadPaddedRedRow(input, static_cast<int>(y) + 1, pBelow);
+
+            const size_t planeOffset = y * width;
+            float* pOutput = m_combinedOutput.GetRowSamples<float>(static_cast<uint32_t>(y));
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                float horiz =
+                    (pAbove[x + 2] - pAbove[x]) +
+                    2.0f * (pCenter[x + 2] - pCenter[x]) +
+                    (pBelow[x + 2] - pBelow[x]);
+                float vert =
+                    (pAbove[x] + 2.0f * pAbove[x + 1] + pAbove[x + 2]) -
+                    (pBelow[x] + 2.0f * pBelow[x + 1] + pBelow[x + 2]);
+                pOutput[x] = std::sqrt(horiz * horiz + vert * vert);
+
+                if (pGradientXPlane != nullptr)
+                    pGradientXPlane[planeOffset + x] = horiz;
+                if (pGradientYPlane != nullptr)
+                    pGradientYPlane[planeOffset + x] = vert;
+                if (pOrientationPlane != nullptr)
+                    pOrientationPlane[planeOffset + x] = std::atan2(vert, horiz);
+            }
+
+            float* pOldAbove = pAbove;
+            pAbove = pCenter;
+            pCenter = pBelow;
+            pBelow = pOldAbove;
+        }
+    });
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "CpuImageProcessor.h"
+
+#include <cassert>
+#include <vector>
+
+namespace CS570
+{
+    // Bits selecting the single channel planes the fused Sobel pass writes next to its gray magnitude
+    // image, which is the magnitude plane itself. Shared with the GPU SobelFilter.
+    static const uint32_t k_sobelOutputGradientX = 1u << 0;
+    static const uint32_t k_sobelOutputGradientY = 1u << 1;
+    // atan2(Gy, Gx) in radians.
+    static const uint32_t k_sobelOutputOrientation = 1u << 2;
+    static const uint32_t k_sobelOutputPlaneCount = 3;
+
+    // Index of the plane selected by a single k_sobelOutput* bit.
+    inline uint32_t GetSobelPlaneIndex(uint32_t output)
+    {
+        uint32_t index = 0;
+        while ((output >> index) > 1u)
+            ++index;
+        assert(output == (1u << index) && index < k_sobelOutputPlaneCount);
+        return index;
+    }
+
+    // Fused version of SobelFilter.hlsl: Gx (right minus left column) and Gy (top minus bottom row)
+    // are computed from one read of each 3x3 neighborhood, held in a three row window of the red
+    // channel, and combined into the single channel magnitude image in the same pass.
+    class CpuSobelFilter : public BaseCpuImageProcessor
+    {
+    public:
+        void OnCreate(const CpuImage& input, uint32_t planeOutputs = 0u);
+        void OnDestroy();
+
+        void Execute() override;
+
+        CpuImage& GetOutputImage() override { return m_combinedOutput; }
+
+        // Width x height plane for one of the k_sobelOutput* bits passed to the last OnCreate.
+        const std::vector<float>& GetPlane(uint32_t output) const;
+
+    private:
+        const CpuImage* m_pInput = nullptr;
+
+        uint32_t m_planeOutputs = 0u;
+        std::vector<float> m_planes[k_sobelOutputPlaneCount];
+
+        CpuImage m_combinedOutput;
+    };
+}
@@ -0,0 +1,84 @@
+#include "CpuStreamingPipeline.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace CS570;
+
+void CpuStreamingPipeline::OnCreate(
+    CpuPipeline* pPipeline,
+    const std::vector<uint32_t>& inputNodes,
+    const std::vector<std::string>& inputFiles,
+    uint32_t bandRows)
+{
+    assert(inputNodes.size() == inputFiles.size());
+
+    m_pPipeline = pPipeline;
+    m_inputNodes = inputNodes;
+    m_bandRows = std::max(bandRows, 1u);
+    m_stats = StreamingPipelineStats();
+
+    // Readers hold a mapping and can't be copied, so the vector is sized once.
+    m_readers = std::vector<CpuPPMReader>(inputFiles.size());
+    m_bands.resize(inputFiles.size());
+    for (size_t input = 0; input < inputFiles.size(); ++input)
+    {
+        m_readers[input].Open(inputFiles[input]);
+        if (m_readers[input].IsText())
+            throw "Text ppm files can't be streamed, convert them to binary first.";
+
+        if (input == 0)
+        {
+            m_width = m_readers[input].GetWidth();
+            m_height = m_readers[input].GetHeight();
+        }
+        else if (m_readers[input].GetWidth() != m_width || m_readers[input].GetHeight() != m_height)
+        {
+            throw "Streamed inputs must all be the same size.";
+        }
+    }
+}
+
+void CpuStreamingPipeline::OnDestroy()
+{
+    std::vector<CpuPPMReader>().swap(m_readers);
+    std::vector<CpuImage>().swap(m_bands);
+    m_inputNodes.clear();
+    m_pPipeline = nullptr;
+}
+
+void CpuStreamingPipeline::Execute(const std::string& outputFile)
+{
+    assert(m_pPipeline != nullptr);
+
+    const uint32_t halo = m_pPipeline->GetRowHalo();
+
+    CpuPPMWriter writer;
+    writer.Open(outputFile, m_width, m_height);
+
+    m_stats.bandCount = 0u;
+    m_stats.haloRows = halo;
+    m_stats.peakBandSize = 0u;
+    for (uint32_t rowBegin = 0; rowBegin < m_height; rowBegin += std::min(m_bandRows, m_height - rowBegin))
+    {
+        const uint32_t rowEnd = rowBegin + std::min(m_bandRows, m_height - rowBegin);
+        const uint32_t loadBegin = rowBegin - std::min(rowBegin, halo);
+        const uint32_t loadEnd = static_cast<uint32_t>(std::min<uint64_t>(uint64_t(rowEnd) + halo, m_height));
+
+        for (size_t input = 0; input < m_readers.size(); ++input)
+        {
+            m_readers[input].ReadRows(loadBegin, loadEnd, &m_bands[input]);
+            m_pPipeline->SetInput(m_inputNodes[input], m_bands[input]);
+            m_stats.peakBandSize = std::max<uint64_t>(m_stats.peakBandSize, m_bands[input].GetSizeInBytes());
+        }
+
+        m_pPipeline->Execute();
+
+        const CpuImage& output = m_pPipeline->GetOutputImage();
+        if (output.GetWidth() != m_width || output.GetHeight() != loadEnd - loadBegin)
+            throw "Streamed pipelines must keep the image size.";
+        writer.WriteRows(rowBegin, rowEnd, output, rowBegin - loadBegin);
+
+        ++m_stats.bandCount;
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "CpuPipeline.h"
+#include "CpuPPM.h"
+
+#include <string>
+#include <vector>
+
+namespace CS570
+{
+    struct StreamingPipelineStats
+    {
+        uint32_t bandCount = 0u;
+        // Extra input rows loaded above and below every band.
+        uint32_t haloRows = 0u;
+        // Largest band of one input, in bytes; the pipeline's intermediates are band sized too.
+        uint64_t peakBandSize = 0u;
+    };
+
+    // Runs a CpuPipeline over binary ppm inputs too large to load whole, a band of bandRows output
+    // rows at a time. Every band loads its rows of each input plus GetRowHalo() rows above and below
+    // through CpuPPMReader, executes the pipeline on them, and writes the band's rows of the first
+    // output with CpuPPMWriter. Operations read zero outside their input, so bands at the top and
+    // bottom see the real edge, and for the FIR stages (direct and separable blurs, Sobel, unsharp
+    // mask, pointwise operations) the halo gives every band the same result as the whole image. The
+    // recursive blur's response is infinite and the 8 sigma halo truncates its filter state, so its
+    // bands can differ from the whole image by up to 1 LSB of the output.
+    //
+    // Memory stays proportional to (bandRows + 2 * halo) x width times the pipeline's live
+    // intermediates, whatever the image height. Row offsets into the files are 64 bit.
+    class CpuStreamingPipeline
+    {
+    public:
+        // pPipeline must stay alive until Execute returns. inputNodes[i] reads inputFiles[i]; the
+        // inputs must all be the same size.
+        void OnCreate(
+            CpuPipeline* pPipeline,
+            const std::vector<uint32_t>& inputNodes,
+            const std::vector<std::string>& inputFiles,
+            uint32_t bandRows = k_defaultBandRows);
+        void OnDestroy();
+
+        // Throws a const char* when a file can't be read or written, or an operation can't run in bands.
+        void Execute(const std::string& outputFile);
+
+        uint32_t GetWidth() const { return m_width; }
+        uint32_t GetHeight() const { return m_height; }
+        const StreamingPipelineStats& GetStats() const { return m_stats; }
+
+        static const uint32_t k_defaultBandRows = 256;
+
+    private:
+        CpuPipeline* m_pPipeline = nullptr;
+        std::vector<uint32_t> m_inputNodes;
+        std::vector<CpuPPMReader> m_readers;
+        std::vector<CpuImage> m_bands;
+        uint32_t m_bandRows = k_defaultBandRows;
+        uint32_t m_width = 0u;
+        uint32_t m_height = 0u;
+
+        StreamingPipelineStats m_stats;
+    };
+}
@@ -0,0 +1,685 @@
+#include "CpuTiledImage.h"
+
+#include "CpuOutputFile.h"
+#include "CpuParallel.h"
+#include "CpuPPM.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <type_traits>
+
+using namespace CS570;
+
+const uint32_t CpuTiledImage::k_tileSize;
+
+static const uint32_t k_tiledImageVersion = 1;
+// Tiles start on page boundaries, so reading one never pulls in part of another.
+static const uint64_t k_tileAlignment = 4096;
+// Residuals of the predictive codec are packed this many at a time, with one bit width per block.
+static const uint32_t k_codecBlockSize = 16;
+
+namespace
+{
+    struct TiledImageHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        uint32_t tileSize;
+        uint32_t format;
+        uint32_t mipCount;
+        uint32_t tileCount;
+        uint64_t tableOffset;
+        uint32_t reserved[6];
+    };
+    static_assert(sizeof(TiledImageHeader) == 64, "The tiled image header is 64 bytes.");
+
+    struct TileEntry
+    {
+        uint64_t offset;
+        uint32_t size;
+        uint32_t codec;
+    };
+    static_assert(sizeof(TileEntry) == 16, "Tile table entries are 16 bytes.");
+}
+
+static uint32_t ComputeMipCount(uint32_t width, uint32_t height)
+{
+    uint32_t mipCount = 1u;
+    while ((width >> mipCount) > 0 || (height >> mipCount) > 0)
+        ++mipCount;
+    return mipCount;
+}
+
+static uint32_t GetLevelSize(uint32_t size, uint32_t level)
+{
+    return (size >> level) > 0 ? size >> level : 1u;
+}
+
+static uint32_t GetTileCount(uint32_t size)
+{
+    return (size + CpuTiledImage::k_tileSize - 1) / CpuTiledImage::k_tileSize;
+}
+
+static uint64_t AlignTileOffset(uint64_t offset)
+{
+    return (offset + k_tileAlignment - 1) & ~(k_tileAlignment - 1);
+}
+
+// The LOCO-I median edge detector: min(a, b) or max(a, b) when c suggests an edge, else the plane
+// a + b - c, which is the plane clamped to [min(a, b), max(a, b)] and needs no branches.
+template <typename T>
+static T PredictMedian(T left, T up, T upLeft)
+{
+    typedef typename std::conditional<sizeof(T) < 4, int32_t, int64_t>::type Wide;
+    const Wide plane = Wide(left) + Wide(up) - Wide(upLeft);
+    return static_cast<T>(std::min(std::max(plane, Wide(std::min(left, up))), Wide(std::max(left, up))));
+}
+
+// Maps a residual, wrapped to the sample type, to a small unsigned number if it is small either way.
+template <typename T>
+static uint32_t ZigZag(T residual)
+{
+    const T sign = static_cast<T>(0u - (residual >> (sizeof(T) * 8 - 1)));
+    return static_cast<T>(static_cast<T>(residual << 1) ^ sign);
+}
+
+template <typename T>
+static T UnZigZag(uint32_t value)
+{
+    return static_cast<T>(static_cast<T>(value >> 1) ^ static_cast<T>(0u - (value & 1u)));
+}
+
+// Residuals of a tile, channel by channel in raster order. The first row is predicted from the
+// left and the first column from above.
+template <typename T>
+static void ComputeResiduals(const uint8_t* pTile, size_t rowPitch, uint32_t width, uint32_t height, uint32_t* pResiduals)
+{
+    const size_t stride = CpuImage::k_channelCount;
+    for (uint32_t channel = 0; channel < CpuImage::k_channelCount; ++channel)
+    {
+        const T* pRow = reinterpret_cast<const T*>(pTile) + channel;
+        *pResiduals++ = ZigZag(pRow[0]);
+        for (uint32_t x = 1; x < width; ++x)
+            *pResiduals++ = ZigZag(static_cast<T>(pRow[x * stride] - pRow[(x - 1) * stride]));
+
+        for (uint32_t y = 1; y < height; ++y)
+        {
+            const T* pUpRow = pRow;
+            pRow = reinterpret_cast<const T*>(pTile + y * rowPitch) + channel;
+            *pResiduals++ = ZigZag(static_cast<T>(pRow[0] - pUpRow[0]));
+            for (uint32_t x = 1; x < width; ++x)
+            {
+                const T prediction = PredictMedian(pRow[(x - 1) * stride], pUpRow[x * stride], pUpRow[(x - 1) * stride]);
+                *pResiduals++ = ZigZag(static_cast<T>(pRow[x * stride] - prediction));
+            }
+        }
+    }
+}
+
+template <typename T>
+static void ApplyResiduals(const uint32_t* pResiduals, uint32_t width, uint32_t height, uint8_t* pTile, size_t rowPitch)
+{
+    const size_t stride = CpuImage::k_channelCount;
+    for (uint32_t channel = 0; channel < CpuImage::k_channelCount; ++channel)
+    {
+        T* pRow = reinterpret_cast<T*>(pTile) + channel;
+        T left = UnZigZag<T>(*pResiduals++);
+        pRow[0] = left;
+        for (uint32_t x = 1; x < width; ++x)
+        {
+            left = static_cast<T>(left + UnZigZag<T>(*pResiduals++));
+            pRow[x * stride] = left;
+        }
+
+        for (uint32_t y = 1; y < height; ++y)
+        {
+            const T* pUpRow = pRow;
+            pRow = reinterpret_cast<T*>(pTile + y * rowPitch) + channel;
+            T upLeft = pUpRow[0];
+            left = static_cast<T>(upLeft + UnZigZag<T>(*pResiduals++));
+            pRow[0] = left;
+            for (uint32_t x = 1; x < width; ++x)
+            {
+                const T up = pUpRow[x * stride];
+                left = static_cast<T>(PredictMedian(left, up, upLeft) + UnZigZag<T>(*pResiduals++));
+                pRow[x * stride] = left;
+                upLeft = up;
+            }
+        }
+    }
+}
+
+// Every block is a byte holding the bit width of its largest residual, then the block's residuals
+// packed at that width, low bits first. A block of k_codecBlockSize residuals always fills whole bytes.
+static void PackResiduals(const uint32_t* pResiduals, size_t count, std::vector<uint8_t>* pEncoded)
+{
+    pEncoded->clear();
+    for (size_t blockBegin = 0; blockBegin < count; blockBegin += k_codecBlockSize)
+    {
+        const size_t blockEnd = std::min(blockBegin + k_codecBlockSize, count);
+        uint32_t usedBits = 0u;
+        for (size_t i = blockBegin; i < blockEnd; ++i)
+            usedBits |= pResiduals[i];
+        uint32_t bitWidth = 0u;
+        while (bitWidth < 32 && (usedBits >> bitWidth) != 0)
+            ++bitWidth;
+        pEncoded->push_back(static_cast<uint8_t>(bitWidth));
+
+        uint64_t bits = 0u;
+        uint32_t bitCount = 0u;
+        for (size_t i = blockBegin; i < blockBegin + k_codecBlockSize; ++i)
+        {
+            bits |= uint64_t(i < blockEnd ? pResiduals[i] : 0u) << bitCount;
+            bitCount += bitWidth;
+            for (; bitCount >= 8; bitCount -= 8, bits >>= 8)
+                pEncoded->push_back(static_cast<uint8_t>(bits));
+        }
+    }
+}
+
+static bool UnpackResiduals(const uint8_t* pEncoded, size_t size, size_t count, uint32_t maxBitWidth, uint32_t* pResiduals)
+{
+    // Blocks are copied to a buffer with room to read 8 bytes at any residual's first byte.
+    uint8_t block[k_codecBlockSize * 4 + 8] = {};
+    size_t offset = 0;
+    for (size_t blockBegin = 0; blockBegin < count; blockBegin += k_codecBlockSize)
+    {
+        if (offset == size)
+            return false;
+        const uint32_t bitWidth = pEncoded[offset++];
+        const size_t blockSize = k_codecBlockSize * bitWidth / 8;
+        if (bitWidth > maxBitWidth || size - offset < blockSize)
+            return false;
+        std::memcpy(block, pEncoded + offset, blockSize);
+        offset += blockSize;
+
+        const uint64_t mask = (uint64_t(1) << bitWidth) - 1u;
+        const size_t blockCount = std::min(size_t(k_codecBlockSize), count - blockBegin);
+        for (size_t i = 0; i < blockCount; ++i)
+        {
+            const size_t bit = i * bitWidth;
+            uint64_t bits;
+            std::memcpy(&bits, block + bit / 8, sizeof(bits));
+            pResiduals[blockBegin + i] = static_cast<uint32_t>((bits >> (bit % 8)) & mask);
+        }
+    }
+    return offset == size;
+}
+
+// Decodes a tile's data into pDest, its rows rowPitch bytes apart.
+static void DecodeTileData(
+    const uint8_t* pData,
+    size_t size,
+    TileCodec codec,
+    CpuPixelFormat format,
+    uint32_t width,
+    uint32_t height,
+    uint8_t* pDest,
+    size_t rowPitch,
+    std::vector<uint32_t>* pResiduals)
+{
+    const size_t tilePitch = size_t(width) * GetPixelSize(format);
+    if (codec == TileCodec::None)
+    {
+        for (uint32_t y = 0; y < height; ++y)
+            std::memcpy(pDest + y * rowPitch, pData + y * tilePitch, tilePitch);
+        return;
+    }
+
+    const uint32_t sampleBits = GetPixelSize(format) / CpuImage::k_channelCount * 8;
+    pResiduals->resize(size_t(width) * height * CpuImage::k_channelCount);
+    if (!UnpackResiduals(pData, size, pResiduals->size(), sampleBits, pResiduals->data()))
+        throw "Invalid tiled image file, corrupt tile data.";
+
+    if (sampleBits == 8)
+        ApplyResiduals<uint8_t>(pResiduals->data(), width, height, pDest, rowPitch);
+    else if (sampleBits == 16)
+        ApplyResiduals<uint16_t>(pResiduals->data(), width, height, pDest, rowPitch);
+    else
+        ApplyResiduals<uint32_t>(pResiduals->data(), width, height, pDest, rowPitch);
+}
+
+void CpuTiledImage::Open(const std::string& file)
+{
+    Close();
+    try
+    {
+        m_file.Open(file, CpuMappedFile::Access::Random);
+    }
+    catch (const char*)
+    {
+        throw "Failed to open tiled image file.";
+    }
+
+    const uint8_t* pData = m_file.GetData();
+    const size_t fileSize = m_file.GetSize();
+    TiledImageHeader header;
+    if (fileSize < sizeof(header))
+        throw "Invalid tiled image file, ran out of header.";
+    std::memcpy(&header, pData, sizeof(header));
+
+    if (std::memcmp(header.magic, "CTI1", 4) != 0 || header.version != k_tiledImageVersion)
+        throw "Invalid tiled image file, only version 1 is supported.";
+    if (header.width == 0 || header.height == 0 || header.tileSize != k_tileSize ||
+        header.format > static_cast<uint32_t>(CpuPixelFormat::RGBA32F) ||
+        header.mipCount != ComputeMipCount(header.width, header.height))
+        throw "Invalid tiled image file, bad dimensions, tile size or format.";
+
+    m_width = header.width;
+    m_height = header.height;
+    m_mipCount = header.mipCount;
+    m_format = static_cast<CpuPixelFormat>(header.format);
+
+    m_levelTiles.resize(m_mipCount);
+    uint32_t tileCount = 0u;
+    for (uint32_t level = 0; level < m_mipCount; ++level)
+    {
+        m_levelTiles[level] = tileCount;
+        tileCount += GetTileColumnCount(level) * GetTileRowCount(level);
+    }
+    if (header.tileCount != tileCount || header.tableOffset > fileSize ||
+        (fileSize - header.tableOffset) / sizeof(Tile) < tileCount)
+        throw "Invalid tiled image file, bad tile table.";
+
+    static_assert(sizeof(Tile) == sizeof(TileEntry), "Tiles are read straight from the tile table.");
+    m_tiles.resize(tileCount);
+    std::memcpy(m_tiles.data(), pData + header.tableOffset, tileCount * sizeof(Tile));
+
+    const uint32_t pixelSize = GetPixelSize(m_format);
+    for (uint32_t level = 0; level < m_mipCount; ++level)
+    {
+        for (uint32_t tileY = 0; tileY < GetTileRowCount(level); ++tileY)
+        {
+            for (uint32_t tileX = 0; tileX < GetTileColumnCount(level); ++tileX)
+            {
+                const Tile& tile = GetTile(level, tileX, tileY);
+                const uint32_t width = std::min(k_tileSize, GetWidth(level) - tileX * k_tileSize);
+                const uint32_t height = std::min(k_tileSize, GetHeight(level) - tileY * k_tileSize);
+                if (tile.offset > fileSize || fileSize - tile.offset < tile.size ||
+                    tile.codec > static_cast<uint32_t>(TileCodec::Predictive) ||
+                    (tile.codec == static_cast<uint32_t>(TileCodec::None) && tile.size != size_t(width) * height * pixelSize))
+                    throw "Invalid tiled image file, bad tile table.";
+            }
+        }
+    }
+}
+
+void CpuTiledImage::Close()
+{
+    m_file.Close();
+    m_width = 0u;
+    m_height = 0u;
+    m_mipCount = 0u;
+    m_levelTiles.clear();
+    m_tiles.clear();
+}
+
+uint32_t CpuTiledImage::GetLevelForSize(uint32_t width, uint32_t height) const
+{
+    uint32_t level = 0u;
+    while (level + 1 < m_mipCount && GetWidth(level + 1) >= width && GetHeight(level + 1) >= height)
+        ++level;
+    return level;
+}
+
+void CpuTiledImage::ReadTile(uint32_t level, uint32_t tileX, uint32_t tileY, uint8_t* pDest, size_t rowPitch) const
+{
+    assert(level < m_mipCount && tileX < GetTileColumnCount(level) && tileY < GetTileRowCount(level));
+
+    const Tile& tile = GetTile(level, tileX, tileY);
+    std::vector<uint32_t> residuals;
+    DecodeTileData(m_file.GetData() + tile.offset, tile.size, static_cast<TileCodec>(tile.codec), m_format,
+        std::min(k_tileSize, GetWidth(level) - tileX * k_tileSize), std::min(k_tileSize, GetHeight(level) - tileY * k_tileSize),
+        pDest, rowPitch, &residuals);
+}
+
+void CpuTiledImage::ForEachRegionTile(
+    uint32_t level,
+    uint32_t x,
+    uint32_t y,
+    uint32_t width,
+    uint32_t height,
+    const std::function<void(const uint8_t*, size_t, uint32_t, uint32_t, uint32_t, uint32_t)>& copyTile) const
+{
+    assert(level < m_mipCount);
+    if (x > GetWidth(level) || width > GetWidth(level) - x || y > GetHeight(level) || height > GetHeight(level) - y)
+        throw "The region is outside of the tiled image.";
+    if (width == 0 || height == 0)
+        return;
+
+    const uint32_t pixelSize = GetPixelSize(m_format);
+    const uint32_t firstTileX = x / k_tileSize;
+    const uint32_t firstTileY = y / k_tileSize;
+    const uint32_t columnCount = (x + width - 1) / k_tileSize - firstTileX + 1;
+    const uint32_t rowCount = (y + height - 1) / k_tileSize - firstTileY + 1;
+
+    std::vector<const char*> tileErrors(size_t(columnCount) * rowCount, nullptr);
+    ParallelFor(0, tileErrors.size(), 1, [&](size_t tileBegin, size_t tileEnd) {
+        std::vector<uint8_t> tileBytes;
+        std::vector<uint32_t> residuals;
+        for (size_t tileIndex = tileBegin; tileIndex < tileEnd; ++tileIndex)
+        {
+            const uint32_t tileX = firstTileX + static_cast<uint32_t>(tileIndex % columnCount);
+            const uint32_t tileY = firstTileY + static_cast<uint32_t>(tileIndex / columnCount);
+            const uint32_t tileLeft = tileX * k_tileSize;
+            const uint32_t tileTop = tileY * k_tileSize;
+            const uint32_t tileWidth = std::min(k_tileSize, GetWidth(level) - tileLeft);
+            const uint32_t tileHeight = std::min(k_tileSize, GetHeight(level) - tileTop);
+            const size_t tilePitch = size_t(tileWidth) * pixelSize;
+
+            // Uncompressed tiles are read in place from the mapping.
+            const Tile& tile = GetTile(level, tileX, tileY);
+            const uint8_t* pTile = m_file.GetData() + tile.offset;
+            if (tile.codec != static_cast<uint32_t>(TileCodec::None))
+            {
+                tileBytes.resize(tilePitch * tileHeight);
+                try
+                {
+                    DecodeTileData(pTile, tile.size, static_cast<TileCodec>(tile.codec), m_format, tileWidth, tileHeight,
+                        tileBytes.data(), tilePitch, &residuals);
+                }
+                catch (const char* pError)
+                {
+                    tileErrors[tileIndex] = pError;
+                    continue;
+                }
+                pTile = tileBytes.data();
+            }
+
+            const uint32_t left = std::max(x, tileLeft);
+            const uint32_t top = std::max(y, tileTop);
+            const uint32_t right = std::min(x + width, tileLeft + tileWidth);
+            const uint32_t bottom = std::min(y + height, tileTop + tileHeight);
+            copyTile(pTile + (top - tileTop) * tilePitch + size_t(left - tileLeft) * pixelSize, tilePitch,
+                left - x, top - y, right - left, bottom - top);
+        }
+    });
+    for (const char* pError : tileErrors)
+    {
+        if (pError != nullptr)
+            throw pError;
+    }
+}
+
+void CpuTiledImage::ReadRegion(
+    uint32_t level,
+    uint32_t x,
+    uint32_t y,
+    uint32_t width,
+    uint32_t height,
+    uint8_t* pDest,
+    size_t rowPitch) const
+{
+    const uint32_t pixelSize = GetPixelSize(m_format);
+    ForEachRegionTile(level, x, y, width, height,
+        [&](const uint8_t* pSrc, size_t srcPitch, uint32_t destX, uint32_t destY, uint32_t copyWidth, uint32_t copyHeight) {
+            for (uint32_t row = 0; row < copyHeight; ++row)
+            {
+                std::memcpy(pDest + (destY + row) * rowPitch + size_t(destX) * pixelSize, pSrc + row * srcPitch,
+                    size_t(copyWidth) * pixelSize);
+            }
+        });
+}
+
+void CpuTiledImage::ReadRegion(uint32_t level, uint32_t x, uint32_t y, uint32_t width, uint32_t height, CpuImage* pImage) const
+{
+    pImage->Resize(width, height, m_format);
+    ReadRegion(level, x, y, width, height, pImage->GetBytes(), size_t(width) * GetPixelSize(m_format));
+}
+
+namespace
+{
+    // Produces every level a band of k_tileSize rows at a time. A band of level n is downsampled
+    // from the one or two bands of level n - 1 under it, which are produced on demand, so the
+    // levels are written in an interleaved order while only a couple of bands per level are live.
+    class TiledImageWriter
+    {
+    public:
+        TiledImageWriter(
+            uint32_t width,
+            uint32_t height,
+            CpuPixelFormat format,
+            TileCodec codec,
+            const std::function<void(uint32_t, uint32_t, CpuImage*)>& readRows)
+            : m_width(width)
+            , m_height(height)
+            , m_format(format)
+            , m_codec(codec)
+            , m_readRows(readRows)
+        {
+        }
+
+        void Write(const std::string& file);
+
+    private:
+        void ProduceTileRow(uint32_t level, uint32_t tileRow, CpuImage* pBand);
+        void WriteTileRow(uint32_t level, uint32_t tileRow, const CpuImage& band);
+
+        uint32_t m_width;
+        uint32_t m_height;
+        CpuPixelFormat m_format;
+        TileCodec m_codec;
+        const std::function<void(uint32_t, uint32_t, CpuImage*)>& m_readRows;
+
+        CpuOutputFile m_file;
+        uint64_t m_nextOffset = 0u;
+        std::vector<uint32_t> m_levelTiles;
+        std::vector<uint32_t> m_nextTileRows;
+        std::vector<TileEntry> m_tiles;
+    };
+}
+
+void TiledImageWriter::Write(const std::string& file)
+{
+    if (m_width == 0 || m_height == 0)
+        throw "Can't write an empty tiled image.";
+    if (GetChannelCount(m_format) != CpuImage::k_channelCount)
+        throw "Tiled images store RGBA pixels.";
+
+    const uint32_t mipCount = ComputeMipCount(m_width, m_height);
+    m_levelTiles.resize(mipCount);
+    uint32_t tileCount = 0u;
+    for (uint32_t level = 0; level < mipCount; ++level)
+    {
+        m_levelTiles[level] = tileCount;
+        tileCount += GetTileCount(GetLevelSize(m_width, level)) * GetTileCount(GetLevelSize(m_height, level));
+    }
+    m_tiles.resize(tileCount);
+    m_nextTileRows.assign(mipCount, 0u);
+
+    TiledImageHeader header = {};
+    std::memcpy(header.magic, "CTI1", 4);
+    header.version = k_tiledImageVersion;
+    header.width = m_width;
+    header.height = m_height;
+    header.tileSize = CpuTiledImage::k_tileSize;
+    header.format = static_cast<uint32_t>(m_format);
+    header.mipCount = mipCount;
+    header.tileCount = tileCount;
+    header.tableOffset = sizeof(header);
+
+    // Tiles are appended as they are encoded, their final sizes unknown up front.
+    const uint64_t tableEnd = header.tableOffset + uint64_t(tileCount) * sizeof(TileEntry);
+    m_file.Open(file, tableEnd);
+    m_nextOffset = tableEnd;
+
+    // The last level is a single tile, whose band pulls in every other.
+    CpuImage band;
+    ProduceTileRow(mipCount - 1, 0, &band);
+
+    m_file.Write(0, &header, sizeof(header));
+    m_file.Write(header.tableOffset, m_tiles.data(), m_tiles.size() * sizeof(TileEntry));
+    m_file.Close();
+}
+
+void TiledImageWriter::ProduceTileRow(uint32_t level, uint32_t tileRow, CpuImage* pBand)
+{
+    assert(m_nextTileRows[level] == tileRow);
+
+    const uint32_t width = GetLevelSize(m_width, level);
+    const uint32_t height = GetLevelSize(m_height, level);
+    const uint32_t rowBegin = tileRow * CpuTiledImage::k_tileSize;
+    const uint32_t rowEnd = std::min(rowBegin + CpuTiledImage::k_tileSize, height);
+    if (level == 0)
+    {
+        m_readRows(rowBegin, rowEnd, pBand);
+        if (pBand->GetWidth() != width || pBand->GetHeight() != rowEnd - rowBegin)
+            throw "The rows read for the tiled image have the wrong size.";
+
+        // The levels are filtered in f32.
+        if (pBand->GetFormat() != CpuPixelFormat::RGBA32F)
+        {
+            CpuImage band(width, rowEnd - rowBegin);
+            ConvertPixelsToFloat(pBand->GetBytes(), pBand->GetPixelCount(), pBand->GetFormat(), band.GetData());
+            *pBand = std::move(band);
+        }
+    }
+    else
+    {
+        const uint32_t parentWidth = GetLevelSize(m_width, level - 1);
+        const uint32_t parentHeight = GetLevelSize(m_height, level - 1);
+        const uint32_t parentRowBegin = 2 * rowBegin;
+        const uint32_t parentRowEnd = std::min(2 * rowEnd, parentHeight);
+        const uint32_t parentTileRowEnd = (parentRowEnd - 1) / CpuTiledImage::k_tileSize + 1;
+
+        CpuImage parentBands[2];
+        for (uint32_t parentTileRow = 2 * tileRow; parentTileRow < parentTileRowEnd; ++parentTileRow)
+            ProduceTileRow(level - 1, parentTileRow, &parentBands[parentTileRow - 2 * tileRow]);
+
+        auto getParentRow = [&](uint32_t row) {
+            const uint32_t bandRow = row - parentRowBegin;
+            const uint32_t firstBandHeight = parentBands[0].GetHeight();
+            if (bandRow < firstBandHeight)
+                return parentBands[0].GetRow(bandRow);
+            return parentBands[1].GetRow(bandRow - firstBandHeight);
+        };
+
+        pBand->Resize(width, rowEnd - rowBegin);
+        ParallelFor(rowBegin, rowEnd, 16, [&](size_t bandBegin, size_t bandEnd) {
+            for (size_t y = bandBegin; y < bandEnd; ++y)
+            {
+                const float* pRow0 = getParentRow(static_cast<uint32_t>(2 * y));
+                const float* pRow1 = getParentRow(std::min(static_cast<uint32_t>(2 * y + 1), parentHeight - 1));
+                float* pDst = pBand->GetRow(static_cast<uint32_t>(y) - rowBegin);
+                for (uint32_t x = 0; x < width; ++x)
+                {
+                    const size_t x0 = size_t(2 * x) * CpuImage::k_channelCount;
+                    const size_t x1 = size_t(std::min(2 * x + 1, parentWidth - 1)) * CpuImage::k_channelCount;
+                    for (uint32_t channel = 0; channel < CpuImage::k_channelCount; ++channel)
+                    {
+                        pDst[size_t(x) * CpuImage::k_channelCount + channel] =
+                            0.25f * (pRow0[x0 + channel] + pRow0[x1 + channel] + pRow1[x0 + channel] + pRow1[x1 + channel]);
+                    }
+                }
+            }
+        });
+
+        // Halving rounds down, so an odd last row of the level above belongs to no band of this one
+        // and still has to be written.
+        if (tileRow + 1 == GetTileCount(height))
+        {
+            const uint32_t parentTileRowCount = GetTileCount(parentHeight);
+            while (m_nextTileRows[level - 1] < parentTileRowCount)
+                ProduceTileRow(level - 1, m_nextTileRows[level - 1], &parentBands[0]);
+        }
+    }
+
+    WriteTileRow(level, tileRow, *pBand);
+    ++m_nextTileRows[level];
+}
+
+void TiledImageWriter::WriteTileRow(uint32_t level, uint32_t tileRow, const CpuImage& band)
+{
+    const uint32_t width = band.GetWidth();
+    const uint32_t height = band.GetHeight();
+    const uint32_t pixelSize = GetPixelSize(m_format);
+    const uint32_t columnCount = GetTileCount(width);
+
+    // Tiles are converted and encoded in parallel, then appended in order.
+    std::vector<std::vector<uint8_t>> tileData(columnCount);
+    std::vector<TileCodec> tileCodecs(columnCount, TileCodec::None);
+    ParallelFor(0, columnCount, 1, [&](size_t tileBegin, size_t tileEnd) {
+        std::vector<uint8_t> tileBytes;
+        std::vector<uint32_t> residuals;
+        for (size_t tileX = tileBegin; tileX < tileEnd; ++tileX)
+        {
+            const uint32_t tileLeft = static_cast<uint32_t>(tileX) * CpuTiledImage::k_tileSize;
+            const uint32_t tileWidth = std::min(CpuTiledImage::k_tileSize, width - tileLeft);
+            const size_t tilePitch = size_t(tileWidth) * pixelSize;
+            tileBytes.resize(tilePitch * height);
+            for (uint32_t y = 0; y < height; ++y)
+                ConvertPixelsFromFloat(band.GetPixel(tileLeft, y), tileWidth, m_format, tileBytes.data() + y * tilePitch);
+
+            if (m_codec == TileCodec::Predictive)
+            {
+                residuals.resize(size_t(tileWidth) * height * CpuImage::k_channelCount);
+                if (pixelSize == 4)
+                    ComputeResiduals<uint8_t>(tileBytes.data(), tilePitch, tileWidth, height, residuals.data());
+                else if (pixelSize == 8)
+                    ComputeResiduals<uint16_t>(tileBytes.data(), tilePitch, tileWidth, height, residuals.data());
+                else
+                    ComputeResiduals<uint32_t>(tileBytes.data(), tilePitch, tileWidth, height, residuals.data());
+
+                PackResiduals(residuals.data(), residuals.size(), &tileData[tileX]);
+                if (tileData[tileX].size() < tileBytes.size())
+                {
+                    tileCodecs[tileX] = TileCodec::Predictive;
+                    continue;
+                }
+            }
+            tileData[tileX] = tileBytes;
+        }
+    });
+
+    const uint32_t firstTile = m_levelTiles[level] + tileRow * columnCount;
+    for (uint32_t tileX = 0; tileX < columnCount; ++tileX)
+    {
+        TileEntry& tile = m_tiles[firstTile + tileX];
+        tile.offset = AlignTileOffset(m_nextOffset);
+        tile.size = static_cast<uint32_t>(tileData[tileX].size());
+        tile.codec = static_cast<uint32_t>(tileCodecs[tileX]);
+        m_file.Write(tile.offset, tileData[tileX].data(), tileData[tileX].size());
+        m_nextOffset = tile.offset + tile.size;
+    }
+}
+
+void CS570::WriteTiledImage(
+    const std::string& file,
+    uint32_t width,
+    uint32_t height,
+    CpuPixelFormat format,
+    TileCodec codec,
+    const std::function<void(uint32_t, uint32_t, CpuImage*)>& readRows)
+{
+    TiledImageWriter writer(width, height, format, codec, readRows);
+    writer.Write(file);
+}
+
+void CS570::WriteTiledImage(const std::string& file, const CpuImage& image, CpuPixelFormat format, TileCodec codec)
+{
+    WriteTiledImage(file, image.GetWidth(), image.GetHeight(), format, codec,
+        [&](uint32_t rowBegin, uint32_t rowEnd, CpuImage* pBand) {
+            const size_t rowSize = size_t(image.GetWidth()) * GetPixelSize(image.GetFormat());
+            pBand->Resize(image.GetWidth(), rowEnd - rowBegin, image.GetFormat());
+            std::memcpy(pBand->GetBytes(), image.GetBytes() + rowBegin * rowSize, (rowEnd - rowBegin) * rowSize);
+        });
+}
+
+void CS570::ConvertPPMToTiledImage(const std::string& ppmFile, const std::string& tiledFile, CpuPixelFormat format, TileCodec codec)
+{
+    CpuPPMReader reader;
+    reader.Open(ppmFile);
+    if (reader.IsText())
+    {
+        CpuImage image;
+        reader.ReadRows(0, reader.GetHeight(), &image);
+        WriteTiledImage(tiledFile, image, format, codec);
+        return;
+    }
+
+    WriteTiledImage(tiledFile, reader.GetWidth(), reader.GetHeight(), format, codec,
+        [&](uint32_t rowBegin, uint32_t rowEnd, CpuImage* pBand) { reader.ReadRows(rowBegin, rowEnd, pBand); });
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "CpuImage.h"
+#include "CpuMappedFile.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace CS570
+{
+    enum class TileCodec : uint32_t
+    {
+        None,
+        // Lossless: every channel of a tile predicted from its left, upper and upper left neighbors
+        // (the LOCO-I median predictor) and the residuals bit packed in blocks of 16, each block
+        // with its own bit width. Tiles that don't get smaller are stored uncompressed.
+        Predictive,
+    };
+
+    // A tiled image file (.cti) holds an image and its mip levels in 256x256 tiles, so a region or a
+    // zoom level can be read by decoding only the tiles that cover it. The file is memory mapped and
+    // every tile starts on a 4 KB boundary, so reading a region touches only the pages of its tiles.
+    //
+    // Layout, in the machine's byte order: a 64 byte header ("CTI1", version, width, height, tile
+    // size, format, mip count, tile count, table offset), then a table of tile count entries (uint64_t
+    // offset, uint32_t size, uint32_t codec), then the tiles. Tiles are ordered by mip level and row
+    // major within a level, and tiles on the right and bottom edges only hold the pixels inside the
+    // level. Mip level n is max(1, width >> n) x max(1, height >> n), down to 1x1, every texel the
+    // average of a 2x2 block of the level above as the WIC loader's mips are.
+    class CpuTiledImage
+    {
+    public:
+        static const uint32_t k_tileSize = 256;
+
+        // Maps the file and reads its tile table. Throws a const char* when the file is invalid.
+        void Open(const std::string& file);
+        void Close();
+
+        uint32_t GetWidth(uint32_t level = 0) const { return (m_width >> level) > 0 ? m_width >> level : 1u; }
+        uint32_t GetHeight(uint32_t level = 0) const { return (m_height >> level) > 0 ? m_height >> level : 1u; }
+        uint32_t GetMipCount() const { return m_mipCount; }
+        CpuPixelFormat GetFormat() const { return m_format; }
+
+        uint32_t GetTileColumnCount(uint32_t level) const { return (GetWidth(level) + k_tileSize - 1) / k_tileSize; }
+        uint32_t GetTileRowCount(uint32_t level) const { return (GetHeight(level) + k_tileSize - 1) / k_tileSize; }
+
+        // The smallest level at least width x height, for previews.
+        uint32_t GetLevelForSize(uint32_t width, uint32_t height) const;
+
+        // Decodes a tile in the stored format, its rows rowPitch bytes apart.
+        void ReadTile(uint32_t level, uint32_t tileX, uint32_t tileY, uint8_t* pDest, size_t rowPitch) const;
+
+        // Reads [x, x + width) x [y, y + height) of a level, decoding its tiles in parallel, in the stored
+        // format with rows rowPitch bytes apart, or into an image in the stored format.
+        void ReadRegion(
+            uint32_t level, uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint8_t* pDest, size_t rowPitch) const;
+        void ReadRegion(uint32_t level, uint32_t x, uint32_t y, uint32_t width, uint32_t height, CpuImage* pImage) const;
+
+    private:
+        struct Tile
+        {
+            uint64_t offset;
+            uint32_t size;
+            uint32_t codec;
+        };
+
+        // Calls copyTile(pSrc, srcPitch, destX, destY, copyWidth, copyHeight) for the part of every tile
+        // inside the region, in parallel, pSrc pointing to its first pixel in the stored format and
+        // destX and destY relative to the region.
+        void ForEachRegionTile(
+            uint32_t level,
+            uint32_t x,
+            uint32_t y,
+            uint32_t width,
+            uint32_t height,
+            const std::function<void(const uint8_t*, size_t, uint32_t, uint32_t, uint32_t, uint32_t)>& copyTile) const;
+
+        const Tile& GetTile(uint32_t level, uint32_t tileX, uint32_t tileY) const
+        {
+            return m_tiles[m_levelTiles[level] + tileY * GetTileColumnCount(level) + tileX];
+        }
+
+        CpuMappedFile m_file;
+        uint32_t m_width = 0u;
+        uint32_t m_height = 0u;
+        uint32_t m_mipCount = 0u;
+        CpuPixelFormat m_format = CpuPixelFormat::RGBA8;
+        // First tile of every level.
+        std::vector<uint32_t> m_levelTiles;
+        std::vector<Tile> m_tiles;
+    };
+
+    // Writes a tiled image of width x height with all its mip levels, in one of the RGBA formats.
+    // readRows(rowBegin, rowEnd, pBand) loads full resolution rows in any format, grey ones included,
+    // and is called for consecutive bands of k_tileSize rows, so the image never has to be in memory
+    // whole. Throws a const char* when the file can't be written.
+    void WriteTiledImage(
+        const std::string& file,
+        uint32_t width,
+        uint32_t height,
+        CpuPixelFormat format,
+        TileCodec codec,
+        const std::function<void(uint32_t, uint32_t, CpuImage*)>& readRows);
+    void WriteTiledImage(const std::string& file, const CpuImage& image, CpuPixelFormat format, TileCodec codec);
+
+    // Converts a ppm file, a band of rows at a time for binary ones.
+    void ConvertPPMToTiledImage(const std::string& ppmFile, const std::string& tiledFile, CpuPixelFormat format, TileCodec codec);
+}
@@ -0,0 +1,102 @@
+#include "CpuUnsharpMask.h"
+
+#include "CpuParallel.h"
+#include "CpuSimd.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+using namespace CS570;
+
+// color + (color - blurred) * weight for a row, the blur output being (b, b, b, 1) as the gray image
+// GaussianBlur writes.
+template <typename T, uint32_t ChannelCount>
+static void SharpenRow(
+    const T* pInput, PixelChannels<ChannelCount> channels, const float* pBlurred, uint32_t width, Float4 weight, float* pOutput)
+{
+    for (uint32_t x = 0; x < width; ++x)
+    {
+        float b = pBlurred[x];
+        Float4 color = LoadPixel(pInput, channels);
+        Float4 blurred(b, b, b, 1.0f);
+        (color + (color - blurred) * weight).Store(pOutput);
+        pInput += ChannelCount;
+        pOutput += CpuImage::k_channelCount;
+    }
+}
+
+void CpuUnsharpMask::OnCreate(
+    const CpuImage& input,
+    uint32_t blurKernelSize,
+    float blurKernelVariance)
+{
+    m_pInput = &input;
+    m_kernelSize = blurKernelSize;
+    m_variance = blurKernelVariance;
+
+    m_output.Resize(input.GetWidth(), input.GetHeight());
+}
+
+void CpuUnsharpMask::OnDestroy()
+{
+    m_output.Release();
+    m_pWeights.reset();
+    m_pInput = nullptr;
+}
+
+void CpuUnsharpMask::Execute()
+{
+    assert(m_pInput != nullptr);
+
+    m_pWeights = GetGaussianKernel(m_kernelSize, m_variance, true, GaussianKernelShape::Separable);
+
+    const CpuImage& input = *m_pInput;
+    const uint32_t halfSize = m_kernelSize >> 1;
+    const uint32_t kernelSize = m_kernelSize;
+    const uint32_t width = m_output.GetWidth();
+    const size_t height = m_output.GetHeight();
+    const float* pWeights = m_pWeights->data();
+    const Float4 weight(m_weight);
+
+    ParallelFor(0, height, 32, [&](size_t rowBegin, size_t rowEnd) {
+        // Horizontal pass of rows rowBegin - halfSize to rowEnd + halfSize, zero outside the image.
+        const size_t passRowCount = (rowEnd - rowBegin) + 2 * halfSize;
+        std::vector<float> horizontalPass(passRowCount * width, 0.0f);
+        std::vector<float> paddedRow(size_t(width) + 2 * halfSize, 0.0f);
+        std::vector<float> blurredRow(width);
+
+        const size_t firstRow = rowBegin >= halfSize ? rowBegin - halfSize : 0;
+        const size_t lastRow = std::min(rowEnd + halfSize, height);
+        for (size_t y = firstRow; y < lastRow; ++y)
+        {
+            LoadRedRow(input, static_cast<uint32_t>(y), paddedRow.data() + halfSize);
+
+            const float* pSrc = paddedRow.data();
+            float* pDst = horizontalPass.data() + (y + halfSize - rowBegin) * width;
+            for (uint32_t col = 0; col < kernelSize; ++col)
+            {
+                const float tapWeight = pWeights[col];
+                for (uint32_t x = 0; x < width; ++x)
+                    pDst[x] += pSrc[x + col] * tapWeight;
+            }
+        }
+
+        for (size_t y = rowBegin; y < rowEnd; ++y)
+        {
+            std::fill(blurredRow.begin(), blurredRow.end(), 0.0f);
+            for (uint32_t row = 0; row < kernelSize; ++row)
+            {
+                const float tapWeight = pWeights[row];
+                const float* pSrc = horizontalPass.data() + (y - rowBegin + row) * width;
+                for (uint32_t x = 0; x < width; ++x)
+                    blurredRow[x] += pSrc[x] * tapWeight;
+            }
+
+            DispatchPixelFormat(input.GetFormat(), [&](auto sample, auto channels) {
+                SharpenRow(input.GetRowSamples<decltype(sample)>(static_cast<uint32_t>(y)), channels, blurredRow.data(), width, weight,
+                    m_output.GetRow(static_cast<uint32_t>(y)));
+            });
+        }
+    });
+}
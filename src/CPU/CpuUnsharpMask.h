@@ -0,0 +1,39 @@
+#pragma once
+
+#include "CpuGaussianKernelCache.h"
+#include "CpuImageProcessor.h"
+
+namespace CS570
+{
+    // Fused equivalent of GaussianBlur -> Subtract -> Add: each chunk of rows is blurred with the
+    // separable kernel in scratch rows and input + weight * (input - blur) is written straight to the
+    // output, so only the input and output images are ever full size.
+    class CpuUnsharpMask : public BaseCpuImageProcessor
+    {
+    public:
+        void OnCreate(
+            const CpuImage& input,
+            uint32_t blurKernelSize,
+            float blurKernelVariance);
+        void OnDestroy();
+
+        void SetWeight(float weight) { m_weight = weight; }
+
+        void Execute() override;
+
+        CpuImage& GetOutputImage() override { return m_output; }
+
+        void SetBlurVariance(float variance) { m_variance = variance; }
+
+    private:
+        const CpuImage* m_pInput = nullptr;
+
+        uint32_t m_kernelSize = 3u;
+        float m_variance = 1.0f;
+        float m_weight = 1.0f;
+
+        GaussianKernelPtr m_pWeights;
+
+        CpuImage m_output;
+    };
+}
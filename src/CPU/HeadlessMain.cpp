@@ -0,0 +1,488 @@
+// Command line front end for the CPU backend. Runs one operation on ppm inputs without a window or
+// a D3D12 device, e.g.
+//   CS570Headless --operation "Gaussian Blur" --input1 media/a.ppm --output blurred.ppm --kernel-size 7
+
+#include "CpuConnectedComponents.h"
+#include "CpuOperationGraphExecutor.h"
+#include "CpuOperationSet.h"
+#include "CpuParallel.h"
+#include "CpuPipeline.h"
+#include "CpuPPM.h"
+#include "CpuStreamingPipeline.h"
+#include "CpuTiledImage.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace CS570;
+
+static OperationGraph BuildOperationChain(
+    const std::string& operations,
+    const CpuImage& input1,
+    const CpuImage& input2,
+    const PointwiseConstants& constants,
+    uint32_t blurKernelSize,
+    float blurVariance)
+{
+    OperationGraph graph;
+    uint32_t input1Node = graph.AddInput(input1.GetWidth(), input1.GetHeight());
+    uint32_t input2Node = graph.AddInput(input2.GetWidth(), input2.GetHeight());
+
+    uint32_t previous = input1Node;
+    size_t begin = 0;
+    while (begin <= operations.size())
+    {
+        size_t end = operations.find(',', begin);
+        if (end == std::string::npos)
+            end = operations.size();
+
+        OperationType type = GetOperationType(operations.substr(begin, end - begin));
+        if (type == OperationType::GaussianBlur)
+            previous = graph.AddGaussianBlur(previous, blurKernelSize, blurVariance);
+        else if (type == OperationType::SobelFilter)
+            previous = graph.AddSobelFilter(previous);
+        else
+            previous = graph.AddPointwise(type, previous, input2Node, constants);
+
+        begin = end + 1;
+    }
+
+    graph.AddOutput(previous);
+    return graph;
+}
+
+// Loads a ppm, or a region of a level of a tiled image. A zero region width reads the whole level.
+static void LoadInputImage(const std::string& file, uint32_t tiledLevel, const uint32_t tiledRegion[4], CpuImage* pImage)
+{
+    if (file.size() < 4 || file.compare(file.size() - 4, 4, ".cti") != 0)
+    {
+        LoadPPM(file, pImage);
+        return;
+    }
+
+    CpuTiledImage tiledImage;
+    tiledImage.Open(file);
+    if (tiledLevel >= tiledImage.GetMipCount())
+        throw "The tiled image has no such level.";
+    if (tiledRegion[2] == 0)
+        tiledImage.ReadRegion(tiledLevel, 0, 0, tiledImage.GetWidth(tiledLevel), tiledImage.GetHeight(tiledLevel), pImage);
+    else
+        tiledImage.ReadRegion(tiledLevel, tiledRegion[0], tiledRegion[1], tiledRegion[2], tiledRegion[3], pImage);
+}
+
+static void PrintUsage()
+{
+    std::printf(
+        "Usage: CS570Headless --operation <name> --input1 <file.ppm> [options]\n"
+        "       CS570Headless --recipe <steps> --input1 <file.ppm> [options]\n"
+        "       CS570Headless --to-tiled <file.cti> --input1 <file.ppm> [options]\n"
+        "Operations: Add, Subtract, Product, Negative, Log, Power, Histogram Equalization,\n"
+        "            Histogram Match, Adaptive Histogram Equalization, Gaussian Blur, Sobel Filter,\n"
+        "            Unsharp Mask, Fourier Transform\n"
+        "A comma separated list of Add, Subtract, Product, Negative, Log, Power, Gaussian Blur and\n"
+        "Sobel Filter runs as one fused OperationGraph: the first operation reads input1 and input2,\n"
+        "each later one reads the previous result and input2.\n"
+        "A recipe is a DAG of ';' separated steps run by CpuPipeline, e.g.\n"
+        "  \"blur = Gaussian Blur(input1); edges = Sobel Filter(input1); out = Add(blur, edges)\"\n"
+        "Inputs ending in .cti are tiled images, of which only the tiles of the level and region read\n"
+        "are decoded.\n"
+        "Options:\n"
+        "  --input2 <file.ppm>       second input, defaults to input1\n"
+        "  --output <file.ppm>       defaults to Output.ppm\n"
+        "  --threads <count>         worker threads, 0 uses every hardware thread (default)\n"
+        "  --iterations <count>      number of times to run the operation, for timing\n"
+        "  --band-rows <rows>        streams the operation or recipe over bands of this many rows,\n"
+        "                            reading and writing binary ppm files a band at a time so the\n"
+        "                            image never has to fit in memory (not for histogram operations,\n"
+        "                            the Fourier transform or comma separated chains)\n"
+        "  --to-tiled <file.cti>     converts input1 to a tiled image with all its mip levels\n"
+        "  --tiled-format <name>     auto (default: rgba8, or rgba16 for 16 bit ppm files), rgba8,\n"
+        "                            rgba16, rgba16f or rgba32f\n"
+        "  --tiled-codec <name>      predictive (default, lossless) or none\n"
+        "  --tiled-level <level>     mip level read from .cti inputs (default 0)\n"
+        "  --tiled-region <x,y,w,h>  region read from .cti inputs (default the whole level)\n"
+        "  --kernel-size <size>      blur kernel size (default 3)\n"
+        "  --variance <value>        blur variance (default 1)\n"
+        "  --blur-algorithm <name>   auto (default), direct, separable or recursive\n"
+        "  --histogram-bins <count>  histogram bins and levels, a power of two from 8 (default) to 65536\n"
+        "  --tiles <count>           adaptive equalization tiles per row and column (default 8)\n"
+        "  --clip-limit <value>      adaptive equalization clip limit, 0 disables clipping (default 2)\n"
+        "  --adaptive-bins <count>   adaptive equalization bins and levels (default 256)\n"
+        "  --ccl-output <file.ppm>   also labels the connected components of the output, as the\n"
+        "                            sample's CCL Output button does, and writes the label image\n"
+        "  --ccl-stats <file>        with --ccl-output, also writes every component's area, bounding\n"
+        "                            box, centroid and mean red, as CSV if the name ends in .csv\n"
+        "                            and binary otherwise\n"
+        "  --connectivity <4|8>      connected component neighborhood (default 4)\n"
+        "  --weight1 <value>         input1 weight\n"
+        "  --weight2 <value>         input2 weight\n"
+        "  --log-constant <value>\n"
+        "  --power-constant <value>\n"
+        "  --power-raise <value>\n");
+}
+
+int main(int argc, char** argv)
+{
+    std::string operation;
+    std::string recipe;
+    std::string inputImage1;
+    std::string inputImage2;
+    std::string outputImage = "Output.ppm";
+    std::string componentImage;
+    std::string componentStatsFile;
+    Connectivity connectivity = Connectivity::Four;
+    uint32_t threadCount = 0u;
+    uint32_t iterationCount = 1u;
+    uint32_t bandRows = 0u;
+    std::string tiledImage;
+    std::string tiledFormatName = "auto";
+    TileCodec tiledCodec = TileCodec::Predictive;
+    uint32_t tiledLevel = 0u;
+    uint32_t tiledRegion[4] = {};
+    uint32_t blurKernelSize = 3u;
+    float blurVariance = 1.0f;
+    GaussianBlurAlgorithm blurAlgorithm = GaussianBlurAlgorithm::Auto;
+    uint32_t histogramBinCount = 8u;
+    uint32_t adaptiveTileCount = 8u;
+    float adaptiveClipLimit = 2.0f;
+    uint32_t adaptiveBinCount = 256u;
+    float weightInput1 = 1.0f;
+    float weightInput2 = 1.0f;
+    float logConstant = 1.0f;
+    float powerConstant = 1.0f;
+    float powerRaise = 1.0f;
+
+    for (int argIndex = 1; argIndex < argc; ++argIndex)
+    {
+        std::string arg = argv[argIndex];
+        if (arg == "--help" || arg == "-h")
+        {
+            PrintUsage();
+            return 0;
+        }
+
+        if (argIndex + 1 >= argc)
+        {
+            std::fprintf(stderr, "Missing value for %s\n", arg.c_str());
+            PrintUsage();
+            return 1;
+        }
+
+        const char* pValue = argv[++argIndex];
+        if (arg == "--operation") operation = pValue;
+        else if (arg == "--recipe") recipe = pValue;
+        else if (arg == "--input1") inputImage1 = pValue;
+        else if (arg == "--input2") inputImage2 = pValue;
+        else if (arg == "--output") outputImage = pValue;
+        else if (arg == "--threads") threadCount = static_cast<uint32_t>(std::atoi(pValue));
+        else if (arg == "--iterations") iterationCount = static_cast<uint32_t>(std::atoi(pValue));
+        else if (arg == "--band-rows") bandRows = static_cast<uint32_t>(std::atoi(pValue));
+        else if (arg == "--to-tiled") tiledImage = pValue;
+        else if (arg == "--tiled-format") tiledFormatName = pValue;
+        else if (arg == "--tiled-codec")
+        {
+            std::string name = pValue;
+            if (name == "predictive") tiledCodec = TileCodec::Predictive;
+            else if (name == "none") tiledCodec = TileCodec::None;
+            else
+            {
+                std::fprintf(stderr, "Unknown tile codec %s\n", pValue);
+                return 1;
+            }
+        }
+        else if (arg == "--tiled-level") tiledLevel = static_cast<uint32_t>(std::atoi(pValue));
+        else if (arg == "--tiled-region")
+        {
+            if (std::sscanf(pValue, "%u,%u,%u,%u", &tiledRegion[0], &tiledRegion[1], &tiledRegion[2], &tiledRegion[3]) != 4 ||
+                tiledRegion[2] == 0 || tiledRegion[3] == 0)
+            {
+                std::fprintf(stderr, "The tiled region must be x,y,width,height.\n");
+                return 1;
+            }
+        }
+        else if (arg == "--kernel-size") blurKernelSize = static_cast<uint32_t>(std::atoi(pValue));
+        else if (arg == "--variance") blurVariance = static_cast<float>(std::atof(pValue));
+        else if (arg == "--blur-algorithm")
+        {
+            std::string name = pValue;
+            if (name == "auto") blurAlgorithm = GaussianBlurAlgorithm::Auto;
+            else if (name == "direct") blurAlgorithm = GaussianBlurAlgorithm::Direct;
+            else if (name == "separable") blurAlgorithm = GaussianBlurAlgorithm::Separable;
+            else if (name == "recursive") blurAlgorithm = GaussianBlurAlgorithm::Recursive;
+            else
+            {
+                std::fprintf(stderr, "Unknown blur algorithm %s\n", pValue);
+                return 1;
+            }
+        }
+        else if (arg == "--histogram-bins") histogramBinCount = static_cast<uint32_t>(std::atoi(pValue));
+        else if (arg == "--tiles") adaptiveTileCount = static_cast<uint32_t>(std::atoi(pValue));
+        else if (arg == "--clip-limit") adaptiveClipLimit = static_cast<float>(std::atof(pValue));
+        else if (arg == "--adaptive-bins") adaptiveBinCount = static_cast<uint32_t>(std::atoi(pValue));
+        else if (arg == "--ccl-output") componentImage = pValue;
+        else if (arg == "--ccl-stats") componentStatsFile = pValue;
+        else if (arg == "--connectivity")
+        {
+            std::string neighbors = pValue;
+            if (neighbors == "4") connectivity = Connectivity::Four;
+            else if (neighbors == "8") connectivity = Connectivity::Eight;
+            else
+            {
+                std::fprintf(stderr, "The connectivity must be 4 or 8.\n");
+                return 1;
+            }
+        }
+        else if (arg == "--weight1") weightInput1 = static_cast<float>(std::atof(pValue));
+        else if (arg == "--weight2") weightInput2 = static_cast<float>(std::atof(pValue));
+        else if (arg == "--log-constant") logConstant = static_cast<float>(std::atof(pValue));
+        else if (arg == "--power-constant") powerConstant = static_cast<float>(std::atof(pValue));
+        else if (arg == "--power-raise") powerRaise = static_cast<float>(std::atof(pValue));
+        else
+        {
+            std::fprintf(stderr, "Unknown option %s\n", arg.c_str());
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if ((operation.empty() && recipe.empty() && tiledImage.empty()) || inputImage1.empty())
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    SetCpuWorkerCount(threadCount);
+
+    if (!tiledImage.empty())
+    {
+        try
+        {
+            CpuPixelFormat format = CpuPixelFormat::RGBA8;
+            if (tiledFormatName == "auto")
+            {
+                CpuPPMReader reader;
+                reader.Open(inputImage1);
+                format = reader.GetMaxValue() > 255 ? CpuPixelFormat::RGBA16 : CpuPixelFormat::RGBA8;
+            }
+            else if (tiledFormatName == "rgba8") format = CpuPixelFormat::RGBA8;
+            else if (tiledFormatName == "rgba16") format = CpuPixelFormat::RGBA16;
+            else if (tiledFormatName == "rgba16f") format = CpuPixelFormat::RGBA16F;
+            else if (tiledFormatName == "rgba32f") format = CpuPixelFormat::RGBA32F;
+            else
+            {
+                std::fprintf(stderr, "Unknown tiled format %s\n", tiledFormatName.c_str());
+                return 1;
+            }
+
+            auto startTime = std::chrono::steady_clock::now();
+            ConvertPPMToTiledImage(inputImage1, tiledImage, format, tiledCodec);
+            auto endTime = std::chrono::steady_clock::now();
+
+            CpuTiledImage converted;
+            converted.Open(tiledImage);
+            std::printf("Tiled image: %ux%u, %u mip levels, %u thread(s), %.3f ms\n",
+                converted.GetWidth(), converted.GetHeight(), converted.GetMipCount(), GetCpuWorkerCount(),
+                std::chrono::duration<double, std::milli>(endTime - startTime).count());
+        }
+        catch (const char* pError)
+        {
+            std::fprintf(stderr, "Error: %s\n", pError);
+            return 1;
+        }
+
+        return 0;
+    }
+
+    if (inputImage2.empty())
+        inputImage2 = inputImage1;
+
+    if (blurKernelSize == 0 || (blurKernelSize & 1) == 0)
+    {
+        std::fprintf(stderr, "The blur kernel size must be odd.\n");
+        return 1;
+    }
+
+    CpuPipelineParameters parameters;
+    parameters.blurKernelSize = blurKernelSize;
+    parameters.blurVariance = blurVariance;
+    parameters.blurAlgorithm = blurAlgorithm;
+    parameters.weightInput1 = weightInput1;
+    parameters.weightInput2 = weightInput2;
+    parameters.logConstant = logConstant;
+    parameters.powerConstant = powerConstant;
+    parameters.powerRaise = powerRaise;
+    parameters.histogramBinCount = histogramBinCount;
+    parameters.adaptiveTileCount = adaptiveTileCount;
+    parameters.adaptiveClipLimit = adaptiveClipLimit;
+    parameters.adaptiveBinCount = adaptiveBinCount;
+
+    if (bandRows > 0)
+    {
+        if (!componentImage.empty() || operation.find(',') != std::string::npos)
+        {
+            std::fprintf(stderr, "--band-rows doesn't support --ccl-output or comma separated chains.\n");
+            return 1;
+        }
+
+        try
+        {
+            // A single operation streams as a one step recipe.
+            std::vector<PipelineRecipeStep> steps;
+            if (!recipe.empty())
+            {
+                steps = ParsePipelineRecipe(recipe);
+            }
+            else
+            {
+                steps.emplace_back();
+                steps.back().name = "output";
+                steps.back().operation = operation;
+                steps.back().inputs[0] = "input1";
+                steps.back().inputs[1] = "input2";
+            }
+
+            // The inputs are rebound to each band as it is read.
+            CpuImage noInput;
+            CpuPipeline pipeline;
+            std::vector<uint32_t> inputNodes = { pipeline.AddInput(noInput), pipeline.AddInput(noInput) };
+            AddPipelineRecipe(steps, { "input1", "input2" }, inputNodes, parameters, &pipeline);
+
+            CpuStreamingPipeline streamingPipeline;
+            streamingPipeline.OnCreate(&pipeline, inputNodes, { inputImage1, inputImage2 }, bandRows);
+
+            auto startTime = std::chrono::steady_clock::now();
+            streamingPipeline.Execute(outputImage);
+            auto endTime = std::chrono::steady_clock::now();
+
+            const StreamingPipelineStats& stats = streamingPipeline.GetStats();
+            std::printf("%s: %ux%u streamed in %u bands of %u rows (+%u halo rows), %.2f MB per input band, %u thread(s), %.3f ms\n",
+                recipe.empty() ? operation.c_str() : "Recipe",
+                streamingPipeline.GetWidth(), streamingPipeline.GetHeight(), stats.bandCount, bandRows, stats.haloRows,
+                stats.peakBandSize / (1024.0 * 1024.0), GetCpuWorkerCount(),
+                std::chrono::duration<double, std::milli>(endTime - startTime).count());
+
+            streamingPipeline.OnDestroy();
+        }
+        catch (const char* pError)
+        {
+            std::fprintf(stderr, "Error: %s\n", pError);
+            return 1;
+        }
+
+        return 0;
+    }
+
+    try
+    {
+        CpuImage input1;
+        CpuImage input2;
+        LoadInputImage(inputImage1, tiledLevel, tiledRegion, &input1);
+        LoadInputImage(inputImage2, tiledLevel, tiledRegion, &input2);
+
+        CpuOperationSet operations;
+        operations.OnCreate(input1, input2, blurKernelSize, blurVariance);
+        operations.SetWeightInput1(weightInput1);
+        operations.SetWeightInput2(weightInput2);
+        operations.SetLogConstant(logConstant);
+        operations.SetPowerConstant(powerConstant);
+        operations.SetPowerRaise(powerRaise);
+        operations.SetBlurAlgorithm(blurAlgorithm);
+        operations.SetHistogramBinCount(histogramBinCount);
+        operations.SetAdaptiveTileCount(adaptiveTileCount);
+        operations.SetAdaptiveClipLimit(adaptiveClipLimit);
+        operations.SetAdaptiveBinCount(adaptiveBinCount);
+
+        CpuOperationGraphExecutor operationChain;
+        CpuPipeline pipeline;
+        BaseCpuImageProcessor* pOperation = nullptr;
+        if (!recipe.empty())
+        {
+            AddPipelineRecipe(
+                ParsePipelineRecipe(recipe),
+                { "input1", "input2" },
+                { pipeline.AddInput(input1), pipeline.AddInput(input2) },
+                parameters,
+                &pipeline);
+            operation = "Recipe";
+            pOperation = &pipeline;
+
+            MemoryPlan plan = pipeline.PlanMemory();
+            std::printf("Recipe intermediates: %.2f MB planned, %.2f MB peak live, %.2f MB unplanned\n",
+                plan.arenaSize / (1024.0 * 1024.0),
+                plan.peakLiveSize / (1024.0 * 1024.0),
+                plan.unplannedSize / (1024.0 * 1024.0));
+        }
+        else if (operation.find(',') != std::string::npos)
+        {
+            PointwiseConstants constants;
+            constants.logConstant = logConstant;
+            constants.powerConstant = powerConstant;
+            constants.powerRaise = powerRaise;
+            constants.weightInput1 = weightInput1;
+            constants.weightInput2 = weightInput2;
+            operationChain.OnCreate(
+                BuildOperationChain(operation, input1, input2, constants, blurKernelSize, blurVariance),
+                { &input1, &input2 });
+            pOperation = &operationChain;
+        }
+        else
+        {
+            pOperation = operations.GetOperation(operation);
+        }
+
+        if (pOperation == nullptr)
+        {
+            std::fprintf(stderr, "Unknown operation \"%s\"\n", operation.c_str());
+            PrintUsage();
+            return 1;
+        }
+
+        auto startTime = std::chrono::steady_clock::now();
+        for (uint32_t iteration = 0; iteration < iterationCount; ++iteration)
+            pOperation->Execute();
+        auto endTime = std::chrono::steady_clock::now();
+
+        double milliseconds = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+        std::printf("%s: %ux%u, %u thread(s), %.3f ms per iteration\n",
+            operation.c_str(), input1.GetWidth(), input1.GetHeight(), GetCpuWorkerCount(),
+            milliseconds / (iterationCount > 0 ? iterationCount : 1));
+
+        WritePPM(outputImage, pOperation->GetOutputImage());
+
+        if (!componentImage.empty())
+        {
+            const CpuImage& output = pOperation->GetOutputImage();
+            std::vector<uint8_t> classKeys;
+            std::vector<uint8_t> reds;
+            ComputeComponentClassKeys(output, &classKeys, componentStatsFile.empty() ? nullptr : &reds);
+
+            CpuConnectedComponents connectedComponents;
+            connectedComponents.OnCreate(classKeys.data(), output.GetWidth(), output.GetHeight(), connectivity);
+            connectedComponents.SetComponentStats(!componentStatsFile.empty(), reds.data());
+            startTime = std::chrono::steady_clock::now();
+            connectedComponents.Execute();
+            endTime = std::chrono::steady_clock::now();
+
+            std::printf("Connected components: %u, %.3f ms\n",
+                connectedComponents.GetComponentCount(),
+                std::chrono::duration<double, std::milli>(endTime - startTime).count());
+
+            WriteLabelPPM(componentImage, connectedComponents.GetLabels().data(), output.GetWidth(), output.GetHeight());
+            if (!componentStatsFile.empty())
+                WriteComponentStats(componentStatsFile, connectedComponents.GetComponentStats());
+        }
+
+        operationChain.OnDestroy();
+        operations.OnDestroy();
+    }
+    catch (const char* pError)
+    {
+        std::fprintf(stderr, "Error: %s\n", pError);
+        return 1;
+    }
+
+    return 0;
+}
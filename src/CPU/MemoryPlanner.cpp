@@ -0,0 +1,90 @@
+#include "MemoryPlanner.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace CS570;
+
+static size_t AlignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+MemoryPlan CS570::PlanTransientMemory(const std::vector<TransientBuffer>& buffers, size_t alignment)
+{
+    assert(alignment > 0);
+
+    MemoryPlan plan;
+    plan.offsets.assign(buffers.size(), 0);
+
+    uint32_t stepCount = 0;
+    for (const TransientBuffer& buffer : buffers)
+    {
+        assert(buffer.firstUse <= buffer.lastUse);
+        stepCount = std::max(stepCount, buffer.lastUse + 1);
+        plan.unplannedSize += AlignUp(buffer.size, alignment);
+    }
+
+    std::vector<size_t> liveSizes(stepCount, 0);
+    for (const TransientBuffer& buffer : buffers)
+    {
+        for (uint32_t step = buffer.firstUse; step <= buffer.lastUse; ++step)
+            liveSizes[step] += AlignUp(buffer.size, alignment);
+    }
+    for (size_t liveSize : liveSizes)
+        plan.peakLiveSize = std::max(plan.peakLiveSize, liveSize);
+
+    std::vector<size_t> order(buffers.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&buffers](size_t a, size_t b) {
+        return buffers[a].size > buffers[b].size;
+    });
+
+    struct Range
+    {
+        size_t begin;
+        size_t end;
+    };
+
+    std::vector<size_t> placed;
+    std::vector<Range> conflicts;
+    for (size_t index : order)
+    {
+        const TransientBuffer& buffer = buffers[index];
+        const size_t size = AlignUp(buffer.size, alignment);
+
+        // Memory ranges of the placed buffers that are live at the same time as this one.
+        conflicts.clear();
+        for (size_t other : placed)
+        {
+            if (buffers[other].lastUse < buffer.firstUse || buffer.lastUse < buffers[other].firstUse)
+                continue;
+            Range range = { plan.offsets[other], plan.offsets[other] + AlignUp(buffers[other].size, alignment) };
+            conflicts.push_back(range);
+        }
+        std::sort(conflicts.begin(), conflicts.end(), [](const Range& a, const Range& b) { return a.begin < b.begin; });
+
+        // Smallest gap that fits, falling back to the end of the last conflicting range.
+        size_t offset = 0;
+        size_t bestOffset = SIZE_MAX;
+        size_t bestGap = SIZE_MAX;
+        for (const Range& range : conflicts)
+        {
+            if (range.begin >= offset && range.begin - offset >= size && range.begin - offset < bestGap)
+            {
+                bestGap = range.begin - offset;
+                bestOffset = offset;
+            }
+            offset = std::max(offset, range.end);
+        }
+        if (bestOffset == SIZE_MAX)
+            bestOffset = offset;
+
+        plan.offsets[index] = bestOffset;
+        plan.arenaSize = std::max(plan.arenaSize, bestOffset + size);
+        placed.push_back(index);
+    }
+
+    return plan;
+}
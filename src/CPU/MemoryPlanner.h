@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace CS570
+{
+    // A buffer that is written at step firstUse and last read at step lastUse (inclusive). Steps are
+    // whatever the caller schedules atomically, e.g. a CpuPipeline wave or a graph stage.
+    struct TransientBuffer
+    {
+        size_t size = 0;
+        uint32_t firstUse = 0u;
+        uint32_t lastUse = 0u;
+    };
+
+    struct MemoryPlan
+    {
+        // Byte offset of each buffer in the shared backing allocation.
+        std::vector<size_t> offsets;
+        // Size of the backing allocation, the planned peak footprint.
+        size_t arenaSize = 0;
+        // Largest sum of simultaneously live buffers, the lower bound for arenaSize.
+        size_t peakLiveSize = 0;
+        // Sum of all buffers, the footprint with one allocation per buffer.
+        size_t unplannedSize = 0;
+    };
+
+    // Packs the buffers into one allocation so buffers with disjoint live ranges share memory.
+    // Buffers are placed largest first (greedy by size) into the smallest gap between the placed
+    // buffers whose live ranges intersect theirs that fits them (best fit), or after the last of
+    // those buffers when no gap does. arenaSize is usually within a few percent of peakLiveSize.
+    MemoryPlan PlanTransientMemory(const std::vector<TransientBuffer>& buffers, size_t alignment);
+}
@@ -0,0 +1,234 @@
+#include "OperationGraph.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace CS570;
+
+bool CS570::IsPointwiseOperation(OperationType type)
+{
+    switch (type)
+    {
+    case OperationType::Add:
+    case OperationType::Subtract:
+    case OperationType::Product:
+    case OperationType::Negative:
+    case OperationType::Log:
+    case OperationType::Power:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool CS570::IsNeighborhoodOperation(OperationType type)
+{
+    return type == OperationType::GaussianBlur || type == OperationType::SobelFilter;
+}
+
+static bool IsUnaryOperation(OperationType type)
+{
+    return type == OperationType::Negative || type == OperationType::Log || type == OperationType::Power;
+}
+
+OperationType CS570::GetOperationType(const std::string& operation)
+{
+    if (operation == "Add") return OperationType::Add;
+    else if (operation == "Subtract") return OperationType::Subtract;
+    else if (operation == "Product") return OperationType::Product;
+    else if (operation == "Negative") return OperationType::Negative;
+    else if (operation == "Log") return OperationType::Log;
+    else if (operation == "Power") return OperationType::Power;
+    else if (operation == "Gaussian Blur") return OperationType::GaussianBlur;
+    else if (operation == "Sobel Filter") return OperationType::SobelFilter;
+
+    throw "Operation is not supported by OperationGraph.";
+}
+
+uint32_t OperationGraph::AddNode(const OperationNode& node)
+{
+    m_nodes.push_back(node);
+    return static_cast<uint32_t>(m_nodes.size() - 1);
+}
+
+uint32_t OperationGraph::AddInput(uint32_t width, uint32_t height)
+{
+    OperationNode node;
+    node.type = OperationType::Input;
+    node.width = width;
+    node.height = height;
+    node.imageIndex = m_inputCount++;
+    return AddNode(node);
+}
+
+uint32_t OperationGraph::AddPointwise(
+    OperationType type,
+    uint32_t input1,
+    uint32_t input2,
+    const PointwiseConstants& constants)
+{
+    if (!IsPointwiseOperation(type))
+        throw "AddPointwise requires a pointwise operation.";
+
+    if (IsUnaryOperation(type))
+        input2 = OperationNode::k_invalidNode;
+    else if (input2 >= m_nodes.size())
+        throw "Invalid OperationGraph input node.";
+
+    if (input1 >= m_nodes.size())
+        throw "Invalid OperationGraph input node.";
+
+    OperationNode node;
+    node.type = type;
+    node.inputs[0] = input1;
+    node.inputs[1] = input2;
+    node.constants = constants;
+    node.width = m_nodes[input1].width;
+    node.height = m_nodes[input1].height;
+    if (input2 != OperationNode::k_invalidNode)
+    {
+        node.width = std::max(node.width, m_nodes[input2].width);
+        node.height = std::max(node.height, m_nodes[input2].height);
+    }
+    return AddNode(node);
+}
+
+uint32_t OperationGraph::AddGaussianBlur(uint32_t input, uint32_t blurKernelSize, float blurVariance)
+{
+    if (input >= m_nodes.size())
+        throw "Invalid OperationGraph input node.";
+
+    OperationNode node;
+    node.type = OperationType::GaussianBlur;
+    node.inputs[0] = input;
+    node.width = m_nodes[input].width;
+    node.height = m_nodes[input].height;
+    node.blurKernelSize = blurKernelSize;
+    node.blurVariance = blurVariance;
+    return AddNode(node);
+}
+
+uint32_t OperationGraph::AddSobelFilter(uint32_t input)
+{
+    if (input >= m_nodes.size())
+        throw "Invalid OperationGraph input node.";
+
+    OperationNode node;
+    node.type = OperationType::SobelFilter;
+    node.inputs[0] = input;
+    node.width = m_nodes[input].width;
+    node.height = m_nodes[input].height;
+    return AddNode(node);
+}
+
+void OperationGraph::AddOutput(uint32_t node)
+{
+    if (node >= m_nodes.size())
+        throw "Invalid OperationGraph output node.";
+
+    if (std::find(m_outputs.begin(), m_outputs.end(), node) == m_outputs.end())
+        m_outputs.push_back(node);
+}
+
+uint32_t OperationGraph::GetConsumerCount(uint32_t node) const
+{
+    // Nodes that read the same input twice (Add(a, a)) count once.
+    uint32_t consumerCount = 0;
+    for (const OperationNode& consumer : m_nodes)
+    {
+        if (consumer.inputs[0] == node || consumer.inputs[1] == node)
+            ++consumerCount;
+    }
+    return consumerCount;
+}
+
+bool OperationGraph::IsMaterialized(uint32_t node) const
+{
+    const OperationNode& current = m_nodes[node];
+    if (current.type == OperationType::Input)
+        return true;
+    if (std::find(m_outputs.begin(), m_outputs.end(), node) != m_outputs.end())
+        return true;
+    if (GetConsumerCount(node) != 1)
+        return true;
+
+    for (const OperationNode& consumer : m_nodes)
+    {
+        if (consumer.inputs[0] != node && consumer.inputs[1] != node)
+            continue;
+
+        return IsNeighborhoodOperation(consumer.type) ||
+            consumer.width != current.width ||
+            consumer.height != current.height;
+    }
+
+    assert(false);
+    return true;
+}
+
+void OperationGraph::CollectStageNodes(uint32_t node, FusedStage* pStage) const
+{
+    if (std::find(pStage->nodes.begin(), pStage->nodes.end(), node) != pStage->nodes.end())
+        return;
+
+    for (uint32_t input : m_nodes[node].inputs)
+    {
+        if (input == OperationNode::k_invalidNode)
+            continue;
+
+        if (IsMaterialized(input))
+        {
+            if (std::find(pStage->sources.begin(), pStage->sources.end(), input) == pStage->sources.end())
+                pStage->sources.push_back(input);
+        }
+        else
+        {
+            CollectStageNodes(input, pStage);
+        }
+    }
+
+    pStage->nodes.push_back(node);
+}
+
+std::vector<FusedStage> OperationGraph::Fuse() const
+{
+    if (m_outputs.empty())
+        throw "OperationGraph has no outputs.";
+
+    // Depth first from the outputs, emitting a stage once every stage it reads from has been
+    // emitted. Nodes no output depends on are never evaluated.
+    std::vector<FusedStage> stages;
+    std::vector<uint8_t> emitted(m_nodes.size(), 0);
+    std::vector<uint32_t> pending(m_outputs.rbegin(), m_outputs.rend());
+    while (!pending.empty())
+    {
+        uint32_t node = pending.back();
+        if (emitted[node] != 0 || m_nodes[node].type == OperationType::Input)
+        {
+            pending.pop_back();
+            continue;
+        }
+
+        FusedStage stage;
+        CollectStageNodes(node, &stage);
+
+        bool ready = true;
+        for (uint32_t source : stage.sources)
+        {
+            if (emitted[source] == 0 && m_nodes[source].type != OperationType::Input)
+            {
+                pending.push_back(source);
+                ready = false;
+            }
+        }
+
+        if (ready)
+        {
+            pending.pop_back();
+            emitted[node] = 1;
+            stages.push_back(stage);
+        }
+    }
+
+    return stages;
+}
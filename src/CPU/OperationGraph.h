@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace CS570
+{
+    enum class OperationType
+    {
+        Input,
+        // Pointwise, the entry points of ImageProcessor.hlsl.
+        Add,
+        Subtract,
+        Product,
+        Negative,
+        Log,
+        Power,
+        // Neighborhood, gray (v, v, v, 1) output from the red channel of the source.
+        GaussianBlur,
+        SobelFilter
+    };
+
+    bool IsPointwiseOperation(OperationType type);
+    bool IsNeighborhoodOperation(OperationType type);
+
+    // Maps the operation names used by the sample UI ("Add", "Gaussian Blur", ...) to a type. Throws
+    // for names that have no graph node.
+    OperationType GetOperationType(const std::string& operation);
+
+    // Same defaults as the ImageProcessor constants.
+    struct PointwiseConstants
+    {
+        float logConstant = 1.0f;
+        float powerConstant = 1.0f;
+        float powerRaise = 1.0f;
+        float weightInput1 = 1.0f;
+        float weightInput2 = 1.0f;
+    };
+
+    struct OperationNode
+    {
+        static const uint32_t k_invalidNode = 0xFFFFFFFFu;
+
+        OperationType type = OperationType::Input;
+        uint32_t inputs[2] = { k_invalidNode, k_invalidNode };
+        uint32_t width = 0u;
+        uint32_t height = 0u;
+
+        // Input nodes: index of the image bound to this input at execution time.
+        uint32_t imageIndex = 0u;
+        PointwiseConstants constants;
+        uint32_t blurKernelSize = 3u;
+        float blurVariance = 1.0f;
+    };
+
+    // One pass of the fused graph: every node is evaluated per tile in order, with only
+    // nodes[nodes.size() - 1] written out. sources are the materialized nodes the pass reads.
+    struct FusedStage
+    {
+        std::vector<uint32_t> nodes;
+        std::vector<uint32_t> sources;
+
+        uint32_t GetOutputNode() const { return nodes.back(); }
+    };
+
+    // Describes a chain or tree of image operations without binding any images, so the CPU and GPU
+    // executors share it. Pointwise nodes take the larger size of their inputs and point sample the
+    // smaller one, like ImageProcessor; neighborhood nodes keep the size of their input.
+    class OperationGraph
+    {
+    public:
+        uint32_t AddInput(uint32_t width, uint32_t height);
+        // input2 is ignored by Negative, Log and Power and may be k_invalidNode for them.
+        uint32_t AddPointwise(
+            OperationType type,
+            uint32_t input1,
+            uint32_t input2 = OperationNode::k_invalidNode,
+            const PointwiseConstants& constants = PointwiseConstants());
+        uint32_t AddGaussianBlur(uint32_t input, uint32_t blurKernelSize, float blurVariance);
+        uint32_t AddSobelFilter(uint32_t input);
+
+        // Outputs are always materialized; everything else only when fusion can't avoid it.
+        void AddOutput(uint32_t node);
+
+        const OperationNode& GetNode(uint32_t node) const { return m_nodes[node]; }
+        size_t GetNodeCount() const { return m_nodes.size(); }
+        const std::vector<uint32_t>& GetOutputs() const { return m_outputs; }
+        uint32_t GetInputCount() const { return m_inputCount; }
+
+        // Fusion pass. A node gets its own image only if it is an input or an output, has more
+        // than one consumer, feeds a neighborhood node (which needs its neighbors), or differs in
+        // size from its consumer (which would have to resample it). Every other node is folded into
+        // the stage of its consumer, so a chain of pointwise nodes, or a neighborhood node followed
+        // by pointwise nodes, runs as one loop per tile. Stages are returned in execution order.
+        std::vector<FusedStage> Fuse() const;
+
+        bool IsMaterialized(uint32_t node) const;
+
+    private:
+        uint32_t AddNode(const OperationNode& node);
+        uint32_t GetConsumerCount(uint32_t node) const;
+        void CollectStageNodes(uint32_t node, FusedStage* pStage) const;
+
+        std::vector<OperationNode> m_nodes;
+        std::vector<uint32_t> m_outputs;
+        uint32_t m_inputCount = 0u;
+    };
+}
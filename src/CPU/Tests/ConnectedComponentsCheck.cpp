@@ -0,0 +1,227 @@
+// Checks CpuConnectedComponents against a plain BFS labeling over random images: labels and
+// per component statistics, for 4 and 8 connectivity, several strip heights and worker counts, and
+// the class keys of float images, NaN included. Returns non zero on failure.
+
+#include "CpuConnectedComponents.h"
+#include "CpuParallel.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace CS570;
+
+static int s_failures = 0;
+
+static void Check(bool condition, const std::string& what)
+{
+    if (!condition)
+    {
+        std::printf("FAILED: %s\n", what.c_str());
+        ++s_failures;
+    }
+}
+
+// Labels in raster order of every component's first pixel, with statistics computed the same way
+// as CpuConnectedComponents: integer sums divided in double at the end.
+static void LabelWithBFS(
+    const uint8_t* pKeys,
+    const uint8_t* pIntensities,
+    uint32_t intensityStride,
+    uint32_t width,
+    uint32_t height,
+    Connectivity connectivity,
+    std::vector<uint32_t>* pLabels,
+    std::vector<ComponentStats>* pStats)
+{
+    pLabels->assign(size_t(width) * height, 0u);
+    pStats->clear();
+    std::vector<size_t> queue;
+    uint32_t nextLabel = 1;
+    for (size_t start = 0; start < pLabels->size(); ++start)
+    {
+        if (pKeys[start] == 0 || (*pLabels)[start] != 0)
+            continue;
+
+        uint64_t area = 0;
+        uint64_t sumX = 0;
+        uint64_t sumY = 0;
+        uint64_t sumIntensity = 0;
+        ComponentStats stats = {};
+        stats.label = nextLabel;
+        stats.classKey = pKeys[start];
+        stats.minX = width;
+        stats.minY = height;
+
+        (*pLabels)[start] = nextLabel;
+        queue.assign(1, start);
+        for (size_t next = 0; next < queue.size(); ++next)
+        {
+            const uint32_t x = static_cast<uint32_t>(queue[next] % width);
+            const uint32_t y = static_cast<uint32_t>(queue[next] / width);
+            ++area;
+            sumX += x;
+            sumY += y;
+            sumIntensity += pIntensities[queue[next] * intensityStride];
+            stats.minX = std::min(stats.minX, x);
+            stats.minY = std::min(stats.minY, y);
+            stats.maxX = std::max(stats.maxX, x);
+            stats.maxY = std::max(stats.maxY, y);
+
+            for (int dy = -1; dy <= 1; ++dy)
+            {
+                for (int dx = -1; dx <= 1; ++dx)
+                {
+                    if ((dx == 0 && dy == 0) || (connectivity == Connectivity::Four && dx != 0 && dy != 0))
+                        continue;
+                    const int neighborX = static_cast<int>(x) + dx;
+                    const int neighborY = static_cast<int>(y) + dy;
+                    if (neighborX < 0 || neighborY < 0 || neighborX >= static_cast<int>(width) || neighborY >= static_cast<int>(height))
+                        continue;
+                    const size_t neighbor = size_t(neighborY) * width + neighborX;
+                    if (pKeys[neighbor] == stats.classKey && (*pLabels)[neighbor] == 0)
+                    {
+                        (*pLabels)[neighbor] = nextLabel;
+                        queue.push_back(neighbor);
+                    }
+                }
+            }
+        }
+
+        const double areaAsDouble = static_cast<double>(area);
+        stats.area = area;
+        stats.centroidX = static_cast<float>(sumX / areaAsDouble);
+        stats.centroidY = static_cast<float>(sumY / areaAsDouble);
+        stats.meanIntensity = static_cast<float>(sumIntensity / areaAsDouble);
+        pStats->push_back(stats);
+        ++nextLabel;
+    }
+}
+
+static bool IsSameStats(const ComponentStats& a, const ComponentStats& b)
+{
+    return a.label == b.label && a.classKey == b.classKey && a.area == b.area && a.minX == b.minX && a.minY == b.minY &&
+        a.maxX == b.maxX && a.maxY == b.maxY && a.centroidX == b.centroidX && a.centroidY == b.centroidY &&
+        a.meanIntensity == b.meanIntensity;
+}
+
+// Random RGBA8 pixels whose red values form blobs: every pixel mostly repeats the class of its left
+// or upper neighbor, so components wind across many rows and strip seams.
+static void MakeImage(std::mt19937& random, uint32_t width, uint32_t height, uint32_t classCount, std::vector<uint8_t>* pPixels)
+{
+    const uint8_t reds[] = { 0, 1, 2, 4, 8, 16, 32, 64, 128 };
+    std::vector<uint8_t> classes(size_t(width) * height);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const uint32_t choice = random() % 8;
+            uint8_t pixelClass = static_cast<uint8_t>(random() % classCount);
+            if (choice < 3 && x > 0)
+                pixelClass = classes[size_t(y) * width + x - 1];
+            else if (choice < 6 && y > 0)
+                pixelClass = classes[size_t(y - 1) * width + x];
+            classes[size_t(y) * width + x] = pixelClass;
+        }
+    }
+
+    pPixels->resize(classes.size() * 4);
+    for (size_t i = 0; i < classes.size(); ++i)
+    {
+        // Any red value with the class's highest set bit, and random intensities in green.
+        const uint8_t red = reds[classes[i]];
+        (*pPixels)[i * 4 + 0] = red > 1 ? static_cast<uint8_t>(red | (random() % red)) : red;
+        (*pPixels)[i * 4 + 1] = static_cast<uint8_t>(random());
+        (*pPixels)[i * 4 + 2] = 0;
+        (*pPixels)[i * 4 + 3] = 255;
+    }
+}
+
+// Float red values, including NaN and values outside [0, 1], are quantized as WritePPM does before
+// their class key is taken, and NaN counts as background.
+static void CheckFloatClassKeys()
+{
+    const float reds[] = { std::numeric_limits<float>::quiet_NaN(), -1.0f, 0.0f, 1.0f / 255.0f, 0.25f, 1.0f, 2.0f };
+    const uint8_t expectedReds[] = { 0, 0, 0, 1, 64, 255, 255 };
+    CpuImage image(7, 2);
+    for (uint32_t y = 0; y < image.GetHeight(); ++y)
+    {
+        for (uint32_t x = 0; x < image.GetWidth(); ++x)
+        {
+            float* pPixel = image.GetPixel(x, y);
+            pPixel[0] = reds[(x + y) % 7];
+            pPixel[1] = pPixel[2] = 0.5f;
+            pPixel[3] = 1.0f;
+        }
+    }
+
+    std::vector<uint8_t> keys;
+    ComputeComponentClassKeys(image, &keys);
+    bool matches = keys.size() == image.GetPixelCount();
+    for (size_t pixel = 0; matches && pixel < keys.size(); ++pixel)
+        matches = keys[pixel] == GetComponentClassKey(expectedReds[(pixel % 7 + pixel / 7) % 7]);
+    Check(matches, "class keys of float red values, NaN included");
+}
+
+int main()
+{
+    CheckFloatClassKeys();
+
+    std::mt19937 random(15);
+    const uint32_t sizes[][2] = { { 1, 1 }, { 1, 97 }, { 97, 1 }, { 31, 29 }, { 200, 150 }, { 64, 513 } };
+    const uint32_t stripHeights[] = { 1, 2, 5, 16, CpuConnectedComponents::k_defaultMinStripHeight };
+    const uint32_t workerCounts[] = { 1, 3, 8 };
+
+    for (uint32_t image = 0; image < 24; ++image)
+    {
+        const uint32_t width = sizes[image % 6][0];
+        const uint32_t height = sizes[image % 6][1];
+        const uint32_t classCount = 2 + image % 7;
+        std::vector<uint8_t> pixels;
+        MakeImage(random, width, height, classCount, &pixels);
+
+        std::vector<uint8_t> keys(size_t(width) * height);
+        ComputeComponentClassKeys(pixels.data(), keys.size(), 4, keys.data());
+
+        for (Connectivity connectivity : { Connectivity::Four, Connectivity::Eight })
+        {
+            std::vector<uint32_t> expectedLabels;
+            std::vector<ComponentStats> expectedStats;
+            LabelWithBFS(keys.data(), pixels.data() + 1, 4, width, height, connectivity, &expectedLabels, &expectedStats);
+
+            for (uint32_t workerCount : workerCounts)
+            {
+                SetCpuWorkerCount(workerCount);
+                for (uint32_t stripHeight : stripHeights)
+                {
+                    const std::string what = "image " + std::to_string(image) + " (" + std::to_string(width) + "x" +
+                        std::to_string(height) + ") " + (connectivity == Connectivity::Four ? "4" : "8") + " connected, " +
+                        std::to_string(workerCount) + " workers, strips of " + std::to_string(stripHeight) + " rows";
+
+                    CpuConnectedComponents connectedComponents;
+                    connectedComponents.OnCreate(keys.data(), width, height, connectivity);
+                    connectedComponents.SetMinStripHeight(stripHeight);
+                    connectedComponents.SetComponentStats(true, pixels.data() + 1, 4);
+                    connectedComponents.Execute();
+
+                    Check(connectedComponents.GetComponentCount() == expectedStats.size(), what + ": component count");
+                    Check(connectedComponents.GetLabels() == expectedLabels, what + ": labels");
+
+                    const std::vector<ComponentStats>& stats = connectedComponents.GetComponentStats();
+                    bool sameStats = stats.size() == expectedStats.size();
+                    for (size_t component = 0; sameStats && component < stats.size(); ++component)
+                        sameStats = IsSameStats(stats[component], expectedStats[component]);
+                    Check(sameStats, what + ": component stats");
+                }
+            }
+        }
+    }
+
+    if (s_failures == 0)
+        std::printf("ConnectedComponentsCheck passed\n");
+    return s_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+// Checks that grey images kept as single channel planes give the same results as the same images
+// stored as RGBA: every operation run on an R8 input matches the run on the equivalent RGBA8 input,
+// and P5 and grey P6 files load as grey planes, grey P6 files only when the reader is asked to
+// check for them. Returns non zero on failure.
+
+#include "CpuParallel.h"
+#include "CpuPipeline.h"
+#include "CpuPPM.h"
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace CS570;
+
+static int s_failures = 0;
+
+static void Check(bool condition, const std::string& what)
+{
+    if (!condition)
+    {
+        std::printf("FAILED: %s\n", what.c_str());
+        ++s_failures;
+    }
+}
+
+// Whether both images widen to the same RGBA32F pixels.
+static bool IsSameImage(const CpuImage& a, const CpuImage& b)
+{
+    if (a.GetWidth() != b.GetWidth() || a.GetHeight() != b.GetHeight())
+        return false;
+
+    std::vector<float> rowA(size_t(a.GetWidth()) * 4);
+    std::vector<float> rowB(rowA.size());
+    for (uint32_t y = 0; y < a.GetHeight(); ++y)
+    {
+        LoadRow(a, y, rowA.data());
+        LoadRow(b, y, rowB.data());
+        if (std::memcmp(rowA.data(), rowB.data(), rowA.size() * sizeof(float)) != 0)
+            return false;
+    }
+    return true;
+}
+
+static void CheckOperations(const CpuImage& grey, const CpuImage& rgba, const CpuImage& color)
+{
+    const char* operations[] = {
+        "Add", "Subtract", "Product", "Negative", "Log", "Power", "Histogram Equalization", "Histogram Match",
+        "Adaptive Histogram Equalization", "Gaussian Blur", "Sobel Filter", "Unsharp Mask", "Fourier Transform"
+    };
+
+    CpuPipelineParameters parameters;
+    parameters.blurKernelSize = 7u;
+    parameters.blurVariance = 2.0f;
+    for (const char* pOperation : operations)
+    {
+        for (GaussianBlurAlgorithm algorithm : { GaussianBlurAlgorithm::Direct, GaussianBlurAlgorithm::Recursive })
+        {
+            parameters.blurAlgorithm = algorithm;
+            CpuImage outputs[2];
+            const CpuImage* inputs[2] = { &grey, &rgba };
+            for (int i = 0; i < 2; ++i)
+            {
+                CpuPipeline pipeline;
+                uint32_t input1 = pipeline.AddInput(*inputs[i]);
+                uint32_t input2 = pipeline.AddInput(color);
+                uint32_t node = pipeline.AddOperation(pOperation, input1, input2, parameters);
+                // A grey operation feeding an RGBA one, so grey intermediates are covered too.
+                pipeline.AddOutput(pipeline.AddOperation("Add", pipeline.AddOperation("Gaussian Blur", node), node));
+                pipeline.Execute();
+                outputs[i] = pipeline.GetOutputImage();
+            }
+            Check(IsSameImage(outputs[0], outputs[1]), std::string(pOperation) + " on a grey plane");
+        }
+    }
+}
+
+static void WriteGreyFile(const char* pFilename, const CpuImage& grey, bool asP6)
+{
+    FILE* pFile = std::fopen(pFilename, "wb");
+    std::fprintf(pFile, "%s\n%u %u\n255\n", asP6 ? "P6" : "P5", grey.GetWidth(), grey.GetHeight());
+    const uint8_t* pSamples = grey.GetBytes();
+    for (size_t i = 0; i < grey.GetPixelCount(); ++i)
+    {
+        for (int channel = 0; channel < (asP6 ? 3 : 1); ++channel)
+            std::fputc(pSamples[i], pFile);
+    }
+    std::fclose(pFile);
+}
+
+static void CheckLoading(const CpuImage& grey)
+{
+    const char* pFilename = "GreyPlaneCheck.ppm";
+    for (bool asP6 : { false, true })
+    {
+        WriteGreyFile(pFilename, grey, asP6);
+        CpuImage loaded;
+        LoadPPM(pFilename, &loaded);
+        const std::string kind = asP6 ? "grey P6" : "P5";
+        Check(loaded.GetFormat() == CpuPixelFormat::R8, kind + " loads as R8");
+        Check(loaded.GetSizeInBytes() == grey.GetSizeInBytes() &&
+            std::memcmp(loaded.GetBytes(), grey.GetBytes(), grey.GetSizeInBytes()) == 0, kind + " samples");
+
+        // Without the opt in, Open doesn't scan P6 pixels and the file reads as RGBA.
+        CpuPPMReader reader;
+        reader.Open(pFilename);
+        Check(reader.GetFormat() == (asP6 ? CpuPixelFormat::RGBA8 : CpuPixelFormat::R8), kind + " format without the grey check");
+    }
+    std::remove(pFilename);
+}
+
+int main()
+{
+    const uint32_t width = 67;
+    const uint32_t height = 45;
+    std::mt19937 random(570);
+
+    CpuImage grey(width, height, CpuPixelFormat::R8);
+    CpuImage rgba(width, height, CpuPixelFormat::RGBA8);
+    CpuImage color(width, height, CpuPixelFormat::RGBA8);
+    for (size_t i = 0; i < grey.GetPixelCount(); ++i)
+    {
+        const uint8_t value = static_cast<uint8_t>(random());
+        grey.GetBytes()[i] = value;
+        std::memset(rgba.GetBytes() + i * 4, value, 3);
+        rgba.GetBytes()[i * 4 + 3] = 255;
+        for (int channel = 0; channel < 4; ++channel)
+            color.GetBytes()[i * 4 + channel] = static_cast<uint8_t>(random());
+    }
+
+    for (uint32_t workerCount : { 1u, 4u })
+    {
+        SetCpuWorkerCount(workerCount);
+        CheckOperations(grey, rgba, color);
+    }
+    CheckLoading(grey);
+
+    if (s_failures == 0)
+        std::printf("GreyPlaneCheck passed\n");
+    return s_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+// Checks CpuOperationGraphExecutor against the same operations run one at a time: a Gaussian blur,
+// an Add with a smaller second input and a Sobel filter followed by a Negative, on an image wider
+// than two tiles so the tile seams are crossed. Also checks which nodes OperationGraph::Fuse
+// materializes and the size AddPointwise gives. Returns non zero on failure.
+
+#include "CpuGaussianBlur.h"
+#include "CpuOperationGraphExecutor.h"
+#include "CpuParallel.h"
+#include "CpuSobelFilter.h"
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace CS570;
+
+static int s_failures = 0;
+
+static void Check(bool condition, const std::string& what)
+{
+    if (!condition)
+    {
+        std::printf("FAILED: %s\n", what.c_str());
+        ++s_failures;
+    }
+}
+
+static CpuImage MakeRandomImage(uint32_t width, uint32_t height, std::mt19937* pRandom)
+{
+    CpuImage image(width, height);
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            float* pPixel = image.GetPixel(x, y);
+            for (uint32_t channel = 0; channel < 3; ++channel)
+                pPixel[channel] = distribution(*pRandom);
+            pPixel[3] = 1.0f;
+        }
+    }
+    return image;
+}
+
+// Both images are RGBA32F and must match exactly, since the executor evaluates the same expressions
+// in the same order as the standalone operations.
+static bool IsSameImage(const CpuImage& a, const CpuImage& b)
+{
+    if (a.GetWidth() != b.GetWidth() || a.GetHeight() != b.GetHeight())
+        return false;
+    for (uint32_t y = 0; y < a.GetHeight(); ++y)
+    {
+        for (uint32_t x = 0; x < a.GetWidth(); ++x)
+        {
+            for (uint32_t channel = 0; channel < CpuImage::k_channelCount; ++channel)
+            {
+                if (a.GetPixel(x, y)[channel] != b.GetPixel(x, y)[channel])
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main()
+{
+    // Two full tiles and a partial one per row, and a second input half the size that Add point
+    // samples.
+    std::mt19937 random(570);
+    const CpuImage input = MakeRandomImage(2 * CpuOperationGraphExecutor::k_tileWidth + 89, 70, &random);
+    const CpuImage smallInput = MakeRandomImage(input.GetWidth() / 2, input.GetHeight() / 2, &random);
+    const uint32_t kernelSize = 7u;
+    const float variance = 2.0f;
+    PointwiseConstants addConstants;
+    addConstants.weightInput1 = 1.5f;
+    addConstants.weightInput2 = 0.5f;
+
+    OperationGraph graph;
+    const uint32_t inputNode = graph.AddInput(input.GetWidth(), input.GetHeight());
+    const uint32_t smallInputNode = graph.AddInput(smallInput.GetWidth(), smallInput.GetHeight());
+    const uint32_t blurNode = graph.AddGaussianBlur(inputNode, kernelSize, variance);
+    const uint32_t addNode = graph.AddPointwise(OperationType::Add, smallInputNode, blurNode, addConstants);
+    const uint32_t sobelNode = graph.AddSobelFilter(addNode);
+    const uint32_t negativeNode = graph.AddPointwise(OperationType::Negative, sobelNode);
+    graph.AddOutput(negativeNode);
+
+    // The blur folds into the Add, which is materialized for the Sobel, which folds into the
+    // Negative.
+    Check(graph.GetNode(addNode).width == input.GetWidth() && graph.GetNode(addNode).height == input.GetHeight(),
+        "Add takes the larger size of its inputs");
+    Check(graph.IsMaterialized(inputNode) && graph.IsMaterialized(smallInputNode), "inputs are materialized");
+    Check(!graph.IsMaterialized(blurNode), "blur is fused into the Add");
+    Check(graph.IsMaterialized(addNode), "Add feeding the Sobel is materialized");
+    Check(!graph.IsMaterialized(sobelNode), "Sobel is fused into the Negative");
+    Check(graph.IsMaterialized(negativeNode), "output is materialized");
+    const std::vector<FusedStage> stages = graph.Fuse();
+    Check(stages.size() == 2 && stages[0].GetOutputNode() == addNode && stages[0].nodes.size() == 2 &&
+        stages[1].GetOutputNode() == negativeNode && stages[1].nodes.size() == 2, "two fused stages");
+
+    for (uint32_t workerCount : { 1u, 4u })
+    {
+        SetCpuWorkerCount(workerCount);
+        const std::string workers = std::to_string(workerCount) + " worker(s)";
+
+        // The executor always uses the separable blur.
+        CpuGaussianBlur blur;
+        blur.SetAlgorithm(GaussianBlurAlgorithm::Separable);
+        blur.OnCreate(input, kernelSize, variance);
+        blur.Execute();
+        CpuImageProcessor add;
+        add.OnCreate("Add", smallInput, blur.GetOutputImage());
+        add.SetWeightInput1(addConstants.weightInput1);
+        add.SetWeightInput2(addConstants.weightInput2);
+        add.Execute();
+        CpuSobelFilter sobel;
+        sobel.OnCreate(add.GetOutputImage());
+        sobel.Execute();
+        CpuImageProcessor negative;
+        negative.OnCreate("Negative", sobel.GetOutputImage(), sobel.GetOutputImage());
+        negative.Execute();
+
+        CpuOperationGraphExecutor executor;
+        executor.OnCreate(graph, { &input, &smallInput });
+        executor.Execute();
+        Check(executor.GetStages().size() == stages.size(), "executor stages, " + workers);
+        Check(IsSameImage(executor.GetNodeImage(addNode), add.GetOutputImage()), "blur and Add stage, " + workers);
+        Check(IsSameImage(executor.GetOutputImage(), negative.GetOutputImage()), "Sobel and Negative stage, " + workers);
+        executor.OnDestroy();
+    }
+
+    if (s_failures == 0)
+        std::printf("OperationGraphCheck passed\n");
+    return s_failures == 0 ? 0 : 1;
+}
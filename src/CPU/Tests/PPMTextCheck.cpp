@@ -0,0 +1,201 @@
+// Checks the block parser behind P3 loading against a plain one token at a time reference: header
+// comments, mixed whitespace and CRLF line ends, samples with leading zeros that run across 8 byte
+// words and across the parser's blocks and parallel ranges, max values of 255, 65535 and others, and
+// malformed or truncated files, which both must reject. Returns non zero on failure.
+
+#include "CpuParallel.h"
+#include "CpuPPM.h"
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace CS570;
+
+static int s_failures = 0;
+
+static void Check(bool condition, const std::string& what)
+{
+    if (!condition)
+    {
+        std::printf("FAILED: %s\n", what.c_str());
+        ++s_failures;
+    }
+}
+
+static bool IsSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Parses the next unsigned decimal token at *pOffset, saturating at 65536, after whitespace and,
+// in the header, comments. Returns false if there is no token or it isn't all digits.
+static bool ReadToken(const std::string& text, size_t* pOffset, bool allowComments, uint32_t* pValue)
+{
+    size_t offset = *pOffset;
+    while (offset < text.size() && (IsSpace(text[offset]) || (allowComments && text[offset] == '#')))
+    {
+        if (text[offset] == '#')
+            offset = text.find_first_of("\r\n", offset) == std::string::npos ? text.size() : text.find_first_of("\r\n", offset);
+        else
+            ++offset;
+    }
+
+    uint32_t value = 0;
+    const size_t digitsBegin = offset;
+    while (offset < text.size() && text[offset] >= '0' && text[offset] <= '9')
+    {
+        value = value * 10 + static_cast<uint32_t>(text[offset] - '0');
+        value = value > 0x10000u ? 0x10000u : value;
+        ++offset;
+    }
+    if (offset == digitsBegin || (offset < text.size() && !IsSpace(text[offset])))
+        return false;
+
+    *pOffset = offset;
+    *pValue = value;
+    return true;
+}
+
+// Loads a P3 file the straightforward way into the format LoadPPM picks. Returns false where LoadPPM
+// must throw.
+static bool LoadReference(const std::string& text, CpuImage* pImage)
+{
+    if (text.compare(0, 2, "P3") != 0)
+        return false;
+
+    size_t offset = 2;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t maxValue = 0;
+    if (!ReadToken(text, &offset, true, &width) || !ReadToken(text, &offset, true, &height) ||
+        !ReadToken(text, &offset, true, &maxValue))
+    {
+        return false;
+    }
+    if (width == 0 || height == 0 || maxValue == 0 || maxValue > 0xFFFF || offset == text.size())
+        return false;
+    ++offset;
+
+    const CpuPixelFormat format =
+        maxValue == 255 ? CpuPixelFormat::RGBA8 : maxValue == 65535 ? CpuPixelFormat::RGBA16 : CpuPixelFormat::RGBA32F;
+    pImage->Resize(width, height, format);
+    for (size_t pixel = 0; pixel < pImage->GetPixelCount(); ++pixel)
+    {
+        for (uint32_t channel = 0; channel < 4; ++channel)
+        {
+            uint32_t value = maxValue;
+            if (channel < 3 && !ReadToken(text, &offset, false, &value))
+                return false;
+            if (value > 0xFFFF || (format == CpuPixelFormat::RGBA8 && value > 255))
+                return false;
+
+            if (format == CpuPixelFormat::RGBA8)
+                pImage->GetBytes()[pixel * 4 + channel] = static_cast<uint8_t>(value);
+            else if (format == CpuPixelFormat::RGBA16)
+                reinterpret_cast<uint16_t*>(pImage->GetBytes())[pixel * 4 + channel] = static_cast<uint16_t>(value);
+            else
+                pImage->GetData()[pixel * 4 + channel] = channel < 3 ? static_cast<float>(value) * (1.0f / static_cast<float>(maxValue)) : 1.0f;
+        }
+    }
+    return true;
+}
+
+static void CheckText(const std::string& text, const std::string& what)
+{
+    const char* pFilename = "PPMTextCheck.ppm";
+    FILE* pFile = std::fopen(pFilename, "wb");
+    std::fwrite(text.data(), 1, text.size(), pFile);
+    std::fclose(pFile);
+
+    CpuImage expected;
+    const bool isValid = LoadReference(text, &expected);
+
+    CpuImage loaded;
+    bool loadedOk = true;
+    try
+    {
+        LoadPPM(pFilename, &loaded);
+    }
+    catch (const char*)
+    {
+        loadedOk = false;
+    }
+    std::remove(pFilename);
+
+    if (!isValid)
+    {
+        Check(!loadedOk, what + " is rejected");
+        return;
+    }
+    Check(loadedOk, what + " loads");
+    Check(loadedOk && loaded.GetFormat() == expected.GetFormat() && loaded.GetWidth() == expected.GetWidth() &&
+        loaded.GetHeight() == expected.GetHeight() && loaded.GetSizeInBytes() == expected.GetSizeInBytes() &&
+        std::memcmp(loaded.GetBytes(), expected.GetBytes(), expected.GetSizeInBytes()) == 0, what + " samples");
+}
+
+// A P3 file of random samples up to maxValue, each with 0 to 12 leading zeros and followed by a
+// random run of whitespace, so samples land at every position in the 8 byte words.
+static std::string MakeRandomText(uint32_t width, uint32_t height, uint32_t maxValue, std::mt19937* pRandom)
+{
+    const char* separators[] = { " ", "\t", "\n", "\r\n", "  ", " \t\r\n", "\n\n\n" };
+    std::string text = "P3\n# random samples\n" + std::to_string(width) + " " + std::to_string(height) + "\r\n" +
+        std::to_string(maxValue) + "\n";
+    for (size_t sample = 0; sample < size_t(width) * height * 3; ++sample)
+    {
+        const uint32_t leadingZeros = (*pRandom)() % 4 == 0 ? (*pRandom)() % 13 : 0;
+        text.append(leadingZeros, '0');
+        text += std::to_string((*pRandom)() % (maxValue + 1));
+        text += separators[(*pRandom)() % 7];
+    }
+    return text;
+}
+
+int main()
+{
+    std::mt19937 random(570);
+
+    CheckText("P3\n# a comment\n3 # width\n# height next\n2\n#max\n255\n"
+        "255 0 0\t0 255 0  0 0 255\r\n"
+        "00000000255 0000000 1\n\n\t12 34 56 7 8 9\n", "comments, mixed whitespace and leading zeros");
+    CheckText("P3\r\n2 1\r\n65535\r\n65535 00065534 1\r\n12345678 0 40000\r\n", "CRLF and 16 bit samples");
+    CheckText("P3 1 1 1023 1023 512 0", "max value 1023 without line ends");
+    CheckText("P3\n1 1\n255\n1 2 3", "no whitespace after the last sample");
+    CheckText("P3\n1 1\n255\n1 2 3 garbage after the samples", "trailing data");
+
+    // Malformed and truncated files.
+    CheckText("P3\n2 1\n255\n1 2 3 4 5", "one sample short");
+    CheckText("P3\n2 1\n255\n1 2 3\n", "one pixel short");
+    CheckText("P3\n2 1\n255\n", "no samples");
+    CheckText("P3\n2 1\n", "no max value");
+    CheckText("P3\n2", "no height");
+    CheckText("P3\n1 1\n255\n1 2a 3", "letter in a sample");
+    CheckText("P3\n1 1\n255\n1 -2 3", "negative sample");
+    CheckText("P3\n1 1\n255\n1 2 # comment\n3", "comment in the pixel data");
+    CheckText("P3\n1 1\n255\n1 256 3", "sample above 255");
+    CheckText("P3\n1 1\n65535\n1 65536 3", "sample above 65535");
+    CheckText("P3\n1 1\n65535\n1 99999999999 3", "sample longer than a word");
+    CheckText("P3\n1 1\n65536\n1 2 3", "max value above 65535");
+    CheckText("P3\n0 1\n255\n", "zero width");
+
+    for (uint32_t maxValue : { 1u, 7u, 255u, 1000u, 4095u, 65535u })
+    {
+        for (uint32_t size : { 1u, 5u, 37u })
+            CheckText(MakeRandomText(size, size + 2, maxValue, &random), "random " + std::to_string(size) + "x" +
+                std::to_string(size + 2) + ", max value " + std::to_string(maxValue));
+    }
+
+    // Larger than one 8 MB block, and cut into ranges parsed in parallel when there are workers.
+    const std::string large = MakeRandomText(1024, 900, 65535, &random);
+    for (uint32_t workerCount : { 1u, 4u })
+    {
+        SetCpuWorkerCount(workerCount);
+        CheckText(large, "multi block file with " + std::to_string(workerCount) + " worker(s)");
+    }
+
+    if (s_failures == 0)
+        std::printf("PPMTextCheck passed\n");
+    return s_failures == 0 ? 0 : 1;
+}
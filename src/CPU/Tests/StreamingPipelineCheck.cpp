@@ -0,0 +1,127 @@
+// Checks that CpuStreamingPipeline writes the same ppm bytes as CpuPipeline run on the whole image,
+// for Gaussian blur, Sobel, unsharp mask and a chain of them, with band heights that don't divide
+// the image height so the halo rows and the short last band are both exercised. Returns non zero
+// on failure.
+
+#include "CpuParallel.h"
+#include "CpuStreamingPipeline.h"
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace CS570;
+
+static int s_failures = 0;
+
+static void Check(bool condition, const std::string& what)
+{
+    if (!condition)
+    {
+        std::printf("FAILED: %s\n", what.c_str());
+        ++s_failures;
+    }
+}
+
+static void WriteRandomP6(const char* pFilename, uint32_t width, uint32_t height, std::mt19937* pRandom)
+{
+    FILE* pFile = std::fopen(pFilename, "wb");
+    std::fprintf(pFile, "P6\n%u %u\n255\n", width, height);
+    for (size_t i = 0; i < size_t(width) * height * 3; ++i)
+        std::fputc(static_cast<int>((*pRandom)() & 0xFF), pFile);
+    std::fclose(pFile);
+}
+
+static std::vector<uint8_t> ReadFileBytes(const char* pFilename)
+{
+    std::vector<uint8_t> bytes;
+    FILE* pFile = std::fopen(pFilename, "rb");
+    if (pFile == nullptr)
+        return bytes;
+    int c;
+    while ((c = std::fgetc(pFile)) != EOF)
+        bytes.push_back(static_cast<uint8_t>(c));
+    std::fclose(pFile);
+    return bytes;
+}
+
+// Adds the operations named by recipe, each applied to the previous node, and returns the last.
+static uint32_t AddChain(CpuPipeline* pPipeline, uint32_t input, const std::vector<const char*>& recipe,
+    const CpuPipelineParameters& parameters)
+{
+    uint32_t node = input;
+    for (const char* pOperation : recipe)
+        node = pPipeline->AddOperation(pOperation, node, CpuPipeline::k_invalidNode, parameters);
+    return node;
+}
+
+static void CheckChain(const char* pInputFile, const std::vector<const char*>& recipe,
+    const CpuPipelineParameters& parameters, const std::string& what)
+{
+    const char* pWholeFile = "StreamingPipelineCheckWhole.ppm";
+    const char* pStreamedFile = "StreamingPipelineCheckStreamed.ppm";
+
+    CpuImage input;
+    LoadPPM(pInputFile, &input);
+    CpuPipeline wholePipeline;
+    wholePipeline.AddOutput(AddChain(&wholePipeline, wholePipeline.AddInput(input), recipe, parameters));
+    wholePipeline.Execute();
+    WritePPM(pWholeFile, wholePipeline.GetOutputImage());
+    const std::vector<uint8_t> expected = ReadFileBytes(pWholeFile);
+    Check(!expected.empty(), what + " whole image output");
+
+    for (uint32_t bandRows : { 5u, 7u, 16u })
+    {
+        CpuImage placeholder;
+        CpuPipeline pipeline;
+        const uint32_t inputNode = pipeline.AddInput(placeholder);
+        pipeline.AddOutput(AddChain(&pipeline, inputNode, recipe, parameters));
+
+        CpuStreamingPipeline streaming;
+        streaming.OnCreate(&pipeline, { inputNode }, { pInputFile }, bandRows);
+        streaming.Execute(pStreamedFile);
+        const uint32_t bandCount = streaming.GetStats().bandCount;
+        streaming.OnDestroy();
+
+        const std::string band = what + ", " + std::to_string(bandRows) + " row bands";
+        Check(bandCount == (input.GetHeight() + bandRows - 1) / bandRows, band + " band count");
+        Check(ReadFileBytes(pStreamedFile) == expected, band);
+    }
+
+    std::remove(pWholeFile);
+    std::remove(pStreamedFile);
+}
+
+int main()
+{
+    // 53 rows, which none of the band heights divides.
+    const char* pInputFile = "StreamingPipelineCheckInput.ppm";
+    std::mt19937 random(570);
+    WriteRandomP6(pInputFile, 61, 53, &random);
+
+    CpuPipelineParameters parameters;
+    parameters.blurKernelSize = 9u;
+    parameters.blurVariance = 3.0f;
+    parameters.weightInput1 = 1.5f;
+
+    for (uint32_t workerCount : { 1u, 4u })
+    {
+        SetCpuWorkerCount(workerCount);
+        for (GaussianBlurAlgorithm algorithm : { GaussianBlurAlgorithm::Direct, GaussianBlurAlgorithm::Separable })
+        {
+            parameters.blurAlgorithm = algorithm;
+            const std::string blur = algorithm == GaussianBlurAlgorithm::Direct ? "direct" : "separable";
+            CheckChain(pInputFile, { "Gaussian Blur" }, parameters, "Gaussian Blur (" + blur + ")");
+            CheckChain(pInputFile, { "Unsharp Mask", "Gaussian Blur", "Sobel Filter" }, parameters,
+                "Unsharp Mask, Gaussian Blur (" + blur + "), Sobel Filter");
+        }
+        CheckChain(pInputFile, { "Sobel Filter" }, parameters, "Sobel Filter");
+        CheckChain(pInputFile, { "Unsharp Mask" }, parameters, "Unsharp Mask");
+    }
+    std::remove(pInputFile);
+
+    if (s_failures == 0)
+        std::printf("StreamingPipelineCheck passed\n");
+    return s_failures == 0 ? 0 : 1;
+}
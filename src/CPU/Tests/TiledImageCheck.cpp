@@ -0,0 +1,175 @@
+// Checks that a tiled image written with WriteTiledImage reads back exactly through the memory
+// mapped CpuTiledImage: every tile of every mip level and whole level regions, for a size that isn't
+// a multiple of the tile size, in every RGBA format and with both codecs. Returns non zero on failure.
+
+#include "CpuParallel.h"
+#include "CpuTiledImage.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace CS570;
+
+static int s_failures = 0;
+
+static void Check(bool condition, const std::string& what)
+{
+    if (!condition)
+    {
+        std::printf("FAILED: %s\n", what.c_str());
+        ++s_failures;
+    }
+}
+
+// Smooth gradients, which the predictive codec shrinks, except for noise in the last tile column,
+// whose full resolution tiles it stores uncompressed.
+static CpuImage MakeSourceImage(uint32_t width, uint32_t height)
+{
+    std::mt19937 random(570);
+    std::uniform_real_distribution<float> noise(0.0f, 1.0f);
+    CpuImage image(width, height);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            float* pPixel = image.GetPixel(x, y);
+            const bool noisy = x >= 2 * CpuTiledImage::k_tileSize;
+            pPixel[0] = noisy ? noise(random) : float(x) / width;
+            pPixel[1] = noisy ? noise(random) : float(y) / height;
+            pPixel[2] = noisy ? noise(random) : 0.5f + 0.5f * std::sin(0.01f * (x + y));
+            pPixel[3] = 1.0f;
+        }
+    }
+    return image;
+}
+
+// The levels the writer is documented to produce: each texel the average of a 2x2 block of the level
+// above, the last row and column repeated on odd sizes, down to 1x1.
+static std::vector<CpuImage> MakeMipChain(const CpuImage& image)
+{
+    std::vector<CpuImage> levels;
+    levels.push_back(image);
+    while (levels.back().GetWidth() > 1 || levels.back().GetHeight() > 1)
+    {
+        const CpuImage& parent = levels.back();
+        CpuImage level(std::max(parent.GetWidth() / 2, 1u), std::max(parent.GetHeight() / 2, 1u));
+        for (uint32_t y = 0; y < level.GetHeight(); ++y)
+        {
+            const uint32_t y1 = std::min(2 * y + 1, parent.GetHeight() - 1);
+            for (uint32_t x = 0; x < level.GetWidth(); ++x)
+            {
+                const uint32_t x1 = std::min(2 * x + 1, parent.GetWidth() - 1);
+                for (uint32_t channel = 0; channel < CpuImage::k_channelCount; ++channel)
+                {
+                    level.GetPixel(x, y)[channel] = 0.25f *
+                        (parent.GetPixel(2 * x, 2 * y)[channel] + parent.GetPixel(x1, 2 * y)[channel] +
+                         parent.GetPixel(2 * x, y1)[channel] + parent.GetPixel(x1, y1)[channel]);
+                }
+            }
+        }
+        levels.push_back(std::move(level));
+    }
+    return levels;
+}
+
+// Expected bytes of [x, x + width) x [y, y + height) of a level in the stored format.
+static std::vector<uint8_t> GetExpectedBytes(
+    const CpuImage& level, CpuPixelFormat format, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+    const size_t rowSize = size_t(width) * GetPixelSize(format);
+    std::vector<uint8_t> bytes(rowSize * height);
+    for (uint32_t row = 0; row < height; ++row)
+        ConvertPixelsFromFloat(level.GetPixel(x, y + row), width, format, bytes.data() + row * rowSize);
+    return bytes;
+}
+
+// Returns the size of the file.
+static long CheckTiledImage(const std::vector<CpuImage>& levels, CpuPixelFormat format, TileCodec codec, const std::string& what)
+{
+    const char* pFilename = "TiledImageCheck.cti";
+    const uint32_t tileSize = CpuTiledImage::k_tileSize;
+    const uint32_t pixelSize = GetPixelSize(format);
+
+    WriteTiledImage(pFilename, levels[0], format, codec);
+
+    CpuTiledImage tiled;
+    tiled.Open(pFilename);
+    Check(tiled.GetWidth() == levels[0].GetWidth() && tiled.GetHeight() == levels[0].GetHeight(), what + " size");
+    Check(tiled.GetFormat() == format, what + " format");
+    Check(tiled.GetMipCount() == levels.size(), what + " mip count");
+    if (s_failures != 0)
+        return 0;
+
+    for (uint32_t levelIndex = 0; levelIndex < tiled.GetMipCount(); ++levelIndex)
+    {
+        const CpuImage& level = levels[levelIndex];
+        const std::string levelName = what + " level " + std::to_string(levelIndex);
+        Check(tiled.GetWidth(levelIndex) == level.GetWidth() && tiled.GetHeight(levelIndex) == level.GetHeight(),
+            levelName + " size");
+
+        std::vector<uint8_t> tile;
+        for (uint32_t tileY = 0; tileY < tiled.GetTileRowCount(levelIndex); ++tileY)
+        {
+            for (uint32_t tileX = 0; tileX < tiled.GetTileColumnCount(levelIndex); ++tileX)
+            {
+                const uint32_t tileWidth = std::min(tileSize, level.GetWidth() - tileX * tileSize);
+                const uint32_t tileHeight = std::min(tileSize, level.GetHeight() - tileY * tileSize);
+                tile.assign(size_t(tileWidth) * tileHeight * pixelSize, 0);
+                tiled.ReadTile(levelIndex, tileX, tileY, tile.data(), size_t(tileWidth) * pixelSize);
+                Check(tile == GetExpectedBytes(level, format, tileX * tileSize, tileY * tileSize, tileWidth, tileHeight),
+                    levelName + " tile " + std::to_string(tileX) + ", " + std::to_string(tileY));
+            }
+        }
+
+        // A region crossing tile boundaries, decoded through ForEachRegionTile.
+        const uint32_t regionX = level.GetWidth() / 3;
+        const uint32_t regionY = level.GetHeight() / 4;
+        const uint32_t regionWidth = level.GetWidth() - regionX;
+        const uint32_t regionHeight = level.GetHeight() - regionY;
+        CpuImage region;
+        tiled.ReadRegion(levelIndex, regionX, regionY, regionWidth, regionHeight, &region);
+        const std::vector<uint8_t> expected = GetExpectedBytes(level, format, regionX, regionY, regionWidth, regionHeight);
+        Check(region.GetFormat() == format && region.GetSizeInBytes() == expected.size() &&
+            std::memcmp(region.GetBytes(), expected.data(), expected.size()) == 0, levelName + " region");
+    }
+    tiled.Close();
+
+    FILE* pFile = std::fopen(pFilename, "rb");
+    std::fseek(pFile, 0, SEEK_END);
+    const long fileSize = std::ftell(pFile);
+    std::fclose(pFile);
+    std::remove(pFilename);
+    return fileSize;
+}
+
+int main()
+{
+    // Three tile columns and two tile rows at full resolution, neither dimension tile aligned.
+    const std::vector<CpuImage> levels = MakeMipChain(MakeSourceImage(601, 300));
+
+    const CpuPixelFormat formats[] = {
+        CpuPixelFormat::RGBA8, CpuPixelFormat::RGBA16, CpuPixelFormat::RGBA16F, CpuPixelFormat::RGBA32F
+    };
+    const char* formatNames[] = { "RGBA8", "RGBA16", "RGBA16F", "RGBA32F" };
+    for (uint32_t workerCount : { 1u, 4u })
+    {
+        SetCpuWorkerCount(workerCount);
+        for (size_t format = 0; format < 4; ++format)
+        {
+            const std::string name = formatNames[format];
+            const long uncompressedSize = CheckTiledImage(levels, formats[format], TileCodec::None, name + " uncompressed");
+            const long predictiveSize = CheckTiledImage(levels, formats[format], TileCodec::Predictive, name + " predictive");
+            // The smooth tiles have to be stored compressed for the predictive decoder to be covered.
+            Check(predictiveSize < uncompressedSize, name + " predictive tiles are smaller");
+        }
+    }
+
+    if (s_failures == 0)
+        std::printf("TiledImageCheck passed\n");
+    return s_failures == 0 ? 0 : 1;
+}
@@ -21,7 +21,8 @@ void ComputeHistogram::OnCreate(
     Device* pDevice,
     UploadHeap* pUploadHeap,
     ResourceViewHeaps* pResourceViewHeaps,
-    DynamicBufferRing* pConstantBufferRing)
+    DynamicBufferRing* pConstantBufferRing,
+    uint32_t binCount)
 {
     m_pDevice = pDevice;
     m_pResourceViewHeaps = pResourceViewHeaps;
@@ -58,73 +59,85 @@ void ComputeHistogram::OnCreate(
             pDevice->GetDevice()->CreateRootSignature(
                 0, pOutBlob->GetBufferPointer(), pOutBlob->GetBufferSize(), IID_PPV_ARGS(&m_pRootSignature))
         );
-        CAULDRON_DX12::SetName(m_pRootSignature, std::string("ComputeHistogram::QuadCount"));
+        CAULDRON_DX12::SetName(m_pRootSignature, std::string("ComputeHistogram"));
 
         pOutBlob->Release();
         if (pErrorBlob)
             pErrorBlob->Release();
     }
 
-    m_quadCount.OnCreate(m_pRootSignature, pDevice);
-
-    m_sumQuads.OnCreate(m_pRootSignature, pDevice);
+    m_histogramCount.OnCreate(m_pRootSignature, binCount, HistogramMode::Red, pDevice, pResourceViewHeaps);
 
-    m_createLUT.OnCreate(m_pRootSignature, input, pDevice, pResourceViewHeaps);
+    m_createLUT.OnCreate(m_pRootSignature, input, binCount, pDevice, pResourceViewHeaps);
 
-    m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_constBuffer);
     m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_inputTextureSrv);
 
-    m_constants.inputWidth = input.GetWidth();
-    m_constants.inputHeight = input.GetHeight();
+    m_inputWidth = input.GetWidth();
+    m_inputHeight = input.GetHeight();
     input.CreateSRV(0, &m_inputTextureSrv);
-
-    CreateOutputResource(input);
 }
 
-void QuadCount::OnCreate(ID3D12RootSignature* pRootSignature, Device* pDevice)
+void HistogramCount::OnCreate(
+    ID3D12RootSignature* pRootSignature,
+    uint32_t binCount,
+    HistogramMode mode,
+    Device* pDevice,
+    ResourceViewHeaps* pResourceViewHeaps)
 {
-    D3D12_SHADER_BYTECODE shaderByteCode = {};
+    m_binCount = binCount;
+    m_totalBinCount = binCount * GetHistogramChannelCount(mode);
+
+    D3D12_SHADER_BYTECODE clearByteCode = {};
     DefineList defines;
+    defines["BIN_COUNT"] = std::to_string(binCount);
+    defines["HISTOGRAM_MODE"] = std::to_string(static_cast<uint32_t>(mode));
     CAULDRON_DX12::CompileShaderFromFile(
-        "DX12/HistogramQuadCount.hlsl",
+        "DX12/HistogramCount.hlsl",
         &defines,
-        "QuadCount",
+        "ClearHistogram",
         "-T cs_6_0 /Zi /Zss -Od -Qembed_debug",
-        &shaderByteCode);
+        &clearByteCode);
 
     D3D12_COMPUTE_PIPELINE_STATE_DESC descPso = {};
-    descPso.CS = shaderByteCode;
+    descPso.CS = clearByteCode;
     descPso.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
     descPso.pRootSignature = pRootSignature;
     descPso.NodeMask = 0;
 
-    ThrowIfFailed(pDevice->GetDevice()->CreateComputePipelineState(&descPso, IID_PPV_ARGS(&m_pPipeline)));
-}
+    ThrowIfFailed(pDevice->GetDevice()->CreateComputePipelineState(&descPso, IID_PPV_ARGS(&m_pClearHistogram)));
 
-void SumQuads::OnCreate(ID3D12RootSignature* pRootSignature, Device* pDevice)
-{
-    D3D12_SHADER_BYTECODE shaderByteCode = {};
-    DefineList defines;
-    shaderByteCode = {};
+    D3D12_SHADER_BYTECODE countByteCode = {};
     CAULDRON_DX12::CompileShaderFromFile(
-        "DX12/HistogramSumQuads.hlsl",
+        "DX12/HistogramCount.hlsl",
         &defines,
-        "SumQuads",
+        "CountHistogram",
         "-T cs_6_0 /Zi /Zss -Od -Qembed_debug",
-        &shaderByteCode);
+        &countByteCode);
 
-    D3D12_COMPUTE_PIPELINE_STATE_DESC descPso = {};
-    descPso.CS = shaderByteCode;
-    descPso.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
-    descPso.pRootSignature = pRootSignature;
-    descPso.NodeMask = 0;
+    descPso.CS = countByteCode;
+
+    ThrowIfFailed(pDevice->GetDevice()->CreateComputePipelineState(&descPso, IID_PPV_ARGS(&m_pCountHistogram)));
 
-    ThrowIfFailed(pDevice->GetDevice()->CreateComputePipelineState(&descPso, IID_PPV_ARGS(&m_pPipeline)));
+    CD3DX12_RESOURCE_DESC histogramDesc = CD3DX12_RESOURCE_DESC::Buffer(m_totalBinCount, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+    histogramDesc.Format = DXGI_FORMAT_R32_UINT;
+    m_histogram.InitBuffer(
+        pDevice,
+        "HistogramCount",
+        &histogramDesc,
+        0,
+        D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+    pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_histogramUav);
+    m_histogram.CreateBufferUAV(0, nullptr, &m_histogramUav);
+
+    pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_histogramSrv);
+    m_histogram.CreateSRV(0, &m_histogramSrv);
 }
 
 void CreateLUT::OnCreate(
     ID3D12RootSignature* pRootSignature,
     const Texture& input,
+    uint32_t binCount,
     Device* pDevice,
     ResourceViewHeaps* pResourceViewHeaps)
 {
@@ -145,105 +158,50 @@ void CreateLUT::OnCreate(
 
     ThrowIfFailed(pDevice->GetDevice()->CreateComputePipelineState(&descPso, IID_PPV_ARGS(&m_pCreateLUT)));
 
-    D3D12_SHADER_BYTECODE createInverseLUTByteCode = {};
-    CAULDRON_DX12::CompileShaderFromFile(
-        "DX12/HistogramCreateLUT.hlsl",
-        &defines,
-        "CreateInverseLUT",
-        "-T cs_6_0 /Zi /Zss -Od -Qembed_debug",
-        &createInverseLUTByteCode);
-
-    descPso.CS = createInverseLUTByteCode;
-
-    ThrowIfFailed(pDevice->GetDevice()->CreateComputePipelineState(&descPso, IID_PPV_ARGS(&m_pCreateInverseLUT)));
-
-    D3D12_SHADER_BYTECODE initInverseLUTByteCode = {};
-    CAULDRON_DX12::CompileShaderFromFile(
-        "DX12/HistogramInitInverseLUT.hlsl",
-        &defines,
-        "InitInverseLUT",
-        "-T cs_6_0 /Zi /Zss -Od -Qembed_debug",
-        &initInverseLUTByteCode);
-
-    descPso.CS = initInverseLUTByteCode;
-
-    ThrowIfFailed(pDevice->GetDevice()->CreateComputePipelineState(&descPso, IID_PPV_ARGS(&m_pInitInverseLUT)));
-
-    m_lutConstants.outputSize = 8;
+    m_lutConstants.binCount = binCount;
     m_lutConstants.pixelCount = input.GetWidth() * input.GetHeight();
 
-    CD3DX12_RESOURCE_DESC outputDesc =
-        CD3DX12_RESOURCE_DESC::Tex2D(
-            DXGI_FORMAT_R32_UINT,
-            8, 1,
-            1, // array size
-            1, // mip size
-            1, // sample count
-            0, // sample quality
-            D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
-
-    m_outputLUT.InitRenderTarget(pDevice, "HistogramLUT", &outputDesc, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    CD3DX12_RESOURCE_DESC outputDesc = CD3DX12_RESOURCE_DESC::Buffer(2 * binCount, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+    outputDesc.Format = DXGI_FORMAT_R32_UINT;
+    m_outputLUT.InitBuffer(
+        pDevice,
+        "HistogramLUT",
+        &outputDesc,
+        0,
+        D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 
     pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_outputUav);
-    m_outputLUT.CreateUAV(0, &m_outputUav);
+    m_outputLUT.CreateBufferUAV(0, nullptr, &m_outputUav);
 }
 
-void ComputeHistogram::CreateOutputResource(Texture& input)
+void CreateLUT::CreateLUTSrv(uint32_t index, CBV_SRV_UAV* pSrvTable)
 {
-    // Histogram count requires multiple of 2 dimensions.
-    uint32_t extraWidth = input.GetWidth() % 2;
-    uint32_t extraHeight = input.GetHeight() % 2;
-    uint32_t histWidth = input.GetWidth() + extraWidth;
-    uint32_t histHeight = input.GetHeight() + extraHeight;
-    CD3DX12_RESOURCE_DESC outputDesc1 =
-        CD3DX12_RESOURCE_DESC::Tex2D(
-            DXGI_FORMAT_R16G16_UINT,
-            histWidth, histHeight,
-            1, // array size
-            1, // mip size
-            1, // sample count
-            0, // sample quality
-            D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
-
-    m_histogramOutput1State = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
-    m_histogramOutput1.InitRenderTarget(m_pDevice, "ComputeHistogramOutput1", &outputDesc1, m_histogramOutput1State);
-
-    m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_outputUav1);
-    m_histogramOutput1.CreateUAV(0, &m_outputUav1);
-
-    m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_outputSrv1);
-    m_histogramOutput1.CreateSRV(0, &m_outputSrv1);
-
-    histWidth >>= 1;
-    histHeight >>= 1;
-    extraWidth = histWidth % 2;
-    extraHeight = histHeight % 2;
-    CD3DX12_RESOURCE_DESC outputDesc2 =
-        CD3DX12_RESOURCE_DESC::Tex2D(
-            DXGI_FORMAT_R16G16_UINT,
-            histWidth + extraWidth, histHeight + extraHeight, // 1/4 the size of output1, but needs to be multiple of 2.
-            1, // array size
-            1, // mip size
-            1, // sample count
-            0, // sample quality
-            D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
-
-    m_histogramOutput2State = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
-    m_histogramOutput2.InitRenderTarget(m_pDevice, "ComputeHistogramOutput2", &outputDesc2, m_histogramOutput2State);
-
-    m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_outputUav2);
-    m_histogramOutput2.CreateUAV(0, &m_outputUav2);
-
-    m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_outputSrv2);
-    m_histogramOutput2.CreateSRV(0, &m_outputSrv2);
+    CreateSrv(0, index, pSrvTable);
 }
 
-void ComputeHistogram::OnDestroy()
+void CreateLUT::CreateInverseLUTSrv(uint32_t index, CBV_SRV_UAV* pSrvTable)
+{
+    CreateSrv(m_lutConstants.binCount, index, pSrvTable);
+}
+
+void CreateLUT::CreateSrv(uint32_t firstElement, uint32_t index, CBV_SRV_UAV* pSrvTable)
 {
-    m_histogramOutput1.OnDestroy();
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Format = DXGI_FORMAT_R32_UINT;
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.Buffer.FirstElement = firstElement;
+    srvDesc.Buffer.NumElements = m_lutConstants.binCount;
+    srvDesc.Buffer.StructureByteStride = 0;
+    srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
+
+    m_outputLUT.CreateSRV(index, pSrvTable, &srvDesc);
+}
 
-    m_quadCount.OnDestroy();
-    m_sumQuads.OnDestroy();
+void ComputeHistogram::OnDestroy()
+{
+    m_histogramCount.OnDestroy();
+    m_createLUT.OnDestroy();
 
     if (m_pRootSignature != nullptr)
     {
@@ -252,21 +210,20 @@ void ComputeHistogram::OnDestroy()
     }
 }
 
-void QuadCount::OnDestroy()
+void HistogramCount::OnDestroy()
 {
-    if (m_pPipeline != nullptr)
+    m_histogram.OnDestroy();
+
+    if (m_pClearHistogram != nullptr)
     {
-        m_pPipeline->Release();
-        m_pPipeline = nullptr;
+        m_pClearHistogram->Release();
+        m_pClearHistogram = nullptr;
     }
-}
 
-void SumQuads::OnDestroy()
-{
-    if (m_pPipeline != nullptr)
+    if (m_pCountHistogram != nullptr)
     {
-        m_pPipeline->Release();
-        m_pPipeline = nullptr;
+        m_pCountHistogram->Release();
+        m_pCountHistogram = nullptr;
     }
 }
 
@@ -279,219 +236,90 @@ void CreateLUT::OnDestroy()
         m_pCreateLUT->Release();
         m_pCreateLUT = nullptr;
     }
-
-    if (m_pCreateInverseLUT != nullptr)
-    {
-        m_pCreateInverseLUT->Release();
-        m_pCreateInverseLUT = nullptr;
-    }
 }
 
-void ComputeHistogram::Draw(ID3D12GraphicsCommandList* pCommandList, bool createInverseLUT)
+void ComputeHistogram::Draw(ID3D12GraphicsCommandList* pCommandList)
 {
     UserMarker marker(pCommandList, "ComputeHistogram");
 
-    CD3DX12_RESOURCE_BARRIER barriers[2] = {
-        CD3DX12_RESOURCE_BARRIER::Transition(
-            m_histogramOutput1.GetResource(),
-            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-            D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
-        CD3DX12_RESOURCE_BARRIER()
-    };
-
-    if (m_histogramOutput1State == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE)
-    {
-        pCommandList->ResourceBarrier(1, barriers);
-        m_histogramOutput1State = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
-    }
-
-    m_quadCount.Setup(pCommandList, m_pRootSignature);
-
-    D3D12_GPU_VIRTUAL_ADDRESS cbHandle;
-    uint32_t* pConstMem;
-    uint32_t constantsSize = sizeof(Constants);
-    m_pConstantBufferRing->AllocConstantBuffer(constantsSize, (void**)&pConstMem, &cbHandle);
-
-    m_constants.outputWidth = m_histogramOutput1.GetWidth();
-    m_constants.outputHeight = m_histogramOutput1.GetHeight();
-    memcpy(pConstMem, &m_constants, constantsSize);
-
     ID3D12DescriptorHeap* pDescriptorHeaps[] = { m_pResourceViewHeaps->GetCBV_SRV_UAVHeap(), m_pResourceViewHeaps->GetSamplerHeap() };
     pCommandList->SetDescriptorHeaps(2, pDescriptorHeaps);
 
-    pCommandList->SetComputeRootConstantBufferView(0, cbHandle);
-    pCommandList->SetComputeRootDescriptorTable(1, m_outputUav1.GetGPU());
-    pCommandList->SetComputeRootDescriptorTable(2, m_inputTextureSrv.GetGPU());
-
-    m_quadCount.Draw(pCommandList, m_histogramOutput1.GetWidth(), m_histogramOutput1.GetHeight());
+    m_histogramCount.Draw(pCommandList, m_pConstantBufferRing, m_pRootSignature, &m_inputTextureSrv, m_inputWidth, m_inputHeight);
 
-    barriers[0] =
-        CD3DX12_RESOURCE_BARRIER::Transition(
-            m_histogramOutput1.GetResource(),
-            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
-            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-    barriers[1] =
-        CD3DX12_RESOURCE_BARRIER::Transition(
-            m_histogramOutput2.GetResource(),
-            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-            D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-
-    m_histogramOutput1State = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
-    if (m_histogramOutput2State == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE)
-    {
-        pCommandList->ResourceBarrier(2, barriers);
-        m_histogramOutput2State = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
-    }
-    else
-        pCommandList->ResourceBarrier(1, barriers);
-
-
-    CBV_SRV_UAV* pSumQuadsOutput = nullptr;
-    // If the first output is already 2x2 then we can skip the reduction.
-    if (m_constants.outputWidth > 2 || m_constants.outputHeight > 2)
-    {
-        m_sumQuads.Setup(pCommandList, m_pRootSignature);
-
-        auto outputUav = m_outputUav2.GetGPU();
-        auto outputSrv = m_outputSrv2.GetGPU();
-        auto pOutputResource = &m_histogramOutput2;
-
-        auto inputUav = m_outputUav1.GetGPU();
-        auto inputSrv = m_outputSrv1.GetGPU();
-        auto pInputResource = &m_histogramOutput1;
-
-        m_constants.inputWidth = pInputResource->GetWidth();
-        m_constants.inputHeight = pInputResource->GetHeight();
-
-        m_constants.outputWidth = pOutputResource->GetWidth();
-        m_constants.outputHeight = pOutputResource->GetHeight();
-
-        while (true)
-        {
-            m_pConstantBufferRing->AllocConstantBuffer(constantsSize, (void**)&pConstMem, &cbHandle);
-            memcpy(pConstMem, &m_constants, constantsSize);
-
-            pCommandList->SetComputeRootConstantBufferView(0, cbHandle);
-            pCommandList->SetComputeRootDescriptorTable(1, outputUav);
-            pCommandList->SetComputeRootDescriptorTable(2, inputSrv);
-
-            m_sumQuads.Draw(pCommandList, pOutputResource->GetWidth(), pOutputResource->GetHeight());
-
-            barriers[0] =
-                CD3DX12_RESOURCE_BARRIER::Transition(
-                    pOutputResource->GetResource(),
-                    D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
-                    D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-            barriers[1] =
-                CD3DX12_RESOURCE_BARRIER::Transition(
-                    pInputResource->GetResource(),
-                    D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-                    D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-            pCommandList->ResourceBarrier(2, barriers);
-
-            m_histogramOutput1State = m_histogramOutput1State == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE ? D3D12_RESOURCE_STATE_UNORDERED_ACCESS : D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
-            m_histogramOutput2State = m_histogramOutput2State == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE ? D3D12_RESOURCE_STATE_UNORDERED_ACCESS : D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
-
-            if (m_constants.outputWidth == 2 && m_constants.outputHeight == 2)
-                break;
-
-            m_constants.inputWidth = m_constants.outputWidth;
-            m_constants.inputHeight = m_constants.outputHeight;
-
-            m_constants.outputWidth = max(m_constants.outputWidth >> 1, 2);
-            m_constants.outputHeight = max(m_constants.outputHeight >> 1, 2);
-
-            auto pTmp = pOutputResource;
-            pOutputResource = pInputResource;
-            pInputResource = pTmp;
-
-            auto tmpUav = outputUav;
-            outputUav = inputUav;
-            inputUav = tmpUav;
-
-            auto tmpSrv = outputSrv;
-            outputSrv = inputSrv;
-            inputSrv = tmpSrv;
-        }
-
-        if (memcmp(&outputSrv, &m_outputSrv1.GetGPU(), sizeof(outputSrv)) == 0)
-            pSumQuadsOutput = &m_outputSrv1;
-        else
-            pSumQuadsOutput = &m_outputSrv2;
-    }
-    else
-        pSumQuadsOutput = &m_outputSrv1;
-
-    m_createLUT.Draw(pCommandList, m_pConstantBufferRing, m_pRootSignature, pSumQuadsOutput, createInverseLUT);
+    m_createLUT.Draw(pCommandList, m_pConstantBufferRing, m_pRootSignature, &m_histogramCount.GetOutputSrv());
 }
 
-void QuadCount::Setup(ID3D12GraphicsCommandList* pCommandList, ID3D12RootSignature* pRootSignature)
-{
-    pCommandList->SetPipelineState(m_pPipeline);
-    pCommandList->SetComputeRootSignature(pRootSignature);
-}
-
-void QuadCount::Draw(ID3D12GraphicsCommandList* pCommandList, uint32_t outputWidth, uint32_t outputHeight)
-{
-    uint32_t dispatchX = (outputWidth + 7) / 8;
-    uint32_t dispatchY = (outputHeight + 7) / 8;
-    uint32_t dispatchZ = 1;
-    pCommandList->Dispatch(dispatchX, dispatchY, dispatchZ);
-}
-
-void CreateLUT::Draw(
+void HistogramCount::Draw(
     ID3D12GraphicsCommandList* pCommandList,
     DynamicBufferRing* pConstantBufferRing,
     ID3D12RootSignature* pRootSignature,
     CBV_SRV_UAV* pInputSrv,
-    bool createInverseLUT)
+    uint32_t inputWidth,
+    uint32_t inputHeight)
 {
     CD3DX12_RESOURCE_BARRIER barrier =
         CD3DX12_RESOURCE_BARRIER::Transition(
-            m_outputLUT.GetResource(),
+            m_histogram.GetResource(),
             D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
             D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 
     pCommandList->ResourceBarrier(1, &barrier);
 
-    if (createInverseLUT)
-    {
-        InitInverseLUT(pCommandList, pConstantBufferRing, pRootSignature, pInputSrv);
-        pCommandList->SetPipelineState(m_pCreateInverseLUT);
-    }
-    else
-        pCommandList->SetPipelineState(m_pCreateLUT);
     pCommandList->SetComputeRootSignature(pRootSignature);
 
+    struct Constants
+    {
+        uint32_t inputWidth;
+        uint32_t inputHeight;
+        uint32_t outputWidth;
+        uint32_t outputHeight;
+    };
+    Constants constants = { inputWidth, inputHeight, m_totalBinCount, 1u };
+
     D3D12_GPU_VIRTUAL_ADDRESS cbHandle;
     uint32_t* pConstMem;
-    pConstantBufferRing->AllocConstantBuffer(sizeof(m_lutConstants), (void**)&pConstMem, &cbHandle);
-
-    memcpy(pConstMem, &m_lutConstants, sizeof(m_lutConstants));
+    pConstantBufferRing->AllocConstantBuffer(sizeof(constants), (void**)&pConstMem, &cbHandle);
+    memcpy(pConstMem, &constants, sizeof(constants));
 
     pCommandList->SetComputeRootConstantBufferView(0, cbHandle);
-
-    pCommandList->SetComputeRootDescriptorTable(1, m_outputUav.GetGPU());
+    pCommandList->SetComputeRootDescriptorTable(1, m_histogramUav.GetGPU());
     pCommandList->SetComputeRootDescriptorTable(2, pInputSrv->GetGPU());
 
-    uint32_t dispatchX = (m_lutConstants.outputSize + 7) / 8;
-    pCommandList->Dispatch(dispatchX, 1, 1);
+    pCommandList->SetPipelineState(m_pClearHistogram);
+    pCommandList->Dispatch((m_totalBinCount + 63) / 64, 1, 1);
+
+    barrier = CD3DX12_RESOURCE_BARRIER::UAV(m_histogram.GetResource());
+    pCommandList->ResourceBarrier(1, &barrier);
+
+    // Every group counts a 64x64 block, see TILE_SIZE in HistogramCount.hlsl.
+    pCommandList->SetPipelineState(m_pCountHistogram);
+    pCommandList->Dispatch((inputWidth + 63) / 64, (inputHeight + 63) / 64, 1);
+
     barrier =
         CD3DX12_RESOURCE_BARRIER::Transition(
-            m_outputLUT.GetResource(),
+            m_histogram.GetResource(),
             D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
             D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 
     pCommandList->ResourceBarrier(1, &barrier);
 }
 
-void CreateLUT::InitInverseLUT(
+void CreateLUT::Draw(
     ID3D12GraphicsCommandList* pCommandList,
     DynamicBufferRing* pConstantBufferRing,
     ID3D12RootSignature* pRootSignature,
     CBV_SRV_UAV* pInputSrv)
 {
-    pCommandList->SetPipelineState(m_pInitInverseLUT);
+    CD3DX12_RESOURCE_BARRIER barrier =
+        CD3DX12_RESOURCE_BARRIER::Transition(
+            m_outputLUT.GetResource(),
+            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+    pCommandList->ResourceBarrier(1, &barrier);
+
+    pCommandList->SetPipelineState(m_pCreateLUT);
     pCommandList->SetComputeRootSignature(pRootSignature);
 
     D3D12_GPU_VIRTUAL_ADDRESS cbHandle;
@@ -505,20 +333,13 @@ void CreateLUT::InitInverseLUT(
     pCommandList->SetComputeRootDescriptorTable(1, m_outputUav.GetGPU());
     pCommandList->SetComputeRootDescriptorTable(2, pInputSrv->GetGPU());
 
-    uint32_t dispatchX = (m_lutConstants.outputSize + 7) / 8;
-    pCommandList->Dispatch(dispatchX, 1, 1);
-}
-
-void SumQuads::Setup(ID3D12GraphicsCommandList* pCommandList, ID3D12RootSignature* pRootSignature)
-{
-    pCommandList->SetPipelineState(m_pPipeline);
-    pCommandList->SetComputeRootSignature(pRootSignature);
-}
+    // A single group scans every bin.
+    pCommandList->Dispatch(1, 1, 1);
+    barrier =
+        CD3DX12_RESOURCE_BARRIER::Transition(
+            m_outputLUT.GetResource(),
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 
-void SumQuads::Draw(ID3D12GraphicsCommandList* pCommandList, uint32_t outputWidth, uint32_t outputHeight)
-{
-    uint32_t dispatchX = (outputWidth + 7) / 8;
-    uint32_t dispatchY = (outputHeight + 7) / 8;
-    uint32_t dispatchZ = 1;
-    pCommandList->Dispatch(dispatchX, dispatchY, dispatchZ);
+    pCommandList->ResourceBarrier(1, &barrier);
 }
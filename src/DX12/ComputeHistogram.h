@@ -6,44 +6,60 @@
 #include "Texture.h"
 #include "UploadHeap.h"
 
+#include "../CPU/CpuHistogram.h"
+
 #include <string>
 
 namespace CS570
 {
-    class QuadCount
+    // Counts binCount bins per channel of the mode into a R32_UINT buffer, through per group
+    // sub-histograms (HistogramCount.hlsl). Its memory is the bins alone, whatever the input size.
+    class HistogramCount
     {
     public:
-        void OnCreate(ID3D12RootSignature* pRootSignature, CAULDRON_DX12::Device* pDevice);
+        void OnCreate(
+            ID3D12RootSignature* pRootSignature,
+            uint32_t binCount,
+            HistogramMode mode,
+            CAULDRON_DX12::Device* pDevice,
+            CAULDRON_DX12::ResourceViewHeaps* pResourceViewHeaps);
 
         void OnDestroy();
 
-        void Setup(ID3D12GraphicsCommandList* pCommandList, ID3D12RootSignature* pRootSignature);
-        void Draw(ID3D12GraphicsCommandList* pCommandList, uint32_t outputWidth, uint32_t outputHeight);
+        void Draw(
+            ID3D12GraphicsCommandList* pCommandList,
+            CAULDRON_DX12::DynamicBufferRing* pConstantBufferRing,
+            ID3D12RootSignature* pRootSignature,
+            CAULDRON_DX12::CBV_SRV_UAV* pInputSrv,
+            uint32_t inputWidth,
+            uint32_t inputHeight);
 
-    private:
-        ID3D12PipelineState* m_pPipeline = nullptr;
-    };
+        uint32_t GetBinCount() const { return m_binCount; }
 
-    class SumQuads
-    {
-    public:
-        void OnCreate(ID3D12RootSignature* pRootSignature, CAULDRON_DX12::Device* pDevice);
+        CAULDRON_DX12::Texture& GetOutputResource() { return m_histogram; }
+        CAULDRON_DX12::CBV_SRV_UAV& GetOutputSrv() { return m_histogramSrv; }
 
-        void OnDestroy();
+    private:
+        ID3D12PipelineState* m_pClearHistogram = nullptr;
+        ID3D12PipelineState* m_pCountHistogram = nullptr;
 
-        void Setup(ID3D12GraphicsCommandList* pCommandList, ID3D12RootSignature* pRootSignature);
-        void Draw(ID3D12GraphicsCommandList* pCommandList, uint32_t outputWidth, uint32_t outputHeight);
+        uint32_t m_binCount = 0u;
+        uint32_t m_totalBinCount = 0u;
 
-    private:
-        ID3D12PipelineState* m_pPipeline = nullptr;
+        CAULDRON_DX12::Texture m_histogram;
+        CAULDRON_DX12::CBV_SRV_UAV m_histogramUav;
+        CAULDRON_DX12::CBV_SRV_UAV m_histogramSrv;
     };
 
+    // Builds the forward and inverse LUTs of a histogram with one prefix sum (HistogramCreateLUT.hlsl),
+    // both into one R32_UINT buffer: the forward LUT first, then the inverse LUT.
     class CreateLUT
     {
     public:
         void OnCreate(
             ID3D12RootSignature* pRootSignature,
             const CAULDRON_DX12::Texture& input,
+            uint32_t binCount,
             CAULDRON_DX12::Device* pDevice,
             CAULDRON_DX12::ResourceViewHeaps* pResourceViewHeaps);
 
@@ -53,25 +69,22 @@ namespace CS570
             ID3D12GraphicsCommandList* pCommandList,
             CAULDRON_DX12::DynamicBufferRing* pConstantBufferRing,
             ID3D12RootSignature* pRootSignature,
-            CAULDRON_DX12::CBV_SRV_UAV* pInputSrv,
-            bool generateInverseLUT=false);
+            CAULDRON_DX12::CBV_SRV_UAV* pInputSrv);
+
+        // Buffer<uint> views of binCount entries.
+        void CreateLUTSrv(uint32_t index, CAULDRON_DX12::CBV_SRV_UAV* pSrvTable);
+        void CreateInverseLUTSrv(uint32_t index, CAULDRON_DX12::CBV_SRV_UAV* pSrvTable);
 
         CAULDRON_DX12::Texture& GetOutputResource() { return m_outputLUT; }
 
     private:
-        void InitInverseLUT(
-            ID3D12GraphicsCommandList* pCommandList,
-            CAULDRON_DX12::DynamicBufferRing* pConstantBufferRing,
-            ID3D12RootSignature* pRootSignature,
-            CAULDRON_DX12::CBV_SRV_UAV* pInputSrv);
+        void CreateSrv(uint32_t firstElement, uint32_t index, CAULDRON_DX12::CBV_SRV_UAV* pSrvTable);
 
         ID3D12PipelineState* m_pCreateLUT = nullptr;
-        ID3D12PipelineState* m_pCreateInverseLUT = nullptr;
-        ID3D12PipelineState* m_pInitInverseLUT = nullptr;
 
         struct LutConstants
         {
-            uint32_t outputSize;
+            uint32_t binCount;
             uint32_t pixelCount;
         };
         LutConstants m_lutConstants;
@@ -88,50 +101,34 @@ namespace CS570
             CAULDRON_DX12::Device *pDevice,
             CAULDRON_DX12::UploadHeap *pUploadHeap,
             CAULDRON_DX12::ResourceViewHeaps *pResourceViewHeaps,
-            CAULDRON_DX12::DynamicBufferRing *pConstantBufferRing);
+            CAULDRON_DX12::DynamicBufferRing *pConstantBufferRing,
+            uint32_t binCount = k_defaultBinCount);
         void OnDestroy();
 
-        void Draw(ID3D12GraphicsCommandList *pCommandList, bool createInverseLUT=false);
+        // Counts the red channel and builds both LUTs.
+        void Draw(ID3D12GraphicsCommandList *pCommandList);
+
+        void CreateLUTSrv(uint32_t index, CAULDRON_DX12::CBV_SRV_UAV* pSrvTable) { m_createLUT.CreateLUTSrv(index, pSrvTable); }
+        void CreateInverseLUTSrv(uint32_t index, CAULDRON_DX12::CBV_SRV_UAV* pSrvTable) { m_createLUT.CreateInverseLUTSrv(index, pSrvTable); }
 
         CAULDRON_DX12::Texture& GetOutputResource() { return m_createLUT.GetOutputResource(); }
 
-    private:
-        void CreateOutputResource(CAULDRON_DX12::Texture& input);
+        static const uint32_t k_defaultBinCount = 8;
 
+    private:
         ID3D12RootSignature* m_pRootSignature = nullptr;
 
-        CAULDRON_DX12::Texture m_histogramOutput1;
-        D3D12_RESOURCE_STATES m_histogramOutput1State;
-
-        CAULDRON_DX12::Texture m_histogramOutput2;
-        D3D12_RESOURCE_STATES m_histogramOutput2State;
-
-        struct Constants
-        {
-            uint32_t inputWidth = 0u;
-            uint32_t inputHeight = 0u;
-            uint32_t outputWidth = 0u;
-            uint32_t outputHeight = 0u;
-        };
-
-        Constants m_constants;
+        uint32_t m_inputWidth = 0u;
+        uint32_t m_inputHeight = 0u;
 
         CAULDRON_DX12::Device* m_pDevice = nullptr;
 
-        CAULDRON_DX12::CBV_SRV_UAV m_constBuffer; // dimension
         CAULDRON_DX12::CBV_SRV_UAV m_inputTextureSrv; //src
 
-        CAULDRON_DX12::CBV_SRV_UAV m_outputUav1;
-        CAULDRON_DX12::CBV_SRV_UAV m_outputSrv1;
-        CAULDRON_DX12::CBV_SRV_UAV m_outputUav2;
-        CAULDRON_DX12::CBV_SRV_UAV m_outputSrv2;
-        CAULDRON_DX12::CBV_SRV_UAV* m_pCurrentOutputSrv = nullptr;
-
         CAULDRON_DX12::ResourceViewHeaps* m_pResourceViewHeaps = nullptr;
         CAULDRON_DX12::DynamicBufferRing* m_pConstantBufferRing = nullptr;
 
-        QuadCount m_quadCount;
-        SumQuads m_sumQuads;
+        HistogramCount m_histogramCount;
         CreateLUT m_createLUT;
     };
 }
\ No newline at end of file
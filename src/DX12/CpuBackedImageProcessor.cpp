@@ -0,0 +1,122 @@
+#include "CpuBackedImageProcessor.h"
+#include "CpuPixelFormatDxgi.h"
+
+#include "Device.h"
+#include "Error.h"
+#include "Helper.h"
+#include "UserMarkers.h"
+#include "Texture.h"
+
+#include "stdafx.h"
+
+using namespace CS570;
+using namespace CAULDRON_DX12;
+
+void CpuBackedImageProcessor::OnCreate(
+    BaseCpuImageProcessor* pOperation,
+    uint32_t uploadBufferCount,
+    Device* pDevice,
+    ResourceViewHeaps* pResourceViewHeaps)
+{
+    m_pOperation = pOperation;
+    m_pDevice = pDevice;
+
+    const CpuImage& output = pOperation->GetOutputImage();
+    assert(!output.IsEmpty());
+
+    // Grey outputs upload as a single channel too; the SRV reads them as (g, g, g, 1).
+    CD3DX12_RESOURCE_DESC outputDesc =
+        CD3DX12_RESOURCE_DESC::Tex2D(
+            GetDxgiFormat(output.GetFormat()),
+            output.GetWidth(), output.GetHeight(),
+            1, // array size
+            1, // mip size
+            1, // sample count
+            0, // sample quality
+            D3D12_RESOURCE_FLAG_NONE);
+
+    m_outputTexture.Init(m_pDevice, "CpuBackedImageProcessorOutput", &outputDesc,
+        D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, nullptr);
+
+    pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_outputSrv);
+    m_outputTexture.CreateSRV(0, &m_outputSrv);
+
+    UINT64 uploadSize = 0u;
+    m_pDevice->GetDevice()->GetCopyableFootprints(&outputDesc, 0, 1, 0, &m_uploadFootprint, &m_uploadRowCount, &m_uploadRowSize, &uploadSize);
+
+    for (uint32_t i = 0; i < uploadBufferCount; ++i)
+    {
+        ID3D12Resource* pUploadBuffer = nullptr;
+        ThrowIfFailed(m_pDevice->GetDevice()->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+            D3D12_HEAP_FLAG_NONE,
+            &CD3DX12_RESOURCE_DESC::Buffer(uploadSize),
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr,
+            IID_PPV_ARGS(&pUploadBuffer)));
+        SetName(pUploadBuffer, "CpuBackedImageProcessor::UploadBuffer");
+
+        uint8_t* pMappedData = nullptr;
+        pUploadBuffer->Map(0, nullptr, reinterpret_cast<void**>(&pMappedData));
+
+        m_uploadBuffers.push_back(pUploadBuffer);
+        m_mappedUploadBuffers.push_back(pMappedData);
+    }
+
+    m_currentUploadBuffer = 0u;
+}
+
+void CpuBackedImageProcessor::OnDestroy()
+{
+    m_outputTexture.OnDestroy();
+
+    for (auto pUploadBuffer : m_uploadBuffers)
+    {
+        pUploadBuffer->Unmap(0, nullptr);
+        pUploadBuffer->Release();
+    }
+
+    m_uploadBuffers.clear();
+    m_mappedUploadBuffers.clear();
+
+    m_pOperation = nullptr;
+}
+
+void CpuBackedImageProcessor::Draw(ID3D12GraphicsCommandList* pCommandList)
+{
+    CAULDRON_DX12::UserMarker marker(pCommandList, "CpuBackedImageProcessor");
+
+    m_pOperation->Execute();
+
+    const CpuImage& output = m_pOperation->GetOutputImage();
+    uint8_t* pUploadData = m_mappedUploadBuffers[m_currentUploadBuffer] + m_uploadFootprint.Offset;
+    assert(GetDxgiFormat(output.GetFormat()) == m_outputTexture.GetResource()->GetDesc().Format);
+    for (uint32_t row = 0; row < m_uploadRowCount; ++row)
+    {
+        memcpy(pUploadData + size_t(row) * m_uploadFootprint.Footprint.RowPitch,
+            output.GetRowSamples<float>(row),
+            static_cast<size_t>(m_uploadRowSize));
+    }
+
+    CD3DX12_RESOURCE_BARRIER barrier =
+        CD3DX12_RESOURCE_BARRIER::Transition(
+            m_outputTexture.GetResource(),
+            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+            D3D12_RESOURCE_STATE_COPY_DEST);
+
+    pCommandList->ResourceBarrier(1, &barrier);
+
+    CD3DX12_TEXTURE_COPY_LOCATION copyDest(m_outputTexture.GetResource(), 0);
+    CD3DX12_TEXTURE_COPY_LOCATION copySrc(m_uploadBuffers[m_currentUploadBuffer], m_uploadFootprint);
+    pCommandList->CopyTextureRegion(&copyDest, 0, 0, 0, &copySrc, nullptr);
+
+    barrier =
+        CD3DX12_RESOURCE_BARRIER::Transition(
+            m_outputTexture.GetResource(),
+            D3D12_RESOURCE_STATE_COPY_DEST,
+            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+    pCommandList->ResourceBarrier(1, &barrier);
+
+    m_currentUploadBuffer = (m_currentUploadBuffer + 1) % static_cast<uint32_t>(m_uploadBuffers.size());
+}
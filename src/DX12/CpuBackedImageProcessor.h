@@ -0,0 +1,49 @@
+#pragma once
+
+#include "ImageProcessor.h"
+
+#include "../CPU/CpuImageProcessor.h"
+
+#include "Device.h"
+#include "ResourceViewHeaps.h"
+#include "Texture.h"
+
+#include <vector>
+
+namespace CS570
+{
+    // Runs a CPU operation in Draw() and uploads its output into a texture, so the CPU backend can be
+    // displayed and saved through the same BaseImageProcessor interface as the compute shaders.
+    class CpuBackedImageProcessor : public BaseImageProcessor
+    {
+    public:
+        void OnCreate(
+            BaseCpuImageProcessor* pOperation,
+            uint32_t uploadBufferCount,
+            CAULDRON_DX12::Device* pDevice,
+            CAULDRON_DX12::ResourceViewHeaps* pResourceViewHeaps);
+        void OnDestroy();
+
+        void Draw(ID3D12GraphicsCommandList* pCommandList) override;
+
+        CAULDRON_DX12::CBV_SRV_UAV& GetOutputSrv() override { return m_outputSrv; }
+        CAULDRON_DX12::Texture& GetOutputResource() override { return m_outputTexture; }
+
+    private:
+        BaseCpuImageProcessor* m_pOperation = nullptr;
+
+        CAULDRON_DX12::Device* m_pDevice = nullptr;
+
+        CAULDRON_DX12::Texture m_outputTexture;
+        CAULDRON_DX12::CBV_SRV_UAV m_outputSrv;
+
+        // One persistently mapped upload buffer per frame in flight, used round robin.
+        std::vector<ID3D12Resource*> m_uploadBuffers;
+        std::vector<uint8_t*> m_mappedUploadBuffers;
+        uint32_t m_currentUploadBuffer = 0u;
+
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT m_uploadFootprint = {};
+        uint32_t m_uploadRowCount = 0u;
+        UINT64 m_uploadRowSize = 0u;
+    };
+}
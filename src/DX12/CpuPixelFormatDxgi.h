@@ -0,0 +1,65 @@
+#pragma once
+
+#include "../CPU/CpuPixelFormat.h"
+
+#include <DXGIFormat.h>
+
+namespace CS570
+{
+    // The texture format a CpuPixelFormat's samples upload to as they are.
+    inline DXGI_FORMAT GetDxgiFormat(CpuPixelFormat format)
+    {
+        switch (format)
+        {
+        case CpuPixelFormat::RGBA8: return DXGI_FORMAT_R8G8B8A8_UNORM;
+        case CpuPixelFormat::RGBA16: return DXGI_FORMAT_R16G16B16A16_UNORM;
+        case CpuPixelFormat::RGBA16F: return DXGI_FORMAT_R16G16B16A16_FLOAT;
+        case CpuPixelFormat::RGBA32F: return DXGI_FORMAT_R32G32B32A32_FLOAT;
+        case CpuPixelFormat::R8: return DXGI_FORMAT_R8_UNORM;
+        case CpuPixelFormat::R16: return DXGI_FORMAT_R16_UNORM;
+        case CpuPixelFormat::R32F: return DXGI_FORMAT_R32_FLOAT;
+        }
+        return DXGI_FORMAT_UNKNOWN;
+    }
+
+    // The CpuPixelFormat with the same layout as a texture format. Returns false if there is none.
+    inline bool GetCpuPixelFormat(DXGI_FORMAT format, CpuPixelFormat* pFormat)
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_R8G8B8A8_UNORM: *pFormat = CpuPixelFormat::RGBA8; return true;
+        case DXGI_FORMAT_R16G16B16A16_UNORM: *pFormat = CpuPixelFormat::RGBA16; return true;
+        case DXGI_FORMAT_R16G16B16A16_FLOAT: *pFormat = CpuPixelFormat::RGBA16F; return true;
+        case DXGI_FORMAT_R32G32B32A32_FLOAT: *pFormat = CpuPixelFormat::RGBA32F; return true;
+        case DXGI_FORMAT_R8_UNORM: *pFormat = CpuPixelFormat::R8; return true;
+        case DXGI_FORMAT_R16_UNORM: *pFormat = CpuPixelFormat::R16; return true;
+        case DXGI_FORMAT_R32_FLOAT: *pFormat = CpuPixelFormat::R32F; return true;
+        default: return false;
+        }
+    }
+
+    // The format of an RGBA operation's output over an input texture. The operations write values
+    // outside [0, 1], such as the unsharp mask overshoot and the Fourier coefficients, so UNORM inputs
+    // get a float output; RGBA16F holds those and keeps 8 and 16 bit inputs at 8 bytes per pixel.
+    // Only 32 bit float inputs keep a 32 bit output. Grey planes, which their SRVs read as
+    // (g, g, g, 1), follow the same rule.
+    inline DXGI_FORMAT GetOperationOutputFormat(DXGI_FORMAT inputFormat)
+    {
+        switch (inputFormat)
+        {
+        case DXGI_FORMAT_R32G32B32A32_FLOAT:
+        case DXGI_FORMAT_R32_FLOAT:
+            return DXGI_FORMAT_R32G32B32A32_FLOAT;
+        default:
+            return DXGI_FORMAT_R16G16B16A16_FLOAT;
+        }
+    }
+
+    // The format of the single channel plane written by the operations that only produce grey, picked
+    // by the same rule as GetOperationOutputFormat.
+    inline DXGI_FORMAT GetGreyOperationOutputFormat(DXGI_FORMAT inputFormat)
+    {
+        return GetOperationOutputFormat(inputFormat) == DXGI_FORMAT_R32G32B32A32_FLOAT ?
+            DXGI_FORMAT_R32_FLOAT : DXGI_FORMAT_R16_FLOAT;
+    }
+}
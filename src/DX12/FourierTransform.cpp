@@ -1,4 +1,5 @@
 #include "FourierTransform.h"
+#include "CpuPixelFormatDxgi.h"
 
 #include "Device.h"
 #include "DynamicBufferRing.h"
@@ -106,7 +107,7 @@ void FourierTransform::CreateOutputResource(Texture& input)
 {
     CD3DX12_RESOURCE_DESC outputDesc =
         CD3DX12_RESOURCE_DESC::Tex2D(
-            input.GetFormat(),
+            GetOperationOutputFormat(input.GetFormat()),
             input.GetWidth(), input.GetHeight(),
             1, // array size
             1, // mip size
@@ -118,12 +119,16 @@ void FourierTransform::CreateOutputResource(Texture& input)
 
     m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_fOfXvUav);
     m_fOfXv.CreateUAV(0, &m_fOfXvUav);
+
+    m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_fOfXvSrv);
     m_fOfXv.CreateSRV(0, &m_fOfXvSrv);
 
     m_fOfUv.InitRenderTarget(m_pDevice, "F(u,v)", &outputDesc, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 
     m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_fOfUvUav);
     m_fOfUv.CreateUAV(0, &m_fOfUvUav);
+
+    m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_fOfUvSrv);
     m_fOfUv.CreateSRV(0, &m_fOfUvSrv);
 
     m_constants.outputWidth = input.GetWidth();
@@ -206,7 +211,7 @@ void FourierTransform::Draw(ID3D12GraphicsCommandList* pCommandList)
     // Horizontal Pass
     pCommandList->SetPipelineState(m_pHorizontalPipeline);
     pCommandList->SetComputeRootDescriptorTable(1, m_fOfUvUav.GetGPU());
-    pCommandList->SetComputeRootDescriptorTable(2, m_fOfXvUav.GetGPU());
+    pCommandList->SetComputeRootDescriptorTable(2, m_fOfXvSrv.GetGPU());
 
     pCommandList->Dispatch(dispatchX, dispatchY, dispatchZ);
 
@@ -8,14 +8,23 @@ RWTexture2D<float4> outputTex : register(u0);
 
 #define PI 3.14159265359f
 
-float2 computeEulers(float uv, float xy, float MN)
+// e^(-2 PI i uv xy / MN) as (real, imaginary). The product is reduced mod MN first so the angle
+// stays in [0, 2 PI) and keeps its precision for large images.
+float2 computeEulers(uint uv, uint xy, uint MN)
 {
-    float power = (2 * PI * (uv * xy)) / MN;
-    float2 complex = float2(sin(power), -sin(power));
+    float power = (2 * PI * float((uv * xy) % MN)) / float(MN);
+    return float2(cos(power), -sin(power));
+}
 
-    return complex;
+float2 complexMultiply(float2 a, float2 b)
+{
+    return float2(a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x);
 }
 
+// Computes the same centered spectrum as CpuFourierTransform,
+// F(u,v) = sum f(x,y) (-1)^(x+y) e^(-2 PI i (ux/W + vy/H)) of the red channel, stored as
+// (real, imaginary, 0, 1). VerticalPass transforms the columns into F(x,v), HorizontalPass the rows
+// of that into F(u,v).
 [numthreads(8, 8, 1)]
 void HorizontalPass(uint3 dispatchId : SV_DispatchThreadID)
 {
@@ -27,9 +36,9 @@ void HorizontalPass(uint3 dispatchId : SV_DispatchThreadID)
     [loop]
     for (uint x = 0; x < g_outputSize.x; ++x)
     {
-        float2 verticalPassOutput = inputTex.Load(x, v);
+        float2 verticalPassOutput = inputTex.Load(int3(x, v, 0)).rg;
         float2 complex = computeEulers(dispatchId.x, x, g_outputSize.x);
-        sum += (complex * verticalPassOutput);
+        sum += complexMultiply(verticalPassOutput, complex);
     }
 
     outputTex[dispatchId.xy] = float4(sum, 0.0f, 1.0f);
@@ -46,11 +55,11 @@ void VerticalPass(uint3 dispatchId : SV_DispatchThreadID)
     [loop]
     for (uint y = 0; y < g_outputSize.y; ++y)
     {
-        float image = inputTex.Load(x, y);
-        float xyPower = pow(-1.0f, x + y);
+        float image = inputTex.Load(int3(x, y, 0)).r;
+        float xyPower = ((x + y) & 1) != 0 ? -1.0f : 1.0f;
         float2 complex = computeEulers(dispatchId.y, y, g_outputSize.y);
         sum += (image * xyPower * complex);
     }
-    
+
     outputTex[dispatchId.xy] = float4(sum, 0.0f, 1.0f);
 }
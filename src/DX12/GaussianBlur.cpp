@@ -1,4 +1,5 @@
 #include "GaussianBlur.h"
+#include "CpuPixelFormatDxgi.h"
 
 #include "Device.h"
 #include "DynamicBufferRing.h"
@@ -11,6 +12,9 @@
 #include "UserMarkers.h"
 #include "Texture.h"
 
+#include "../CPU/CpuGaussianKernelCache.h"
+#include "../CPU/CpuRecursiveGaussian.h"
+
 #include "stdafx.h"
 
 using namespace CS570;
@@ -33,6 +37,12 @@ void GaussianBlur::OnCreate(
     m_pResourceViewHeaps = pResourceViewHeaps;
     m_pConstantBufferRing = pConstantBufferRing;
 
+    assert(blurKernelSize <= k_maxSeparableKernelSize);
+    m_kernelSize = blurKernelSize;
+    m_variance = blurKernelVariance;
+    UpdateSeparableWeights(blurKernelVariance);
+    UpdateRecursiveCoefficients(blurKernelVariance);
+
     {
         int parameterCount = 0;
         CD3DX12_ROOT_PARAMETER rtSlot[3];
@@ -71,14 +81,35 @@ void GaussianBlur::OnCreate(
             pErrorBlob->Release();
     }
 
-    D3D12_SHADER_BYTECODE shaderByteCode = {};
+    CreatePipeline("Blur", &m_pPipeline);
+    CreatePipeline("BlurHorizontal", &m_pHorizontalPipeline);
+    CreatePipeline("BlurVertical", &m_pVerticalPipeline);
+    CreatePipeline("RecursiveCausalHorizontal", &m_pRecursiveCausalHorizontalPipeline);
+    CreatePipeline("RecursiveAntiCausalHorizontal", &m_pRecursiveAntiCausalHorizontalPipeline);
+    CreatePipeline("RecursiveCausalVertical", &m_pRecursiveCausalVerticalPipeline);
+    CreatePipeline("RecursiveAntiCausalVertical", &m_pRecursiveAntiCausalVerticalPipeline);
+
+    m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_constBuffer);
+
+    m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(2, &m_inputSrvTable);
+    m_computeWeights.GetOutputResource().CreateSRV(0, &m_inputSrvTable);
+    input.CreateSRV(1, &m_inputSrvTable);
+
+    CreateOutputResource(input);
+}
+
+void GaussianBlur::CreatePipeline(const char* pEntryFunc, ID3D12PipelineState** ppPipeline)
+{
     DefineList defines;
-    defines["KERNEL_WIDTH"] = std::to_string(blurKernelSize);
-    defines["KERNEL_HEIGHT"] = std::to_string(blurKernelSize);
+    defines["KERNEL_WIDTH"] = std::to_string(m_kernelSize);
+    defines["KERNEL_HEIGHT"] = std::to_string(m_kernelSize);
+    defines["MAX_SEPARABLE_KERNEL_SIZE"] = std::to_string(k_maxSeparableKernelSize);
+
+    D3D12_SHADER_BYTECODE shaderByteCode = {};
     CAULDRON_DX12::CompileShaderFromFile(
         "DX12/GaussianBlur.hlsl",
         &defines,
-        "Blur",
+        pEntryFunc,
         "-T cs_6_0 /Zi /Zss -Od -Qembed_debug",
         &shaderByteCode);
 
@@ -88,15 +119,7 @@ void GaussianBlur::OnCreate(
     descPso.pRootSignature = m_pRootSignature;
     descPso.NodeMask = 0;
 
-    ThrowIfFailed(pDevice->GetDevice()->CreateComputePipelineState(&descPso, IID_PPV_ARGS(&m_pPipeline)));
-
-    m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_constBuffer);
-
-    m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(2, &m_inputSrvTable);
-    m_computeWeights.GetOutputResource().CreateSRV(0, &m_inputSrvTable);
-    input.CreateSRV(1, &m_inputSrvTable);
-
-    CreateOutputResource(input);
+    ThrowIfFailed(m_pDevice->GetDevice()->CreateComputePipelineState(&descPso, IID_PPV_ARGS(ppPipeline)));
 }
 
 void ComputeGaussianWeights::OnCreate(
@@ -166,14 +189,16 @@ void ComputeGaussianWeights::OnCreate(
 
     m_constants.sigmaSquared = blurKernelVariance * blurKernelVariance;
     m_constants.oneOverSigmaSquared = 1.0f / m_constants.sigmaSquared;
+    m_weightsDirty = true;
     CreateOutputResource(blurKernelSize);
 }
 
 void GaussianBlur::CreateOutputResource(Texture& input)
 {
+    // Only red is read, so the output is a single grey plane.
     CD3DX12_RESOURCE_DESC outputDesc =
         CD3DX12_RESOURCE_DESC::Tex2D(
-            input.GetFormat(),
+            GetGreyOperationOutputFormat(input.GetFormat()),
             input.GetWidth(), input.GetHeight(),
             1, // array size
             1, // mip size
@@ -189,10 +214,49 @@ void GaussianBlur::CreateOutputResource(Texture& input)
     m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_outputSrv);
     m_blurredOutput.CreateSRV(0, &m_outputSrv);
 
+    m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(2, &m_outputSrvTable);
+    m_computeWeights.GetOutputResource().CreateSRV(0, &m_outputSrvTable);
+    m_blurredOutput.CreateSRV(1, &m_outputSrvTable);
+
+    // The horizontal pass of the separable blur stays 32 bit. The recursive blur alternates between
+    // this target and m_blurredOutput, so only its causal passes are stored at 32 bit; the
+    // anti-causal horizontal result that the vertical passes read has the output's precision.
+    CD3DX12_RESOURCE_DESC horizontalPassDesc = outputDesc;
+    horizontalPassDesc.Format = DXGI_FORMAT_R32_FLOAT;
+    m_horizontalPassOutput.InitRenderTarget(m_pDevice, "GaussianBlurHorizontalPass", &horizontalPassDesc, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+    m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_horizontalPassUav);
+    m_horizontalPassOutput.CreateUAV(0, &m_horizontalPassUav);
+
+    // Same layout as m_inputSrvTable so BlurVertical reads the horizontal pass as inputTex.
+    m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(2, &m_horizontalPassSrvTable);
+    m_computeWeights.GetOutputResource().CreateSRV(0, &m_horizontalPassSrvTable);
+    m_horizontalPassOutput.CreateSRV(1, &m_horizontalPassSrvTable);
+
     m_constants.outputWidth = input.GetWidth();
     m_constants.outputHeight = input.GetHeight();
 }
 
+void GaussianBlur::UpdateSeparableWeights(float variance)
+{
+    GaussianKernelPtr pWeights = GetGaussianKernel(m_kernelSize, variance, true, GaussianKernelShape::Separable);
+    std::copy(pWeights->begin(), pWeights->end(), m_constants.weights);
+}
+
+void GaussianBlur::UpdateRecursiveCoefficients(float variance)
+{
+    RecursiveGaussianCoefficients coefficients;
+    ComputeRecursiveGaussianCoefficients(std::fabs(variance), &coefficients);
+
+    m_constants.recursiveFilter[0] = coefficients.b;
+    for (int i = 0; i < 3; ++i)
+    {
+        m_constants.recursiveFilter[1 + i] = coefficients.a[i];
+        for (int j = 0; j < 3; ++j)
+            m_constants.recursiveBoundary[i][j] = coefficients.boundary[i * 3 + j];
+    }
+}
+
 void ComputeGaussianWeights::CreateOutputResource(uint32_t blurKernelSize)
 {
     CD3DX12_RESOURCE_DESC outputDesc =
@@ -219,6 +283,7 @@ void GaussianBlur::OnDestroy()
     m_computeWeights.OnDestroy();
 
     m_blurredOutput.OnDestroy();
+    m_horizontalPassOutput.OnDestroy();
 
     if (m_pPipeline != nullptr)
     {
@@ -226,6 +291,33 @@ void GaussianBlur::OnDestroy()
         m_pPipeline = nullptr;
     }
 
+    if (m_pHorizontalPipeline != nullptr)
+    {
+        m_pHorizontalPipeline->Release();
+        m_pHorizontalPipeline = nullptr;
+    }
+
+    if (m_pVerticalPipeline != nullptr)
+    {
+        m_pVerticalPipeline->Release();
+        m_pVerticalPipeline = nullptr;
+    }
+
+    ID3D12PipelineState** recursivePipelines[] = {
+        &m_pRecursiveCausalHorizontalPipeline,
+        &m_pRecursiveAntiCausalHorizontalPipeline,
+        &m_pRecursiveCausalVerticalPipeline,
+        &m_pRecursiveAntiCausalVerticalPipeline,
+    };
+    for (ID3D12PipelineState** ppPipeline : recursivePipelines)
+    {
+        if (*ppPipeline != nullptr)
+        {
+            (*ppPipeline)->Release();
+            *ppPipeline = nullptr;
+        }
+    }
+
     if (m_pRootSignature != nullptr)
     {
         m_pRootSignature->Release();
@@ -253,18 +345,74 @@ void GaussianBlur::Draw(ID3D12GraphicsCommandList* pCommandList)
 {
     UserMarker marker(pCommandList, "GaussianBlur");
 
-    m_computeWeights.Draw(pCommandList);
+    switch (ResolveGaussianBlurAlgorithm(m_algorithm, m_kernelSize, m_variance))
+    {
+    case GaussianBlurAlgorithm::Direct:
+        m_computeWeights.Draw(pCommandList);
+
+        Dispatch(pCommandList, m_pPipeline, m_blurredOutput, m_outputUav, m_inputSrvTable);
+        break;
+    case GaussianBlurAlgorithm::Recursive:
+    {
+        // input -> horizontal pass -> output -> horizontal pass -> output, each step one direction
+        // of one axis.
+        const uint32_t rowCount = m_constants.outputHeight;
+        const uint32_t columnCount = m_constants.outputWidth;
+        DispatchRecursive(pCommandList, m_pRecursiveCausalHorizontalPipeline, rowCount, m_horizontalPassOutput, m_horizontalPassUav, m_inputSrvTable);
+        DispatchRecursive(pCommandList, m_pRecursiveAntiCausalHorizontalPipeline, rowCount, m_blurredOutput, m_outputUav, m_horizontalPassSrvTable);
+        DispatchRecursive(pCommandList, m_pRecursiveCausalVerticalPipeline, columnCount, m_horizontalPassOutput, m_horizontalPassUav, m_outputSrvTable);
+        DispatchRecursive(pCommandList, m_pRecursiveAntiCausalVerticalPipeline, columnCount, m_blurredOutput, m_outputUav, m_horizontalPassSrvTable);
+        break;
+    }
+    default:
+        Dispatch(pCommandList, m_pHorizontalPipeline, m_horizontalPassOutput, m_horizontalPassUav, m_inputSrvTable);
+        Dispatch(pCommandList, m_pVerticalPipeline, m_blurredOutput, m_outputUav, m_horizontalPassSrvTable);
+        break;
+    }
+}
 
+void GaussianBlur::Dispatch(
+    ID3D12GraphicsCommandList* pCommandList,
+    ID3D12PipelineState* pPipeline,
+    Texture& output,
+    CBV_SRV_UAV& outputUav,
+    CBV_SRV_UAV& inputSrvTable)
+{
+    uint32_t dispatchX = (m_constants.outputWidth + 7) / 8;
+    uint32_t dispatchY = (m_constants.outputHeight + 7) / 8;
+    DispatchGroups(pCommandList, pPipeline, dispatchX, dispatchY, output, outputUav, inputSrvTable);
+}
+
+void GaussianBlur::DispatchRecursive(
+    ID3D12GraphicsCommandList* pCommandList,
+    ID3D12PipelineState* pPipeline,
+    uint32_t lineCount,
+    Texture& output,
+    CBV_SRV_UAV& outputUav,
+    CBV_SRV_UAV& inputSrvTable)
+{
+    DispatchGroups(pCommandList, pPipeline, (lineCount + 63) / 64, 1, output, outputUav, inputSrvTable);
+}
+
+void GaussianBlur::DispatchGroups(
+    ID3D12GraphicsCommandList* pCommandList,
+    ID3D12PipelineState* pPipeline,
+    uint32_t dispatchX,
+    uint32_t dispatchY,
+    Texture& output,
+    CBV_SRV_UAV& outputUav,
+    CBV_SRV_UAV& inputSrvTable)
+{
     CD3DX12_RESOURCE_BARRIER barriers[1] = {
         CD3DX12_RESOURCE_BARRIER::Transition(
-            m_blurredOutput.GetResource(),
+            output.GetResource(),
             D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
             D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
     };
 
     pCommandList->ResourceBarrier(1, barriers);
 
-    pCommandList->SetPipelineState(m_pPipeline);
+    pCommandList->SetPipelineState(pPipeline);
     pCommandList->SetComputeRootSignature(m_pRootSignature);
 
     D3D12_GPU_VIRTUAL_ADDRESS cbHandle;
@@ -278,17 +426,14 @@ void GaussianBlur::Draw(ID3D12GraphicsCommandList* pCommandList)
     pCommandList->SetDescriptorHeaps(2, pDescriptorHeaps);
 
     pCommandList->SetComputeRootConstantBufferView(0, cbHandle);
-    pCommandList->SetComputeRootDescriptorTable(1, m_outputUav.GetGPU());
-    pCommandList->SetComputeRootDescriptorTable(2, m_inputSrvTable.GetGPU());
+    pCommandList->SetComputeRootDescriptorTable(1, outputUav.GetGPU());
+    pCommandList->SetComputeRootDescriptorTable(2, inputSrvTable.GetGPU());
 
-    uint32_t dispatchX = (m_constants.outputWidth + 7) / 8;
-    uint32_t dispatchY = (m_constants.outputHeight + 7) / 8;
-    uint32_t dispatchZ = 1;
-    pCommandList->Dispatch(dispatchX, dispatchY, dispatchZ);
+    pCommandList->Dispatch(dispatchX, dispatchY, 1);
 
     barriers[0] =
         CD3DX12_RESOURCE_BARRIER::Transition(
-            m_blurredOutput.GetResource(),
+            output.GetResource(),
             D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
             D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 
@@ -297,6 +442,11 @@ void GaussianBlur::Draw(ID3D12GraphicsCommandList* pCommandList)
 
 void ComputeGaussianWeights::Draw(ID3D12GraphicsCommandList* pCommandList)
 {
+    if (!m_weightsDirty)
+        return;
+
+    m_weightsDirty = false;
+
     UserMarker marker(pCommandList, "ComputeGaussianWeights");
 
     CD3DX12_RESOURCE_BARRIER barriers[1] = {
@@ -8,6 +8,8 @@
 #include "Texture.h"
 #include "UploadHeap.h"
 
+#include "../CPU/CpuGaussianBlur.h"
+
 #include <string>
 
 namespace CS570
@@ -30,6 +32,7 @@ namespace CS570
         {
             m_constants.sigmaSquared = variance * variance;
             m_constants.oneOverSigmaSquared = 1.0f / m_constants.sigmaSquared;
+            m_weightsDirty = true;
         }
     private:
         void CreateOutputResource(uint32_t blurKernelSize);
@@ -38,6 +41,8 @@ namespace CS570
         ID3D12PipelineState* m_pPipeline = nullptr;
 
         CAULDRON_DX12::Texture m_blurWeights;
+        // Draw only dispatches after OnCreate or SetVariance, the texture keeps the weights otherwise.
+        bool m_weightsDirty = true;
 
         struct Constants
         {
@@ -79,22 +84,73 @@ namespace CS570
 
         void SetVariance(float variance)
         {
+            m_variance = variance;
             m_computeWeights.SetVariance(variance);
+            UpdateSeparableWeights(variance);
+            UpdateRecursiveCoefficients(variance);
         }
+
+        // Separable runs BlurHorizontal then BlurVertical with 1D weights that are normalized once on
+        // the CPU, Direct the 2D Blur that re-sums the weights per pixel, and Recursive the four
+        // Recursive* passes. Auto resolves with ResolveGaussianBlurAlgorithm, the same as the CPU.
+        void SetAlgorithm(GaussianBlurAlgorithm algorithm) { m_algorithm = algorithm; }
+
+        static const uint32_t k_maxSeparableKernelSize = 32;
+
     private:
         void CreateOutputResource(CAULDRON_DX12::Texture& input);
+        void UpdateSeparableWeights(float variance);
+        void UpdateRecursiveCoefficients(float variance);
+        void CreatePipeline(const char* pEntryFunc, ID3D12PipelineState** ppPipeline);
+        void Dispatch(
+            ID3D12GraphicsCommandList* pCommandList,
+            ID3D12PipelineState* pPipeline,
+            CAULDRON_DX12::Texture& output,
+            CAULDRON_DX12::CBV_SRV_UAV& outputUav,
+            CAULDRON_DX12::CBV_SRV_UAV& inputSrvTable);
+        // One 64 thread group per 64 rows (horizontal) or columns (vertical).
+        void DispatchRecursive(
+            ID3D12GraphicsCommandList* pCommandList,
+            ID3D12PipelineState* pPipeline,
+            uint32_t lineCount,
+            CAULDRON_DX12::Texture& output,
+            CAULDRON_DX12::CBV_SRV_UAV& outputUav,
+            CAULDRON_DX12::CBV_SRV_UAV& inputSrvTable);
+        void DispatchGroups(
+            ID3D12GraphicsCommandList* pCommandList,
+            ID3D12PipelineState* pPipeline,
+            uint32_t dispatchX,
+            uint32_t dispatchY,
+            CAULDRON_DX12::Texture& output,
+            CAULDRON_DX12::CBV_SRV_UAV& outputUav,
+            CAULDRON_DX12::CBV_SRV_UAV& inputSrvTable);
 
         ComputeGaussianWeights m_computeWeights;
 
         ID3D12RootSignature* m_pRootSignature = nullptr;
         ID3D12PipelineState* m_pPipeline = nullptr;
+        ID3D12PipelineState* m_pHorizontalPipeline = nullptr;
+        ID3D12PipelineState* m_pVerticalPipeline = nullptr;
+        ID3D12PipelineState* m_pRecursiveCausalHorizontalPipeline = nullptr;
+        ID3D12PipelineState* m_pRecursiveAntiCausalHorizontalPipeline = nullptr;
+        ID3D12PipelineState* m_pRecursiveCausalVerticalPipeline = nullptr;
+        ID3D12PipelineState* m_pRecursiveAntiCausalVerticalPipeline = nullptr;
 
         CAULDRON_DX12::Texture m_blurredOutput;
+        CAULDRON_DX12::Texture m_horizontalPassOutput;
+
+        uint32_t m_kernelSize = 0u;
+        float m_variance = 1.0f;
+        GaussianBlurAlgorithm m_algorithm = GaussianBlurAlgorithm::Auto;
 
         struct Constants
         {
             uint32_t outputWidth = 0u;
             uint32_t outputHeight = 0u;
+            uint32_t padding[2] = {};
+            float weights[k_maxSeparableKernelSize] = {};
+            float recursiveFilter[4] = {};
+            float recursiveBoundary[3][4] = {};
         };
 
         Constants m_constants;
@@ -106,6 +162,12 @@ namespace CS570
         CAULDRON_DX12::CBV_SRV_UAV m_inputSrvTable;
         CAULDRON_DX12::CBV_SRV_UAV m_outputUav;
         CAULDRON_DX12::CBV_SRV_UAV m_outputSrv;
+        // Same layout as m_inputSrvTable, the recursive vertical pass reads the horizontal result
+        // back from m_blurredOutput.
+        CAULDRON_DX12::CBV_SRV_UAV m_outputSrvTable;
+
+        CAULDRON_DX12::CBV_SRV_UAV m_horizontalPassSrvTable;
+        CAULDRON_DX12::CBV_SRV_UAV m_horizontalPassUav;
 
         CAULDRON_DX12::ResourceViewHeaps* m_pResourceViewHeaps = nullptr;
         CAULDRON_DX12::DynamicBufferRing* m_pConstantBufferRing = nullptr;
@@ -1,12 +1,18 @@
 cbuffer Constants : register(b0)
 {
     uint2 g_outputSize;
+    // Normalized 1D weights for the separable passes, four per element.
+    float4 g_weights[MAX_SEPARABLE_KERNEL_SIZE / 4];
+    // Recursive filter: x = B, yzw = a1, a2, a3.
+    float4 g_recursiveFilter;
+    // Rows of the anti-causal boundary matrix in xyz.
+    float4 g_recursiveBoundary[3];
 }
 
 
 Texture2D<float> weightsTex : register(t0);
 Texture2D inputTex : register(t1);
-RWTexture2D<float4> outputTex : register(u0);
+RWTexture2D<float> outputTex : register(u0);
 
 [numthreads(8, 8, 1)]
 void Blur(uint3 dispatchId : SV_DispatchThreadID)
@@ -51,5 +57,122 @@ void Blur(uint3 dispatchId : SV_DispatchThreadID)
         ++offsetXY.y;
     }
 
-    outputTex[dispatchId.xy] = float4(blurredOutput, blurredOutput, blurredOutput, 1.0f);
+    outputTex[dispatchId.xy] = blurredOutput;
+}
+
+float LoadSeparableWeight(uint index)
+{
+    return g_weights[index >> 2][index & 3];
+}
+
+[numthreads(8, 8, 1)]
+void BlurHorizontal(uint3 dispatchId : SV_DispatchThreadID)
+{
+    if (dispatchId.x >= g_outputSize.x || dispatchId.y >= g_outputSize.y)
+        return;
+
+    const int halfWidth = KERNEL_WIDTH >> 1;
+    int3 loadXY = int3(int(dispatchId.x) - halfWidth, dispatchId.y, 0);
+    float blurredOutput = 0.0f;
+    [loop]
+    for (uint col = 0; col < KERNEL_WIDTH; ++col)
+    {
+        blurredOutput += inputTex.Load(loadXY).r * LoadSeparableWeight(col);
+        ++loadXY.x;
+    }
+
+    outputTex[dispatchId.xy] = blurredOutput;
+}
+
+[numthreads(8, 8, 1)]
+void BlurVertical(uint3 dispatchId : SV_DispatchThreadID)
+{
+    if (dispatchId.x >= g_outputSize.x || dispatchId.y >= g_outputSize.y)
+        return;
+
+    const int halfHeight = KERNEL_HEIGHT >> 1;
+    int3 loadXY = int3(dispatchId.x, int(dispatchId.y) - halfHeight, 0);
+    float blurredOutput = 0.0f;
+    [loop]
+    for (uint row = 0; row < KERNEL_HEIGHT; ++row)
+    {
+        blurredOutput += inputTex.Load(loadXY).r * LoadSeparableWeight(row);
+        ++loadXY.y;
+    }
+
+    outputTex[dispatchId.xy] = blurredOutput;
+}
+
+// Young - van Vliet recursive passes, see CpuRecursiveGaussian.h. Each thread filters one whole row
+// or column, so cost doesn't depend on the kernel size. The causal pass writes its result to
+// outputTex, then the anti-causal pass reads it back as inputTex and starts from the state the
+// causal pass would reach on the zero padding past the end.
+void RecursiveCausal(int2 xy, int2 step, uint count)
+{
+    float3 previous = float3(0.0f, 0.0f, 0.0f);
+    [loop]
+    for (uint n = 0; n < count; ++n)
+    {
+        float filtered = g_recursiveFilter.x * inputTex.Load(int3(xy, 0)).r + dot(g_recursiveFilter.yzw, previous);
+        previous = float3(filtered, previous.xy);
+        outputTex[xy] = filtered;
+        xy += step;
+    }
+}
+
+void RecursiveAntiCausal(int2 xy, int2 step, uint count)
+{
+    // xy is the last texel and step walks backwards, so this is w[N-1], w[N-2], w[N-3].
+    float3 causalTail = float3(
+        inputTex.Load(int3(xy, 0)).r,
+        inputTex.Load(int3(xy + step, 0)).r,
+        inputTex.Load(int3(xy + 2 * step, 0)).r);
+    float3 previous = float3(
+        dot(g_recursiveBoundary[0].xyz, causalTail),
+        dot(g_recursiveBoundary[1].xyz, causalTail),
+        dot(g_recursiveBoundary[2].xyz, causalTail));
+    [loop]
+    for (uint n = 0; n < count; ++n)
+    {
+        float filtered = g_recursiveFilter.x * inputTex.Load(int3(xy, 0)).r + dot(g_recursiveFilter.yzw, previous);
+        previous = float3(filtered, previous.xy);
+        outputTex[xy] = filtered;
+        xy += step;
+    }
+}
+
+[numthreads(64, 1, 1)]
+void RecursiveCausalHorizontal(uint3 dispatchId : SV_DispatchThreadID)
+{
+    if (dispatchId.x >= g_outputSize.y)
+        return;
+
+    RecursiveCausal(int2(0, dispatchId.x), int2(1, 0), g_outputSize.x);
+}
+
+[numthreads(64, 1, 1)]
+void RecursiveAntiCausalHorizontal(uint3 dispatchId : SV_DispatchThreadID)
+{
+    if (dispatchId.x >= g_outputSize.y)
+        return;
+
+    RecursiveAntiCausal(int2(g_outputSize.x - 1, dispatchId.x), int2(-1, 0), g_outputSize.x);
+}
+
+[numthreads(64, 1, 1)]
+void RecursiveCausalVertical(uint3 dispatchId : SV_DispatchThreadID)
+{
+    if (dispatchId.x >= g_outputSize.x)
+        return;
+
+    RecursiveCausal(int2(dispatchId.x, 0), int2(0, 1), g_outputSize.y);
+}
+
+[numthreads(64, 1, 1)]
+void RecursiveAntiCausalVertical(uint3 dispatchId : SV_DispatchThreadID)
+{
+    if (dispatchId.x >= g_outputSize.x)
+        return;
+
+    RecursiveAntiCausal(int2(dispatchId.x, g_outputSize.y - 1), int2(0, -1), g_outputSize.y);
 }
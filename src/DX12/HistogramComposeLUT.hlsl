@@ -0,0 +1,31 @@
+cbuffer Constants : register(b0)
+{
+    uint g_binCount;
+    // Non-zero when the output levels come from g_levelTable rather than being evenly spaced.
+    uint g_useLevelTable;
+    uint2 g_padding;
+    float4 g_levelTable[2];
+}
+
+Buffer<uint> histogramLUT : register(t0);
+Buffer<uint> histogramInverseLUT : register(t1);
+RWBuffer<float> matchLUT : register(u0);
+
+// The output value of every bin of the input: the input CDF, then the inverse CDF of the match
+// image, then the value of the level that reaches.
+[numthreads(64, 1, 1)]
+void ComposeLUT(uint3 dispatchId : SV_DispatchThreadID)
+{
+    if (dispatchId.x >= g_binCount)
+        return;
+
+    uint level = histogramInverseLUT[histogramLUT[dispatchId.x]];
+
+    float value;
+    if (g_useLevelTable != 0)
+        value = g_levelTable[level >> 2][level & 3];
+    else
+        value = float(level) / float(g_binCount - 1);
+
+    matchLUT[dispatchId.x] = value;
+}
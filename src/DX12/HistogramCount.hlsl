@@ -0,0 +1,99 @@
+// BIN_COUNT bins per channel. HISTOGRAM_MODE 0 counts red, 1 red, green and blue, 2 luminance.
+#if HISTOGRAM_MODE == 1
+#define CHANNEL_COUNT 3
+#else
+#define CHANNEL_COUNT 1
+#endif
+
+#define TOTAL_BIN_COUNT (BIN_COUNT * CHANNEL_COUNT)
+
+// Each group covers a TILE_SIZE x TILE_SIZE block, every thread counting a 4x4 grid of pixels.
+#define GROUP_SIZE 16
+#define TILE_SIZE (GROUP_SIZE * 4)
+
+// Groups count into a groupshared sub-histogram and add it to the output once. Larger histograms
+// don't fit in groupshared memory and count into the output directly.
+#if TOTAL_BIN_COUNT <= 4096
+#define USE_GROUP_BINS 1
+#else
+#define USE_GROUP_BINS 0
+#endif
+
+cbuffer Constants : register(b0)
+{
+    uint2 g_inputSize;
+    uint2 g_outputSize;
+}
+
+Texture2D inputTex : register(t0);
+RWBuffer<uint> histogram : register(u0);
+
+#if USE_GROUP_BINS
+groupshared uint groupBins[TOTAL_BIN_COUNT];
+#endif
+
+uint ComputeBinNumber(float value)
+{
+    return min(uint(max(value, 0.0) * BIN_COUNT), BIN_COUNT - 1);
+}
+
+void AddToBin(uint bin)
+{
+#if USE_GROUP_BINS
+    InterlockedAdd(groupBins[bin], 1);
+#else
+    InterlockedAdd(histogram[bin], 1);
+#endif
+}
+
+[numthreads(64, 1, 1)]
+void ClearHistogram(uint3 dispatchId : SV_DispatchThreadID)
+{
+    if (dispatchId.x >= TOTAL_BIN_COUNT)
+        return;
+
+    histogram[dispatchId.x] = 0;
+}
+
+[numthreads(GROUP_SIZE, GROUP_SIZE, 1)]
+void CountHistogram(uint3 groupId : SV_GroupID, uint3 groupThreadId : SV_GroupThreadID, uint groupIndex : SV_GroupIndex)
+{
+#if USE_GROUP_BINS
+    for (uint clearBin = groupIndex; clearBin < TOTAL_BIN_COUNT; clearBin += GROUP_SIZE * GROUP_SIZE)
+        groupBins[clearBin] = 0;
+
+    GroupMemoryBarrierWithGroupSync();
+#endif
+
+    uint2 tileBase = groupId.xy * TILE_SIZE + groupThreadId.xy;
+    for (uint y = 0; y < TILE_SIZE; y += GROUP_SIZE)
+    {
+        for (uint x = 0; x < TILE_SIZE; x += GROUP_SIZE)
+        {
+            uint2 pixel = tileBase + uint2(x, y);
+            if (pixel.x >= g_inputSize.x || pixel.y >= g_inputSize.y)
+                continue;
+
+            float4 color = inputTex.Load(int3(pixel, 0));
+#if HISTOGRAM_MODE == 1
+            AddToBin(ComputeBinNumber(color.r));
+            AddToBin(BIN_COUNT + ComputeBinNumber(color.g));
+            AddToBin(2 * BIN_COUNT + ComputeBinNumber(color.b));
+#elif HISTOGRAM_MODE == 2
+            AddToBin(ComputeBinNumber(dot(color.rgb, float3(0.2126, 0.7152, 0.0722))));
+#else
+            AddToBin(ComputeBinNumber(color.r));
+#endif
+        }
+    }
+
+#if USE_GROUP_BINS
+    GroupMemoryBarrierWithGroupSync();
+
+    for (uint bin = groupIndex; bin < TOTAL_BIN_COUNT; bin += GROUP_SIZE * GROUP_SIZE)
+    {
+        if (groupBins[bin] != 0)
+            InterlockedAdd(histogram[bin], groupBins[bin]);
+    }
+#endif
+}
@@ -1,58 +1,101 @@
 cbuffer Constants : register(b0)
 {
-    uint g_outputSize;
+    uint g_binCount;
     uint g_pixelCount;
 }
 
-Texture2D<uint2> inputTex : register(t0);
-RWTexture1D<uint> outputTex : register(u0);
+Buffer<uint> histogram : register(t0);
+// The forward LUT (bin to level) at [0, g_binCount), the inverse LUT (level to the first bin
+// reaching it) at [g_binCount, 2 * g_binCount).
+RWBuffer<uint> lutBuffer : register(u0);
 
-float2 TwoDecimals(float2 value)
+#define THREAD_COUNT 1024
+
+groupshared uint threadSums[THREAD_COUNT];
+
+// a * b as a high and low word, from 16 bit partial products, since 64 bit integers need the
+// optional Int64ShaderOps capability.
+void Multiply64(uint a, uint b, out uint high, out uint low)
 {
-    // reduce to two decimals
-    return round(value * 100.0) * 0.01;
+    uint aLow = a & 0xFFFF;
+    uint aHigh = a >> 16;
+    uint bLow = b & 0xFFFF;
+    uint bHigh = b >> 16;
+    uint lowLow = aLow * bLow;
+    uint highLow = aHigh * bLow;
+    uint lowHigh = aLow * bHigh;
+    uint middle = (lowLow >> 16) + (highLow & 0xFFFF) + (lowHigh & 0xFFFF);
+    low = (middle << 16) | (lowLow & 0xFFFF);
+    high = aHigh * bHigh + (highLow >> 16) + (lowHigh >> 16) + (middle >> 16);
 }
 
-uint ComputeRemapValue(uint binNumber)
+// (high, low) / divisor by shift and subtract long division. high < divisor, so the quotient fits
+// in 32 bits.
+uint Divide64(uint high, uint low, uint divisor)
 {
-    float oneOverPixelCount = 1.0 / float(g_pixelCount);
-    int3 inputIndex = int3(0, 0, 0);
-    int3 indexOffsets[3] = { int3(1, 0, 0), int3(-1, 1, 0), int3(1, 0, 0) };
-    int inputOffsetIndex = 0;
-    float cumulativeOutput = 0.0f;
-    for (uint currentBin = 0; currentBin < (binNumber + 1); currentBin += 2)
+    uint remainder = high;
+    uint quotient = 0;
+    for (int bit = 31; bit >= 0; --bit)
     {
-        uint2 binCounts = inputTex.Load(inputIndex);
-
-        inputIndex += indexOffsets[inputOffsetIndex++];
-
-        // Two counts per texel.
-        float2 currentBinOutput = TwoDecimals(TwoDecimals(float2(binCounts) * oneOverPixelCount) * 7.0);
-
-        cumulativeOutput += currentBinOutput.x;
-
-        cumulativeOutput += (currentBin + 1) < (binNumber + 1) ? currentBinOutput.y : 0;
+        // The shifted remainder can need 33 bits; when it does it is at least the divisor, and
+        // subtracting wraps back to the right value.
+        bool carry = remainder >= 0x80000000;
+        remainder = (remainder << 1) | ((low >> bit) & 1);
+        quotient <<= 1;
+        if (carry || remainder >= divisor)
+        {
+            remainder -= divisor;
+            quotient |= 1;
+        }
     }
-    
-    return min(round(uint(cumulativeOutput)), 7);
+    return quotient;
 }
 
-[numthreads(8, 1, 1)]
-void CreateLUT(uint3 dispatchId : SV_DispatchThreadID)
+uint ComputeLevel(uint cumulativeCount)
 {
-    if (dispatchId.x >= g_outputSize.x)
-        return;
- 
-    outputTex[dispatchId.x] = ComputeRemapValue(dispatchId.x);
+    // Integer math, so the LUTs match CpuComputeHistogram and the inverse is exact.
+    uint high;
+    uint low;
+    Multiply64(cumulativeCount, g_binCount - 1, high, low);
+    return Divide64(high, low, g_pixelCount);
 }
 
-[numthreads(8, 1, 1)]
-void CreateInverseLUT(uint3 dispatchId : SV_DispatchThreadID)
+// One prefix sum over the bins builds both LUTs. Every thread owns a run of consecutive bins: it
+// sums them, the group scans the run totals, then every thread scans its run from its offset.
+[numthreads(THREAD_COUNT, 1, 1)]
+void CreateLUT(uint threadIndex : SV_GroupIndex)
 {
-    if (dispatchId.x >= g_outputSize.x)
-        return;
- 
-    uint outputIndex = ComputeRemapValue(dispatchId.x);
+    uint binsPerThread = (g_binCount + THREAD_COUNT - 1) / THREAD_COUNT;
+    uint firstBin = min(threadIndex * binsPerThread, g_binCount);
+    uint lastBin = min(firstBin + binsPerThread, g_binCount);
+
+    uint runTotal = 0;
+    for (uint bin = firstBin; bin < lastBin; ++bin)
+        runTotal += histogram[bin];
 
-    InterlockedMin(outputTex[outputIndex], dispatchId.x);
+    threadSums[threadIndex] = runTotal;
+    GroupMemoryBarrierWithGroupSync();
+
+    for (uint offset = 1; offset < THREAD_COUNT; offset <<= 1)
+    {
+        uint addend = threadIndex >= offset ? threadSums[threadIndex - offset] : 0;
+        GroupMemoryBarrierWithGroupSync();
+        threadSums[threadIndex] += addend;
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    uint cumulativeCount = threadSums[threadIndex] - runTotal;
+    uint previousLevel = ComputeLevel(cumulativeCount);
+    for (uint currentBin = firstBin; currentBin < lastBin; ++currentBin)
+    {
+        cumulativeCount += histogram[currentBin];
+        uint level = ComputeLevel(cumulativeCount);
+        lutBuffer[currentBin] = level;
+
+        // Levels (previousLevel, level] first reach this bin, so the inverse is fully filled
+        // without InterlockedMin: the level ranges of the bins are disjoint.
+        for (uint inverseLevel = currentBin == 0 ? 0 : previousLevel + 1; inverseLevel <= level; ++inverseLevel)
+            lutBuffer[g_binCount + inverseLevel] = currentBin;
+        previousLevel = level;
+    }
 }
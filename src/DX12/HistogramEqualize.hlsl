@@ -5,14 +5,24 @@ cbuffer Constants : register(b0)
 
 uint ComputeBinNumber(float red)
 {
-    float numberOfBins = 8.0;
+    return min(uint(max(red, 0.0) * BIN_COUNT), BIN_COUNT - 1);
+}
 
-    return min(uint(numberOfBins * red), 7);
+// Value of an output level, the original table for 8 levels and evenly spaced otherwise.
+float ComputeLevelValue(uint level)
+{
+#if BIN_COUNT == 8
+    const float binSize = 255.0 / 8.0;
+    const float remapped[8] = { 0, binSize * 1.25, 2.5 * binSize, 3.5 * binSize, 4.5 * binSize, 5.5 * binSize, 6.75 * binSize, 8.0 * binSize };
+    return remapped[min(level, 7)] / 255.0;
+#else
+    return float(min(level, BIN_COUNT - 1)) / float(BIN_COUNT - 1);
+#endif
 }
 
 Texture2D inputTex : register(t0);
-Texture1D<uint> histogramLUT : register(t1);
-RWTexture2D<float4> outputTex : register(u0);
+Buffer<uint> histogramLUT : register(t1);
+RWTexture2D<float> outputTex : register(u0);
 
 [numthreads(8, 8, 1)]
 void Equalize(uint3 dispatchId : SV_DispatchThreadID)
@@ -25,11 +35,7 @@ void Equalize(uint3 dispatchId : SV_DispatchThreadID)
 
     uint binNumber = ComputeBinNumber(red);
 
-    uint remappedBinNumber = histogramLUT.Load(int2(binNumber, 0));
-
-    const float binSize = 255.0 / 8.0;
-    const float remapped[8] = { 0, binSize * 1.25, 2.5 * binSize, 3.5 * binSize, 4.5 * binSize, 5.5 * binSize, 6.75 * binSize, 8.0 * binSize };
-    float newRed = remapped[remappedBinNumber] / 255.0;
+    float newRed = ComputeLevelValue(histogramLUT[binNumber]);
     
-    outputTex[baseXY.xy] = float4(newRed, newRed, newRed, 1);
+    outputTex[baseXY.xy] = newRed;
 }
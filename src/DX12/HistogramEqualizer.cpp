@@ -1,4 +1,5 @@
 #include "HistogramEqualizer.h"
+#include "CpuPixelFormatDxgi.h"
 
 #include "Device.h"
 #include "DynamicBufferRing.h"
@@ -21,9 +22,10 @@ void HistogramEqualizer::OnCreate(
     Device* pDevice,
     UploadHeap* pUploadHeap,
     ResourceViewHeaps* pResourceViewHeaps,
-    DynamicBufferRing* pConstantBufferRing)
+    DynamicBufferRing* pConstantBufferRing,
+    uint32_t binCount)
 {
-    m_computeHistogram.OnCreate(input, pDevice, pUploadHeap, pResourceViewHeaps, pConstantBufferRing);
+    m_computeHistogram.OnCreate(input, pDevice, pUploadHeap, pResourceViewHeaps, pConstantBufferRing, binCount);
 
     m_pDevice = pDevice;
     m_pResourceViewHeaps = pResourceViewHeaps;
@@ -69,6 +71,7 @@ void HistogramEqualizer::OnCreate(
 
     D3D12_SHADER_BYTECODE shaderByteCode = {};
     DefineList defines;
+    defines["BIN_COUNT"] = std::to_string(binCount);
     CAULDRON_DX12::CompileShaderFromFile(
         "DX12/HistogramEqualize.hlsl",
         &defines,
@@ -88,16 +91,17 @@ void HistogramEqualizer::OnCreate(
 
     m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(2, &m_inputSrvTable);
     input.CreateSRV(0, &m_inputSrvTable);
-    m_computeHistogram.GetOutputResource().CreateSRV(1, &m_inputSrvTable);
+    m_computeHistogram.CreateLUTSrv(1, &m_inputSrvTable);
 
     CreateOutputResource(input);
 }
 
 void HistogramEqualizer::CreateOutputResource(Texture& input)
 {
+    // Only red is read, so the output is a single grey plane.
     CD3DX12_RESOURCE_DESC outputDesc =
         CD3DX12_RESOURCE_DESC::Tex2D(
-            input.GetFormat(),
+            GetGreyOperationOutputFormat(input.GetFormat()),
             input.GetWidth(), input.GetHeight(),
             1, // array size
             1, // mip size
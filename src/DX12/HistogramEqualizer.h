@@ -21,7 +21,8 @@ namespace CS570
             CAULDRON_DX12::Device* pDevice,
             CAULDRON_DX12::UploadHeap* pUploadHeap,
             CAULDRON_DX12::ResourceViewHeaps* pResourceViewHeaps,
-            CAULDRON_DX12::DynamicBufferRing* pConstantBufferRing);
+            CAULDRON_DX12::DynamicBufferRing* pConstantBufferRing,
+            uint32_t binCount = ComputeHistogram::k_defaultBinCount);
         void OnDestroy();
 
         void Draw(ID3D12GraphicsCommandList *pCommandList) override;
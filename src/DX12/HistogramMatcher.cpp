@@ -1,4 +1,5 @@
 #include "HistogramMatcher.h"
+#include "CpuPixelFormatDxgi.h"
 
 #include "Device.h"
 #include "DynamicBufferRing.h"
@@ -11,6 +12,8 @@
 #include "UserMarkers.h"
 #include "Texture.h"
 
+#include "../CPU/CpuComputeHistogram.h"
+
 #include "stdafx.h"
 
 using namespace CS570;
@@ -22,14 +25,16 @@ void HistogramMatcher::OnCreate(
     Device* pDevice,
     UploadHeap* pUploadHeap,
     ResourceViewHeaps* pResourceViewHeaps,
-    DynamicBufferRing* pConstantBufferRing)
+    DynamicBufferRing* pConstantBufferRing,
+    uint32_t binCount)
 {
-    m_computeHistogramLUT.OnCreate(input, pDevice, pUploadHeap, pResourceViewHeaps, pConstantBufferRing);
-    m_computeHistogramInverseLUT.OnCreate(match, pDevice, pUploadHeap, pResourceViewHeaps, pConstantBufferRing);
+    m_computeHistogramLUT.OnCreate(input, pDevice, pUploadHeap, pResourceViewHeaps, pConstantBufferRing, binCount);
+    m_computeHistogramInverseLUT.OnCreate(match, pDevice, pUploadHeap, pResourceViewHeaps, pConstantBufferRing, binCount);
 
     m_pDevice = pDevice;
     m_pResourceViewHeaps = pResourceViewHeaps;
     m_pConstantBufferRing = pConstantBufferRing;
+    m_isMatchLUTReady = false;
 
     {
         int parameterCount = 0;
@@ -42,7 +47,7 @@ void HistogramMatcher::OnCreate(
         rtSlot[parameterCount++].InitAsDescriptorTable(1, &uavDescRange, D3D12_SHADER_VISIBILITY_ALL);
 
         CD3DX12_DESCRIPTOR_RANGE srvDescRange = {};
-        srvDescRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 3, 0);
+        srvDescRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 2, 0);
         rtSlot[parameterCount++].InitAsDescriptorTable(1, &srvDescRange, D3D12_SHADER_VISIBILITY_ALL);
 
         CD3DX12_ROOT_SIGNATURE_DESC descRootSignature = CD3DX12_ROOT_SIGNATURE_DESC();
@@ -62,7 +67,7 @@ void HistogramMatcher::OnCreate(
             pDevice->GetDevice()->CreateRootSignature(
                 0, pOutBlob->GetBufferPointer(), pOutBlob->GetBufferSize(), IID_PPV_ARGS(&m_pRootSignature))
         );
-        CAULDRON_DX12::SetName(m_pRootSignature, std::string("HistogramEqualization::Equalize"));
+        CAULDRON_DX12::SetName(m_pRootSignature, std::string("HistogramMatcher::Match"));
 
         pOutBlob->Release();
         if (pErrorBlob)
@@ -71,6 +76,7 @@ void HistogramMatcher::OnCreate(
 
     D3D12_SHADER_BYTECODE shaderByteCode = {};
     DefineList defines;
+    defines["BIN_COUNT"] = std::to_string(binCount);
     CAULDRON_DX12::CompileShaderFromFile(
         "DX12/HistogramMatch.hlsl",
         &defines,
@@ -86,21 +92,68 @@ void HistogramMatcher::OnCreate(
 
     ThrowIfFailed(pDevice->GetDevice()->CreateComputePipelineState(&descPso, IID_PPV_ARGS(&m_pPipeline)));
 
+    D3D12_SHADER_BYTECODE composeByteCode = {};
+    CAULDRON_DX12::CompileShaderFromFile(
+        "DX12/HistogramComposeLUT.hlsl",
+        &defines,
+        "ComposeLUT",
+        "-T cs_6_0 /Zi /Zss -Od -Qembed_debug",
+        &composeByteCode);
+
+    descPso.CS = composeByteCode;
+    ThrowIfFailed(pDevice->GetDevice()->CreateComputePipelineState(&descPso, IID_PPV_ARGS(&m_pComposePipeline)));
+
     m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_constBuffer);
 
-    m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(3, &m_inputSrvTable);
+    CreateMatchLUT(binCount);
+
+    m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(2, &m_composeSrvTable);
+    m_computeHistogramLUT.CreateLUTSrv(0, &m_composeSrvTable);
+    m_computeHistogramInverseLUT.CreateInverseLUTSrv(1, &m_composeSrvTable);
+
+    m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(2, &m_inputSrvTable);
     input.CreateSRV(0, &m_inputSrvTable);
-    m_computeHistogramLUT.GetOutputResource().CreateSRV(1, &m_inputSrvTable);
-    m_computeHistogramInverseLUT.GetOutputResource().CreateSRV(2, &m_inputSrvTable);
+
+    D3D12_SHADER_RESOURCE_VIEW_DESC matchLUTSrvDesc = {};
+    matchLUTSrvDesc.Format = DXGI_FORMAT_R32_FLOAT;
+    matchLUTSrvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+    matchLUTSrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    matchLUTSrvDesc.Buffer.FirstElement = 0;
+    matchLUTSrvDesc.Buffer.NumElements = binCount;
+    matchLUTSrvDesc.Buffer.StructureByteStride = 0;
+    matchLUTSrvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
+    m_matchLUT.CreateSRV(1, &m_inputSrvTable, &matchLUTSrvDesc);
 
     CreateOutputResource(input);
 }
 
+void HistogramMatcher::CreateMatchLUT(uint32_t binCount)
+{
+    m_composeConstants.binCount = binCount;
+    // 8 levels keep the output values of the original table, see GetRemappedBinValue.
+    m_composeConstants.useLevelTable = binCount == 8 ? 1u : 0u;
+    for (uint32_t level = 0; level < 8; ++level)
+        m_composeConstants.levelTable[level] = GetRemappedBinValue(level, 8);
+
+    CD3DX12_RESOURCE_DESC lutDesc = CD3DX12_RESOURCE_DESC::Buffer(binCount, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+    lutDesc.Format = DXGI_FORMAT_R32_FLOAT;
+    m_matchLUT.InitBuffer(
+        m_pDevice,
+        "HistogramMatchLUT",
+        &lutDesc,
+        0,
+        D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+    m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_matchLUTUav);
+    m_matchLUT.CreateBufferUAV(0, nullptr, &m_matchLUTUav);
+}
+
 void HistogramMatcher::CreateOutputResource(Texture& input)
 {
+    // Only red is read, so the output is a single grey plane.
     CD3DX12_RESOURCE_DESC outputDesc =
         CD3DX12_RESOURCE_DESC::Tex2D(
-            input.GetFormat(),
+            GetGreyOperationOutputFormat(input.GetFormat()),
             input.GetWidth(), input.GetHeight(),
             1, // array size
             1, // mip size
@@ -126,6 +179,13 @@ void HistogramMatcher::OnDestroy()
     m_computeHistogramInverseLUT.OnDestroy();
 
     m_matchedOutput.OnDestroy();
+    m_matchLUT.OnDestroy();
+
+    if (m_pComposePipeline != nullptr)
+    {
+        m_pComposePipeline->Release();
+        m_pComposePipeline = nullptr;
+    }
 
     if (m_pPipeline != nullptr)
     {
@@ -140,14 +200,57 @@ void HistogramMatcher::OnDestroy()
     }
 }
 
+void HistogramMatcher::DrawComposeLUT(ID3D12GraphicsCommandList* pCommandList)
+{
+    ID3D12DescriptorHeap* pDescriptorHeaps[] = { m_pResourceViewHeaps->GetCBV_SRV_UAVHeap(), m_pResourceViewHeaps->GetSamplerHeap() };
+    pCommandList->SetDescriptorHeaps(2, pDescriptorHeaps);
+
+    pCommandList->SetComputeRootSignature(m_pRootSignature);
+
+    CD3DX12_RESOURCE_BARRIER lutBarrier =
+        CD3DX12_RESOURCE_BARRIER::Transition(
+            m_matchLUT.GetResource(),
+            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    pCommandList->ResourceBarrier(1, &lutBarrier);
+
+    D3D12_GPU_VIRTUAL_ADDRESS composeCbHandle;
+    uint32_t* pComposeConstMem;
+    m_pConstantBufferRing->AllocConstantBuffer(sizeof(ComposeConstants), (void**)&pComposeConstMem, &composeCbHandle);
+    memcpy(pComposeConstMem, &m_composeConstants, sizeof(ComposeConstants));
+
+    pCommandList->SetPipelineState(m_pComposePipeline);
+    pCommandList->SetComputeRootConstantBufferView(0, composeCbHandle);
+    pCommandList->SetComputeRootDescriptorTable(1, m_matchLUTUav.GetGPU());
+    pCommandList->SetComputeRootDescriptorTable(2, m_composeSrvTable.GetGPU());
+    pCommandList->Dispatch((m_composeConstants.binCount + 63) / 64, 1, 1);
+
+    lutBarrier =
+        CD3DX12_RESOURCE_BARRIER::Transition(
+            m_matchLUT.GetResource(),
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    pCommandList->ResourceBarrier(1, &lutBarrier);
+}
+
 void HistogramMatcher::Draw(ID3D12GraphicsCommandList* pCommandList)
 {
-    UserMarker marker(pCommandList, "HistogramEqualization");
+    UserMarker marker(pCommandList, "HistogramMatch");
 
-    bool createInverseLUT = false;
-    m_computeHistogramLUT.Draw(pCommandList, createInverseLUT);
-    createInverseLUT = true;
-    m_computeHistogramInverseLUT.Draw(pCommandList, createInverseLUT);
+    // Neither image changes until the next OnCreate, so both histograms are counted and composed
+    // into the match LUT on the first Draw only, and later Draws are just the gather.
+    if (!m_isMatchLUTReady)
+    {
+        m_computeHistogramLUT.Draw(pCommandList);
+        m_computeHistogramInverseLUT.Draw(pCommandList);
+        DrawComposeLUT(pCommandList);
+        m_isMatchLUTReady = true;
+    }
+
+    ID3D12DescriptorHeap* pDescriptorHeaps[] = { m_pResourceViewHeaps->GetCBV_SRV_UAVHeap(), m_pResourceViewHeaps->GetSamplerHeap() };
+    pCommandList->SetDescriptorHeaps(2, pDescriptorHeaps);
+
+    pCommandList->SetComputeRootSignature(m_pRootSignature);
 
     CD3DX12_RESOURCE_BARRIER barriers[1] = {
         CD3DX12_RESOURCE_BARRIER::Transition(
@@ -159,7 +262,6 @@ void HistogramMatcher::Draw(ID3D12GraphicsCommandList* pCommandList)
     pCommandList->ResourceBarrier(1, barriers);
 
     pCommandList->SetPipelineState(m_pPipeline);
-    pCommandList->SetComputeRootSignature(m_pRootSignature);
 
     D3D12_GPU_VIRTUAL_ADDRESS cbHandle;
     uint32_t* pConstMem;
@@ -168,9 +270,6 @@ void HistogramMatcher::Draw(ID3D12GraphicsCommandList* pCommandList)
 
     memcpy(pConstMem, &m_constants, constantsSize);
 
-    ID3D12DescriptorHeap* pDescriptorHeaps[] = { m_pResourceViewHeaps->GetCBV_SRV_UAVHeap(), m_pResourceViewHeaps->GetSamplerHeap() };
-    pCommandList->SetDescriptorHeaps(2, pDescriptorHeaps);
-
     pCommandList->SetComputeRootConstantBufferView(0, cbHandle);
     pCommandList->SetComputeRootDescriptorTable(1, m_outputUav.GetGPU());
     pCommandList->SetComputeRootDescriptorTable(2, m_inputSrvTable.GetGPU());
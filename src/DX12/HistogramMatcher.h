@@ -13,6 +13,9 @@
 
 namespace CS570
 {
+    // Composes the forward LUT of the input and the inverse LUT of the match image into one LUT of
+    // output values (HistogramComposeLUT.hlsl), so Match is a single gather per pixel. The histograms
+    // are counted and the LUT composed only on the first Draw after OnCreate.
     class HistogramMatcher : public BaseImageProcessor
     {
     public:
@@ -22,7 +25,8 @@ namespace CS570
             CAULDRON_DX12::Device* pDevice,
             CAULDRON_DX12::UploadHeap* pUploadHeap,
             CAULDRON_DX12::ResourceViewHeaps* pResourceViewHeaps,
-            CAULDRON_DX12::DynamicBufferRing* pConstantBufferRing);
+            CAULDRON_DX12::DynamicBufferRing* pConstantBufferRing,
+            uint32_t binCount = ComputeHistogram::k_defaultBinCount);
         void OnDestroy();
 
         void Draw(ID3D12GraphicsCommandList *pCommandList) override;
@@ -32,8 +36,11 @@ namespace CS570
 
     private:
         void CreateOutputResource(CAULDRON_DX12::Texture& input);
+        void CreateMatchLUT(uint32_t binCount);
+        void DrawComposeLUT(ID3D12GraphicsCommandList* pCommandList);
 
         ID3D12RootSignature* m_pRootSignature = nullptr;
+        ID3D12PipelineState* m_pComposePipeline = nullptr;
         ID3D12PipelineState* m_pPipeline = nullptr;
 
         CAULDRON_DX12::Texture m_matchedOutput;
@@ -46,10 +53,21 @@ namespace CS570
 
         Constants m_constants;
 
+        struct ComposeConstants
+        {
+            uint32_t binCount = 0u;
+            uint32_t useLevelTable = 0u;
+            uint32_t padding[2] = {};
+            float levelTable[8] = {};
+        };
+
+        ComposeConstants m_composeConstants;
+
         CAULDRON_DX12::Device* m_pDevice = nullptr;
 
         CAULDRON_DX12::CBV_SRV_UAV m_constBuffer; // dimension
 
+        CAULDRON_DX12::CBV_SRV_UAV m_composeSrvTable;
         CAULDRON_DX12::CBV_SRV_UAV m_inputSrvTable;
         CAULDRON_DX12::CBV_SRV_UAV m_outputUav;
         CAULDRON_DX12::CBV_SRV_UAV m_outputSrv;
@@ -59,5 +77,9 @@ namespace CS570
 
         ComputeHistogram m_computeHistogramLUT;
         ComputeHistogram m_computeHistogramInverseLUT;
+        bool m_isMatchLUTReady = false;
+
+        CAULDRON_DX12::Texture m_matchLUT;
+        CAULDRON_DX12::CBV_SRV_UAV m_matchLUTUav;
     };
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "ImageProcessor.h"
+#include "CpuPixelFormatDxgi.h"
 
 #include "Device.h"
 #include "DynamicBufferRing.h"
@@ -114,9 +115,13 @@ void ImageProcessor::CreateOutputResource(
 {
     uint32_t newWidth = max(input1.GetWidth(), input2.GetWidth());
     uint32_t newHeight = max(input1.GetHeight(), input2.GetHeight());
+    // Inputs of different formats get the widest output.
+    DXGI_FORMAT outputFormat = GetOperationOutputFormat(input1.GetFormat());
+    if (outputFormat != GetOperationOutputFormat(input2.GetFormat()))
+        outputFormat = DXGI_FORMAT_R32G32B32A32_FLOAT;
     CD3DX12_RESOURCE_DESC outputDesc =
         CD3DX12_RESOURCE_DESC::Tex2D(
-            DXGI_FORMAT_R16G16B16A16_FLOAT,
+            outputFormat,
             newWidth, newHeight,
             1, // array size
             1, // mip size
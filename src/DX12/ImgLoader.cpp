@@ -21,6 +21,8 @@
 #include "ImgLoader.h"
 #include "DDSLoader.h"
 #include "WICLoader.h"
+#include "TiledImageLoader.h"
+#include "PPMLoader.h"
 
 
 ImgLoader *CreateImageLoader(const char *pFilename)
@@ -32,10 +34,32 @@ ImgLoader *CreateImageLoader(const char *pFilename)
     {
         return new DDSLoader();
     }
+    else if (_stricmp(ext, ".cti") == 0)
+    {
+        return new CS570::TiledImageLoader();
+    }
+    else if (_stricmp(ext, ".ppm") == 0)
+    {
+        return new CS570::PPMLoader();
+    }
     else
     {
         return new WICLoader();
     }
 }
 
+bool ImgLoader::LoadInto(const char *pFilename, ImgDestination *pDestination, IMG_INFO *pInfo)
+{
+    if (!Load(pFilename, 1.0f, pInfo) || pInfo->depth > 1 || pInfo->arraySize > 1)
+        return false;
+    pInfo->mipMapCount = 1;
+
+    uint32_t rowPitch = 0;
+    void *pPixels = pDestination->GetPixels(*pInfo, &rowPitch);
+    if (pPixels == nullptr)
+        return false;
 
+    // block compressed formats are rejected by the destinations, so a row is width pixels
+    CopyPixels(pPixels, rowPitch, pInfo->width * pInfo->bitCount / 8, pInfo->height);
+    return true;
+}
@@ -31,6 +31,17 @@ struct IMG_INFO
     UINT32           bitCount;
 };
 
+// Memory a loader decodes into, e.g. an upload heap allocation or a host image
+
+class ImgDestination
+{
+public:
+    virtual ~ImgDestination() {};
+    // returns rows of the top mip level of the image described by info, *pRowPitch bytes apart, or
+    // nullptr if the destination can't hold the format
+    virtual void *GetPixels(const IMG_INFO &info, uint32_t *pRowPitch) = 0;
+};
+
 //Loads a Image file
 
 class ImgLoader
@@ -40,6 +51,9 @@ public:
     virtual bool Load(const char *pFilename, float cutOff, IMG_INFO *pInfo) = 0;
     // after calling Load, calls to CopyPixels return each time a lower mip level 
     virtual void CopyPixels(void *pDest, uint32_t stride, uint32_t width, uint32_t height) = 0;
+
+    // loads the top mip level straight into the memory pDestination hands out, with no intermediate copy
+    bool LoadInto(const char *pFilename, ImgDestination *pDestination, IMG_INFO *pInfo);
 };
 
 
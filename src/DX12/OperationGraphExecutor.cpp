@@ -0,0 +1,527 @@
+#include "OperationGraphExecutor.h"
+#include "CpuPixelFormatDxgi.h"
+
+#include "Device.h"
+#include "DynamicBufferRing.h"
+#include "Error.h"
+#include "Helper.h"
+#include "ShaderCompiler.h"
+#include "ShaderCompilerHelper.h"
+#include "StaticBufferPool.h"
+#include "UploadHeap.h"
+#include "UserMarkers.h"
+#include "Texture.h"
+
+#include "../CPU/CpuGaussianKernelCache.h"
+
+#include "stdafx.h"
+
+#include <cstdio>
+
+using namespace CS570;
+using namespace CAULDRON_DX12;
+
+// Exact bit pattern of value, so the generated shader uses the same constants as the CPU path.
+static std::string FloatLiteral(float value)
+{
+    uint32_t bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    char literal[32];
+    snprintf(literal, sizeof(literal), "asfloat(0x%08Xu)", bits);
+    return literal;
+}
+
+static std::string NodeValue(uint32_t node)
+{
+    return "v" + std::to_string(node);
+}
+
+static void GenerateNeighborhoodPrologue(
+    const OperationGraph& graph, uint32_t node, uint32_t sourceSlot, std::string* pDeclarations, std::string* pBody)
+{
+    const OperationNode& current = graph.GetNode(node);
+    const std::string suffix = std::to_string(node);
+    const std::string source = "sourceTex" + std::to_string(sourceSlot);
+    const uint32_t halfSize = current.type == OperationType::GaussianBlur ? current.blurKernelSize >> 1 : 1u;
+    const std::string cacheSize = std::to_string(8u + 2u * halfSize);
+
+    *pDeclarations += "groupshared float s_redCache" + suffix + "[" + cacheSize + " * " + cacheSize + "];\n";
+    *pBody +=
+        "    {\n"
+        "        int2 cacheOrigin = int2(groupId.xy * TILE_SIZE) - " + std::to_string(halfSize) + ";\n"
+        "        [loop]\n"
+        "        for (uint index = groupIndex; index < " + cacheSize + " * " + cacheSize + "; index += TILE_SIZE * TILE_SIZE)\n"
+        "        {\n"
+        "            int2 loadXY = cacheOrigin + int2(index % " + cacheSize + ", index / " + cacheSize + ");\n"
+        "            s_redCache" + suffix + "[index] = " + source + ".Load(int3(loadXY, 0)).r;\n"
+        "        }\n"
+        "    }\n"
+        "    GroupMemoryBarrierWithGroupSync();\n";
+
+    if (current.type != OperationType::GaussianBlur)
+        return;
+
+    GaussianKernelPtr pWeights = GetGaussianKernel(current.blurKernelSize, current.blurVariance, true, GaussianKernelShape::Separable);
+    *pDeclarations += "static const float g_weights" + suffix + "[" + std::to_string(current.blurKernelSize) + "] = {";
+    for (size_t tap = 0; tap < pWeights->size(); ++tap)
+        *pDeclarations += (tap == 0 ? " " : ", ") + FloatLiteral((*pWeights)[tap]);
+    *pDeclarations += " };\n";
+    *pDeclarations += "groupshared float s_horizontalPass" + suffix + "[" + cacheSize + " * TILE_SIZE];\n";
+
+    *pBody +=
+        "    [loop]\n"
+        "    for (uint index" + suffix + " = groupIndex; index" + suffix + " < " + cacheSize + " * TILE_SIZE; index" + suffix + " += TILE_SIZE * TILE_SIZE)\n"
+        "    {\n"
+        "        uint row = index" + suffix + " / TILE_SIZE;\n"
+        "        uint col = index" + suffix + " % TILE_SIZE;\n"
+        "        float blurred = 0.0f;\n"
+        "        [loop]\n"
+        "        for (uint tap = 0; tap < " + std::to_string(current.blurKernelSize) + "; ++tap)\n"
+        "            blurred += s_redCache" + suffix + "[row * " + cacheSize + " + col + tap] * g_weights" + suffix + "[tap];\n"
+        "        s_horizontalPass" + suffix + "[index" + suffix + "] = blurred;\n"
+        "    }\n"
+        "    GroupMemoryBarrierWithGroupSync();\n";
+}
+
+static void GenerateNodeEvaluation(const OperationGraph& graph, uint32_t node, std::string* pBody)
+{
+    const OperationNode& current = graph.GetNode(node);
+    const std::string suffix = std::to_string(node);
+    const std::string value = NodeValue(node);
+    const std::string input1 = current.inputs[0] != OperationNode::k_invalidNode ? NodeValue(current.inputs[0]) : "";
+    const std::string input2 = current.inputs[1] != OperationNode::k_invalidNode ? NodeValue(current.inputs[1]) : "";
+    const std::string weight1 = FloatLiteral(current.constants.weightInput1);
+    const std::string weight2 = FloatLiteral(current.constants.weightInput2);
+
+    // Same expressions as the ImageProcessor.hlsl entry points.
+    switch (current.type)
+    {
+    case OperationType::Add:
+        *pBody += "    float4 " + value + " = " + input1 + " * " + weight1 + " + " + input2 + " * " + weight2 + ";\n";
+        break;
+    case OperationType::Subtract:
+        *pBody += "    float4 " + value + " = " + input1 + " * " + weight1 + " - " + input2 + " * " + weight2 + ";\n";
+        break;
+    case OperationType::Product:
+        *pBody += "    float4 " + value + " = (" + input1 + " * " + weight1 + ") * (" + input2 + " * " + weight2 + ");\n";
+        break;
+    case OperationType::Negative:
+        *pBody += "    float4 " + value + " = 1.0f - " + input1 + ";\n";
+        break;
+    case OperationType::Log:
+        *pBody += "    float4 " + value + " = " + FloatLiteral(current.constants.logConstant) + " * log(1.0f + " + input1 + ");\n";
+        break;
+    case OperationType::Power:
+        *pBody += "    float4 " + value + " = " + FloatLiteral(current.constants.powerConstant) +
+            " * pow(" + input1 + " + 0.001f, " + FloatLiteral(current.constants.powerRaise) + ");\n";
+        break;
+    case OperationType::GaussianBlur:
+        *pBody +=
+            "    float blurred" + suffix + " = 0.0f;\n"
+            "    [loop]\n"
+            "    for (uint tap" + suffix + " = 0; tap" + suffix + " < " + std::to_string(current.blurKernelSize) + "; ++tap" + suffix + ")\n"
+            "        blurred" + suffix + " += s_horizontalPass" + suffix + "[(groupThreadId.y + tap" + suffix + ") * TILE_SIZE + groupThreadId.x] * g_weights" + suffix + "[tap" + suffix + "];\n"
+            "    float4 " + value + " = float4(blurred" + suffix + ", blurred" + suffix + ", blurred" + suffix + ", 1.0f);\n";
+        break;
+    case OperationType::SobelFilter:
+    {
+        const std::string cache = "s_redCache" + suffix;
+        auto tap = [&](int dx, int dy) {
+            return cache + "[(groupThreadId.y + " + std::to_string(1 + dy) + ") * (TILE_SIZE + 2) + groupThreadId.x + " + std::to_string(1 + dx) + "]";
+        };
+        *pBody +=
+            "    float horiz" + suffix + " = (" + tap(1, -1) + " - " + tap(-1, -1) + ") + 2.0f * (" + tap(1, 0) + " - " + tap(-1, 0) +
+            ") + (" + tap(1, 1) + " - " + tap(-1, 1) + ");\n"
+            "    float vert" + suffix + " = (" + tap(-1, -1) + " + 2.0f * " + tap(0, -1) + " + " + tap(1, -1) + ") - (" +
+            tap(-1, 1) + " + 2.0f * " + tap(0, 1) + " + " + tap(1, 1) + ");\n"
+            "    float magnitude" + suffix + " = sqrt((horiz" + suffix + " * horiz" + suffix + ") + (vert" + suffix + " * vert" + suffix + "));\n"
+            "    float4 " + value + " = float4(magnitude" + suffix + ", magnitude" + suffix + ", magnitude" + suffix + ", 1.0f);\n";
+        break;
+    }
+    default:
+        assert(false);
+        break;
+    }
+}
+
+// One compute shader for the whole stage. Every thread takes part in filling the groupshared caches
+// before the out of bounds threads return, as in UnsharpMask.hlsl. Stages ending in a neighborhood
+// node write a single grey channel, like GaussianBlur.hlsl and SobelFilter.hlsl.
+static std::string GenerateStageShader(const OperationGraph& graph, const FusedStage& stage)
+{
+    const bool isGreyOutput = IsNeighborhoodOperation(graph.GetNode(stage.GetOutputNode()).type);
+    std::string declarations =
+        "cbuffer Constants : register(b0)\n"
+        "{\n"
+        "    uint2 g_outputSize;\n"
+        "}\n"
+        "\n"
+        "RWTexture2D<" + std::string(isGreyOutput ? "float" : "float4") + "> outputTex : register(u0);\n"
+        "SamplerState inputSampler : register(s0);\n"
+        "\n"
+        "#define TILE_SIZE 8\n";
+    for (size_t slot = 0; slot < stage.sources.size(); ++slot)
+        declarations += "Texture2D sourceTex" + std::to_string(slot) + " : register(t" + std::to_string(slot) + ");\n";
+
+    std::string prologue;
+    std::string body =
+        "    float2 inputUV = (float2(dispatchId.xy) / float2(g_outputSize.xy));\n";
+    for (size_t slot = 0; slot < stage.sources.size(); ++slot)
+    {
+        body += "    float4 " + NodeValue(stage.sources[slot]) + " = sourceTex" + std::to_string(slot) +
+            ".SampleLevel(inputSampler, inputUV, 0);\n";
+    }
+
+    for (uint32_t node : stage.nodes)
+    {
+        const OperationNode& current = graph.GetNode(node);
+        if (IsNeighborhoodOperation(current.type))
+        {
+            size_t sourceSlot = std::find(stage.sources.begin(), stage.sources.end(), current.inputs[0]) - stage.sources.begin();
+            GenerateNeighborhoodPrologue(graph, node, static_cast<uint32_t>(sourceSlot), &declarations, &prologue);
+        }
+        GenerateNodeEvaluation(graph, node, &body);
+    }
+
+    return declarations +
+        "\n"
+        "[numthreads(TILE_SIZE, TILE_SIZE, 1)]\n"
+        "void Stage(uint3 dispatchId : SV_DispatchThreadID, uint3 groupId : SV_GroupID, uint3 groupThreadId : SV_GroupThreadID, uint groupIndex : SV_GroupIndex)\n"
+        "{\n" +
+        prologue +
+        "\n"
+        "    if (dispatchId.x >= g_outputSize.x || dispatchId.y >= g_outputSize.y)\n"
+        "        return;\n"
+        "\n" +
+        body +
+        "\n"
+        "    outputTex[dispatchId.xy] = " + NodeValue(stage.GetOutputNode()) + (isGreyOutput ? ".r" : "") + ";\n"
+        "}\n";
+}
+
+// Format of the image of every node, picked from the formats of its inputs the way the standalone
+// operations pick their output formats, so a stage output matches the output of its last node run
+// on its own. Nodes only reference earlier nodes, so one pass in order is enough.
+static std::vector<DXGI_FORMAT> GetNodeFormats(const OperationGraph& graph, const std::vector<Texture*>& inputs)
+{
+    std::vector<DXGI_FORMAT> formats(graph.GetNodeCount());
+    for (uint32_t node = 0; node < graph.GetNodeCount(); ++node)
+    {
+        const OperationNode& current = graph.GetNode(node);
+        if (current.type == OperationType::Input)
+        {
+            formats[node] = inputs[current.imageIndex]->GetFormat();
+        }
+        else if (IsNeighborhoodOperation(current.type))
+        {
+            formats[node] = GetGreyOperationOutputFormat(formats[current.inputs[0]]);
+        }
+        else
+        {
+            // Inputs of different formats get the widest output, as in ImageProcessor.
+            formats[node] = GetOperationOutputFormat(formats[current.inputs[0]]);
+            if (current.inputs[1] != OperationNode::k_invalidNode && formats[node] != GetOperationOutputFormat(formats[current.inputs[1]]))
+                formats[node] = DXGI_FORMAT_R32G32B32A32_FLOAT;
+        }
+    }
+    return formats;
+}
+
+static CD3DX12_RESOURCE_DESC GetStageOutputDesc(const OperationNode& output, DXGI_FORMAT format)
+{
+    return CD3DX12_RESOURCE_DESC::Tex2D(
+        format,
+        output.width, output.height,
+        1, // array size
+        1, // mip size
+        1, // sample count
+        0, // sample quality
+        D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+}
+
+void OperationGraphExecutor::OnCreate(
+    const OperationGraph& graph,
+    const std::vector<Texture*>& inputs,
+    Device* pDevice,
+    UploadHeap* pUploadHeap,
+    ResourceViewHeaps* pResourceViewHeaps,
+    DynamicBufferRing* pConstantBufferRing)
+{
+    if (inputs.size() != graph.GetInputCount())
+        throw "OperationGraph input count mismatch.";
+
+    m_pDevice = pDevice;
+    m_pResourceViewHeaps = pResourceViewHeaps;
+    m_pConstantBufferRing = pConstantBufferRing;
+
+    m_graph = graph;
+    m_inputs = inputs;
+
+    std::vector<FusedStage> fusedStages = graph.Fuse();
+    const std::vector<DXGI_FORMAT> nodeFormats = GetNodeFormats(graph, inputs);
+    m_stages.clear();
+    m_stages.resize(fusedStages.size());
+
+    // Stages run one after another, so a stage output is live from its stage to the last stage
+    // reading it. Graph outputs outlive Draw and keep their own allocations.
+    std::vector<uint32_t> producerStage(graph.GetNodeCount(), OperationNode::k_invalidNode);
+    std::vector<TransientBuffer> transients;
+    std::vector<size_t> transientStages;
+    for (size_t stageIndex = 0; stageIndex < fusedStages.size(); ++stageIndex)
+    {
+        for (uint32_t source : fusedStages[stageIndex].sources)
+        {
+            if (producerStage[source] != OperationNode::k_invalidNode)
+                transients[producerStage[source]].lastUse = static_cast<uint32_t>(stageIndex);
+        }
+
+        uint32_t outputNode = fusedStages[stageIndex].GetOutputNode();
+        const std::vector<uint32_t>& graphOutputs = graph.GetOutputs();
+        if (std::find(graphOutputs.begin(), graphOutputs.end(), outputNode) != graphOutputs.end())
+            continue;
+
+        CD3DX12_RESOURCE_DESC outputDesc = GetStageOutputDesc(graph.GetNode(outputNode), nodeFormats[outputNode]);
+        D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = pDevice->GetDevice()->GetResourceAllocationInfo(0, 1, &outputDesc);
+
+        TransientBuffer transient;
+        transient.size = static_cast<size_t>(allocationInfo.SizeInBytes);
+        transient.firstUse = static_cast<uint32_t>(stageIndex);
+        transient.lastUse = static_cast<uint32_t>(stageIndex);
+        producerStage[outputNode] = static_cast<uint32_t>(transients.size());
+        transients.push_back(transient);
+        transientStages.push_back(stageIndex);
+    }
+
+    m_memoryPlan = PlanTransientMemory(transients, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+    if (m_memoryPlan.arenaSize > 0)
+    {
+        CD3DX12_HEAP_DESC heapDesc(
+            m_memoryPlan.arenaSize,
+            D3D12_HEAP_TYPE_DEFAULT,
+            D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
+            D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES);
+        ThrowIfFailed(pDevice->GetDevice()->CreateHeap(&heapDesc, IID_PPV_ARGS(&m_pTransientHeap)));
+        CAULDRON_DX12::SetName(m_pTransientHeap, "OperationGraphExecutor::TransientHeap");
+    }
+    for (size_t transient = 0; transient < transientStages.size(); ++transient)
+        m_stages[transientStages[transient]].isTransient = true;
+    for (size_t stageIndex = 0; stageIndex < fusedStages.size(); ++stageIndex)
+    {
+        const FusedStage& fusedStage = fusedStages[stageIndex];
+        Stage& stage = m_stages[stageIndex];
+        const OperationNode& output = graph.GetNode(fusedStage.GetOutputNode());
+        stage.outputNode = fusedStage.GetOutputNode();
+        stage.outputWidth = output.width;
+        stage.outputHeight = output.height;
+
+        for (uint32_t node : fusedStage.nodes)
+        {
+            const OperationNode& current = graph.GetNode(node);
+            if (current.type == OperationType::GaussianBlur && current.blurKernelSize > k_maxKernelSize)
+                throw "OperationGraph blur kernel size is too large.";
+        }
+
+        CreateRootSignature(static_cast<uint32_t>(fusedStage.sources.size()), &stage);
+
+        std::string shaderCode = GenerateStageShader(graph, fusedStage);
+        D3D12_SHADER_BYTECODE shaderByteCode = {};
+        DefineList defines;
+        CAULDRON_DX12::CompileShaderFromString(
+            shaderCode.c_str(),
+            &defines,
+            "Stage",
+            "-T cs_6_0 /Zi /Zss -Od -Qembed_debug",
+            &shaderByteCode);
+
+        D3D12_COMPUTE_PIPELINE_STATE_DESC descPso = {};
+        descPso.CS = shaderByteCode;
+        descPso.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
+        descPso.pRootSignature = stage.pRootSignature;
+        descPso.NodeMask = 0;
+
+        ThrowIfFailed(pDevice->GetDevice()->CreateComputePipelineState(&descPso, IID_PPV_ARGS(&stage.pPipeline)));
+
+        CD3DX12_RESOURCE_DESC outputDesc = GetStageOutputDesc(output, nodeFormats[fusedStage.GetOutputNode()]);
+
+        stage.pOutput.reset(new Texture());
+        if (stage.isTransient)
+        {
+            size_t transient = std::find(transientStages.begin(), transientStages.end(), stageIndex) - transientStages.begin();
+            stage.pOutput->InitPlaced(
+                m_pDevice,
+                "OperationGraphIntermediate",
+                &outputDesc,
+                m_pTransientHeap,
+                m_memoryPlan.offsets[transient],
+                D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        }
+        else
+        {
+            stage.pOutput->InitRenderTarget(m_pDevice, "OperationGraphOutput", &outputDesc, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        }
+
+        m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &stage.outputUav);
+        stage.pOutput->CreateUAV(0, &stage.outputUav);
+
+        m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &stage.outputSrv);
+        stage.pOutput->CreateSRV(0, &stage.outputSrv);
+
+        // Stages run in order, so every source is either an input or the output of an earlier stage.
+        m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(static_cast<uint32_t>(fusedStage.sources.size()), &stage.sourceSrvTable);
+        for (size_t slot = 0; slot < fusedStage.sources.size(); ++slot)
+            GetNodeTexture(fusedStage.sources[slot]).CreateSRV(static_cast<uint32_t>(slot), &stage.sourceSrvTable);
+
+        if (stage.outputNode == graph.GetOutputs().front())
+            m_outputStage = stageIndex;
+    }
+}
+
+void OperationGraphExecutor::CreateRootSignature(uint32_t sourceCount, Stage* pStage)
+{
+    int parameterCount = 0;
+    CD3DX12_ROOT_PARAMETER rtSlot[3];
+
+    rtSlot[parameterCount++].InitAsConstantBufferView(0, 0, D3D12_SHADER_VISIBILITY_ALL);
+
+    CD3DX12_DESCRIPTOR_RANGE uavDescRange = {};
+    uavDescRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0);
+    rtSlot[parameterCount++].InitAsDescriptorTable(1, &uavDescRange, D3D12_SHADER_VISIBILITY_ALL);
+
+    CD3DX12_DESCRIPTOR_RANGE srvDescRange = {};
+    srvDescRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, sourceCount, 0);
+    rtSlot[parameterCount++].InitAsDescriptorTable(1, &srvDescRange, D3D12_SHADER_VISIBILITY_ALL);
+
+    CD3DX12_ROOT_SIGNATURE_DESC descRootSignature = CD3DX12_ROOT_SIGNATURE_DESC();
+    descRootSignature.NumParameters = parameterCount;
+    descRootSignature.pParameters = rtSlot;
+
+    D3D12_STATIC_SAMPLER_DESC nearestSampler = {};
+    nearestSampler.Filter = D3D12_FILTER_MIN_MAG_MIP_POINT;
+    nearestSampler.AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+    nearestSampler.AddressV = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+    nearestSampler.AddressW = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+    nearestSampler.ComparisonFunc = D3D12_COMPARISON_FUNC_ALWAYS;
+    nearestSampler.BorderColor = D3D12_STATIC_BORDER_COLOR_TRANSPARENT_BLACK;
+    nearestSampler.MinLOD = 0.0f;
+    nearestSampler.MaxLOD = D3D12_FLOAT32_MAX;
+    nearestSampler.MipLODBias = 0;
+    nearestSampler.MaxAnisotropy = 1;
+    nearestSampler.ShaderRegister = 0;
+    nearestSampler.RegisterSpace = 0;
+    nearestSampler.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+    descRootSignature.NumStaticSamplers = 1;
+    descRootSignature.pStaticSamplers = &nearestSampler;
+
+    descRootSignature.Flags = D3D12_ROOT_SIGNATURE_FLAG_NONE;
+
+    ID3DBlob* pOutBlob = nullptr;
+    ID3DBlob* pErrorBlob = nullptr;
+
+    ThrowIfFailed(D3D12SerializeRootSignature(
+        &descRootSignature, D3D_ROOT_SIGNATURE_VERSION_1, &pOutBlob, &pErrorBlob));
+    ThrowIfFailed(
+        m_pDevice->GetDevice()->CreateRootSignature(
+            0, pOutBlob->GetBufferPointer(), pOutBlob->GetBufferSize(), IID_PPV_ARGS(&pStage->pRootSignature))
+    );
+    CAULDRON_DX12::SetName(pStage->pRootSignature, std::string("OperationGraphExecutor::Stage") + std::to_string(pStage->outputNode));
+
+    pOutBlob->Release();
+    if (pErrorBlob)
+        pErrorBlob->Release();
+}
+
+Texture& OperationGraphExecutor::GetNodeTexture(uint32_t node)
+{
+    const OperationNode& current = m_graph.GetNode(node);
+    if (current.type == OperationType::Input)
+        return *m_inputs[current.imageIndex];
+
+    for (Stage& stage : m_stages)
+    {
+        if (stage.outputNode == node && stage.pOutput)
+            return *stage.pOutput;
+    }
+
+    throw "OperationGraph node has no texture.";
+}
+
+void OperationGraphExecutor::OnDestroy()
+{
+    for (Stage& stage : m_stages)
+    {
+        if (stage.pOutput)
+            stage.pOutput->OnDestroy();
+
+        if (stage.pPipeline != nullptr)
+        {
+            stage.pPipeline->Release();
+            stage.pPipeline = nullptr;
+        }
+
+        if (stage.pRootSignature != nullptr)
+        {
+            stage.pRootSignature->Release();
+            stage.pRootSignature = nullptr;
+        }
+    }
+    m_stages.clear();
+    m_inputs.clear();
+
+    if (m_pTransientHeap != nullptr)
+    {
+        m_pTransientHeap->Release();
+        m_pTransientHeap = nullptr;
+    }
+    m_memoryPlan = MemoryPlan();
+}
+
+void OperationGraphExecutor::Draw(ID3D12GraphicsCommandList* pCommandList)
+{
+    UserMarker marker(pCommandList, "OperationGraph");
+
+    ID3D12DescriptorHeap* pDescriptorHeaps[] = { m_pResourceViewHeaps->GetCBV_SRV_UAVHeap(), m_pResourceViewHeaps->GetSamplerHeap() };
+    pCommandList->SetDescriptorHeaps(2, pDescriptorHeaps);
+
+    for (Stage& stage : m_stages)
+    {
+        // The stage overwrites every texel, so whatever aliased a transient output before is discarded.
+        CD3DX12_RESOURCE_BARRIER barriers[2] = {
+            CD3DX12_RESOURCE_BARRIER::Aliasing(nullptr, stage.pOutput->GetResource()),
+            CD3DX12_RESOURCE_BARRIER::Transition(
+                stage.pOutput->GetResource(),
+                D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+                D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+        };
+
+        uint32_t firstBarrier = stage.isTransient ? 0u : 1u;
+        pCommandList->ResourceBarrier(2 - firstBarrier, barriers + firstBarrier);
+
+        pCommandList->SetPipelineState(stage.pPipeline);
+        pCommandList->SetComputeRootSignature(stage.pRootSignature);
+
+        D3D12_GPU_VIRTUAL_ADDRESS cbHandle;
+        uint32_t* pConstMem;
+        uint32_t constantsSize = 2 * sizeof(uint32_t);
+        m_pConstantBufferRing->AllocConstantBuffer(constantsSize, (void**)&pConstMem, &cbHandle);
+        pConstMem[0] = stage.outputWidth;
+        pConstMem[1] = stage.outputHeight;
+
+        pCommandList->SetComputeRootConstantBufferView(0, cbHandle);
+        pCommandList->SetComputeRootDescriptorTable(1, stage.outputUav.GetGPU());
+        pCommandList->SetComputeRootDescriptorTable(2, stage.sourceSrvTable.GetGPU());
+
+        uint32_t dispatchX = (stage.outputWidth + 7) / 8;
+        uint32_t dispatchY = (stage.outputHeight + 7) / 8;
+        uint32_t dispatchZ = 1;
+        pCommandList->Dispatch(dispatchX, dispatchY, dispatchZ);
+
+        barriers[0] =
+            CD3DX12_RESOURCE_BARRIER::Transition(
+                stage.pOutput->GetResource(),
+                D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+                D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+        pCommandList->ResourceBarrier(1, barriers);
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "ImageProcessor.h"
+
+#include "Device.h"
+#include "DynamicBufferRing.h"
+#include "ResourceViewHeaps.h"
+#include "Texture.h"
+#include "UploadHeap.h"
+
+#include "../CPU/MemoryPlanner.h"
+#include "../CPU/OperationGraph.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace CS570
+{
+    // GPU counterpart of CpuOperationGraphExecutor. Every fused stage of the graph is compiled into
+    // its own compute shader: neighborhood nodes fill groupshared caches the way UnsharpMask.hlsl and
+    // SobelFilter.hlsl do, then each thread evaluates the rest of the stage in registers, so a stage
+    // is one dispatch and one output no matter how many nodes it holds. The output has the format
+    // the standalone operation of the stage's last node would write for the same inputs.
+    //
+    // Node constants and blur weights are compiled into the shaders as literals; build a new
+    // executor to change them.
+    //
+    // Stage outputs that aren't graph outputs are placed in one heap laid out by
+    // PlanTransientMemory, so intermediates of stages that are never live together alias.
+    class OperationGraphExecutor : public BaseImageProcessor
+    {
+    public:
+        // inputs[i] is bound to the graph input with imageIndex i.
+        void OnCreate(
+            const OperationGraph& graph,
+            const std::vector<CAULDRON_DX12::Texture*>& inputs,
+            CAULDRON_DX12::Device* pDevice,
+            CAULDRON_DX12::UploadHeap* pUploadHeap,
+            CAULDRON_DX12::ResourceViewHeaps* pResourceViewHeaps,
+            CAULDRON_DX12::DynamicBufferRing* pConstantBufferRing);
+        void OnDestroy();
+
+        void Draw(ID3D12GraphicsCommandList* pCommandList) override;
+
+        // The first graph output.
+        CAULDRON_DX12::CBV_SRV_UAV& GetOutputSrv() override { return m_stages[m_outputStage].outputSrv; }
+        CAULDRON_DX12::Texture& GetOutputResource() override { return *m_stages[m_outputStage].pOutput; }
+
+        // Placement of the intermediate stage outputs in the shared heap.
+        const MemoryPlan& GetMemoryPlan() const { return m_memoryPlan; }
+
+        static const uint32_t k_maxKernelSize = 32;
+
+    private:
+        struct Stage
+        {
+            uint32_t outputNode = 0u;
+            uint32_t outputWidth = 0u;
+            uint32_t outputHeight = 0u;
+
+            ID3D12RootSignature* pRootSignature = nullptr;
+            ID3D12PipelineState* pPipeline = nullptr;
+
+            std::unique_ptr<CAULDRON_DX12::Texture> pOutput;
+            // Placed in m_pTransientHeap, where it may alias the outputs of earlier stages.
+            bool isTransient = false;
+
+            CAULDRON_DX12::CBV_SRV_UAV sourceSrvTable;
+            CAULDRON_DX12::CBV_SRV_UAV outputUav;
+            CAULDRON_DX12::CBV_SRV_UAV outputSrv;
+        };
+
+        void CreateRootSignature(uint32_t sourceCount, Stage* pStage);
+        CAULDRON_DX12::Texture& GetNodeTexture(uint32_t node);
+
+        OperationGraph m_graph;
+        std::vector<CAULDRON_DX12::Texture*> m_inputs;
+        std::vector<Stage> m_stages;
+        size_t m_outputStage = 0;
+
+        ID3D12Heap* m_pTransientHeap = nullptr;
+        MemoryPlan m_memoryPlan;
+
+        CAULDRON_DX12::Device* m_pDevice = nullptr;
+        CAULDRON_DX12::ResourceViewHeaps* m_pResourceViewHeaps = nullptr;
+        CAULDRON_DX12::DynamicBufferRing* m_pConstantBufferRing = nullptr;
+    };
+}
@@ -0,0 +1,45 @@
+#include "PPMLoader.h"
+#include "CpuPixelFormatDxgi.h"
+
+#include "Misc.h"
+
+#include "stdafx.h"
+
+using namespace CS570;
+
+bool PPMLoader::Load(const char* pFilename, float cutOff, IMG_INFO* pInfo)
+{
+    try
+    {
+        // The whole file is uploaded, so grey P6 files are checked for too.
+        m_reader.Open(pFilename, true);
+    }
+    catch (const char* pError)
+    {
+        Trace(format("%s: %s\n", pFilename, pError));
+        return false;
+    }
+
+    pInfo->width = m_reader.GetWidth();
+    pInfo->height = m_reader.GetHeight();
+    pInfo->depth = 1u;
+    pInfo->arraySize = 1u;
+    pInfo->mipMapCount = 1u;
+    // Grey files stay single channel; their SRVs read them as (g, g, g, 1).
+    pInfo->format = GetDxgiFormat(m_reader.GetFormat());
+    pInfo->bitCount = GetPixelSize(m_reader.GetFormat()) * 8;
+    return true;
+}
+
+void PPMLoader::CopyPixels(void* pDest, uint32_t stride, uint32_t width, uint32_t height)
+{
+    assert(height == m_reader.GetHeight() && width == m_reader.GetWidth() * GetPixelSize(m_reader.GetFormat()));
+    try
+    {
+        m_reader.ReadRows(0, height, static_cast<uint8_t*>(pDest), stride);
+    }
+    catch (const char* pError)
+    {
+        Trace(format("Failed to read ppm pixels: %s\n", pError));
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "ImgLoader.h"
+
+#include "../CPU/CpuPPM.h"
+
+namespace CS570
+{
+    // Loads a ppm file in the format CpuPPMReader picks, a single channel for grey files, decoding it
+    // straight out of the mapped file into the memory CopyPixels is given, e.g. the upload heap, with
+    // no host copy of the image.
+    class PPMLoader : public ImgLoader
+    {
+    public:
+        bool Load(const char* pFilename, float cutOff, IMG_INFO* pInfo) override;
+        // ppm files have a single mip level
+        void CopyPixels(void* pDest, uint32_t stride, uint32_t width, uint32_t height) override;
+
+    private:
+        CpuPPMReader m_reader;
+    };
+}
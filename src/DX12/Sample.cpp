@@ -7,6 +7,7 @@
 #include "ImGuiHelper.h"
 #include "Misc.h"
 #include "ShaderCompilerHelper.h"
+#include "TiledImageLoader.h"
 
 #define _SILENCE_EXPERIMENTAL_FILESYSTEM_DEPRECATION_WARNING
 #include <experimental/filesystem>
@@ -31,6 +32,8 @@ static inline void SetWindowClientSize(HWND hWnd, LONG width, LONG height)
 
 const bool VALIDATION_ENABLED = false;
 
+static const char k_defaultRecipe[] = "blur = Gaussian Blur(input1); edges = Sobel Filter(input1); out = Add(blur, edges)";
+
 Sample::Sample(LPCSTR name) : FrameworkWindows(name)
 {
     m_lastFrameTime = MillisecondsNow();
@@ -58,6 +61,7 @@ void Sample::OnParseCommandLine(LPSTR lpCmdLine, uint32_t* pWidth, uint32_t* pHe
         *pbFullScreen = jData.value("fullScreen", *pbFullScreen);
         m_isCpuValidationLayerEnabled = jData.value("CpuValidationLayerEnabled", m_isCpuValidationLayerEnabled);
         m_isGpuValidationLayerEnabled = jData.value("GpuValidationLayerEnabled", m_isGpuValidationLayerEnabled);
+        m_backend = jData.value("backend", m_backend);
 #ifdef FFX_CACAO_ENABLE_PROFILING
         m_isBenchmarking = jData.value("benchmark", m_isBenchmarking);
 #endif
@@ -97,11 +101,26 @@ void Sample::OnCreate(HWND hWnd)
     if ((dwAttrib != INVALID_FILE_ATTRIBUTES) && ((dwAttrib & FILE_ATTRIBUTE_DIRECTORY)) != 0)
     {
         std::string path = "./media";
+
+        // Other image files are converted once to tiled images next to them, which are listed instead.
+        for (const auto& entry: std::experimental::filesystem::directory_iterator(path))
+        {
+            std::string extension = entry.path().extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), ::toupper);
+            if (extension == ".PNG" || extension == ".JPG" || extension == ".JPEG" || extension == ".DDS")
+            {
+                std::experimental::filesystem::path tiledFile = entry.path();
+                tiledFile.replace_extension(".cti");
+                if (!std::experimental::filesystem::exists(tiledFile))
+                    ConvertToTiledImage(entry.path().string().c_str(), tiledFile.string());
+            }
+        }
+
         for (const auto& entry: std::experimental::filesystem::directory_iterator(path))
         {
             std::string extension = entry.path().extension().string();
             std::transform(extension.begin(), extension.end(), extension.begin(), ::toupper);
-            if (extension == ".PPM")
+            if (extension == ".PPM" || extension == ".CTI")
                 m_mediaFiles.push_back(entry.path().string());
         }
     }
@@ -128,14 +147,17 @@ void Sample::OnCreate(HWND hWnd)
 
     ImGUI_Init((void *)hWnd);
 
-    m_currentOperation = 10;
+    m_currentOperation = 11;
     std::string operations[] = {
         "Add", "Subtract", "Product",
         "Negative", "Log", "Power",
         "Histogram Equalization", "Histogram Match",
+        "Adaptive Histogram Equalization",
         "Gaussian Blur",
         "Sobel Filter",
-        "Unsharp Mask"
+        "Unsharp Mask",
+        "Fourier Transform",
+        "Recipe"
     };
     m_operations.insert(m_operations.end(), operations, &operations[sizeof(operations) / sizeof(operations[0])]);
     m_currentInput1 = 0;
@@ -143,6 +165,8 @@ void Sample::OnCreate(HWND hWnd)
     m_currentInput2 = std::min(m_currentInput1 + 1, static_cast<int32_t>(m_mediaFiles.size() - 1));
     std::string inputImage2 = m_mediaFiles[m_currentInput2];
     m_node->OnCreate(&m_device, inputImage1, inputImage2, m_operations[m_currentOperation], &m_swapChain);
+    m_node->SetBackend(m_backend);
+    m_node->SetRecipe(k_defaultRecipe);
 }
 
 //--------------------------------------------------------------------------------------
@@ -295,6 +319,14 @@ void Sample::BuildUI()
         if (ImGui::Combo("Display Filter", &currentFilter, filters))
             m_node->SetDisplayFilter(currentFilter == 0 ? D3D12_FILTER_MIN_MAG_LINEAR_MIP_POINT : D3D12_FILTER_MIN_MAG_MIP_POINT);
 
+        int currentBackend = m_backend == "CPU" ? 1 : 0;
+        const char* backends = "GPU\0CPU\0";
+        if (ImGui::Combo("Backend", &currentBackend, backends))
+        {
+            m_backend = currentBackend == 0 ? "GPU" : "CPU";
+            m_node->SetBackend(m_backend);
+        }
+
         std::vector<const char*> operations(m_operations.size());
         for (uint32_t i = 0; i < m_operations.size(); ++i)
         {
@@ -307,6 +339,8 @@ void Sample::BuildUI()
             operation = operations[m_currentOperation];
             m_node->SetOperation(operation);
         }
+        if (m_backend != "CPU" && (operation == "Adaptive Histogram Equalization" || operation == "Fourier Transform"))
+            ImGui::Text("Only available on the CPU backend.");
 
         std::vector<const char*> inputs;
         for (const auto& mediaFile : m_mediaFiles)
@@ -317,8 +351,19 @@ void Sample::BuildUI()
         if (ImGui::Combo("Input1", &m_currentInput1, inputs.data(), inputs.size()))
             inputsUpdated = lastInput1 != m_currentInput1;
 
+        if (operation == "Recipe")
+        {
+            static char recipe[512] = {};
+            if (recipe[0] == '\0')
+                strncpy_s(recipe, k_defaultRecipe, sizeof(recipe) - 1);
+            if (ImGui::InputText("Steps", recipe, sizeof(recipe), ImGuiInputTextFlags_EnterReturnsTrue))
+                m_node->SetRecipe(recipe);
+            if (!m_node->GetRecipeError().empty())
+                ImGui::Text("Recipe error: %s", m_node->GetRecipeError().c_str());
+        }
+
         if (operation == "Add" || operation == "Subtract" ||
-            operation == "Product" || operation == "Unsharp Mask")
+            operation == "Product" || operation == "Unsharp Mask" || operation == "Recipe")
         {
             static float weightInput1 = 1.0f;
             if (ImGui::SliderFloat("Input1 Weight", &weightInput1, -10.0f, 10.0f, "%.2f"))
@@ -327,7 +372,7 @@ void Sample::BuildUI()
 
         int lastInput2 = m_currentInput2;
         if (operation == "Add" || operation == "Subtract"||
-            operation == "Product" || operation == "Histogram Match")
+            operation == "Product" || operation == "Histogram Match" || operation == "Recipe")
         {
             if (ImGui::Combo("Input2", &m_currentInput2, inputs.data(), inputs.size()))
                 inputsUpdated = lastInput2 != m_currentInput2;
@@ -349,13 +394,13 @@ void Sample::BuildUI()
                 m_node->SetInput2(m_mediaFiles[m_currentInput2]);
         }
 
-        if (operation == "Log")
+        if (operation == "Log" || operation == "Recipe")
         {
             static float logConstant = 1.0f;
             if (ImGui::SliderFloat("Log Constant", &logConstant, 0.0f, 3.0f, "%.2f"))
                 m_node->SetLogConstant(logConstant);
         }
-        else if (operation == "Power")
+        if (operation == "Power" || operation == "Recipe")
         {
             static float powerConstant = 1.0f;
             if (ImGui::SliderFloat("Power Constant", &powerConstant, 0.0f, 3.0f, "%.2f"))
@@ -365,11 +410,12 @@ void Sample::BuildUI()
             if (ImGui::SliderFloat("Power Raise", &powerRaise, 0.0f, 2.0f, "%.3f"))
                 m_node->SetPowerRaise(powerRaise);
         }
-        else if (operation == "Gaussian Blur" || operation == "Unsharp Mask")
+        if (operation == "Gaussian Blur" || operation == "Unsharp Mask" || operation == "Recipe")
         {
             static int32_t currentBlurKernelSize = 0u;
             const char* blurKernelSizes[] = {
-                "3", "5", "7", "9", "11", "13", "15"
+                "3", "5", "7", "9", "11", "13", "15",
+                "17", "19", "21", "23", "25", "27", "29", "31"
             };
             if (ImGui::Combo("BlurKernelSize", &currentBlurKernelSize, blurKernelSizes, sizeof(blurKernelSizes)/sizeof(blurKernelSizes[0])))
                 m_node->SetBlurKernelSize(atoi(blurKernelSizes[currentBlurKernelSize]));
@@ -377,6 +423,15 @@ void Sample::BuildUI()
             static float currentBlurVariance = 1.0f;
             if (ImGui::SliderFloat("Blur Variance", &currentBlurVariance, 0.0f, 50.0f, "%.3f"))
                 m_node->SetBlurVariance(currentBlurVariance);
+
+            // Unsharp Mask always blurs its tiles with the direct separable kernel.
+            if (operation == "Gaussian Blur" || operation == "Recipe")
+            {
+                static int32_t currentBlurAlgorithm = 0;
+                const char* blurAlgorithms[] = { "Auto", "Direct", "Separable", "Recursive" };
+                if (ImGui::Combo("Blur Algorithm", &currentBlurAlgorithm, blurAlgorithms, sizeof(blurAlgorithms)/sizeof(blurAlgorithms[0])))
+                    m_node->SetBlurAlgorithm(static_cast<GaussianBlurAlgorithm>(currentBlurAlgorithm));
+            }
         }
 
         /*if (ImGui::CollapsingHeader("Profiler", ImGuiTreeNodeFlags_DefaultOpen))
@@ -32,6 +32,8 @@ namespace CS570
         int32_t m_currentOperation = 0;
         std::vector<std::string> m_operations;
 
+        std::string m_backend = "GPU";
+
         int32_t m_currentInput1 = 0;
         int32_t m_currentInput2 = 1;
         std::vector<std::string> m_mediaFiles;
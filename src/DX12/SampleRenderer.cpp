@@ -1,13 +1,17 @@
 #include "SampleRenderer.h"
+#include "CpuPixelFormatDxgi.h"
 
 #include "Error.h"
+#include "Misc.h"
 #include "Texture.h"
 #include "SaveTexture.h"
 
+#include "../CPU/CpuConnectedComponents.h"
+#include "../CPU/CpuPPM.h"
+#include "../CPU/CpuTiledImage.h"
+
 #include <algorithm>
-#include <fstream>
-#include <sstream>
-#include <queue>
+#include <memory>
 #include <vector>
 
 #include "stdafx.h"
@@ -83,6 +87,8 @@ void SampleRenderer::OnCreate(
     m_unsharpMask.OnCreate(m_inputTexture1, m_blurKernelSize, m_blurVariance,
         m_pDevice, &m_uploadHeap, &m_resourceViewHeaps, &m_constantBufferRing);
 
+    CreateCpuOperations();
+
     SetOperation(initialOperation);
 
     m_imageRenderer.OnCreate(m_pDevice, &m_resourceViewHeaps, &m_vidMemBufferPool, pSwapChain->GetFormat());
@@ -95,177 +101,303 @@ void SampleRenderer::OnCreate(
     m_uploadHeap.FlushAndFinish();
 }
 
-static uint16_t ReadColor(std::ifstream& inputFile, std::string& lineOfPixels, std::stringstream& streamOfPixels)
+namespace
 {
-    uint16_t color = 0xFF;
-    bool parsedColor = false;
-    while (!parsedColor)
+    // Hands a loader the CPU backend's image to decode rows into, in whichever of the CPU pixel
+    // formats the file's samples fit.
+    class CpuImageDestination : public ImgDestination
     {
-        if (streamOfPixels.eof())
+    public:
+        explicit CpuImageDestination(CpuImage* pImage) : m_pImage(pImage) {}
+
+        void* GetPixels(const IMG_INFO& info, uint32_t* pRowPitch) override
         {
-            if (inputFile.eof())
-                break;
+            CpuPixelFormat pixelFormat;
+            if (!GetCpuPixelFormat(info.format, &pixelFormat))
+                return nullptr;
 
-            std::getline(inputFile, lineOfPixels);
-            streamOfPixels.clear();
-            streamOfPixels << lineOfPixels;
+            m_pImage->Resize(info.width, info.height, pixelFormat);
+            *pRowPitch = info.width * GetPixelSize(pixelFormat);
+            return m_pImage->GetBytes();
         }
 
-        streamOfPixels >> color;
+    private:
+        CpuImage* m_pImage;
+    };
+}
+
+bool SampleRenderer::LoadCpuInputImage(const std::string& inputImage, CpuImage& cpuInputImage)
+{
+    // Only the CPU backend reads the host copies, so none is kept while the GPU backend is selected
+    // unless CreateRecipe needs them.
+    cpuInputImage.Release();
+    if (m_currentBackend != "CPU")
+        return false;
+
+    return DecodeCpuInputImage(inputImage, cpuInputImage);
+}
 
-        parsedColor = !streamOfPixels.fail();
+bool SampleRenderer::DecodeCpuInputImage(const std::string& inputImage, CpuImage& cpuInputImage)
+{
+    cpuInputImage.Release();
+    std::string extension = inputImage.substr(inputImage.length() - 4);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::toupper);
+    if (extension == ".CTI")
+    {
+        CpuTiledImage tiledImage;
+        tiledImage.Open(inputImage);
+        tiledImage.ReadRegion(0, 0, 0, tiledImage.GetWidth(), tiledImage.GetHeight(), &cpuInputImage);
+        return true;
     }
 
-    assert(parsedColor);
+    // Only ppm and tiled image inputs are decoded on the host, so the CPU backend is unavailable for
+    // the others.
+    if (extension != ".PPM")
+        return false;
 
-    return color;
+    std::unique_ptr<ImgLoader> pLoader(CreateImageLoader(inputImage.c_str()));
+    CpuImageDestination destination(&cpuInputImage);
+    IMG_INFO imageHeader = {};
+    if (!pLoader->LoadInto(inputImage.c_str(), &destination, &imageHeader))
+    {
+        cpuInputImage.Release();
+        return false;
+    }
+    return true;
 }
 
-static void LoadPPMTextData(std::ifstream& inputFile, uint32_t width, uint32_t height, uint32_t maxValue, float* pImageBuffer)
+void SampleRenderer::LoadInputTexture(
+    const std::string& inputImage,
+    CAULDRON_DX12::Texture& inputTexture,
+    CpuImage& cpuInputImage)
 {
-    float invMaxValue = 1.0f / static_cast<float>(maxValue);
+    if (LoadCpuInputImage(inputImage, cpuInputImage))
+    {
+        IMG_INFO imageHeader = {};
+        imageHeader.width = cpuInputImage.GetWidth();
+        imageHeader.height = cpuInputImage.GetHeight();
+        imageHeader.depth = 1u;
+        imageHeader.arraySize = 1u;
+        imageHeader.mipMapCount = 1u;
+        imageHeader.bitCount = GetPixelSize(cpuInputImage.GetFormat()) * 8;
+        imageHeader.format = GetDxgiFormat(cpuInputImage.GetFormat());
+        inputTexture.InitFromData(m_pDevice, "InputImage1", m_uploadHeap, imageHeader, cpuInputImage.GetBytes());
+    }
+    else
+    {
+        // The loader decodes straight into the upload heap.
+        inputTexture.InitFromFile(m_pDevice, &m_uploadHeap, inputImage.c_str());
+    }
+}
 
-    std::string lineOfPixels;
-    std::stringstream streamOfPixels;
+void SampleRenderer::LoadInputTextures(
+    const std::string& inputImage1,
+    const std::string& inputImage2)
+{
+    //const std::string inputImage1 = "CCL_Output.ppm";
+    LoadInputTexture(inputImage1, m_inputTexture1, m_cpuInputImage1);
+    LoadInputTexture(inputImage2, m_inputTexture2, m_cpuInputImage2);
+}
 
-    std::getline(inputFile, lineOfPixels);
-    streamOfPixels << lineOfPixels;
+void SampleRenderer::CreateCpuOperations()
+{
+    if (m_currentBackend != "CPU" || m_cpuInputImage1.IsEmpty() || m_cpuInputImage2.IsEmpty())
+        return;
 
-    float* pWritePtr = pImageBuffer;
-    for (uint32_t hIndex = 0; hIndex < height; ++hIndex)
+    m_cpuOperations.OnCreate(m_cpuInputImage1, m_cpuInputImage2, m_blurKernelSize, m_blurVariance);
+
+    const char* operations[] = {
+        "Add", "Subtract", "Product",
+        "Negative", "Log", "Power",
+        "Histogram Equalization", "Histogram Match",
+        "Adaptive Histogram Equalization",
+        "Gaussian Blur",
+        "Sobel Filter",
+        "Unsharp Mask",
+        "Fourier Transform"
+    };
+    for (const char* pOperation : operations)
     {
-        for (uint32_t wIndex = 0; wIndex < width; ++wIndex)
-        {
-            uint16_t red = ReadColor(inputFile, lineOfPixels, streamOfPixels);
-            uint16_t green = ReadColor(inputFile, lineOfPixels, streamOfPixels);
-            uint16_t blue = ReadColor(inputFile, lineOfPixels, streamOfPixels);
-
-            *pWritePtr = static_cast<float>(red) * invMaxValue;
-            ++pWritePtr;
-            *pWritePtr = static_cast<float>(green) * invMaxValue;
-            ++pWritePtr;
-            *pWritePtr = static_cast<float>(blue) * invMaxValue;
-            ++pWritePtr;
-            *pWritePtr = 1.0f; // alpha
-            ++pWritePtr;
-        }
+        m_cpuBackedOperations[pOperation].OnCreate(
+            m_cpuOperations.GetOperation(pOperation), k_backBufferCount + 1, m_pDevice, &m_resourceViewHeaps);
     }
 }
 
-
-template <typename T>
-void LoadPPMBinaryData(std::ifstream& inputFile, uint32_t width, uint32_t height, uint32_t maxValue, float* pImageBuffer)
+void SampleRenderer::DestroyCpuOperations()
 {
-    float invMaxValue = 1.0f / static_cast<float>(maxValue);
+    for (auto& cpuBackedOperation : m_cpuBackedOperations)
+        cpuBackedOperation.second.OnDestroy();
+    m_cpuBackedOperations.clear();
+
+    m_cpuOperations.OnDestroy();
+}
 
-    float* pReadPtr = pImageBuffer;
-    for (uint32_t hIndex = 0; hIndex < height; ++hIndex)
+// Maps the recipe onto an OperationGraph when every step is a pointwise or neighborhood node, so
+// the GPU can run it as fused stages. Returns false otherwise.
+static bool BuildRecipeGraph(
+    const std::vector<PipelineRecipeStep>& steps,
+    const CAULDRON_DX12::Texture& input1,
+    const CAULDRON_DX12::Texture& input2,
+    const CpuPipelineParameters& parameters,
+    OperationGraph* pGraph)
+{
+    PointwiseConstants constants;
+    constants.logConstant = parameters.logConstant;
+    constants.powerConstant = parameters.powerConstant;
+    constants.powerRaise = parameters.powerRaise;
+    constants.weightInput1 = parameters.weightInput1;
+    constants.weightInput2 = parameters.weightInput2;
+
+    std::map<std::string, uint32_t> nodes;
+    nodes["input1"] = pGraph->AddInput(input1.GetWidth(), input1.GetHeight());
+    nodes["input2"] = pGraph->AddInput(input2.GetWidth(), input2.GetHeight());
+
+    uint32_t node = OperationNode::k_invalidNode;
+    try
     {
-        std::vector<T> pixelRowBytes(width * 3);
-        inputFile.read((char*)pixelRowBytes.data(), sizeof(T) * width * 3);
-        for (uint32_t wIndex = 0; wIndex < width; ++wIndex)
+        for (const PipelineRecipeStep& step : steps)
         {
-            *pReadPtr = static_cast<float>(pixelRowBytes[(wIndex * 3) + 0]) * invMaxValue;
-            ++pReadPtr;
-            *pReadPtr = static_cast<float>(pixelRowBytes[(wIndex * 3) + 1]) * invMaxValue;
-            ++pReadPtr;
-            *pReadPtr = static_cast<float>(pixelRowBytes[(wIndex * 3) + 2]) * invMaxValue;
-            ++pReadPtr;
-            *pReadPtr = 1.0f; // alpha
-            ++pReadPtr;
+            OperationType type = GetOperationType(step.operation);
+            auto input1Node = nodes.find(step.inputs[0]);
+            auto input2Node = nodes.find(step.inputs[1]);
+            if (input1Node == nodes.end())
+                return false;
+
+            if (type == OperationType::GaussianBlur)
+                node = pGraph->AddGaussianBlur(input1Node->second, parameters.blurKernelSize, parameters.blurVariance);
+            else if (type == OperationType::SobelFilter)
+                node = pGraph->AddSobelFilter(input1Node->second);
+            else
+                node = pGraph->AddPointwise(
+                    type, input1Node->second, input2Node != nodes.end() ? input2Node->second : OperationNode::k_invalidNode, constants);
+            nodes[step.name] = node;
         }
     }
+    catch (const char*)
+    {
+        return false;
+    }
+
+    pGraph->AddOutput(node);
+    return true;
 }
 
-static void LoadPPM(const std::string& imageFile, IMG_INFO* pImageHeader, std::vector<uint8_t>* pImageData)
+void SampleRenderer::CreateRecipe()
 {
-    std::ifstream inputFile(imageFile);
+    m_recipeError.clear();
+    if (m_recipe.empty())
+        return;
 
-    assert(inputFile.is_open());
+    std::vector<PipelineRecipeStep> steps;
+    try
+    {
+        steps = ParsePipelineRecipe(m_recipe);
+    }
+    catch (const char* pError)
+    {
+        m_recipeError = pError;
+        Trace(std::string("Recipe: ") + pError);
+        return;
+    }
 
-    std::string imageTypeCode;
-    inputFile >> imageTypeCode;
+    OperationGraph graph;
+    if (BuildRecipeGraph(steps, m_inputTexture1, m_inputTexture2, m_pipelineParameters, &graph))
+    {
+        m_gpuRecipe.OnCreate(graph, { &m_inputTexture1, &m_inputTexture2 },
+            m_pDevice, &m_uploadHeap, &m_resourceViewHeaps, &m_constantBufferRing);
+        m_gpuRecipeCreated = true;
+    }
 
-    bool widthHeightParsed = false;
-    std::string headerLine;
-    while (!widthHeightParsed)
+    if (m_currentBackend != "CPU")
     {
-        if (inputFile.eof())
-            throw "Invalid ppm file, failed to parse width and height from header.";
+        if (m_gpuRecipeCreated)
+            return;
 
-        std::getline(inputFile, headerLine);
-        if (!headerLine.empty() && headerLine.front() != '#')
-        {
-            std::stringstream str;
-            str << headerLine;
-            str >> pImageHeader->width;
-            str >> pImageHeader->height;
-            widthHeightParsed = true;
-        }
+        // The GPU backend keeps no host copies, but falls back to CpuPipeline for recipes it can't
+        // fuse, which reads them.
+        DecodeCpuInputImage(m_inputImage1, m_cpuInputImage1);
+        DecodeCpuInputImage(m_inputImage2, m_cpuInputImage2);
     }
 
-    bool maxValueParsed = false;
-    uint32_t maxPixelValue = 0u;
-    while (!maxValueParsed)
+    if (m_cpuInputImage1.IsEmpty() || m_cpuInputImage2.IsEmpty())
     {
-        if (inputFile.eof())
-            throw "Invalid ppm file, failed to parse width and height from header.";
-
-        std::getline(inputFile, headerLine);
-        if (!headerLine.empty() && headerLine.front() != '#')
-        {
-            std::stringstream str;
-            str << headerLine;
-            str >> maxPixelValue;
-            maxValueParsed = true;
-        }
+        if (!m_gpuRecipeCreated)
+            m_recipeError = "Steps without a GPU node run on the CPU, which can't decode these inputs.";
+        return;
     }
 
-    pImageHeader->bitCount = 32 * 4;
-    pImageHeader->format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+    try
+    {
+        uint32_t input1 = m_cpuRecipe.AddInput(m_cpuInputImage1);
+        uint32_t input2 = m_cpuRecipe.AddInput(m_cpuInputImage2);
+        AddPipelineRecipe(steps, { "input1", "input2" }, { input1, input2 }, m_pipelineParameters, &m_cpuRecipe);
 
-    pImageData->resize(pImageHeader->width * pImageHeader->height * sizeof(float) * 4);
-    if (imageTypeCode == "P3")
-        LoadPPMTextData(inputFile, pImageHeader->width, pImageHeader->height, maxPixelValue, reinterpret_cast<float*>(pImageData->data()));
-    else if (maxPixelValue > 255)
-        LoadPPMBinaryData<uint16_t>(inputFile, pImageHeader->width, pImageHeader->height, maxPixelValue, reinterpret_cast<float*>(pImageData->data()));
-    else
-        LoadPPMBinaryData<uint8_t>(inputFile, pImageHeader->width, pImageHeader->height, maxPixelValue, reinterpret_cast<float*>(pImageData->data()));
+        // CpuBackedImageProcessor sizes its texture from the output, so run the pipeline once.
+        m_cpuRecipe.Execute();
+    }
+    catch (const char* pError)
+    {
+        m_recipeError = pError;
+        Trace(std::string("Recipe: ") + pError);
+        m_cpuRecipe.Clear();
+        return;
+    }
 
-    pImageHeader->depth = 1u;
-    pImageHeader->arraySize = 1u;
-    pImageHeader->mipMapCount = 1u;
+    m_cpuRecipeOperation.OnCreate(&m_cpuRecipe, k_backBufferCount + 1, m_pDevice, &m_resourceViewHeaps);
+    m_cpuRecipeCreated = true;
 }
 
-void SampleRenderer::LoadInputTexture(
-    const std::string& inputImage,
-    CAULDRON_DX12::Texture& inputTexture)
+void SampleRenderer::DestroyRecipe()
 {
-    std::string extension = inputImage.substr(inputImage.length() - 4);
-    std::transform(extension.begin(), extension.end(), extension.begin(), ::toupper);
-    if (extension == ".PPM")
+    if (m_gpuRecipeCreated)
+        m_gpuRecipe.OnDestroy();
+    m_gpuRecipeCreated = false;
+
+    if (m_cpuRecipeCreated)
+        m_cpuRecipeOperation.OnDestroy();
+    m_cpuRecipeCreated = false;
+    m_cpuRecipe.Clear();
+
+    // Only a GPU backend fallback recipe loaded host copies while the GPU backend is selected.
+    if (m_currentBackend != "CPU")
     {
-        IMG_INFO imageHeader = {};
-        std::vector<uint8_t> imageData;
-        LoadPPM(inputImage, &imageHeader, &imageData);
-        inputTexture.InitFromData(m_pDevice, "InputImage1", m_uploadHeap, imageHeader, imageData.data());
+        m_cpuInputImage1.Release();
+        m_cpuInputImage2.Release();
     }
-    else
-        inputTexture.InitFromFile(m_pDevice, &m_uploadHeap, inputImage.c_str());
 }
 
-void SampleRenderer::LoadInputTextures(
-    const std::string& inputImage1,
-    const std::string& inputImage2)
+void SampleRenderer::UpdateRecipeParameters()
 {
-    //const std::string inputImage1 = "CCL_Output.ppm";
-    LoadInputTexture(inputImage1, m_inputTexture1);
-    LoadInputTexture(inputImage2, m_inputTexture2);
+    m_cpuRecipe.SetParameters(m_pipelineParameters);
+    // The graph executor compiles the constants into its shaders.
+    if (m_gpuRecipeCreated)
+        m_rebuildRecipe = true;
 }
 
 void SampleRenderer::SetOperation(const std::string& operation)
 {
     m_currentOperation = operation;
+    if (operation == "Recipe")
+    {
+        // Nothing is drawn for a recipe that didn't build; GetRecipeError says why.
+        m_pCurrentOperation = nullptr;
+        if (m_currentBackend == "GPU" && m_gpuRecipeCreated)
+            m_pCurrentOperation = &m_gpuRecipe;
+        else if (m_cpuRecipeCreated)
+            m_pCurrentOperation = &m_cpuRecipeOperation;
+        return;
+    }
+
+    if (m_currentBackend == "CPU")
+    {
+        auto cpuBackedOperation = m_cpuBackedOperations.find(operation);
+        if (cpuBackedOperation != m_cpuBackedOperations.end())
+        {
+            m_pCurrentOperation = &cpuBackedOperation->second;
+            return;
+        }
+    }
+
     if (operation == "Add") m_pCurrentOperation = &m_addOperation;
     else if (operation == "Subtract") m_pCurrentOperation = &m_subtractOperation;
     else if (operation == "Product") m_pCurrentOperation = &m_productOperation;
@@ -277,6 +409,16 @@ void SampleRenderer::SetOperation(const std::string& operation)
     else if (operation == "Gaussian Blur") m_pCurrentOperation = &m_gaussianBlur;
     else if (operation == "Sobel Filter") m_pCurrentOperation = &m_sobelFilter;
     else if (operation == "Unsharp Mask") m_pCurrentOperation = &m_unsharpMask;
+    // Only the CPU backend runs the others, so nothing is drawn.
+    else m_pCurrentOperation = nullptr;
+}
+
+void SampleRenderer::SetBackend(const std::string& backend)
+{
+    if ((backend == "CPU") != (m_currentBackend == "CPU"))
+        m_reloadCpuInputs = true;
+    m_currentBackend = backend;
+    SetOperation(m_currentOperation);
 }
 
 void SampleRenderer::SetInput1(const std::string& inputImage1)
@@ -298,6 +440,9 @@ void SampleRenderer::SetWeightInput1(float weight)
     m_subtractOperation.SetWeightInput1(weight);
     m_productOperation.SetWeightInput1(weight);
     m_unsharpMask.SetWeight(weight);
+    m_cpuOperations.SetWeightInput1(weight);
+    m_pipelineParameters.weightInput1 = weight;
+    UpdateRecipeParameters();
 }
 
 void SampleRenderer::SetWeightInput2(float weight)
@@ -305,30 +450,72 @@ void SampleRenderer::SetWeightInput2(float weight)
     m_addOperation.SetWeightInput2(weight);
     m_subtractOperation.SetWeightInput2(weight);
     m_productOperation.SetWeightInput2(weight);
+    m_cpuOperations.SetWeightInput2(weight);
+    m_pipelineParameters.weightInput2 = weight;
+    UpdateRecipeParameters();
 }
 
 void SampleRenderer::OnPostRender()
 {
+    if (m_reloadCpuInputs && !m_rebuildImage1 && !m_rebuildImage2)
+    {
+        // The textures stay, only the host copies and what reads them are recreated.
+        m_pDevice->GPUFlush();
+
+        DestroyCpuOperations();
+        DestroyRecipe();
+        LoadCpuInputImage(m_inputImage1, m_cpuInputImage1);
+        LoadCpuInputImage(m_inputImage2, m_cpuInputImage2);
+        CreateCpuOperations();
+        CreateRecipe();
+        m_reloadCpuInputs = false;
+        m_rebuildRecipe = false;
+
+        SetOperation(m_currentOperation);
+    }
+
     if (!m_rebuildImage1 && !m_rebuildImage2 && !m_recreateBlurWeights)
+    {
+        if (m_rebuildRecipe)
+        {
+            m_pDevice->GPUFlush();
+
+            DestroyRecipe();
+            CreateRecipe();
+            m_rebuildRecipe = false;
+
+            SetOperation(m_currentOperation);
+        }
         return;
+    }
 
     m_pDevice->GPUFlush();
 
     if (m_rebuildImage1)
     {
         m_inputTexture1.OnDestroy();
-        LoadInputTexture(m_inputImage1, m_inputTexture1);
+        LoadInputTexture(m_inputImage1, m_inputTexture1, m_cpuInputImage1);
 
         m_rebuildImage1 = false;
     }
+    else if (m_reloadCpuInputs)
+    {
+        LoadCpuInputImage(m_inputImage1, m_cpuInputImage1);
+    }
 
     if (m_rebuildImage2)
     {
         m_inputTexture2.OnDestroy();
-        LoadInputTexture(m_inputImage2, m_inputTexture2);
+        LoadInputTexture(m_inputImage2, m_inputTexture2, m_cpuInputImage2);
 
         m_rebuildImage2 = false;
     }
+    else if (m_reloadCpuInputs)
+    {
+        LoadCpuInputImage(m_inputImage2, m_cpuInputImage2);
+    }
+
+    m_reloadCpuInputs = false;
 
     m_recreateBlurWeights = false;
 
@@ -348,6 +535,9 @@ void SampleRenderer::OnPostRender()
 
     m_unsharpMask.OnDestroy();
 
+    DestroyCpuOperations();
+    DestroyRecipe();
+
     m_addOperation.OnCreate("Add",
         m_inputTexture1, m_inputTexture2,
         m_pDevice, &m_uploadHeap, &m_resourceViewHeaps, &m_constantBufferRing);
@@ -382,6 +572,12 @@ void SampleRenderer::OnPostRender()
     m_unsharpMask.OnCreate(m_inputTexture1, m_blurKernelSize, m_blurVariance,
         m_pDevice, &m_uploadHeap, &m_resourceViewHeaps, &m_constantBufferRing);
 
+    CreateCpuOperations();
+    CreateRecipe();
+    m_rebuildRecipe = false;
+
+    SetOperation(m_currentOperation);
+
     m_vidMemBufferPool.UploadData(m_uploadHeap.GetCommandList());
     m_uploadHeap.FlushAndFinish();
 
@@ -410,6 +606,9 @@ void SampleRenderer::OnDestroy()
 
     m_unsharpMask.OnDestroy();
 
+    DestroyCpuOperations();
+    DestroyRecipe();
+
     m_imageRenderer.OnDestroy();
 
     m_inputTexture1.OnDestroy();
@@ -448,160 +647,25 @@ void SampleRenderer::LoadScene()
     m_vidMemBufferPool.FreeUploadHeap();
 }
 
-static void WritePPMHeader(std::ofstream& fstream, int width, int height)
-{
-    assert(fstream.is_open());
-
-    int maxValue = 255; // This assumes our output format is rgba8
-    std::stringstream header;
-    header << "P6" << " " << width << " " << height << " " << maxValue << " ";
-    //header << "P3" << std::endl << width << " " << height << std::endl << maxValue << std::endl;
-
-    fstream << header.str();
-}
-
-struct PixelColor
-{
-    uint8_t rgb[3];
-};
-
-static constexpr const uint32_t k_numObjectColors = 10;
-static const PixelColor k_objectColors[k_numObjectColors] = {
-    {0, 0, 0},
-    {255, 0, 0},
-    {0, 255, 0},
-    {0, 0, 255},
-    {255, 0, 255},
-    {255, 255, 0},
-    {0, 255, 255},
-    {255, 128, 128},
-    {128, 255, 128},
-    {128, 128, 255}
-};
-
-uint32_t FindLargestSetBit(uint8_t red)
-{
-    uint32_t bitCount = 0;
-    while (red != 0)
-    {
-        red >>= 1;
-        ++bitCount;
-    }
-
-    return bitCount;
-}
-
 static void WriteConnectedComponentImage(
     CAULDRON_DX12::SaveTexture& saver,
     ID3D12Device* pDevice,
     ID3D12CommandQueue* pDirectQueue,
-    const char* pFilename)
+    const char* pFilename,
+    const char* pStatsFilename)
 {
-    saver.ProcessStagingBuffer(pDevice, pDirectQueue, [pFilename](int width, int height, uint8_t* pImageBuffer) {
-        struct PixelIndex
-        {
-            int x;
-            int y;
-            PixelIndex(int _x, int _y) : x(_x), y(_y) {}
-        };
-
-        std::queue<PixelIndex> processingQueue;
-        struct PixelLabel
-        {
-            uint32_t label = 0;
-        };
-
-        /*uint8_t pImageBuffer[] = {
-            //       0            1                  2               3
-                0, 0, 0, 0,     0, 0, 0, 0,     0, 0, 0, 0,    255, 0, 0, 0, // 0
-                0, 0, 0, 0,     0, 0, 0, 0,   255, 0, 0, 0,    255, 0, 0, 0, // 1
-                0, 0, 0, 0,   255, 0, 0, 0,   255, 0, 0, 0,    255, 0, 0, 0, // 2
-              255, 0, 0, 0,     0, 0, 0, 0,     0, 0, 0, 0,    255, 0, 0, 0  // 3
-        };
-        width = 4;
-        height = 4;*/
-
-        PixelLabel currentLabel = { 1 };
-        uint32_t currentLargestSetBit = 0;
-        std::vector<std::vector<PixelLabel>> pixelLabels(height, std::vector<PixelLabel>(width));
-        uint8_t* pReadPtr = pImageBuffer;
-        for (int row = 0; row < height; ++row)
-        {
-            for (int col = 0; col < width; ++col)
-            {
-                uint8_t red = *pReadPtr;
-                if (red != 0 && pixelLabels[row][col].label == 0)
-                {
-                    currentLargestSetBit = FindLargestSetBit(red);
-                    // label this pixel with the current label
-                    pixelLabels[row][col].label = currentLabel.label;
-                    // push the pixel on the queue so we can examine its neighbors
-                    processingQueue.push(PixelIndex(col, row));
-                    while (!processingQueue.empty())
-                    {
-                        auto pixelIndex = processingQueue.front();
-                        processingQueue.pop();
-
-                        // examine the neighbors of the current pixel
-                        const PixelIndex neighborOffsets[4] = { {-1, 0}, {1, 0}, {0, -1}, {0, 1} };
-                        for (int offsetIndex = 0; offsetIndex < 4; ++offsetIndex)
-                        {
-                            int nextX = pixelIndex.x + neighborOffsets[offsetIndex].x;
-                            int nextY = pixelIndex.y + neighborOffsets[offsetIndex].y;
-                            // no need to examine pixels that we've already examined.
-                            if (nextY == row && nextX < col || nextY < row)
-                                continue;
-                            // don't go past bounds
-                            if (nextX < 0 || nextX >= width || nextY < 0 || nextY >= height)
-                                continue;
-                            // don't examine pixels that are already labelled
-                            if (pixelLabels[nextY][nextX].label == 0)
-                            {
-                                // if they aren't the correct value then skip
-                                int nextIndex = (nextY * width * 4) + (nextX * 4);
-                                uint8_t nextRed = pImageBuffer[nextIndex];
-                                // If the largest set bit is the same then consider it the same object
-                                if (FindLargestSetBit(nextRed) == currentLargestSetBit)
-                                {
-                                    // label this pixel with the current label
-                                    pixelLabels[nextY][nextX].label = currentLabel.label;
-                                    // push the next pixel on the queue so we can examine its neighbors
-                                    processingQueue.push(PixelIndex(nextX, nextY));
-                                }
-                            }
-                        }
-                    }
-
-                    ++currentLabel.label;
-                }
-
-                ++pReadPtr; // red
-                ++pReadPtr; // green
-                ++pReadPtr; // blue
-                ++pReadPtr; // alpha
-            }
-        }
-
-        std::ofstream fstream(pFilename, std::ios::binary);
-
-        WritePPMHeader(fstream, width, height);
-
-        for (int row = 0; row < height; ++row)
-        {
-            for (int col = 0; col < width; ++col)
-            {
-                PixelLabel pixelLabel = pixelLabels[row][col];
-                const PixelColor& pixelColor = k_objectColors[pixelLabel.label % k_numObjectColors];
-
-                //fstream << (int)pixelColor.rgb[0] << " ";
-                //fstream << (int)pixelColor.rgb[1] << " ";
-                //fstream << (int)pixelColor.rgb[2] << "    ";
-                fstream << pixelColor.rgb[0];
-                fstream << pixelColor.rgb[1];
-                fstream << pixelColor.rgb[2];
-            }
-            //fstream << std::endl;
-        }
+    saver.ProcessStagingBuffer(pDevice, pDirectQueue, [pFilename, pStatsFilename](int width, int height, uint8_t* pImageBuffer) {
+        // The staging buffer is rgba8, so the red channel of every fourth byte picks the class.
+        std::vector<uint8_t> classKeys(size_t(width) * height);
+        ComputeComponentClassKeys(pImageBuffer, classKeys.size(), 4, classKeys.data());
+
+        CpuConnectedComponents connectedComponents;
+        connectedComponents.OnCreate(classKeys.data(), width, height, Connectivity::Four);
+        connectedComponents.SetComponentStats(true, pImageBuffer, 4);
+        connectedComponents.Execute();
+
+        WriteLabelPPM(pFilename, connectedComponents.GetLabels().data(), width, height);
+        WriteComponentStats(pStatsFilename, connectedComponents.GetComponentStats());
     });
 }
 
@@ -612,36 +676,10 @@ static void WriteOutputToPPM(
     const char* pFilename)
 {
     saver.ProcessStagingBuffer(pDevice, pDirectQueue, [pFilename](int width, int height, uint8_t* pImageBuffer) {
-        std::ofstream fstream(pFilename, std::ios::binary);
-
-        WritePPMHeader(fstream, width, height);
-
-        uint8_t* pReadPtr = pImageBuffer;
-        for (int row = 0; row < height; ++row)
-        {
-            for (int col = 0; col < width; ++col)
-            {
-                uint8_t red = *pReadPtr;
-                fstream << red;
-                //fstream << (int)red << " ";
-                ++pReadPtr;
-
-                uint8_t green = *pReadPtr;
-                fstream << green;
-                //fstream << (int)green << " ";
-                ++pReadPtr;
-
-                uint8_t blue = *pReadPtr;
-                fstream << blue;
-                //fstream << (int)blue << " ";
-                ++pReadPtr;
-
-                //fstream << "  ";
-                // jump past the alpha
-                ++pReadPtr;
-            }
-            //fstream << std::endl;
-        }
+        // The staging buffer is rgba8 with rows packed back to back.
+        WritePPM(pFilename, width, height, [pImageBuffer, width](uint32_t row, uint8_t* pRowBytes) {
+            PackRGBA8ToRGB8(pImageBuffer + size_t(row) * width * 4, width, pRowBytes);
+        });
     });
 }
 
@@ -660,7 +698,8 @@ void SampleRenderer::OnRender(State *pState, CAULDRON_DX12::SwapChain *pSwapChai
 
     m_gpuTimer.GetTimeStamp(pCmdLst1, "Begin Frame");
 
-    m_pCurrentOperation->Draw(pCmdLst1);
+    if (m_pCurrentOperation != nullptr)
+        m_pCurrentOperation->Draw(pCmdLst1);
 
     CD3DX12_RESOURCE_BARRIER barriers[] = {
         CD3DX12_RESOURCE_BARRIER::Transition(
@@ -683,7 +722,15 @@ void SampleRenderer::OnRender(State *pState, CAULDRON_DX12::SwapChain *pSwapChai
     pCmdLst2->RSSetScissorRects(1, &m_rectScissor);
     pCmdLst2->OMSetRenderTargets(1, pSwapChain->GetCurrentBackBufferRTV(), true, NULL);
 
-    m_imageRenderer.Draw(pCmdLst2, m_displayFilter, &m_pCurrentOperation->GetOutputSrv());
+    if (m_pCurrentOperation != nullptr)
+    {
+        m_imageRenderer.Draw(pCmdLst2, m_displayFilter, &m_pCurrentOperation->GetOutputSrv());
+    }
+    else
+    {
+        const float clearColor[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        pCmdLst2->ClearRenderTargetView(*pSwapChain->GetCurrentBackBufferRTV(), clearColor, 0, nullptr);
+    }
 
     CAULDRON_DX12::SaveTexture saver;
     if (m_saveOutput || m_saveCCLOutput)
@@ -736,7 +783,8 @@ void SampleRenderer::OnRender(State *pState, CAULDRON_DX12::SwapChain *pSwapChai
             saver,
             m_pDevice->GetDevice(),
             m_pDevice->GetGraphicsQueue(),
-            "CCL_Output.ppm");
+            "CCL_Output.ppm",
+            "CCL_Output.csv");
         m_saveCCLOutput = false;
     }
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "CommandListRing.h"
+#include "CpuBackedImageProcessor.h"
 #include "Device.h"
 #include "DynamicBufferRing.h"
 #include "GaussianBlur.h"
@@ -10,6 +11,7 @@
 #include "ImageProcessor.h"
 #include "ImageRenderer.h"
 #include "Imgui.h"
+#include "OperationGraphExecutor.h"
 #include "ResourceViewHeaps.h"
 #include "SobelFilter.h"
 #include "StaticBufferPool.h"
@@ -17,6 +19,11 @@
 #include "Texture.h"
 #include "UnsharpMask.h"
 
+#include "../CPU/CpuImage.h"
+#include "../CPU/CpuOperationSet.h"
+#include "../CPU/CpuPipeline.h"
+
+#include <map>
 #include <string>
 
 static const int k_backBufferCount = 2;
@@ -55,26 +62,74 @@ namespace CS570
         const std::string& GetOperation() const { return m_currentOperation; }
         void SetOperation(const std::string& operation);
 
+        // Steps run by the "Recipe" operation, in the ParsePipelineRecipe syntax with input1 and
+        // input2 as the inputs. The GPU backend runs it as a fused OperationGraph when every step
+        // has a graph node, otherwise both backends run it through CpuPipeline.
+        void SetRecipe(const std::string& recipe)
+        {
+            m_recipe = recipe;
+            m_rebuildRecipe = true;
+        }
+        // Why the last recipe didn't build, empty if it did.
+        const std::string& GetRecipeError() const { return m_recipeError; }
+
+        // "GPU" runs the compute shaders, "CPU" runs the portable CPU backend and uploads its output.
+        const std::string& GetBackend() const { return m_currentBackend; }
+        void SetBackend(const std::string& backend);
+
         void SetInput1(const std::string& inputImage1);
         void SetInput2(const std::string& inputImage2);
 
         void SetWeightInput1(float weight);
         void SetWeightInput2(float weight);
 
-        void SetLogConstant(float constant) { m_logOperation.SetLogConstant(constant); }
-        void SetPowerConstant(float constant) { m_powerOperation.SetPowerConstant(constant); }
-        void SetPowerRaise(float raise) { m_powerOperation.SetPowerRaise(raise); }
+        void SetLogConstant(float constant)
+        {
+            m_logOperation.SetLogConstant(constant);
+            m_cpuOperations.SetLogConstant(constant);
+            m_pipelineParameters.logConstant = constant;
+            UpdateRecipeParameters();
+        }
+
+        void SetPowerConstant(float constant)
+        {
+            m_powerOperation.SetPowerConstant(constant);
+            m_cpuOperations.SetPowerConstant(constant);
+            m_pipelineParameters.powerConstant = constant;
+            UpdateRecipeParameters();
+        }
+
+        void SetPowerRaise(float raise)
+        {
+            m_powerOperation.SetPowerRaise(raise);
+            m_cpuOperations.SetPowerRaise(raise);
+            m_pipelineParameters.powerRaise = raise;
+            UpdateRecipeParameters();
+        }
 
         void SetBlurKernelSize(uint32_t blurKernelSize)
         {
             m_recreateBlurWeights = blurKernelSize != m_blurKernelSize;
             m_blurKernelSize = blurKernelSize;
+            m_pipelineParameters.blurKernelSize = blurKernelSize;
         }
 
         void SetBlurVariance(float blurVariance)
         {
+            m_blurVariance = blurVariance;
             m_gaussianBlur.SetVariance(blurVariance);
             m_unsharpMask.SetBlurVariance(blurVariance);
+            m_cpuOperations.SetBlurVariance(blurVariance);
+            m_pipelineParameters.blurVariance = blurVariance;
+            UpdateRecipeParameters();
+        }
+
+        void SetBlurAlgorithm(GaussianBlurAlgorithm algorithm)
+        {
+            m_gaussianBlur.SetAlgorithm(algorithm);
+            m_cpuOperations.SetBlurAlgorithm(algorithm);
+            m_pipelineParameters.blurAlgorithm = algorithm;
+            UpdateRecipeParameters();
         }
 
         void SetDisplayFilter(D3D12_FILTER filter) { m_displayFilter = filter; }
@@ -83,11 +138,23 @@ namespace CS570
         void SaveCCLOutput() { m_saveCCLOutput = true; }
 
     private:
-        void LoadInputTexture(const std::string& inputImage, CAULDRON_DX12::Texture& inputTexture);
+        // Returns false, with cpuInputImage released, if the CPU backend isn't selected or can't read
+        // the input.
+        bool LoadCpuInputImage(const std::string& inputImage, CpuImage& cpuInputImage);
+        // The same whatever the backend.
+        bool DecodeCpuInputImage(const std::string& inputImage, CpuImage& cpuInputImage);
+        void LoadInputTexture(const std::string& inputImage, CAULDRON_DX12::Texture& inputTexture, CpuImage& cpuInputImage);
         void LoadInputTextures(
             const std::string& inputImage1,
             const std::string& inputImage2);
 
+        void CreateCpuOperations();
+        void DestroyCpuOperations();
+
+        void CreateRecipe();
+        void DestroyRecipe();
+        void UpdateRecipeParameters();
+
         CAULDRON_DX12::Device* m_pDevice = nullptr;
 
         uint32_t m_width = 0u;
@@ -106,6 +173,12 @@ namespace CS570
         CAULDRON_DX12::Texture m_inputTexture1;
         CAULDRON_DX12::Texture m_inputTexture2;
 
+        // Host copies of the ppm and tiled image inputs, only loaded while the CPU backend is selected
+        // or the recipe falls back to CpuPipeline on the GPU backend.
+        CpuImage m_cpuInputImage1;
+        CpuImage m_cpuInputImage2;
+        bool m_reloadCpuInputs = false;
+
         bool m_rebuildImage1 = false;
         bool m_rebuildImage2 = false;
         std::string m_inputImage1;
@@ -133,6 +206,20 @@ namespace CS570
 
         UnsharpMask m_unsharpMask;
 
+        std::string m_currentBackend = "GPU";
+        CpuOperationSet m_cpuOperations;
+        std::map<std::string, CpuBackedImageProcessor> m_cpuBackedOperations;
+
+        std::string m_recipe;
+        std::string m_recipeError;
+        bool m_rebuildRecipe = false;
+        CpuPipelineParameters m_pipelineParameters;
+        CpuPipeline m_cpuRecipe;
+        CpuBackedImageProcessor m_cpuRecipeOperation;
+        bool m_cpuRecipeCreated = false;
+        OperationGraphExecutor m_gpuRecipe;
+        bool m_gpuRecipeCreated = false;
+
         D3D12_FILTER m_displayFilter = D3D12_FILTER_MIN_MAG_LINEAR_MIP_POINT;
         ImageRenderer m_imageRenderer;
 
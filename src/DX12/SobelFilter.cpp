@@ -1,4 +1,5 @@
 #include "SobelFilter.h"
+#include "CpuPixelFormatDxgi.h"
 
 #include "Device.h"
 #include "DynamicBufferRing.h"
@@ -21,11 +22,13 @@ void SobelFilter::OnCreate(
     Device* pDevice,
     UploadHeap* pUploadHeap,
     ResourceViewHeaps* pResourceViewHeaps,
-    DynamicBufferRing* pConstantBufferRing)
+    DynamicBufferRing* pConstantBufferRing,
+    uint32_t planeOutputs)
 {
     m_pDevice = pDevice;
     m_pResourceViewHeaps = pResourceViewHeaps;
     m_pConstantBufferRing = pConstantBufferRing;
+    m_planeOutputs = planeOutputs;
 
     {
         int parameterCount = 0;
@@ -34,7 +37,7 @@ void SobelFilter::OnCreate(
         rtSlot[parameterCount++].InitAsConstantBufferView(0, 0, D3D12_SHADER_VISIBILITY_ALL);
 
         CD3DX12_DESCRIPTOR_RANGE uavDescRange = {};
-        uavDescRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0);
+        uavDescRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1 + k_sobelOutputPlaneCount, 0);
         rtSlot[parameterCount++].InitAsDescriptorTable(1, &uavDescRange, D3D12_SHADER_VISIBILITY_ALL);
 
         CD3DX12_DESCRIPTOR_RANGE srvDescRange = {};
@@ -65,33 +68,25 @@ void SobelFilter::OnCreate(
             pErrorBlob->Release();
     }
 
-    D3D12_SHADER_BYTECODE horizontalByteCode = {};
+    D3D12_SHADER_BYTECODE shaderByteCode = {};
     DefineList defines;
+    defines["OUTPUT_GRADIENT_X"] = (planeOutputs & k_sobelOutputGradientX) != 0 ? "1" : "0";
+    defines["OUTPUT_GRADIENT_Y"] = (planeOutputs & k_sobelOutputGradientY) != 0 ? "1" : "0";
+    defines["OUTPUT_ORIENTATION"] = (planeOutputs & k_sobelOutputOrientation) != 0 ? "1" : "0";
     CAULDRON_DX12::CompileShaderFromFile(
         "DX12/SobelFilter.hlsl",
         &defines,
-        "HorizontalFilter",
+        "Gradient",
         "-T cs_6_0 /Zi /Zss -Od -Qembed_debug",
-        &horizontalByteCode);
+        &shaderByteCode);
 
     D3D12_COMPUTE_PIPELINE_STATE_DESC descPso = {};
-    descPso.CS = horizontalByteCode;
+    descPso.CS = shaderByteCode;
     descPso.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
     descPso.pRootSignature = m_pRootSignature;
     descPso.NodeMask = 0;
 
-    ThrowIfFailed(pDevice->GetDevice()->CreateComputePipelineState(&descPso, IID_PPV_ARGS(&m_pHorizontalPipeline)));
-
-    D3D12_SHADER_BYTECODE verticalByteCode = {};
-    CAULDRON_DX12::CompileShaderFromFile(
-        "DX12/SobelFilter.hlsl",
-        &defines,
-        "VerticalFilter",
-        "-T cs_6_0 /Zi /Zss -Od -Qembed_debug",
-        &verticalByteCode);
-    descPso.CS = verticalByteCode;
-
-    ThrowIfFailed(pDevice->GetDevice()->CreateComputePipelineState(&descPso, IID_PPV_ARGS(&m_pVerticalPipeline)));
+    ThrowIfFailed(pDevice->GetDevice()->CreateComputePipelineState(&descPso, IID_PPV_ARGS(&m_pPipeline)));
 
     m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_constBuffer);
 
@@ -99,16 +94,14 @@ void SobelFilter::OnCreate(
     input.CreateSRV(0, &m_inputSrv);
 
     CreateOutputResource(input);
-
-    m_combine.OnCreate(m_horizFilterTex, m_vertFilterTex,
-        pDevice, pUploadHeap, pResourceViewHeaps, pConstantBufferRing);
 }
 
 void SobelFilter::CreateOutputResource(Texture& input)
 {
+    // Only red is read, so the output is a single grey plane.
     CD3DX12_RESOURCE_DESC outputDesc =
         CD3DX12_RESOURCE_DESC::Tex2D(
-            input.GetFormat(),
+            GetGreyOperationOutputFormat(input.GetFormat()),
             input.GetWidth(), input.GetHeight(),
             1, // array size
             1, // mip size
@@ -116,36 +109,61 @@ void SobelFilter::CreateOutputResource(Texture& input)
             0, // sample quality
             D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
 
-    m_horizFilterTex.InitRenderTarget(m_pDevice, "SobelFilterIntermediateOutput", &outputDesc, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    m_output.InitRenderTarget(m_pDevice, "SobelFilterOutput", &outputDesc, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 
-    m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_horizFilterUav);
-    m_horizFilterTex.CreateUAV(0, &m_horizFilterUav);
+    m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1 + k_sobelOutputPlaneCount, &m_outputUavTable);
+    m_output.CreateUAV(0, &m_outputUavTable);
 
-    m_vertFilterTex.InitRenderTarget(m_pDevice, "SobelFilterOutput", &outputDesc, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_outputSrv);
+    m_output.CreateSRV(0, &m_outputSrv);
 
-    m_pResourceViewHeaps->AllocCBV_SRV_UAVDescriptor(1, &m_vertFilterUav);
-    m_vertFilterTex.CreateUAV(0, &m_vertFilterUav);
+    // The gradient and orientation planes stay R32_FLOAT.
+    CD3DX12_RESOURCE_DESC planeDesc = outputDesc;
+    planeDesc.Format = DXGI_FORMAT_R32_FLOAT;
+    const char* planeNames[k_sobelOutputPlaneCount] = {
+        "SobelFilterGradientX", "SobelFilterGradientY", "SobelFilterOrientation"
+    };
+    for (uint32_t plane = 0; plane < k_sobelOutputPlaneCount; ++plane)
+    {
+        if ((m_planeOutputs & (1u << plane)) != 0)
+        {
+            m_planes[plane].InitRenderTarget(m_pDevice, planeNames[plane], &planeDesc, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+            m_planes[plane].CreateUAV(1 + plane, &m_outputUavTable);
+        }
+        else
+        {
+            D3D12_UNORDERED_ACCESS_VIEW_DESC nullUavDesc = {};
+            nullUavDesc.Format = DXGI_FORMAT_R32_FLOAT;
+            nullUavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+            m_pDevice->GetDevice()->CreateUnorderedAccessView(nullptr, nullptr, &nullUavDesc, m_outputUavTable.GetCPU(1 + plane));
+        }
+    }
 
     m_constants.outputWidth = input.GetWidth();
     m_constants.outputHeight = input.GetHeight();
 }
 
-void SobelFilter::OnDestroy()
+Texture& SobelFilter::GetPlane(uint32_t output)
 {
-    m_horizFilterTex.OnDestroy();
+    uint32_t plane = GetSobelPlaneIndex(output);
+    assert((m_planeOutputs & output) != 0);
+    return m_planes[plane];
+}
 
-    m_vertFilterTex.OnDestroy();
+void SobelFilter::OnDestroy()
+{
+    m_output.OnDestroy();
 
-    if (m_pHorizontalPipeline != nullptr)
+    for (uint32_t plane = 0; plane < k_sobelOutputPlaneCount; ++plane)
     {
-        m_pHorizontalPipeline->Release();
-        m_pHorizontalPipeline = nullptr;
+        if ((m_planeOutputs & (1u << plane)) != 0)
+            m_planes[plane].OnDestroy();
     }
 
-    if (m_pVerticalPipeline != nullptr)
+    if (m_pPipeline != nullptr)
     {
-        m_pVerticalPipeline->Release();
-        m_pVerticalPipeline = nullptr;
+        m_pPipeline->Release();
+        m_pPipeline = nullptr;
     }
 
     if (m_pRootSignature != nullptr)
@@ -159,20 +177,28 @@ void SobelFilter::Draw(ID3D12GraphicsCommandList* pCommandList)
 {
     UserMarker marker(pCommandList, "SobelFilter");
 
-    CD3DX12_RESOURCE_BARRIER barriers[2] = {
+    CD3DX12_RESOURCE_BARRIER barriers[1 + k_sobelOutputPlaneCount];
+    uint32_t barrierCount = 0;
+    barriers[barrierCount++] =
         CD3DX12_RESOURCE_BARRIER::Transition(
-            m_horizFilterTex.GetResource(),
+            m_output.GetResource(),
             D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-            D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
-        CD3DX12_RESOURCE_BARRIER::Transition(
-            m_vertFilterTex.GetResource(),
-            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-            D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
-    };
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    for (uint32_t plane = 0; plane < k_sobelOutputPlaneCount; ++plane)
+    {
+        if ((m_planeOutputs & (1u << plane)) != 0)
+        {
+            barriers[barrierCount++] =
+                CD3DX12_RESOURCE_BARRIER::Transition(
+                    m_planes[plane].GetResource(),
+                    D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+                    D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        }
+    }
 
-    pCommandList->ResourceBarrier(2, barriers);
+    pCommandList->ResourceBarrier(barrierCount, barriers);
 
-    pCommandList->SetPipelineState(m_pHorizontalPipeline);
+    pCommandList->SetPipelineState(m_pPipeline);
     pCommandList->SetComputeRootSignature(m_pRootSignature);
 
     D3D12_GPU_VIRTUAL_ADDRESS cbHandle;
@@ -186,7 +212,7 @@ void SobelFilter::Draw(ID3D12GraphicsCommandList* pCommandList)
     pCommandList->SetDescriptorHeaps(2, pDescriptorHeaps);
 
     pCommandList->SetComputeRootConstantBufferView(0, cbHandle);
-    pCommandList->SetComputeRootDescriptorTable(1, m_horizFilterUav.GetGPU());
+    pCommandList->SetComputeRootDescriptorTable(1, m_outputUavTable.GetGPU());
     pCommandList->SetComputeRootDescriptorTable(2, m_inputSrv.GetGPU());
 
     uint32_t dispatchX = (m_constants.outputWidth + 7) / 8;
@@ -194,27 +220,8 @@ void SobelFilter::Draw(ID3D12GraphicsCommandList* pCommandList)
     uint32_t dispatchZ = 1;
     pCommandList->Dispatch(dispatchX, dispatchY, dispatchZ);
 
-    barriers[0] =
-        CD3DX12_RESOURCE_BARRIER::Transition(
-            m_horizFilterTex.GetResource(),
-            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
-            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-
-    pCommandList->ResourceBarrier(1, barriers);
-
-    pCommandList->SetPipelineState(m_pVerticalPipeline);
-    pCommandList->SetComputeRootDescriptorTable(1, m_vertFilterUav.GetGPU());
-    pCommandList->SetComputeRootDescriptorTable(2, m_inputSrv.GetGPU());
-
-    pCommandList->Dispatch(dispatchX, dispatchY, dispatchZ);
-
-    barriers[0] =
-        CD3DX12_RESOURCE_BARRIER::Transition(
-            m_vertFilterTex.GetResource(),
-            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
-            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-
-    pCommandList->ResourceBarrier(1, barriers);
+    for (uint32_t barrier = 0; barrier < barrierCount; ++barrier)
+        std::swap(barriers[barrier].Transition.StateBefore, barriers[barrier].Transition.StateAfter);
 
-    m_combine.Draw(pCommandList);
+    pCommandList->ResourceBarrier(barrierCount, barriers);
 }
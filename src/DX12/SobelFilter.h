@@ -6,13 +6,16 @@
 #include "DynamicBufferRing.h"
 #include "ResourceViewHeaps.h"
 #include "Texture.h"
-#include "SobelFilterCombine.h"
 #include "UploadHeap.h"
 
+#include "../CPU/CpuSobelFilter.h"
+
 #include <string>
 
 namespace CS570
 {
+    // One Gradient dispatch reads each 8x8 tile plus apron into groupshared memory once and writes the
+    // gray magnitude output, plus the R32_FLOAT planes selected by planeOutputs (k_sobelOutput* bits).
     class SobelFilter : public BaseImageProcessor
     {
     public:
@@ -21,23 +24,27 @@ namespace CS570
             CAULDRON_DX12::Device* pDevice,
             CAULDRON_DX12::UploadHeap* pUploadHeap,
             CAULDRON_DX12::ResourceViewHeaps* pResourceViewHeaps,
-            CAULDRON_DX12::DynamicBufferRing* pConstantBufferRing);
+            CAULDRON_DX12::DynamicBufferRing* pConstantBufferRing,
+            uint32_t planeOutputs = 0u);
         void OnDestroy();
 
         void Draw(ID3D12GraphicsCommandList *pCommandList) override;
 
-        CAULDRON_DX12::CBV_SRV_UAV& GetOutputSrv() override { return m_combine.GetOutputSrv(); }
-        CAULDRON_DX12::Texture& GetOutputResource() override { return m_combine.GetOutputResource(); }
+        CAULDRON_DX12::CBV_SRV_UAV& GetOutputSrv() override { return m_outputSrv; }
+        CAULDRON_DX12::Texture& GetOutputResource() override { return m_output; }
+
+        // Only valid for the bits passed to OnCreate.
+        CAULDRON_DX12::Texture& GetPlane(uint32_t output);
 
     private:
         void CreateOutputResource(CAULDRON_DX12::Texture& input);
 
         ID3D12RootSignature* m_pRootSignature = nullptr;
-        ID3D12PipelineState* m_pHorizontalPipeline = nullptr;
-        ID3D12PipelineState* m_pVerticalPipeline = nullptr;
+        ID3D12PipelineState* m_pPipeline = nullptr;
 
-        CAULDRON_DX12::Texture m_horizFilterTex;
-        CAULDRON_DX12::Texture m_vertFilterTex;
+        CAULDRON_DX12::Texture m_output;
+        CAULDRON_DX12::Texture m_planes[k_sobelOutputPlaneCount];
+        uint32_t m_planeOutputs = 0u;
 
         struct Constants
         {
@@ -52,12 +59,11 @@ namespace CS570
         CAULDRON_DX12::CBV_SRV_UAV m_constBuffer; // dimension
 
         CAULDRON_DX12::CBV_SRV_UAV m_inputSrv;
-        CAULDRON_DX12::CBV_SRV_UAV m_horizFilterUav;
-        CAULDRON_DX12::CBV_SRV_UAV m_vertFilterUav;
-
-        SobelFilterCombine m_combine;
+        // u0 is m_output, u1..u3 the planes, null views for the ones that weren't requested.
+        CAULDRON_DX12::CBV_SRV_UAV m_outputUavTable;
+        CAULDRON_DX12::CBV_SRV_UAV m_outputSrv;
 
         CAULDRON_DX12::ResourceViewHeaps* m_pResourceViewHeaps = nullptr;
         CAULDRON_DX12::DynamicBufferRing* m_pConstantBufferRing = nullptr;
     };
-}
\ No newline at end of file
+}
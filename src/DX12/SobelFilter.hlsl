@@ -4,72 +4,56 @@ cbuffer Constants : register(b0)
 }
 
 Texture2D inputTex : register(t0);
-RWTexture2D<float4> outputTex : register(u0);
+RWTexture2D<float> outputTex : register(u0);
+// Optional single channel planes, only written when the matching OUTPUT_* define is 1.
+RWTexture2D<float> gradientXTex : register(u1);
+RWTexture2D<float> gradientYTex : register(u2);
+RWTexture2D<float> orientationTex : register(u3);
 
-[numthreads(8, 8, 1)]
-void HorizontalFilter(uint3 dispatchId : SV_DispatchThreadID)
-{
-    if (dispatchId.x >= g_outputSize.x || dispatchId.y >= g_outputSize.y)
-        return;
+#define TILE_SIZE 8
+#define CACHE_SIZE (TILE_SIZE + 2)
 
-    float weights[9] =
-    {
-        -1.0f, 0, 1.0f,
-        -2.0f, 0, 2.0f,
-        -1.0f, 0, 1.0f
-    };
+// Red channel of the group's 8x8 texels plus a one texel apron, so each texel is loaded once per
+// group instead of once per tap.
+groupshared float s_redCache[CACHE_SIZE * CACHE_SIZE];
 
-    const int halfWidth = 3 >> 1;
-    const int halfHeight = 3 >> 1;
-    int2 offsetXY = int2(-halfWidth, -halfHeight);
-    float weightedOutput = 0.0f;
+float CachedRed(int2 cacheXY)
+{
+    return s_redCache[cacheXY.y * CACHE_SIZE + cacheXY.x];
+}
+
+[numthreads(TILE_SIZE, TILE_SIZE, 1)]
+void Gradient(uint3 dispatchId : SV_DispatchThreadID, uint3 groupId : SV_GroupID, uint groupIndex : SV_GroupIndex)
+{
+    int2 cacheOrigin = int2(groupId.xy * TILE_SIZE) - 1;
     [loop]
-    for (uint row = 0; row < 3; ++row)
+    for (uint index = groupIndex; index < CACHE_SIZE * CACHE_SIZE; index += TILE_SIZE * TILE_SIZE)
     {
-        [loop]
-        for (uint col = 0; col < 3; col += 2)
-        {
-            weightedOutput +=
-                inputTex.Load(int3(dispatchId.xy + offsetXY, 0)).r * weights[row * 3 + col];
-            offsetXY.x += 2;
-        }
-        offsetXY.x = -halfWidth;
-        ++offsetXY.y;
+        int2 loadXY = cacheOrigin + int2(index % CACHE_SIZE, index / CACHE_SIZE);
+        s_redCache[index] = inputTex.Load(int3(loadXY, 0)).r;
     }
 
-    outputTex[dispatchId.xy] = float4(weightedOutput, weightedOutput, weightedOutput, 1.0f);
-}
+    GroupMemoryBarrierWithGroupSync();
 
-[numthreads(8, 8, 1)]
-void VerticalFilter(uint3 dispatchId : SV_DispatchThreadID)
-{
     if (dispatchId.x >= g_outputSize.x || dispatchId.y >= g_outputSize.y)
         return;
 
-    float weights[9] =
-    {
-        1.0f,  2.0f,  1.0f,
-        0.0f,  0.0f,  0.0f,
-       -1.0f, -2.00, -1.0f
-    };
-
-    const int halfWidth = 3 >> 1;
-    const int halfHeight = 3 >> 1;
-    int2 offsetXY = int2(-halfWidth, -halfHeight);
-    float weightedOutput = 0.0f;
-    [loop]
-    for (uint row = 0; row < 3; row += 2)
-    {
-        [loop]
-        for (uint col = 0; col < 3; ++col)
-        {
-            weightedOutput +=
-                inputTex.Load(int3(dispatchId.xy + offsetXY, 0)).r * weights[row * 3 + col];
-            ++offsetXY.x;
-        }
-        offsetXY.x = -halfWidth;
-        offsetXY.y += 2;
-    }
-
-    outputTex[dispatchId.xy] = float4(weightedOutput, weightedOutput, weightedOutput, 1.0f);
+    // Center texel of this thread in the cache.
+    int2 c = int2(dispatchId.xy) - cacheOrigin;
+    float above[3] = { CachedRed(c + int2(-1, -1)), CachedRed(c + int2(0, -1)), CachedRed(c + int2(1, -1)) };
+    float center[3] = { CachedRed(c + int2(-1, 0)), CachedRed(c), CachedRed(c + int2(1, 0)) };
+    float below[3] = { CachedRed(c + int2(-1, 1)), CachedRed(c + int2(0, 1)), CachedRed(c + int2(1, 1)) };
+
+    float horiz = (above[2] - above[0]) + 2.0f * (center[2] - center[0]) + (below[2] - below[0]);
+    float vert = (above[0] + 2.0f * above[1] + above[2]) - (below[0] + 2.0f * below[1] + below[2]);
+    outputTex[dispatchId.xy] = sqrt((horiz * horiz) + (vert * vert));
+#if OUTPUT_GRADIENT_X
+    gradientXTex[dispatchId.xy] = horiz;
+#endif
+#if OUTPUT_GRADIENT_Y
+    gradientYTex[dispatchId.xy] = vert;
+#endif
+#if OUTPUT_ORIENTATION
+    orientationTex[dispatchId.xy] = atan2(vert, horiz);
+#endif
 }
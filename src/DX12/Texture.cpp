@@ -111,6 +111,29 @@ namespace CAULDRON_DX12
         return 0;
     }
 
+    INT32 Texture::InitPlaced(Device* pDevice, const char* pDebugName, const CD3DX12_RESOURCE_DESC* pDesc, ID3D12Heap* pHeap, UINT64 heapOffset, D3D12_RESOURCE_STATES initialState)
+    {
+        HRESULT hr = pDevice->GetDevice()->CreatePlacedResource(
+            pHeap,
+            heapOffset,
+            pDesc,
+            initialState,
+            nullptr,
+            IID_PPV_ARGS(&m_pResource));
+        assert(hr == S_OK);
+
+        m_header.format = pDesc->Format;
+        m_header.width = (UINT32)pDesc->Width;
+        m_header.height = (UINT32)pDesc->Height;
+        m_header.mipMapCount = pDesc->MipLevels;
+        m_header.depth = (UINT32)pDesc->Depth();
+        m_header.arraySize = (UINT32)pDesc->ArraySize();
+
+        SetName(m_pResource, pDebugName);
+
+        return hr;
+    }
+
     bool Texture::InitBuffer(Device* pDevice, const char* pDebugName, const CD3DX12_RESOURCE_DESC* pDesc, uint32_t structureSize, D3D12_RESOURCE_STATES state)
     {
         assert(pDevice && pDesc);
@@ -389,7 +412,24 @@ namespace CAULDRON_DX12
             }
         }
 
-        srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        switch (resourceDesc.Format)
+        {
+        // Single channel images are grey planes, so every channel reads the grey value and alpha reads
+        // 1, the way the CPU backend loads them.
+        case DXGI_FORMAT_R8_UNORM:
+        case DXGI_FORMAT_R16_UNORM:
+        case DXGI_FORMAT_R16_FLOAT:
+        case DXGI_FORMAT_R32_FLOAT:
+            srvDesc.Shader4ComponentMapping = D3D12_ENCODE_SHADER_4_COMPONENT_MAPPING(
+                D3D12_SHADER_COMPONENT_MAPPING_FROM_MEMORY_COMPONENT_0,
+                D3D12_SHADER_COMPONENT_MAPPING_FROM_MEMORY_COMPONENT_0,
+                D3D12_SHADER_COMPONENT_MAPPING_FROM_MEMORY_COMPONENT_0,
+                D3D12_SHADER_COMPONENT_MAPPING_FORCE_VALUE_1);
+            break;
+        default:
+            srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+            break;
+        }
         CreateSRV(index, pRV, &srvDesc);
     }
 
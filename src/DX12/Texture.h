@@ -36,6 +36,8 @@ namespace CAULDRON_DX12
         virtual bool InitFromFile(Device *pDevice, UploadHeap *pUploadHeap, const char *szFilename, bool useSRGB = false, float cutOff = 1.0f, D3D12_RESOURCE_FLAGS resourceFlags = D3D12_RESOURCE_FLAG_NONE);
         INT32 Init(Device *pDevice, const char *pDebugName, const CD3DX12_RESOURCE_DESC *pDesc, D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE *pClearValue);
         INT32 InitRenderTarget(Device *pDevice, const char *pDebugName, const CD3DX12_RESOURCE_DESC *pDesc, D3D12_RESOURCE_STATES initialState = D3D12_RESOURCE_STATE_RENDER_TARGET, const FLOAT *clearColor = nullptr);
+        // Creates the texture in a heap the caller owns, e.g. to alias textures that are never live together.
+        INT32 InitPlaced(Device *pDevice, const char *pDebugName, const CD3DX12_RESOURCE_DESC *pDesc, ID3D12Heap *pHeap, UINT64 heapOffset, D3D12_RESOURCE_STATES initialState);
         INT32 InitDepthStencil(Device *pDevice, const char *pDebugName, const CD3DX12_RESOURCE_DESC *pDesc);
         bool InitBuffer(Device *pDevice, const char *pDebugName, const CD3DX12_RESOURCE_DESC *pDesc, uint32_t structureSize, D3D12_RESOURCE_STATES state);     // structureSize needs to be 0 if using a valid DXGI_FORMAT
         bool InitCounter(Device *pDevice, const char *pDebugName, const CD3DX12_RESOURCE_DESC *pCounterDesc, uint32_t counterSize, D3D12_RESOURCE_STATES state);
@@ -0,0 +1,90 @@
+#include "TiledImageLoader.h"
+#include "CpuPixelFormatDxgi.h"
+
+#include "Misc.h"
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "stdafx.h"
+
+using namespace CS570;
+
+bool TiledImageLoader::Load(const char* pFilename, float cutOff, IMG_INFO* pInfo)
+{
+    try
+    {
+        m_image.Open(pFilename);
+    }
+    catch (const char* pError)
+    {
+        Trace(format("%s: %s\n", pFilename, pError));
+        return false;
+    }
+    m_level = 0u;
+
+    pInfo->width = m_image.GetWidth();
+    pInfo->height = m_image.GetHeight();
+    pInfo->depth = 1u;
+    pInfo->arraySize = 1u;
+    pInfo->mipMapCount = m_image.GetMipCount();
+    pInfo->format = GetDxgiFormat(m_image.GetFormat());
+    pInfo->bitCount = GetPixelSize(m_image.GetFormat()) * 8;
+    return true;
+}
+
+void TiledImageLoader::CopyPixels(void* pDest, uint32_t stride, uint32_t width, uint32_t height)
+{
+    assert(m_level < m_image.GetMipCount() && height == m_image.GetHeight(m_level));
+    try
+    {
+        m_image.ReadRegion(m_level, 0, 0, m_image.GetWidth(m_level), height, static_cast<uint8_t*>(pDest), stride);
+    }
+    catch (const char* pError)
+    {
+        Trace(format("Failed to read mip level %u: %s\n", m_level, pError));
+    }
+    ++m_level;
+}
+
+bool CS570::ConvertToTiledImage(const char* pFilename, const std::string& tiledFile, TileCodec codec)
+{
+    std::unique_ptr<ImgLoader> pLoader(CreateImageLoader(pFilename));
+    IMG_INFO info = {};
+    if (!pLoader->Load(pFilename, 1.0f, &info) || info.depth > 1 || info.arraySize > 1)
+        return false;
+
+    CpuPixelFormat tiledFormat;
+    if (info.format == DXGI_FORMAT_B8G8R8A8_UNORM)
+        tiledFormat = CpuPixelFormat::RGBA8;
+    else if (!GetCpuPixelFormat(info.format, &tiledFormat))
+        return false;
+
+    // The loaders decode whole images, so the top level is read once and tiled from memory.
+    const size_t rowSize = size_t(info.width) * GetPixelSize(tiledFormat);
+    std::vector<uint8_t> pixels(rowSize * info.height);
+    pLoader->CopyPixels(pixels.data(), static_cast<uint32_t>(rowSize), static_cast<uint32_t>(rowSize), info.height);
+    if (info.format == DXGI_FORMAT_B8G8R8A8_UNORM)
+    {
+        for (size_t pixel = 0; pixel < pixels.size(); pixel += 4)
+            std::swap(pixels[pixel], pixels[pixel + 2]);
+    }
+
+    try
+    {
+        // Bands are handed over in the loaded format; the writer widens them itself, grey ones to the
+        // RGBA format tiles are stored in.
+        WriteTiledImage(tiledFile, info.width, info.height, GetRgbaFormat(tiledFormat), codec,
+            [&](uint32_t rowBegin, uint32_t rowEnd, CpuImage* pBand) {
+                pBand->Resize(info.width, rowEnd - rowBegin, tiledFormat);
+                std::memcpy(pBand->GetBytes(), pixels.data() + rowBegin * rowSize, (rowEnd - rowBegin) * rowSize);
+            });
+    }
+    catch (const char* pError)
+    {
+        Trace(format("%s: %s\n", tiledFile.c_str(), pError));
+        return false;
+    }
+    return true;
+}
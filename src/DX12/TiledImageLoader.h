@@ -0,0 +1,27 @@
+#pragma once
+
+#include "ImgLoader.h"
+
+#include "../CPU/CpuTiledImage.h"
+
+namespace CS570
+{
+    // Loads a tiled image (.cti) with its stored mip levels, decoding every level straight into the
+    // upload heap in the stored format.
+    class TiledImageLoader : public ImgLoader
+    {
+    public:
+        bool Load(const char* pFilename, float cutOff, IMG_INFO* pInfo) override;
+        // after calling Load, calls to CopyPixels return each time a lower mip level
+        void CopyPixels(void* pDest, uint32_t stride, uint32_t width, uint32_t height) override;
+
+    private:
+        CpuTiledImage m_image;
+        uint32_t m_level = 0u;
+    };
+
+    // Converts an image the other loaders read (png, jpg and the other WIC formats, or a dds holding
+    // an uncompressed RGBA format) to a tiled image in the same sample type. Returns false if the
+    // image can't be loaded or has no tiled image format, e.g. block compressed or array dds files.
+    bool ConvertToTiledImage(const char* pFilename, const std::string& tiledFile, TileCodec codec = TileCodec::Predictive);
+}
@@ -4,16 +4,17 @@
 
 #include "Device.h"
 #include "DynamicBufferRing.h"
-#include "GaussianBlur.h"
 #include "ResourceViewHeaps.h"
 #include "Texture.h"
-#include "SobelFilterCombine.h"
 #include "UploadHeap.h"
 
 #include <string>
 
 namespace CS570
 {
+    // Single dispatch unsharp mask: each 8x8 group blurs its tile with the separable kernel in
+    // groupshared memory and writes input + weight * (input - blur), so the only full size texture
+    // besides the input is the output.
     class UnsharpMask : public BaseImageProcessor
     {
     public:
@@ -29,22 +30,48 @@ namespace CS570
 
         void SetWeight(float weight)
         {
-            m_addOperation.SetWeightInput2(weight);
+            m_constants.weight = weight;
         }
 
         void Draw(ID3D12GraphicsCommandList *pCommandList) override;
 
-        CAULDRON_DX12::CBV_SRV_UAV& GetOutputSrv() override { return m_addOperation.GetOutputSrv(); }
-        CAULDRON_DX12::Texture& GetOutputResource() override { return m_addOperation.GetOutputResource(); }
+        CAULDRON_DX12::CBV_SRV_UAV& GetOutputSrv() override { return m_outputSrv; }
+        CAULDRON_DX12::Texture& GetOutputResource() override { return m_output; }
 
-        void SetBlurVariance(float variance)
-        {
-            m_gaussianBlur.SetVariance(variance);
-        }
+        void SetBlurVariance(float variance);
+
+        static const uint32_t k_maxKernelSize = 32;
 
     private:
-        GaussianBlur m_gaussianBlur;
-        ImageProcessor m_subtractOperation;
-        ImageProcessor m_addOperation;
+        void CreateOutputResource(CAULDRON_DX12::Texture& input);
+
+        ID3D12RootSignature* m_pRootSignature = nullptr;
+        ID3D12PipelineState* m_pPipeline = nullptr;
+
+        CAULDRON_DX12::Texture m_output;
+
+        uint32_t m_kernelSize = 0u;
+
+        struct Constants
+        {
+            uint32_t outputWidth = 0u;
+            uint32_t outputHeight = 0u;
+            float weight = 1.0f;
+            float padding = 0.0f;
+            float weights[k_maxKernelSize] = {};
+        };
+
+        Constants m_constants;
+
+        CAULDRON_DX12::Device* m_pDevice = nullptr;
+
+        CAULDRON_DX12::CBV_SRV_UAV m_constBuffer; // dimension
+
+        CAULDRON_DX12::CBV_SRV_UAV m_inputSrv;
+        CAULDRON_DX12::CBV_SRV_UAV m_outputUav;
+        CAULDRON_DX12::CBV_SRV_UAV m_outputSrv;
+
+        CAULDRON_DX12::ResourceViewHeaps* m_pResourceViewHeaps = nullptr;
+        CAULDRON_DX12::DynamicBufferRing* m_pConstantBufferRing = nullptr;
     };
-}
\ No newline at end of file
+}
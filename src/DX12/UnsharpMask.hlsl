@@ -0,0 +1,66 @@
+cbuffer Constants : register(b0)
+{
+    uint2 g_outputSize;
+    float g_weight;
+    float g_padding;
+    // Normalized 1D blur weights, four per element.
+    float4 g_weights[MAX_KERNEL_SIZE / 4];
+}
+
+Texture2D inputTex : register(t0);
+RWTexture2D<float4> outputTex : register(u0);
+
+#define TILE_SIZE 8
+#define HALF_SIZE (KERNEL_SIZE >> 1)
+#define CACHE_SIZE (TILE_SIZE + 2 * HALF_SIZE)
+
+// Red channel of the group's tile plus a HALF_SIZE apron, then the horizontal blur of every cached row
+// for the tile's columns. Neither ever leaves the group, so the blur costs no texture traffic.
+groupshared float s_redCache[CACHE_SIZE * CACHE_SIZE];
+groupshared float s_horizontalPass[CACHE_SIZE * TILE_SIZE];
+
+float LoadWeight(uint index)
+{
+    return g_weights[index >> 2][index & 3];
+}
+
+[numthreads(TILE_SIZE, TILE_SIZE, 1)]
+void UnsharpMask(uint3 dispatchId : SV_DispatchThreadID, uint3 groupId : SV_GroupID, uint3 groupThreadId : SV_GroupThreadID, uint groupIndex : SV_GroupIndex)
+{
+    int2 cacheOrigin = int2(groupId.xy * TILE_SIZE) - HALF_SIZE;
+    uint index;
+    [loop]
+    for (index = groupIndex; index < CACHE_SIZE * CACHE_SIZE; index += TILE_SIZE * TILE_SIZE)
+    {
+        int2 loadXY = cacheOrigin + int2(index % CACHE_SIZE, index / CACHE_SIZE);
+        s_redCache[index] = inputTex.Load(int3(loadXY, 0)).r;
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    [loop]
+    for (index = groupIndex; index < CACHE_SIZE * TILE_SIZE; index += TILE_SIZE * TILE_SIZE)
+    {
+        uint row = index / TILE_SIZE;
+        uint col = index % TILE_SIZE;
+        float blurred = 0.0f;
+        [loop]
+        for (uint tap = 0; tap < KERNEL_SIZE; ++tap)
+            blurred += s_redCache[row * CACHE_SIZE + col + tap] * LoadWeight(tap);
+        s_horizontalPass[index] = blurred;
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    if (dispatchId.x >= g_outputSize.x || dispatchId.y >= g_outputSize.y)
+        return;
+
+    float blurred = 0.0f;
+    [loop]
+    for (uint tap = 0; tap < KERNEL_SIZE; ++tap)
+        blurred += s_horizontalPass[(groupThreadId.y + tap) * TILE_SIZE + groupThreadId.x] * LoadWeight(tap);
+
+    // Same as Add(input, Subtract(input, blur) * weight) with the gray (b, b, b, 1) blur output.
+    float4 color = inputTex.Load(int3(dispatchId.xy, 0));
+    outputTex[dispatchId.xy] = color + (color - float4(blurred, blurred, blurred, 1.0f)) * g_weight;
+}